@@ -7,24 +7,14 @@
 #include <fstream>
 #include <cerrno>
 #include <argos3/core/utility/logging/argos_log.h>
+#include <argos3/core/utility/string_utilities.h>
 
 /****************************************/
 /****************************************/
 
-pthread_mutex_t CBuzzController::TRAJECTORY_MUTEX;
+pthread_mutex_t CBuzzController::TRAJECTORY_MUTEX = PTHREAD_MUTEX_INITIALIZER;
 CSet<CBuzzController*> CBuzzController::TRAJECTORY_CONTROLLERS;
 
-/*
- * A class used to trick the linker to initialize the trajectory mutex
- * during static initialization.
- */
-class CBuzzControllerMutexInitializer {
-public:
-   CBuzzControllerMutexInitializer() {
-      pthread_mutex_init(&CBuzzController::TRAJECTORY_MUTEX, NULL);
-   }
-} __cBuzzControllerMutexInitializer;
-
 /****************************************/
 /****************************************/
 
@@ -59,6 +49,9 @@ int BuzzLOG (buzzvm_t vm) {
          case BUZZTYPE_USERDATA:
             LOG << "[userdata @" << o->u.value << "]";
             break;
+         case BUZZTYPE_BLOB:
+            LOG << "[blob with " << o->b.value.size << " bytes]";
+            break;
          default:
             break;
       }
@@ -86,17 +79,8 @@ int BuzzGetPicture (buzzvm_t vm) {
    data.resize(fin.tellg());
    fin.seekg(0, std::ios::beg);
    fin.read(&data[0], data.size());
-   
-   unsigned char u_data[data.size()];
-   for(uint32_t i=0; i<data.size(); i++){
-      u_data[i]=(unsigned char) data[i];
-   }
-   char out_base64[b64d_size(data.size())];
-   memset(out_base64,0,b64d_size(data.size()));
-   data = base64_encode(u_data,data.size(),out_base64);
-   //buzzvm_pushs(vm, buzzvm_string_register(vm, "image",1));
-   buzzvm_pushs(vm, buzzvm_string_register(vm, out_base64,1));
-   //buzzvm_gstore(vm);
+   /* Return the raw bytes as a blob, no base64 inflation needed */
+   buzzvm_pushb(vm, data.data(), data.size());
    return buzzvm_ret1(vm);
 }
 
@@ -114,18 +98,26 @@ int BuzzwritePicture (buzzvm_t vm) {
    name+=o->s.value.str;
    //myfile.open(name.c_str());
    buzzvm_lload(vm, 2);
-   buzzvm_type_assert(vm, 1, BUZZTYPE_STRING);
    o = buzzvm_stack_at(vm, 1); 
+   if(o->o.type != BUZZTYPE_STRING)
+      buzzvm_type_assert(vm, 1, BUZZTYPE_BLOB);
    buzzvm_pop(vm);
-   //std::string buzz_obj_out(o->s.value.str);
-   char m_out[strlen(o->s.value.str)];
-   int out_size = base64_decode(o->s.value.str,m_out);
    FILE *f = fopen(name.c_str(), "wb");
    if (f == NULL)
    {
     printf("Error opening file!\n");
+    return buzzvm_ret0(vm);
+   }
+   if(o->o.type == BUZZTYPE_BLOB) {
+      /* Raw bytes */
+      fwrite(o->b.value.data, sizeof(char), o->b.value.size, f);
+   }
+   else {
+      /* Base64-encoded string */
+      std::string m_out(strlen(o->s.value.str), 0);
+      int out_size = base64_decode(o->s.value.str,&m_out[0]);
+      fwrite(m_out.data(), sizeof(char), out_size, f);
    }
-   fwrite(m_out, sizeof(char), out_size, f);
    //fprintf(f, "%s", m_out);
    fclose(f);
    //myfile.close();
@@ -136,29 +128,12 @@ int BuzzwritePicture (buzzvm_t vm) {
 /****************************************/
 
 int BuzzgetblobVm (buzzvm_t vm) {
-   buzzdarray_t sData = buzzvm_vm_serialize(vm);
-   uint32_t ser_size =(uint32_t) buzzdarray_size(sData);
-   char cser_data[ser_size+1];
-   for(int i =0; i< ser_size; i++){
-     uint8_t da = buzzdarray_get(sData,i, uint8_t);
-     memcpy(cser_data+i,&da,sizeof(uint8_t));
-   }
+   buzzmsg_payload_t sData = buzzvm_vm_serialize(vm);
+   uint32_t ser_size =(uint32_t) buzzmsg_payload_size(sData);
    printf("[DEBUG] [RID: %u] I am serializing vm \n",vm->robot);
-   // printf("Size of ser %u, size of base64: %u\n", ser_size, b64d_size(ser_size));
-   
-   // printf("darray serialized data : %s\n",cser_data);
-   unsigned char u_data[ser_size];
-   for(uint32_t i=0; i<ser_size; i++){
-      u_data[i]=(unsigned char) cser_data[i];
-   }
-   char out_base64[b64d_size(ser_size)+1];
-   memset(out_base64,0,b64d_size(ser_size));
-   base64_encode(u_data,ser_size,out_base64);
-   // printf("base64 data %s\n", out_base64);
-   buzzdarray_destroy(&sData);
-   //buzzvm_pushs(vm, buzzvm_string_register(vm, "image",1));
-   buzzvm_pushs(vm, buzzvm_string_register(vm, out_base64,1));
-   //buzzvm_gstore(vm);
+   /* Return the serialized state as a blob */
+   buzzvm_pushb(vm, sData->data, ser_size);
+   buzzmsg_payload_destroy(&sData);
    return buzzvm_ret1(vm);
 }
 
@@ -167,18 +142,21 @@ int BuzzgetblobVm (buzzvm_t vm) {
 
 int BuzzsetblobVm (buzzvm_t vm) {
    buzzvm_lload(vm, 1);
-   buzzvm_type_assert(vm, 1, BUZZTYPE_STRING);
    buzzobj_t o = buzzvm_stack_at(vm, 1);
+   if(o->o.type != BUZZTYPE_STRING)
+      buzzvm_type_assert(vm, 1, BUZZTYPE_BLOB);
    printf("[DEBUG] [RID: %u] I am deserializing and setting vm \n",vm->robot);
    buzzvm_pop(vm);
-   char m_out[strlen(o->s.value.str)];
-   int out_size = base64_decode(o->s.value.str,m_out);
-   // printf("deser base64 size %u darraysize %d \n", strlen(o->s.value.str),out_size);
-   buzzdarray_t deser_ar =  buzzdarray_new(out_size, sizeof(uint8_t), NULL);
-   for(int i=0; i<out_size; i++){
-    uint8_t dserdata = 0;
-    memcpy(&dserdata,m_out+i,sizeof(uint8_t));
-    buzzdarray_push(deser_ar, &dserdata);  
+   buzzmsg_payload_t deser_ar;
+   if(o->o.type == BUZZTYPE_BLOB) {
+      /* Raw serialized state */
+      deser_ar = buzzmsg_payload_frombuffer(o->b.value.data, o->b.value.size);
+   }
+   else {
+      /* Base64-encoded serialized state */
+      std::string m_out(strlen(o->s.value.str), 0);
+      int out_size = base64_decode(o->s.value.str,&m_out[0]);
+      deser_ar = buzzmsg_payload_frombuffer(m_out.data(), out_size);
    }
    // printf("Size of darray after push : %d\n",buzzdarray_size(deser_ar));
    buzzvm_vm_deserialize_set(vm,deser_ar);
@@ -189,7 +167,7 @@ int BuzzsetblobVm (buzzvm_t vm) {
    //   uint8_t da = buzzdarray_get(sData,i, uint8_t);
    //   memcpy(cser_data,&da,sizeof(uint8_t));
    // }
-   buzzdarray_destroy(&deser_ar);
+   buzzmsg_payload_destroy(&deser_ar);
    return buzzvm_ret0(vm);
 }
 
@@ -532,7 +510,10 @@ CBuzzController::CBuzzController() :
    m_pcPos(NULL),
    m_tBuzzVM(NULL),
    m_tBuzzDbgInfo(NULL),
-   m_temp_p2p_test(0) {}
+   m_temp_p2p_test(0),
+   m_fChunkShare(0.5),
+   m_nMsgMaxWait(-1),
+   m_nGCBudget(-1) {}
 
 /****************************************/
 /****************************************/
@@ -560,6 +541,16 @@ void CBuzzController::Init(TConfigurationNode& t_node) {
       GetNodeAttributeOrDefault(t_node, "debug_file", strDbgFName, strDbgFName);
 
       GetNodeAttribute(t_node, "drop_rate", m_drop_rate);
+      /* Get the share of each frame reserved for blob chunks */
+      GetNodeAttributeOrDefault(t_node, "chunk_share", m_fChunkShare, m_fChunkShare);
+      if(m_fChunkShare < 0.0 || m_fChunkShare > 1.0) {
+         THROW_ARGOSEXCEPTION("chunk_share must be in [0,1], got " << m_fChunkShare);
+      }
+      /* Get the out-message scheduler settings */
+      GetNodeAttributeOrDefault(t_node, "msg_weights", m_strMsgWeights, m_strMsgWeights);
+      GetNodeAttributeOrDefault(t_node, "msg_max_wait", m_nMsgMaxWait, m_nMsgMaxWait);
+      /* Get the garbage collector work budget */
+      GetNodeAttributeOrDefault(t_node, "gc_budget", m_nGCBudget, m_nGCBudget);
       
       //GetNodeAttributeOrDefault(t_node, "drop_rate", m_drop_rate, m_drop_rate);
       // printf("drop_rate is %f\n",m_drop_rate );
@@ -587,8 +578,11 @@ void CBuzzController::Init(TConfigurationNode& t_node) {
       }
       if(strBCFName != "" && strDbgFName != "")
          SetBytecode(strBCFName, strDbgFName);
-      else
+      else {
          m_tBuzzVM = buzzvm_new(m_unRobotId);
+         ConfigureMsgScheduler();
+         ConfigureGC();
+      }
       UpdateSensors();
       /* Set initial robot message (id and then all zeros) */
       CByteArray cData;
@@ -673,6 +667,8 @@ void CBuzzController::SetBytecode(const std::string& str_bc_fname,
    /* Reset the BuzzVM */
    if(m_tBuzzVM) buzzvm_destroy(&m_tBuzzVM);
    m_tBuzzVM = buzzvm_new(m_unRobotId);
+   ConfigureMsgScheduler();
+   ConfigureGC();
    /* Get rid of debug info */
    if(m_tBuzzDbgInfo) buzzdebug_destroy(&m_tBuzzDbgInfo);
    m_tBuzzDbgInfo = buzzdebug_new();
@@ -896,6 +892,75 @@ void CBuzzController::ProcessInMsgs() {
 /****************************************/
 /****************************************/
 
+size_t CBuzzController::PackChunkMsgs(CByteArray& c_data,
+                                      size_t un_limit,
+                                      bool b_at_least_one) {
+   size_t unSent = 0;
+   bool bFirst = b_at_least_one;
+   while(!buzzoutmsg_chunk_queue_isempty(m_tBuzzVM)) {
+      /* Get first message, serialized and owned by the queue */
+      buzzmsg_payload_t m = buzzoutmsg_chunk_queue_peek(m_tBuzzVM);
+      /* Make sure the message is smaller than the data buffer
+       * Without this check, large messages would clog the queue forever
+       */
+      size_t unMsgSize = buzzmsg_payload_size(m) + sizeof(UInt16);
+      if(unMsgSize < m_pcRABA->GetSize() - sizeof(UInt16)) {
+         /* Stop at the first message that does not fit, it goes next frame */
+         size_t unLimit = bFirst ? m_pcRABA->GetSize() : Min(un_limit, m_pcRABA->GetSize());
+         if(c_data.Size() + unMsgSize > unLimit) break;
+         /* Add message length to data buffer  */
+         unSent += buzzmsg_payload_size(m);
+         c_data << static_cast<UInt16>(buzzmsg_payload_size(m));
+         /* Add payload to data buffer */
+         c_data.AddBuffer(reinterpret_cast<UInt8*>(m->data), buzzmsg_payload_size(m));
+         bFirst = false;
+      }
+      else {
+         RLOGERR << "Discarded oversize Blob chunk message ("
+                 << unMsgSize
+                 << " bytes). Max size is "
+                 << m_pcRABA->GetSize() - sizeof(UInt16)
+                 << " bytes. (Hint: Increase msg size)"
+                 << std::endl;
+      }
+      /* Get rid of message */
+      buzzoutmsg_chunk_queue_next(m_tBuzzVM);
+   }
+   return unSent;
+}
+
+/****************************************/
+/****************************************/
+
+void CBuzzController::ConfigureMsgScheduler() {
+   /* Weights, as a comma-separated list of type:weight pairs */
+   std::vector<std::string> vecPairs, vecPair;
+   Tokenize(m_strMsgWeights, vecPairs, ", ");
+   for(size_t i = 0; i < vecPairs.size(); ++i) {
+      vecPair.clear();
+      Tokenize(vecPairs[i], vecPair, ":");
+      int nType = vecPair.size() == 2 ? buzzoutmsg_sched_type(vecPair[0].c_str()) : -1;
+      if(nType < 0) {
+         THROW_ARGOSEXCEPTION("Invalid msg_weights entry \"" << vecPairs[i] << "\"");
+      }
+      buzzoutmsg_sched_set_weight(m_tBuzzVM, nType, FromString<UInt16>(vecPair[1]));
+   }
+   /* Aging threshold */
+   if(m_nMsgMaxWait >= 0)
+      buzzoutmsg_sched_set_max_wait(m_tBuzzVM, m_nMsgMaxWait);
+}
+
+/****************************************/
+/****************************************/
+
+void CBuzzController::ConfigureGC() {
+   if(m_nGCBudget >= 0)
+      buzzheap_gc_set_budget(m_tBuzzVM, m_nGCBudget);
+}
+
+/****************************************/
+/****************************************/
+
 void CBuzzController::ProcessOutMsgs() {
   
    // printf("rid %u my Bernoulli random num %d\n",m_tBuzzVM->robot ,pcRNG->Bernoulli(m_drop_rate));
@@ -909,56 +974,23 @@ void CBuzzController::ProcessOutMsgs() {
      buzzvm_process_outmsgs(m_tBuzzVM);
      /* Send robot id */
      cData << m_tBuzzVM->robot;
-      /* Always try to send atleast one chunk msg */
-      if(!buzzoutmsg_chunk_queue_isempty(m_tBuzzVM)){ 
-        /* Get first message */
-        buzzmsg_payload_t m = buzzoutmsg_chunk_queue_first(m_tBuzzVM);
-        /* Make sure the message is smaller than the data buffer
-         * Without this check, large messages would clog the queue forever
-         */
-        size_t unMsgSize = buzzmsg_payload_size(m) + sizeof(UInt16);
-        if(unMsgSize < m_pcRABA->GetSize() - sizeof(UInt16)) {
-           /* Make sure the next message fits the data buffer */
-           if(cData.Size() + unMsgSize > m_pcRABA->GetSize()) {
-              buzzmsg_payload_destroy(&m);
-           }
-           else{
-             /* Add message length to data buffer  */
-             msgsizesent += buzzmsg_payload_size(m);
-             cData << static_cast<UInt16>(buzzmsg_payload_size(m));
-             /* Add payload to data buffer */
-             cData.AddBuffer(reinterpret_cast<UInt8*>(m->data), buzzmsg_payload_size(m));
-           }
-        }
-        else{
-          RLOGERR << "Discarded oversize Blob chunk message ("
-                   << unMsgSize
-                   << " bytes). Max size is "
-                   << m_pcRABA->GetSize() - sizeof(UInt16)
-                   << " bytes. (Hint: Increase msg size)"
-                   << std::endl;
-        }
-        /* Get rid of message */
-        buzzoutmsg_chunk_queue_next(m_tBuzzVM);
-        buzzmsg_payload_destroy(&m);
-      }
-      m_tBuzzVM->outmsgsstep = msgsizesent;
+     /* Pack chunk messages up to their share of the frame, always at least one */
+     size_t unChunkLimit = cData.Size() +
+        static_cast<size_t>(m_fChunkShare * (m_pcRABA->GetSize() - cData.Size()));
+     msgsizesent += PackChunkMsgs(cData, unChunkLimit, true);
      /* Send messages from FIFO */
      do {
         /* Are there more messages? */
         if(buzzoutmsg_queue_isempty(m_tBuzzVM)) break;
-        /* Get first message */
-        buzzmsg_payload_t m = buzzoutmsg_queue_first(m_tBuzzVM);
+        /* Get first message, serialized and owned by the queue */
+        buzzmsg_payload_t m = buzzoutmsg_queue_peek(m_tBuzzVM);
         /* Make sure the message is smaller than the data buffer
          * Without this check, large messages would clog the queue forever
          */
         size_t unMsgSize = buzzmsg_payload_size(m) + sizeof(UInt16);
         if(unMsgSize < m_pcRABA->GetSize() - sizeof(UInt16)) {
            /* Make sure the next message fits the data buffer */
-           if(cData.Size() + unMsgSize > m_pcRABA->GetSize()) {
-              buzzmsg_payload_destroy(&m);
-              break;
-           }
+           if(cData.Size() + unMsgSize > m_pcRABA->GetSize()) break;
            /* Add message length to data buffer */
            msgsizesent+=buzzmsg_payload_size(m);
 
@@ -976,8 +1008,9 @@ void CBuzzController::ProcessOutMsgs() {
         }
         /* Get rid of message */
         buzzoutmsg_queue_next(m_tBuzzVM);
-        buzzmsg_payload_destroy(&m);
      } while(1);
+     /* Give the room left by control traffic to chunk messages */
+     msgsizesent += PackChunkMsgs(cData, m_pcRABA->GetSize(), false);
    }
     m_tBuzzVM->outmsgsstep = msgsizesent;
    /* Pad the rest of the data with zeroes */
@@ -993,7 +1026,7 @@ void CBuzzController::ProcessOutMsgs() {
      /* Send P2P messages from queue */
      /* Send messages from FIFO */
      /* Are there more messages? */
-     if(buzzdarray_isempty(m_tBuzzVM->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P])){
+     if(buzzqueue_isempty(m_tBuzzVM->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P])){
       /* Pad the rest of the data with zeroes */
       while(cDatap2p.Size() < m_pcRABA->GetSize()) cDatap2p << static_cast<UInt8>(0);
       m_pcRABA->SetDataP2P(cDatap2p,-1);
@@ -14,6 +14,7 @@
 #include <buzz/buzzdebug.h>
 #include <string>
 #include <list>
+#include <set>
 
 using namespace argos;
 
@@ -108,14 +109,27 @@ public:
       return m_tBuzzDbgInfo;
    }
 
+   inline const buzzheap_gcstats_s& GetGCStats() const {
+      return m_tBuzzVM->heap->stats;
+   }
+
    std::string ErrorInfo();
 
-   typedef std::map<size_t, bool> TBuzzRobots;
+   /*
+    * Tags of the robot types with a Buzz controller.
+    * Filled during static initialization, read-only afterwards.
+    */
+   typedef std::set<size_t> TBuzzRobots;
    static TBuzzRobots& BUZZ_ROBOTS() {
       static TBuzzRobots tBuzzRobots;
       return tBuzzRobots;
    }
 
+   /* Returns true if the robot type with the given tag has a Buzz controller */
+   static bool IsBuzzRobot(size_t un_tag) {
+      return BUZZ_ROBOTS().count(un_tag) > 0;
+   }
+
    buzzvm_state Register(const std::string& str_key,
                          buzzobj_t t_obj);
 
@@ -200,6 +214,27 @@ protected:
    virtual void ProcessInMsgs();
    virtual void ProcessOutMsgs();
 
+   /*
+    * Moves broadcast chunk messages into the frame while they fit.
+    * @param c_data The frame being filled.
+    * @param un_limit The frame size the chunk messages may fill up to.
+    * @param b_at_least_one Whether the first message may go past un_limit.
+    * @return The number of payload bytes added.
+    */
+   virtual size_t PackChunkMsgs(CByteArray& c_data,
+                                size_t un_limit,
+                                bool b_at_least_one);
+
+   /*
+    * Applies the out-message scheduler settings from the XML to the VM.
+    */
+   virtual void ConfigureMsgScheduler();
+
+   /*
+    * Applies the garbage collector settings from the XML to the VM.
+    */
+   virtual void ConfigureGC();
+
    virtual void UpdateSensors();
 
 protected:
@@ -227,6 +262,14 @@ protected:
    SDebug m_sDebug;
    int m_temp_p2p_test;
    double m_drop_rate;
+   /* Share of each frame reserved for blob chunk messages */
+   Real m_fChunkShare;
+   /* Out-message scheduler weights, as "type:weight,type:weight" */
+   std::string m_strMsgWeights;
+   /* Steps after which a queued message is sent first, -1 for the default */
+   SInt32 m_nMsgMaxWait;
+   /* Objects the collector goes through per step, 0 for all, -1 for the default */
+   SInt32 m_nGCBudget;
    CRandom::CRNG* pcRNG;
 
 public:
@@ -258,7 +301,7 @@ public:
    class C ## ROBOT_TYPE ## BuzzController ## Proxy {                   \
    public:                                                              \
    C ## ROBOT_TYPE ## BuzzController ## Proxy() {                       \
-      CBuzzController::BUZZ_ROBOTS()[GetTag<ROBOT_TYPE,CEntity>()] = true; \
+      CBuzzController::BUZZ_ROBOTS().insert(GetTag<ROBOT_TYPE,CEntity>()); \
    }                                                                    \
    };                                                                   \
    C ## ROBOT_TYPE ## BuzzController ## Proxy ROBOT_TYPE ## BuzzController ## _p;
@@ -56,7 +56,7 @@ void CBuzzQT::Draw(CBuzzController& c_contr) {
 void CBuzzQT::Call(CEntity& c_entity) {
    TThunk t_thunk = m_cThunks[c_entity.GetTag()];
    if(t_thunk) (this->*t_thunk)(c_entity);
-   else if(CBuzzController::BUZZ_ROBOTS()[c_entity.GetTag()]) {
+   else if(CBuzzController::IsBuzzRobot(c_entity.GetTag())) {
       Draw(dynamic_cast<CBuzzController&>(
               dynamic_cast<CComposableEntity&>(c_entity).
               GetComponent<CControllableEntity>("controller").
@@ -69,6 +69,7 @@ void CBuzzQT::Call(CEntity& c_entity) {
 
 void CBuzzQT::DrawInWorld() {
    /* Go through all the Buzz controllers with trajectory enabled */
+   pthread_mutex_lock(&CBuzzController::TRAJECTORY_MUTEX);
    for(CSet<CBuzzController*>::iterator it = CBuzzController::TRAJECTORY_CONTROLLERS.begin();
        it != CBuzzController::TRAJECTORY_CONTROLLERS.end();
        ++it) {
@@ -88,6 +89,7 @@ void CBuzzQT::DrawInWorld() {
          }
       }
    }
+   pthread_mutex_unlock(&CBuzzController::TRAJECTORY_MUTEX);
 }
 
 /****************************************/
@@ -0,0 +1,177 @@
+#include "buzzbitset.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BUZZBITSET_WORD(i) ((i) >> 6)
+#define BUZZBITSET_BIT(i)  ((uint64_t)1 << ((i) & 63))
+
+/****************************************/
+/****************************************/
+
+/* Makes room for the word of index w */
+static void buzzbitset_reserve(buzzbitset_t s,
+                               uint32_t w) {
+   if(w < s->nwords) return;
+   uint32_t n = s->nwords;
+   while(n <= w) n *= 2;
+   uint64_t* words = (uint64_t*)malloc(n * sizeof(uint64_t));
+   if(!words) {
+      fprintf(stderr, "[FATAL] Can't allocate bit set of %u words.\n", n);
+      abort();
+   }
+   memcpy(words, s->words, s->nwords * sizeof(uint64_t));
+   memset(words + s->nwords, 0, (n - s->nwords) * sizeof(uint64_t));
+   if(s->words != s->inl) free(s->words);
+   s->words = words;
+   s->nwords = n;
+}
+
+/****************************************/
+/****************************************/
+
+buzzbitset_t buzzbitset_new() {
+   buzzbitset_t s = (buzzbitset_t)calloc(1, sizeof(struct buzzbitset_s));
+   s->words = s->inl;
+   s->nwords = BUZZBITSET_INLINE_WORDS;
+   return s;
+}
+
+/****************************************/
+/****************************************/
+
+buzzbitset_t buzzbitset_clone(const buzzbitset_t s) {
+   buzzbitset_t c = buzzbitset_new();
+   buzzbitset_reserve(c, s->nwords - 1);
+   memcpy(c->words, s->words, s->nwords * sizeof(uint64_t));
+   c->count = s->count;
+   return c;
+}
+
+/****************************************/
+/****************************************/
+
+void buzzbitset_destroy(buzzbitset_t* s) {
+   if((*s)->words != (*s)->inl) free((*s)->words);
+   free(*s);
+   *s = NULL;
+}
+
+/****************************************/
+/****************************************/
+
+void buzzbitset_clear(buzzbitset_t s) {
+   memset(s->words, 0, s->nwords * sizeof(uint64_t));
+   s->count = 0;
+}
+
+/****************************************/
+/****************************************/
+
+int buzzbitset_add(buzzbitset_t s,
+                   uint32_t i) {
+   buzzbitset_reserve(s, BUZZBITSET_WORD(i));
+   uint64_t* w = s->words + BUZZBITSET_WORD(i);
+   if(*w & BUZZBITSET_BIT(i)) return 0;
+   *w |= BUZZBITSET_BIT(i);
+   ++s->count;
+   return 1;
+}
+
+/****************************************/
+/****************************************/
+
+int buzzbitset_remove(buzzbitset_t s,
+                      uint32_t i) {
+   if(!buzzbitset_has(s, i)) return 0;
+   s->words[BUZZBITSET_WORD(i)] &= ~BUZZBITSET_BIT(i);
+   --s->count;
+   return 1;
+}
+
+/****************************************/
+/****************************************/
+
+int buzzbitset_has(const buzzbitset_t s,
+                   uint32_t i) {
+   return BUZZBITSET_WORD(i) < s->nwords &&
+      (s->words[BUZZBITSET_WORD(i)] & BUZZBITSET_BIT(i)) != 0;
+}
+
+/****************************************/
+/****************************************/
+
+int64_t buzzbitset_next(const buzzbitset_t s,
+                        uint32_t i) {
+   uint32_t w = BUZZBITSET_WORD(i);
+   if(w >= s->nwords) return -1;
+   /* Drop the bits below i in the first word */
+   uint64_t x = s->words[w] & ~(BUZZBITSET_BIT(i) - 1);
+   while(!x) {
+      if(++w >= s->nwords) return -1;
+      x = s->words[w];
+   }
+   return ((int64_t)w << 6) + __builtin_ctzll(x);
+}
+
+/****************************************/
+/****************************************/
+
+int64_t buzzbitset_last(const buzzbitset_t s) {
+   if(!s->count) return -1;
+   uint32_t w = s->nwords;
+   while(!s->words[--w]);
+   return ((int64_t)w << 6) + 63 - __builtin_clzll(s->words[w]);
+}
+
+/****************************************/
+/****************************************/
+
+void buzzbitset_missing(const buzzbitset_t s,
+                        uint32_t n,
+                        buzzbitset_t out) {
+   buzzbitset_clear(out);
+   if(!n) return;
+   uint32_t last = BUZZBITSET_WORD(n - 1);
+   buzzbitset_reserve(out, last);
+   for(uint32_t w = 0; w <= last; ++w) {
+      uint64_t x = ~(w < s->nwords ? s->words[w] : 0);
+      /* Keep only the integers below n in the last word */
+      if(w == last && (n & 63)) x &= BUZZBITSET_BIT(n) - 1;
+      out->words[w] = x;
+      out->count += __builtin_popcountll(x);
+   }
+}
+
+/****************************************/
+/****************************************/
+
+void buzzbitset_tobytes(const buzzbitset_t s,
+                        uint32_t first,
+                        uint32_t n,
+                        uint8_t* out) {
+   for(uint32_t b = first; b < first + n; ++b) {
+      uint32_t w = b >> 3;
+      *out++ = (w < s->nwords) ? (uint8_t)(s->words[w] >> ((b & 7) * 8)) : 0;
+   }
+}
+
+/****************************************/
+/****************************************/
+
+void buzzbitset_frombytes(buzzbitset_t s,
+                          uint32_t first,
+                          const uint8_t* in,
+                          uint32_t n) {
+   if(!n) return;
+   buzzbitset_reserve(s, (first + n - 1) >> 3);
+   for(uint32_t b = first; b < first + n; ++b) {
+      uint64_t* w = s->words + (b >> 3);
+      uint64_t x = *w | ((uint64_t)*in++ << ((b & 7) * 8));
+      s->count += __builtin_popcountll(x ^ *w);
+      *w = x;
+   }
+}
+
+/****************************************/
+/****************************************/
@@ -0,0 +1,151 @@
+#ifndef BUZZBITSET_H
+#define BUZZBITSET_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+   /*
+    * Number of 64-bit words embedded in every bit set.
+    * Sets whose elements are all below 64 times this number do not
+    * allocate a separate buffer.
+    */
+#define BUZZBITSET_INLINE_WORDS 2
+
+   /*
+    * A set of small integers, such as the chunk indices of a blob,
+    * stored one bit per integer. The number of elements is kept up to
+    * date, and set operations work a 64-bit word at a time.
+    * The words point either to the inline storage or to a heap buffer,
+    * once the set has outgrown the inline storage.
+    */
+   struct buzzbitset_s {
+      uint64_t* words;  // Bit i is bit i%64 of word i/64
+      uint32_t nwords;  // Number of words
+      uint32_t count;   // Number of elements
+      uint64_t inl[BUZZBITSET_INLINE_WORDS];
+   };
+   typedef struct buzzbitset_s* buzzbitset_t;
+
+   /*
+    * Creates a new, empty bit set.
+    * @return A new bit set.
+    */
+   extern buzzbitset_t buzzbitset_new();
+
+   /*
+    * Creates a new bit set with the elements of the given one.
+    * @param s The bit set.
+    * @return A new bit set.
+    */
+   extern buzzbitset_t buzzbitset_clone(const buzzbitset_t s);
+
+   /*
+    * Destroys a bit set.
+    * @param s The bit set.
+    */
+   extern void buzzbitset_destroy(buzzbitset_t* s);
+
+   /*
+    * Removes all the elements of a bit set.
+    * @param s The bit set.
+    */
+   extern void buzzbitset_clear(buzzbitset_t s);
+
+   /*
+    * Adds an element to a bit set.
+    * @param s The bit set.
+    * @param i The element.
+    * @return 1 if the element was added, 0 if it was already there.
+    */
+   extern int buzzbitset_add(buzzbitset_t s,
+                             uint32_t i);
+
+   /*
+    * Removes an element from a bit set.
+    * @param s The bit set.
+    * @param i The element.
+    * @return 1 if the element was removed, 0 if it was not there.
+    */
+   extern int buzzbitset_remove(buzzbitset_t s,
+                                uint32_t i);
+
+   /*
+    * Returns 1 if the given element is in a bit set.
+    * @param s The bit set.
+    * @param i The element.
+    * @return 1 if the element is there, 0 otherwise.
+    */
+   extern int buzzbitset_has(const buzzbitset_t s,
+                             uint32_t i);
+
+   /*
+    * Returns the smallest element not smaller than the given one.
+    * @param s The bit set.
+    * @param i Where to start looking.
+    * @return The element, or -1 if there is none.
+    */
+   extern int64_t buzzbitset_next(const buzzbitset_t s,
+                                  uint32_t i);
+
+   /*
+    * Returns the largest element of a bit set.
+    * @param s The bit set.
+    * @return The element, or -1 if the set is empty.
+    */
+   extern int64_t buzzbitset_last(const buzzbitset_t s);
+
+   /*
+    * Puts in a bit set the integers below n missing from another.
+    * @param s The bit set.
+    * @param n The first integer not considered.
+    * @param out The bit set receiving the missing integers; it is cleared first.
+    */
+   extern void buzzbitset_missing(const buzzbitset_t s,
+                                  uint32_t n,
+                                  buzzbitset_t out);
+
+   /*
+    * Copies bytes of a bit set, in the order of their elements.
+    * Byte b holds the elements 8*b to 8*b+7, least significant bit first.
+    * @param s The bit set.
+    * @param first The first byte to copy.
+    * @param n The number of bytes to copy.
+    * @param out The buffer receiving the bytes.
+    */
+   extern void buzzbitset_tobytes(const buzzbitset_t s,
+                                  uint32_t first,
+                                  uint32_t n,
+                                  uint8_t* out);
+
+   /*
+    * Adds to a bit set the elements of bytes as made by buzzbitset_tobytes().
+    * @param s The bit set.
+    * @param first The byte the first given byte stands for.
+    * @param in The bytes.
+    * @param n The number of bytes.
+    */
+   extern void buzzbitset_frombytes(buzzbitset_t s,
+                                    uint32_t first,
+                                    const uint8_t* in,
+                                    uint32_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+/*
+ * Returns the number of elements of a bit set.
+ * @param s The bit set.
+ */
+#define buzzbitset_count(s) (s)->count
+
+/*
+ * Returns the number of bytes covering all the elements of a bit set.
+ * @param s The bit set.
+ */
+#define buzzbitset_nbytes(s) ((uint32_t)((buzzbitset_last(s) + 8) / 8))
+
+#endif
@@ -0,0 +1,53 @@
+#include "buzzblobbuf.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/****************************************/
+/****************************************/
+
+buzzblobbuf_t buzzblobbuf_new(uint32_t size) {
+   buzzblobbuf_t b = (buzzblobbuf_t)malloc(sizeof(struct buzzblobbuf_s));
+   /* Never hand out a NULL data pointer, even for empty buffers */
+   b->data = (uint8_t*)calloc(size > 0 ? size : 1, sizeof(uint8_t));
+   if(!b->data) {
+      fprintf(stderr, "[FATAL] Can't allocate blob buffer of %u bytes.\n", size);
+      abort();
+   }
+   b->size = size;
+   b->refs = 1;
+   return b;
+}
+
+/****************************************/
+/****************************************/
+
+buzzblobbuf_t buzzblobbuf_frombuffer(const void* data,
+                                     uint32_t size) {
+   buzzblobbuf_t b = buzzblobbuf_new(size);
+   if(size > 0) memcpy(b->data, data, size);
+   return b;
+}
+
+/****************************************/
+/****************************************/
+
+buzzblobbuf_t buzzblobbuf_ref(buzzblobbuf_t b) {
+   ++(b->refs);
+   return b;
+}
+
+/****************************************/
+/****************************************/
+
+void buzzblobbuf_unref(buzzblobbuf_t* b) {
+   if(!*b) return;
+   if(--((*b)->refs) == 0) {
+      free((*b)->data);
+      free(*b);
+   }
+   *b = NULL;
+}
+
+/****************************************/
+/****************************************/
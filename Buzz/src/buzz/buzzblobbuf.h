@@ -0,0 +1,65 @@
+#ifndef BUZZBLOBBUF_H
+#define BUZZBLOBBUF_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+   /*
+    * A reference-counted byte buffer.
+    * Blob objects, blob slots and blob chunks share one of these
+    * instead of copying the bytes; chunks are (offset,size) views into it.
+    */
+   struct buzzblobbuf_s {
+      uint8_t* data;  // The bytes
+      uint32_t size;  // Number of bytes
+      uint32_t refs;  // Number of owners
+   };
+   typedef struct buzzblobbuf_s* buzzblobbuf_t;
+
+   /*
+    * Creates a new buffer with one reference.
+    * The content of the buffer is zeroed.
+    * @param size The size of the buffer in bytes.
+    * @return A new buffer.
+    */
+   extern buzzblobbuf_t buzzblobbuf_new(uint32_t size);
+
+   /*
+    * Creates a new buffer with one reference, holding a copy of the given bytes.
+    * @param data The bytes to copy.
+    * @param size The number of bytes.
+    * @return A new buffer.
+    */
+   extern buzzblobbuf_t buzzblobbuf_frombuffer(const void* data,
+                                               uint32_t size);
+
+   /*
+    * Adds a reference to a buffer.
+    * @param b The buffer.
+    * @return The buffer.
+    */
+   extern buzzblobbuf_t buzzblobbuf_ref(buzzblobbuf_t b);
+
+   /*
+    * Drops a reference to a buffer.
+    * The buffer is freed when its last reference is dropped.
+    * The passed pointer is set to NULL.
+    * @param b The buffer.
+    */
+   extern void buzzblobbuf_unref(buzzblobbuf_t* b);
+
+#ifdef __cplusplus
+}
+#endif
+
+/*
+ * Returns a pointer to the byte at the given offset.
+ * @param b The buffer.
+ * @param off The offset.
+ */
+#define buzzblobbuf_at(b, off) ((b)->data + (off))
+
+#endif
@@ -0,0 +1,143 @@
+#include "buzzblobprio.h"
+#include <stdlib.h>
+
+/****************************************/
+/****************************************/
+
+static buzzblobprio_node_t buzzblobprio_node_new(uint8_t level) {
+   buzzblobprio_node_t n = (buzzblobprio_node_t)calloc(
+      1, sizeof(struct buzzblobprio_node_s) + level * sizeof(buzzblobprio_node_t));
+   n->level = level;
+   return n;
+}
+
+/* Entries with stat set first, then by priority, key and id */
+static uint64_t buzzblobprio_order(uint16_t id,
+                                   uint16_t key,
+                                   uint8_t priority,
+                                   uint8_t stat) {
+   return ((uint64_t)(stat ? 0 : 1) << 40) |
+      ((uint64_t)priority << 32) |
+      ((uint64_t)key << 16) |
+      id;
+}
+
+/* Picks the level of a new entry, each level being 4 times sparser */
+static uint8_t buzzblobprio_level(buzzblobprio_t l) {
+   /* xorshift32 */
+   l->rng ^= l->rng << 13;
+   l->rng ^= l->rng >> 17;
+   l->rng ^= l->rng << 5;
+   uint32_t r = l->rng;
+   uint8_t level = 1;
+   while(level < BUZZBLOBPRIO_MAXLEVEL && (r & 3) == 0) {
+      ++level;
+      r >>= 2;
+   }
+   return level;
+}
+
+/* Finds the last entry before the given order, at each level */
+static void buzzblobprio_find(buzzblobprio_t l,
+                              uint64_t order,
+                              buzzblobprio_node_t* pred) {
+   buzzblobprio_node_t x = l->head;
+   for(int i = l->level - 1; i >= 0; --i) {
+      while(x->next[i] && x->next[i]->order < order) x = x->next[i];
+      pred[i] = x;
+   }
+}
+
+static void buzzblobprio_link(buzzblobprio_t l,
+                              buzzblobprio_node_t n) {
+   buzzblobprio_node_t pred[BUZZBLOBPRIO_MAXLEVEL];
+   buzzblobprio_find(l, n->order, pred);
+   while(l->level < n->level) pred[l->level++] = l->head;
+   for(int i = 0; i < n->level; ++i) {
+      n->next[i] = pred[i]->next[i];
+      pred[i]->next[i] = n;
+   }
+   ++l->size;
+}
+
+static void buzzblobprio_unlink(buzzblobprio_t l,
+                                buzzblobprio_node_t n) {
+   buzzblobprio_node_t pred[BUZZBLOBPRIO_MAXLEVEL];
+   buzzblobprio_find(l, n->order, pred);
+   for(int i = 0; i < n->level; ++i)
+      if(pred[i]->next[i] == n) pred[i]->next[i] = n->next[i];
+   while(l->level > 1 && !l->head->next[l->level - 1]) --l->level;
+   --l->size;
+}
+
+/****************************************/
+/****************************************/
+
+buzzblobprio_t buzzblobprio_new() {
+   buzzblobprio_t l = (buzzblobprio_t)calloc(1, sizeof(struct buzzblobprio_s));
+   l->head = buzzblobprio_node_new(BUZZBLOBPRIO_MAXLEVEL);
+   l->level = 1;
+   l->rng = 2463534242u;
+   return l;
+}
+
+/****************************************/
+/****************************************/
+
+void buzzblobprio_destroy(buzzblobprio_t* l) {
+   buzzblobprio_node_t n = (*l)->head;
+   while(n) {
+      buzzblobprio_node_t next = n->next[0];
+      free(n);
+      n = next;
+   }
+   free(*l);
+   *l = NULL;
+}
+
+/****************************************/
+/****************************************/
+
+buzzblobprio_node_t buzzblobprio_insert(buzzblobprio_t l,
+                                        uint16_t id,
+                                        uint16_t key,
+                                        uint8_t priority,
+                                        uint8_t stat) {
+   buzzblobprio_node_t n = buzzblobprio_node_new(buzzblobprio_level(l));
+   n->list = l;
+   n->id = id;
+   n->key = key;
+   n->priority = priority;
+   n->stat = stat ? 1 : 0;
+   n->order = buzzblobprio_order(id, key, priority, stat);
+   buzzblobprio_link(l, n);
+   return n;
+}
+
+/****************************************/
+/****************************************/
+
+void buzzblobprio_remove(buzzblobprio_node_t* n) {
+   if(!*n) return;
+   buzzblobprio_unlink((*n)->list, *n);
+   free(*n);
+   *n = NULL;
+}
+
+/****************************************/
+/****************************************/
+
+void buzzblobprio_update(buzzblobprio_node_t n,
+                         uint8_t priority,
+                         uint8_t stat) {
+   uint64_t order = buzzblobprio_order(n->id, n->key, priority, stat);
+   if(order == n->order) return;
+   buzzblobprio_unlink(n->list, n);
+   n->priority = priority;
+   n->stat = stat ? 1 : 0;
+   n->order = order;
+   buzzblobprio_link(n->list, n);
+}
+
+/****************************************/
+/****************************************/
@@ -0,0 +1,123 @@
+#ifndef BUZZBLOBPRIO_H
+#define BUZZBLOBPRIO_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+   /*
+    * Maximum number of levels of the eviction order.
+    */
+#define BUZZBLOBPRIO_MAXLEVEL 16
+
+   /*
+    * An entry of the eviction order, for the blob (id,key).
+    */
+   struct buzzblobprio_node_s {
+      uint64_t order;                // Sort key made of (stat,priority,key,id)
+      struct buzzblobprio_s* list;   // The order this entry belongs to
+      uint16_t id;                   // Blob stigmergy id
+      uint16_t key;                  // Blob key
+      uint8_t priority;              // Blob priority
+      uint8_t stat;                  // 1 if the blob goes first regardless of priority
+      uint8_t level;                 // Number of links
+      struct buzzblobprio_node_s* next[]; // Next entry, per level
+   };
+   typedef struct buzzblobprio_node_s* buzzblobprio_node_t;
+
+   /*
+    * The order in which blobs are evicted when space must be made.
+    * Entries with stat set come first, then entries by increasing
+    * priority, key and id. It is a skip list, kept up to date as blobs
+    * come and go: looking for the next victim is O(1), adding, removing
+    * or reprioritizing a blob is O(log n).
+    */
+   struct buzzblobprio_s {
+      buzzblobprio_node_t head; // Sentinel, with BUZZBLOBPRIO_MAXLEVEL links
+      uint32_t size;            // Number of entries
+      uint8_t level;            // Number of levels in use
+      uint32_t rng;             // State of the level generator
+   };
+   typedef struct buzzblobprio_s* buzzblobprio_t;
+
+   /*
+    * Creates a new, empty eviction order.
+    * @return A new eviction order.
+    */
+   extern buzzblobprio_t buzzblobprio_new();
+
+   /*
+    * Destroys an eviction order.
+    * The entries still in it are freed.
+    * @param l The eviction order.
+    */
+   extern void buzzblobprio_destroy(buzzblobprio_t* l);
+
+   /*
+    * Adds a blob to the eviction order.
+    * The blob (id,key) must not be in the order already.
+    * @param l The eviction order.
+    * @param id The blob stigmergy id.
+    * @param key The blob key.
+    * @param priority The blob priority.
+    * @param stat 1 if the blob goes first regardless of priority.
+    * @return The new entry.
+    */
+   extern buzzblobprio_node_t buzzblobprio_insert(buzzblobprio_t l,
+                                                  uint16_t id,
+                                                  uint16_t key,
+                                                  uint8_t priority,
+                                                  uint8_t stat);
+
+   /*
+    * Removes an entry from its eviction order and frees it.
+    * The passed pointer is set to NULL. Nothing is done if it is NULL.
+    * @param n The entry.
+    */
+   extern void buzzblobprio_remove(buzzblobprio_node_t* n);
+
+   /*
+    * Moves an entry to the place matching a new priority and stat.
+    * @param n The entry.
+    * @param priority The new blob priority.
+    * @param stat The new stat.
+    */
+   extern void buzzblobprio_update(buzzblobprio_node_t n,
+                                   uint8_t priority,
+                                   uint8_t stat);
+
+#ifdef __cplusplus
+}
+#endif
+
+/*
+ * Returns the first entry of the eviction order, NULL if it is empty.
+ * @param l The eviction order.
+ * @return The first entry.
+ */
+#define buzzblobprio_first(l) ((l)->head->next[0])
+
+/*
+ * Returns the entry after the given one, NULL if it is the last.
+ * @param n The entry.
+ * @return The next entry.
+ */
+#define buzzblobprio_next(n) ((n)->next[0])
+
+/*
+ * Returns the number of entries of the eviction order.
+ * @param l The eviction order.
+ * @return The number of entries.
+ */
+#define buzzblobprio_size(l) ((l)->size)
+
+/*
+ * Returns <tt>true</tt> if the eviction order is empty.
+ * @param l The eviction order.
+ * @return <tt>true</tt> if the eviction order is empty.
+ */
+#define buzzblobprio_isempty(l) ((l)->size == 0)
+
+#endif
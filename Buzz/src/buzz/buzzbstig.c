@@ -1,9 +1,12 @@
 #include "buzzbstig.h"
+#include "buzzlz4.h"
+#include "buzzrs.h"
 #include "buzzmsg.h"
 #include "buzzvm.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <pthread.h>
 
 /****************************************/
 /****************************************/
@@ -57,21 +60,72 @@ int buzzbstig_key_cmp(const void* a, const void* b) {
 /****************************************/
 /****************************************/
 
+buzzblobbuf_t buzzbstig_blob_buffer(buzzobj_t blob, uint32_t* offset, uint32_t* size) {
+   /* Blobs already own a buffer: share it */
+   if(blob->o.type == BUZZTYPE_BLOB) {
+      *offset = blob->b.value.data - blob->b.value.buf->data;
+      *size = blob->b.value.size;
+      return buzzblobbuf_ref(blob->b.value.buf);
+   }
+   /* Strings are kept for older scripts and copied once */
+   *offset = 0;
+   *size = strlen(blob->s.value.str);
+   return buzzblobbuf_frombuffer(blob->s.value.str, *size);
+}
+
+/****************************************/
+/****************************************/
+
 buzzblob_chunk_t buzzbstig_chunk_new(uint32_t hash, // Hash of chunk
-                                     char* chunk) {
+                                     const char* chunk,
+                                     uint16_t size) {
+   buzzblobbuf_t b = buzzblobbuf_frombuffer(chunk, size);
+   buzzblob_chunk_t e = buzzbstig_chunk_view(hash, b, 0, size);
+   buzzblobbuf_unref(&b);
+   return e;
+}
+
+/****************************************/
+/****************************************/
+
+buzzblob_chunk_t buzzbstig_chunk_view(uint32_t hash,
+                                      buzzblobbuf_t buf,
+                                      uint32_t offset,
+                                      uint16_t size) {
    buzzblob_chunk_t e = (buzzblob_chunk_t)malloc(sizeof(struct buzzblob_chunk_s));
    e->hash = hash;
-   uint32_t len = strlen(chunk);
-   char* chunk_cpy = (char*)malloc(len * sizeof(char) + 1);
-   if (len > 0) memcpy(chunk_cpy, chunk, len * sizeof(char));
-   *(chunk_cpy + len)=0;
-   e->chunk = chunk_cpy;
+   e->buf = buzzblobbuf_ref(buf);
+   e->chunk = (char*)buzzblobbuf_at(buf, offset);
+   e->size = size;
+   e->status = BUZZCHUNK_READY;
+   e->hashalgo = BUZZBSTIG_CHECKSUM_MD5;
    return e;
 }
 
 /****************************************/
 /****************************************/
 
+buzzblob_chunk_t buzzbstig_chunk_share(const buzzblob_chunk_t c) {
+   buzzblob_chunk_t e = buzzbstig_chunk_view(c->hash,
+                                             c->buf,
+                                             (uint8_t*)c->chunk - c->buf->data,
+                                             c->size);
+   e->hashalgo = c->hashalgo;
+   return e;
+}
+
+/****************************************/
+/****************************************/
+
+void buzzbstig_chunk_destroy(buzzblob_chunk_t* c) {
+   buzzblobbuf_unref(&((*c)->buf));
+   free(*c);
+   *c = NULL;
+}
+
+/****************************************/
+/****************************************/
+
 buzzbstig_elem_t buzzbstig_elem_new(buzzobj_t data,
                                     uint16_t timestamp,
                                     uint16_t robot) {
@@ -86,22 +140,20 @@ buzzbstig_elem_t buzzbstig_elem_new(buzzobj_t data,
 /****************************************/
 
 void buzzblob_slot_destroy(const void* key, void* data, void* params) {
-   free((void*)key);
+   buzzblobprio_remove( &((*(buzzblob_elem_t*)data)->prio) );
    buzzdict_destroy( &((*(buzzblob_elem_t*)data)->data) );
-   buzzdarray_destroy( &((*(buzzblob_elem_t*)data)->available_list) );
+   buzzbitset_destroy( &((*(buzzblob_elem_t*)data)->available) );
    buzzdarray_destroy( &((*(buzzblob_elem_t*)data)->locations) );
+   buzzblobbuf_unref( &((*(buzzblob_elem_t*)data)->buf) );
+   buzzblobbuf_unref( &((*(buzzblob_elem_t*)data)->raw) );
    free(*(buzzblob_elem_t*)data);
-   free(data);
 }
 
 /****************************************/
 /****************************************/
 
 void buzzblob_chunk_destroy(const void* key, void* data, void* params) {
-   free((void*)key);
-   free((*(buzzblob_chunk_t*)data)->chunk);
-   free(*(buzzblob_chunk_t*)data);
-   free(data);
+   buzzbstig_chunk_destroy((buzzblob_chunk_t*)data);
 }
 
 void buzzblob_location_destroy(uint32_t pos, void* data, void* params) {
@@ -111,7 +163,7 @@ void buzzblob_location_destroy(uint32_t pos, void* data, void* params) {
 /****************************************/
 /****************************************/
 
-buzzblob_elem_t buzzchunk_slot_new(uint32_t hash, uint32_t size) {
+buzzblob_elem_t buzzchunk_slot_new(uint32_t hash, uint32_t size, uint16_t chunk_size, uint8_t parity) {
    buzzblob_elem_t x = (buzzblob_elem_t)malloc(sizeof(struct buzzblob_elem_s));
    x->data = buzzdict_new(
       10,
@@ -122,16 +174,38 @@ buzzblob_elem_t buzzchunk_slot_new(uint32_t hash, uint32_t size) {
       buzzblob_chunk_destroy);
    x->hash=hash;
    x->size=size;
-   x->available_list = buzzdarray_new(10, sizeof(uint16_t),
-                                          NULL);
+   x->chunk_size=chunk_size;
+   x->parity=parity;
+   x->available = buzzbitset_new();
    x->locations = buzzdarray_new(10, sizeof(buzzblob_location_t),
                                           buzzblob_location_destroy);
    x->priority = 1;
    x->status=BUZZBLOB_BUFFERING;
    x->relocstate=BUZZBLOB_OPEN; 
+   x->buf = NULL;
+   x->codec = BUZZBLOB_CODEC_UNKNOWN;
+   x->raw_size = size;
+   x->raw = NULL;
+   buzzbstig_checksum_init(&(x->hashctx), buzzbstig_checksum_default());
+   x->hash_next = 0;
+   x->hash_status = BUZZBLOB_HASH_STREAMING;
+   x->prio = NULL;
    return x;
 }
 
+/****************************************/
+/****************************************/
+
+void buzzbstig_blob_store(buzzvm_t vm,
+                          buzzdict_t s,
+                          uint16_t id,
+                          uint16_t key,
+                          buzzblob_elem_t blob) {
+   /* Replacing a slot unlinks the old one from the eviction order */
+   buzzdict_set(s, &key, &blob);
+   blob->prio = buzzblobprio_insert(vm->blobprio, id, key, blob->priority, 0);
+}
+
 /****************************************/
 /****************************************/
 buzzdict_t buzzbstig_blob_slot_new(){
@@ -157,8 +231,9 @@ void buzz_blob_slot_holders_new(buzzvm_t vm, uint16_t id, uint16_t k, uint32_t b
          buzzdict_remove(*s, &(k));
       } 
       /* create new blob chunk slot */
-      buzzblob_elem_t blb = buzzchunk_slot_new(hash, blob_size);
-      buzzdict_set(*s, &(k), &blb);
+      buzzblob_elem_t blb = buzzchunk_slot_new(hash, blob_size, buzzbstig_chunk_size(vm, id),
+                                               buzzbstig_blob_parity(vm, id, blob_size));
+      buzzbstig_blob_store(vm, *s, id, k, blb);
       /* Create chunk stigmergy */
       //buzzbstig_create_generic(vm, k->i.value);
       /* Look for chunk stig for refreshing */ /* has to be just the key */
@@ -173,12 +248,44 @@ void buzz_blob_slot_holders_new(buzzvm_t vm, uint16_t id, uint16_t k, uint32_t b
 /****************************************/
 /****************************************/
 
+/*
+ * Compresses a blob.
+ * Returns NULL if the compressed blob would not be smaller.
+ */
+static buzzblobbuf_t buzzbstig_blob_compress(buzzblobbuf_t raw) {
+   if(raw->size < 2) return NULL;
+   buzzblobbuf_t enc = buzzblobbuf_new(raw->size - 1);
+   uint32_t enc_size = buzzlz4_compress(raw->data, raw->size, enc->data, enc->size);
+   if(enc_size == 0) {
+      buzzblobbuf_unref(&enc);
+      return NULL;
+   }
+   enc->size = enc_size;
+   return enc;
+}
+
+/****************************************/
+/****************************************/
+
 buzzbstig_elem_t buzzbstig_blob_elem_new(buzzvm_t vm, uint16_t id, buzzobj_t k, buzzobj_t data,
                                     uint16_t timestamp,
                                     uint16_t robot) {
    buzzbstig_elem_t e = (buzzbstig_elem_t)malloc(sizeof(struct buzzbstig_elem_s));
-   /* Hash the blob*/
-   uint32_t* hash = buzzbstig_md5(data->s.value.str, strlen(data->s.value.str));
+   /* Get the blob bytes, rebased so that the buffer starts at the first blob byte */
+   uint32_t blb_off, blb_size;
+   buzzblobbuf_t blb_buf = buzzbstig_blob_buffer(data, &blb_off, &blb_size);
+   if(blb_off > 0) {
+      buzzblobbuf_t rebased = buzzblobbuf_frombuffer(buzzblobbuf_at(blb_buf, blb_off), blb_size);
+      buzzblobbuf_unref(&blb_buf);
+      blb_buf = rebased;
+   }
+   /* Compress the blob if that makes it smaller */
+   const buzzbstig_t* vs = buzzdict_get(vm->bstigs, &id, buzzbstig_t);
+   buzzblobbuf_t enc_buf = (vs && (*vs)->compress) ? buzzbstig_blob_compress(blb_buf) : NULL;
+   buzzblobbuf_t stored = enc_buf ? enc_buf : blb_buf;
+   /* Hash the bytes that travel, so that receivers can verify them as they arrive */
+   uint8_t algo = buzzbstig_checksum_default();
+   uint32_t hash = buzzbstig_checksum(algo, stored->data, stored->size);
    // char hash_buffer[9];
    // sprintf(hash_buffer,"%8X",hash[0]);
    /* Store the hash of the blob */
@@ -186,17 +293,24 @@ buzzbstig_elem_t buzzbstig_blob_elem_new(buzzvm_t vm, uint16_t id, buzzobj_t k,
    e->data = hash_k;
    e->timestamp = timestamp;
    e->robot = robot;
-   hash_k->i.value = hash[0];
+   hash_k->i.value = hash;
    //uint16_t id = k->i.value; 
-   buzz_blob_slot_holders_new(vm,id,k->i.value,strlen(data->s.value.str),hash_k->i.value);
+   buzz_blob_slot_holders_new(vm,id,k->i.value,stored->size,hash_k->i.value);
    /* Get the blob location from its slot */
    buzzdict_t s = *(buzzdict_get(vm->blobs, &id, buzzdict_t));
    /* Look for blob key in blob bstig slot*/
    buzzblob_elem_t blb = *(buzzdict_get(s, &(k->i.value), buzzblob_elem_t));
+   /* The slot owns the blob bytes, just hashed; chunks are views into them */
+   blb->buf = stored;
+   blb->codec = enc_buf ? BUZZBLOB_CODEC_LZ4 : BUZZBLOB_CODEC_NONE;
+   blb->raw_size = blb_size;
+   /* Keep the decoded blob around for local gets */
+   blb->raw = enc_buf ? blb_buf : NULL;
+   blb->hashctx.algo = algo;
+   blb->hash_status = BUZZBLOB_HASH_VERIFIED;
    /* Chunk the blob into fragments and add it into respective data slots */
    buzzblob_split_put_bstig(vm, id, data, blb, k, e);
    fprintf(stderr, "[DEBUG] [ROBOT %u] my image hash : %u \n", vm->robot, hash_k->i.value);
-   free(hash);
    return e;
 }
 
@@ -215,9 +329,7 @@ buzzbstig_elem_t buzzbstig_elem_clone(buzzvm_t vm, const buzzbstig_elem_t e) {
 /****************************************/
 
 void buzzbstig_elem_destroy(const void* key, void* data, void* params) {
-   free((void*)key);
    free(*(buzzbstig_elem_t*)data);
-   free(data);
 }
 
 /****************************************/
@@ -235,6 +347,13 @@ buzzbstig_t buzzbstig_new() {
    x->getter = BUZZBLOB_GETTER_OPEN;
    x->onconflict = NULL;
    x->onconflictlost = NULL;
+   x->chunk_size = BLOB_CHUNK_SIZE;
+   x->max_chunks = MAX_BLOB_CHUNKS;
+   x->reloc_hi = RELOCATION_OF_CHUNKS_AT;
+   x->reloc_lo = STOP_RELOCATION_AT;
+   x->saturated = 0;
+   x->compress = 1;
+   x->parity = 0;
    return x;
 }
 
@@ -287,13 +406,27 @@ int64_t buzzbstig_elem_deserialize(buzzobj_t* key,
 }
 
 void buzzbstig_chunk_serialize(buzzmsg_payload_t buf, buzzblob_chunk_t cdata){
-   buzzmsg_serialize_string(buf, cdata->chunk);
+   /* Checksum algorithm, length, then the raw bytes */
+   buzzmsg_serialize_u8(buf, cdata->hashalgo);
+   buzzmsg_serialize_u16(buf, cdata->size);
+   buzzmsg_payload_append(buf, cdata->chunk, cdata->size);
 }
 
-int64_t buzzbstig_chunk_deserialize(char** cdata,
-                                     buzzmsg_payload_t buf,
-                                     uint32_t pos){
- return buzzmsg_deserialize_string(cdata,buf,pos);
+int64_t buzzbstig_chunk_deserialize(buzzblob_chunk_t cdata,
+                                    buzzmsg_payload_t buf,
+                                    uint32_t pos){
+   /* Make sure there are enough bytes to read the algorithm and length */
+   if(pos + sizeof(uint8_t) + sizeof(uint16_t) > buzzmsg_payload_size(buf)) return -1;
+   int64_t p = buzzmsg_deserialize_u8(&(cdata->hashalgo), buf, pos);
+   if(cdata->hashalgo >= BUZZBSTIG_CHECKSUM_COUNT) return -1;
+   p = buzzmsg_deserialize_u16(&(cdata->size), buf, p);
+   /* Make sure there are enough bytes to read the chunk itself */
+   if(p + cdata->size > buzzmsg_payload_size(buf)) return -1;
+   cdata->buf = buzzblobbuf_frombuffer(buf->data + p, cdata->size);
+   cdata->chunk = (char*)cdata->buf->data;
+   cdata->hash = 0;
+   cdata->status = BUZZCHUNK_READY;
+   return p + cdata->size;
 }
 /****************************************/
 /****************************************/
@@ -340,15 +473,64 @@ void buzzbstig_create_generic(buzzvm_t vm, uint16_t id){
 /****************************************/
 /****************************************/
 
+#define param_get(FIELD, MIN, MAX)                                   \
+   buzzvm_lload(vm, 2);                                              \
+   buzzvm_pushs(vm, buzzvm_string_register(vm, #FIELD, 1));          \
+   buzzvm_tget(vm);                                                  \
+   if(buzzvm_stack_at(vm, 1)->o.type != BUZZTYPE_NIL) {              \
+      buzzvm_type_assert(vm, 1, BUZZTYPE_INT);                       \
+      int32_t val = buzzvm_stack_at(vm, 1)->i.value;                 \
+      if(val < (MIN) || val > (MAX)) {                               \
+         buzzvm_seterror(vm,                                         \
+                         BUZZVM_ERROR_TYPE,                          \
+                         #FIELD " must be in [%d,%d], got %d",       \
+                         (MIN), (MAX), val);                         \
+         return vm->state;                                           \
+      }                                                              \
+      FIELD = val;                                                   \
+   }                                                                 \
+   buzzvm_pop(vm);
+
 int buzzbstig_create(buzzvm_t vm) {
-   buzzvm_lnum_assert(vm, 1);
+   if(buzzvm_lnum(vm) != 1 && buzzvm_lnum(vm) != 2) {
+      buzzvm_seterror(vm,
+                      BUZZVM_ERROR_LNUM,
+                      "expected 1 or 2 parameters, got %" PRId64,
+                      buzzvm_lnum(vm));
+      return vm->state;
+   }
    /* Get bstig id */
    buzzvm_lload(vm, 1);
    buzzvm_type_assert(vm, 1, BUZZTYPE_INT);
    uint16_t id = buzzvm_stack_at(vm, 1)->i.value;
    buzzvm_pop(vm);
+   /* Get the optional parameters */
+   int32_t chunk_size = BLOB_CHUNK_SIZE;
+   int32_t max_chunks = MAX_BLOB_CHUNKS;
+   int32_t reloc_hi = RELOCATION_OF_CHUNKS_AT;
+   int32_t reloc_lo = STOP_RELOCATION_AT;
+   int32_t compress = 1;
+   int32_t parity = 0;
+   if(buzzvm_lnum(vm) == 2) {
+      buzzvm_lload(vm, 2);
+      buzzvm_type_assert(vm, 1, BUZZTYPE_TABLE);
+      buzzvm_pop(vm);
+      param_get(chunk_size, 1, MAX_UINT16);
+      param_get(max_chunks, 0, MAX_UINT16);
+      param_get(reloc_hi, 0, 100);
+      param_get(reloc_lo, 0, reloc_hi);
+      param_get(compress, 0, 1);
+      param_get(parity, 0, BUZZRS_MAXPIECES - 1);
+   }
    /* Call the generic function to register with vm */
    buzzbstig_create_generic(vm,id);
+   buzzbstig_t vs = *buzzdict_get(vm->bstigs, &id, buzzbstig_t);
+   vs->chunk_size = chunk_size;
+   vs->max_chunks = max_chunks;
+   vs->reloc_hi = reloc_hi;
+   vs->reloc_lo = reloc_lo;
+   vs->compress = compress;
+   vs->parity = parity;
    /* Create a table */
    buzzvm_pusht(vm);
    /* Add data and methods */
@@ -374,6 +556,137 @@ int buzzbstig_create(buzzvm_t vm) {
 /****************************************/
 /****************************************/
 
+uint16_t buzzbstig_chunk_size(buzzvm_t vm, uint16_t id) {
+   const buzzbstig_t* vs = buzzdict_get(vm->bstigs, &id, buzzbstig_t);
+   return vs ? (*vs)->chunk_size : BLOB_CHUNK_SIZE;
+}
+
+/****************************************/
+/****************************************/
+
+uint16_t buzzbstig_max_chunks(buzzvm_t vm, uint16_t id) {
+   const buzzbstig_t* vs = buzzdict_get(vm->bstigs, &id, buzzbstig_t);
+   return vs ? (*vs)->max_chunks : MAX_BLOB_CHUNKS;
+}
+
+/****************************************/
+/****************************************/
+
+int buzzbstig_bid_space(buzzvm_t vm, uint16_t id) {
+   const buzzbstig_t* vs = buzzdict_get(vm->bstigs, &id, buzzbstig_t);
+   if(!vs) return MAX_BLOB_CHUNKS - (int64_t)(vm->cmonitor->chunknum);
+   /* Update the storage state, with hysteresis between the thresholds */
+   uint64_t used = vm->cmonitor->chunknum * 100;
+   if(used >= (uint64_t)(*vs)->reloc_hi * (*vs)->max_chunks)
+      (*vs)->saturated = 1;
+   else if(used <= (uint64_t)(*vs)->reloc_lo * (*vs)->max_chunks)
+      (*vs)->saturated = 0;
+   if((*vs)->saturated) return 0;
+   return (*vs)->max_chunks - (int64_t)(vm->cmonitor->chunknum);
+}
+
+/****************************************/
+/****************************************/
+
+uint8_t buzzbstig_blob_parity(buzzvm_t vm, uint16_t id, uint32_t size) {
+   const buzzbstig_t* vs = buzzdict_get(vm->bstigs, &id, buzzbstig_t);
+   if(!vs || !(*vs)->parity) return 0;
+   uint32_t k = (size + (*vs)->chunk_size - 1) / (*vs)->chunk_size;
+   /* The code has room for BUZZRS_MAXPIECES pieces in all */
+   return (k > 0 && k + (*vs)->parity <= BUZZRS_MAXPIECES) ? (*vs)->parity : 0;
+}
+
+/****************************************/
+/****************************************/
+
+uint16_t buzzbstig_blob_chunk_num(buzzblob_elem_t v_blob) {
+   return buzzbstig_blob_data_chunk_num(v_blob) + v_blob->parity;
+}
+
+/****************************************/
+/****************************************/
+
+uint16_t buzzbstig_blob_data_chunk_num(buzzblob_elem_t v_blob) {
+   return (v_blob->size + v_blob->chunk_size - 1) / v_blob->chunk_size;
+}
+
+/****************************************/
+/****************************************/
+
+/* Size of a chunk: data chunks cover the blob, parity chunks are full */
+static uint32_t buzzbstig_blob_chunk_len(buzzblob_elem_t v_blob, uint16_t cid) {
+   if(cid >= buzzbstig_blob_data_chunk_num(v_blob)) return v_blob->chunk_size;
+   uint32_t len = v_blob->size - (uint32_t)cid * v_blob->chunk_size;
+   return (len > v_blob->chunk_size) ? v_blob->chunk_size : len;
+}
+
+/* Returns the chunk if it is stored with its bytes, NULL if missing or a dummy */
+static buzzblob_chunk_t buzzbstig_blob_chunk_get(buzzblob_elem_t v_blob, uint16_t cid) {
+   const buzzblob_chunk_t* cdata = buzzdict_get(v_blob->data, &cid, buzzblob_chunk_t);
+   if(!cdata || (*cdata)->size != buzzbstig_blob_chunk_len(v_blob, cid)) return NULL;
+   return *cdata;
+}
+
+/****************************************/
+/****************************************/
+
+int buzzbstig_blob_complete(buzzblob_elem_t v_blob) {
+   uint16_t chunk_num = buzzbstig_blob_chunk_num(v_blob);
+   if(!v_blob->parity) return buzzdict_size(v_blob->data) == chunk_num;
+   uint16_t need = buzzbstig_blob_data_chunk_num(v_blob);
+   uint16_t have = 0;
+   for(uint16_t i = 0; i < chunk_num && have < need; ++i)
+      if(buzzbstig_blob_chunk_get(v_blob, i)) ++have;
+   return have == need;
+}
+
+/****************************************/
+/****************************************/
+
+void buzzbstig_blob_codec_serialize(buzzmsg_payload_t buf,
+                                    uint8_t codec,
+                                    uint32_t raw_size) {
+   buzzmsg_serialize_u8(buf, codec);
+   if(codec != BUZZBLOB_CODEC_NONE && codec != BUZZBLOB_CODEC_UNKNOWN)
+      buzzmsg_serialize_u32(buf, raw_size);
+}
+
+/****************************************/
+/****************************************/
+
+int64_t buzzbstig_blob_codec_deserialize(uint8_t* codec,
+                                         uint32_t* raw_size,
+                                         buzzmsg_payload_t buf,
+                                         int64_t pos) {
+   if(pos < 0) return -1;
+   pos = buzzmsg_deserialize_u8(codec, buf, pos);
+   if(pos < 0) return -1;
+   *raw_size = 0;
+   if(*codec == BUZZBLOB_CODEC_NONE || *codec == BUZZBLOB_CODEC_UNKNOWN) return pos;
+   if(*codec >= BUZZBLOB_CODEC_COUNT) return -1;
+   return buzzmsg_deserialize_u32(raw_size, buf, pos);
+}
+
+/****************************************/
+/****************************************/
+
+void buzzbstig_blob_set_codec(buzzvm_t vm,
+                              uint16_t id,
+                              uint16_t key,
+                              uint8_t codec,
+                              uint32_t raw_size) {
+   if(codec == BUZZBLOB_CODEC_UNKNOWN) return;
+   const buzzdict_t* s = buzzdict_get(vm->blobs, &id, buzzdict_t);
+   if(!s) return;
+   const buzzblob_elem_t* v_blob = buzzdict_get(*s, &key, buzzblob_elem_t);
+   if(!v_blob || (*v_blob)->codec != BUZZBLOB_CODEC_UNKNOWN) return;
+   (*v_blob)->codec = codec;
+   (*v_blob)->raw_size = (codec == BUZZBLOB_CODEC_NONE) ? (*v_blob)->size : raw_size;
+}
+
+/****************************************/
+/****************************************/
+
 void buzzbstig_put_generic(buzzvm_t vm, uint16_t id, buzzobj_t k, buzzobj_t v){            
    /* Look for blob stigmergy */                            
    const buzzbstig_t* vs = buzzdict_get(vm->bstigs, &id, buzzbstig_t);  
@@ -442,9 +755,11 @@ int buzzbstig_putblob(buzzvm_t vm) {
    /* Get key */
    buzzvm_lload(vm, 1);
    buzzobj_t k = buzzvm_stack_at(vm, 1);
-   /* Get value */
+   /* Get value, which must be nil, a blob or a string */
    buzzvm_lload(vm, 2);
    buzzobj_t v = buzzvm_stack_at(vm, 1);
+   if(v->o.type != BUZZTYPE_NIL && v->o.type != BUZZTYPE_STRING)
+      buzzvm_type_assert(vm, 1, BUZZTYPE_BLOB);
    /* Look for blob stigmergy */
    const buzzbstig_t* vs = buzzdict_get(vm->bstigs, &id, buzzbstig_t);
    if(vs) {
@@ -496,8 +811,7 @@ int buzzbstig_putblob(buzzvm_t vm) {
                blb = buzzdict_get(*s, &(k->i.value), buzzblob_elem_t);
             }
             if(blb){
-               (vm->cmonitor->chunknum)-= buzzdarray_size((*blb)->available_list);
-               //buzzdarray_clear((*blb)->available_list, 10);
+               (vm->cmonitor->chunknum)-= buzzbitset_count((*blb)->available);
                buzzdict_remove(*s,&(k->i.value));
                printf("buzz removed key \n");
 
@@ -505,6 +819,15 @@ int buzzbstig_putblob(buzzvm_t vm) {
          }        
       }
       else if(v->o.type != BUZZTYPE_NIL) {
+         /* Chunk ids are 16-bit, refuse blobs that need more chunks */
+         uint64_t blb_size = (v->o.type == BUZZTYPE_BLOB) ? v->b.value.size : strlen(v->s.value.str);
+         if((blb_size + (*vs)->chunk_size - 1) / (*vs)->chunk_size > MAX_UINT16) {
+            buzzvm_seterror(vm,
+                            BUZZVM_ERROR_TYPE,
+                            "blob of %" PRIu64 " bytes needs more than %d chunks of %u bytes",
+                            blb_size, MAX_UINT16, (*vs)->chunk_size);
+            return vm->state;
+         }
          /* Element not found and new value is not nil, store it */
          buzzbstig_elem_t y = buzzbstig_blob_elem_new(vm, id, k, v, 1, vm->robot);
          buzzbstig_store(*vs, &k, &y);
@@ -643,6 +966,48 @@ int buzzbstig_get(buzzvm_t vm) {
 }
 
 
+/****************************************/
+/****************************************/
+
+void buzzbstig_blob_fetch(buzzvm_t vm,
+                          uint16_t id,
+                          uint16_t key,
+                          buzzblob_elem_t v_blob,
+                          uint16_t requester,
+                          const buzzbitset_t have) {
+   uint16_t first = 0, count = 0;
+   uint8_t want[MAX_CHUNKS_IN_BLOB_REQUEST / 8];
+   /* Without the requester's chunks, ask for everything */
+   const buzzbitset_t held = (requester == vm->robot) ? v_blob->available : have;
+   if(held) {
+      uint16_t chunk_num = buzzbstig_blob_chunk_num(v_blob);
+      buzzbitset_t miss = buzzbitset_new();
+      buzzbitset_missing(held, chunk_num, miss);
+      if(!buzzbitset_count(miss)) {
+         buzzbitset_destroy(&miss);
+         return;
+      }
+      /* Name the missing chunks unless they are all missing or too spread */
+      first = buzzbitset_next(miss, 0) & ~7;
+      uint16_t last = buzzbitset_last(miss);
+      if(buzzbitset_count(miss) < chunk_num && last - first < MAX_CHUNKS_IN_BLOB_REQUEST) {
+         count = last - first + 1;
+         buzzbitset_tobytes(miss, first / 8, (count + 7) / 8, want);
+      }
+      else first = 0;
+      buzzbitset_destroy(&miss);
+   }
+   buzzoutmsg_queue_append_blob_request(vm,
+                                        BUZZMSG_BSTIG_BLOB_REQUEST,
+                                        id,
+                                        key,
+                                        BROADCAST_MESSAGE_CONSTANT,
+                                        requester,
+                                        first,
+                                        count,
+                                        want);
+}
+
 int buzzbstig_blobstatus(buzzvm_t vm) {
    buzzvm_lnum_assert(vm, 1);
    /* Get bstig id */
@@ -678,7 +1043,7 @@ int buzzbstig_blobstatus(buzzvm_t vm) {
             (*v_blob)->relocstate = BUZZBLOB_SINK;
             /* Find the size of the location list if it is equal the number of chunks then bidding is done ask location holders */
             /* Number of chunks in total for this blob */
-            uint16_t chunk_num = ceil( (float)(*v_blob)->size/(float)BLOB_CHUNK_SIZE);
+            uint16_t chunk_num = buzzbstig_blob_chunk_num(*v_blob);
             uint16_t avilable = 0; 
             for(int i=0;i<buzzdarray_size((*v_blob)->locations);i++){
                /* Get the first location element of lowest priority blob */
@@ -686,26 +1051,17 @@ int buzzbstig_blobstatus(buzzvm_t vm) {
                avilable+=lowloc->availablespace;                  
             }
             if(avilable >= chunk_num){
-               /* Send a message to all locations  asking for blob*/
-               for(int i=0;i<buzzdarray_size((*v_blob)->locations);i++){
-                  /* Get the first location element of lowest priority blob */
-                  buzzblob_location_t lowloc = buzzdarray_get((*v_blob)->locations,i, buzzblob_location_t);
-                  // printf("Requested blob for : id: %u key %u avilable %u chunk_num %u location %u\n",id, k->i.value,avilable, chunk_num, lowloc->rid);    
-                  buzzoutmsg_queue_append_blob_request(vm,
-                                                        BUZZMSG_BSTIG_BLOB_REQUEST,
-                                                        id,
-                                                        k->i.value,
-                                                        lowloc->rid,
-                                                        vm->robot);   
-               }
+               /* Ask all locations for the blob */
+               buzzbstig_blob_fetch(vm, id, k->i.value, *v_blob, vm->robot, NULL);
             }
             else{
                /* If the location list does not equal the avilable size then go for state based allocation by broadcasting the source */
                // printf("Requested blob by setting status msg : id: %u key %u status %u\n",id, k->i.value,(*v_blob)->relocstate );
                buzzoutmsg_queue_append_blob_status(vm, BUZZMSG_BSTIG_STATUS, id,
-                                                k->i.value, (*v_blob)->relocstate,vm->robot);
+                                                k->i.value, (*v_blob)->relocstate,vm->robot,
+                                                (*v_blob)->available);
             }
-            (*v_blob)->request_time = 400;
+            (*v_blob)->request_time = TIME_TO_REFETCH_BLOB;
          }
          if((*v_blob)->status == BUZZBLOB_READY){
             buzzvm_pushi(vm, 1);    // blob available
@@ -717,7 +1073,7 @@ int buzzbstig_blobstatus(buzzvm_t vm) {
                (*v_blob)->request_time--;
             } 
             else{
-               uint16_t chunk_num = ceil( (float)(*v_blob)->size/(float)BLOB_CHUNK_SIZE);
+               uint16_t chunk_num = buzzbstig_blob_chunk_num(*v_blob);
                uint16_t avilable = 0; 
                for(int i=0;i<buzzdarray_size((*v_blob)->locations);i++){
                   /* Get the first location element of lowest priority blob */
@@ -725,20 +1081,16 @@ int buzzbstig_blobstatus(buzzvm_t vm) {
                   avilable+=lowloc->availablespace;                  
                }
                if(avilable >= chunk_num){
-                  /* Send a message to all locations  asking for blob*/
-                  for(int i=0;i<buzzdarray_size((*v_blob)->locations);i++){
-                     /* Get the first location element of lowest priority blob */
-                     buzzblob_location_t lowloc = buzzdarray_get((*v_blob)->locations,i, buzzblob_location_t);
-                     // printf("Requested blob for : id: %u key %u avilable %u chunk_num %u location %u\n",id, k->i.value,avilable, chunk_num, lowloc->rid);    
-                     buzzoutmsg_queue_append_blob_request(vm,
-                                                           BUZZMSG_BSTIG_BLOB_REQUEST,
-                                                           id,
-                                                           k->i.value,
-                                                           lowloc->rid,
-                                                           vm->robot);   
-                  }
+                  /* Ask again for the chunks still missing only */
+                  buzzbstig_blob_fetch(vm, id, k->i.value, *v_blob, vm->robot, NULL);
+               }
+               else{
+                  /* Let the source ask for them, telling it what is here already */
+                  buzzoutmsg_queue_append_blob_status(vm, BUZZMSG_BSTIG_STATUS, id,
+                                                      k->i.value, (*v_blob)->relocstate,vm->robot,
+                                                      (*v_blob)->available);
                }
-               (*v_blob)->request_time = 400;
+               (*v_blob)->request_time = TIME_TO_REFETCH_BLOB;
             }
             buzzvm_pushi(vm, 0);    // blob available
             /* Return the value found */
@@ -766,14 +1118,14 @@ int buzzbstig_getblobseqdone(buzzvm_t vm){
       if(v_blob){
          /* Find the size of the location list if it is equal the number of chunks then bidding is done */
          /* Number of chunks in total for this blob */
-         uint16_t chunk_num = ceil( (float)(*v_blob)->size/(float)BLOB_CHUNK_SIZE);
+         uint16_t chunk_num = buzzbstig_blob_chunk_num(*v_blob);
          uint16_t avilable = 0; 
          for(int i=0;i<buzzdarray_size((*v_blob)->locations);i++){
             /* Get the location elements and calculate size */
             buzzblob_location_t lowloc = buzzdarray_get((*v_blob)->locations,i, buzzblob_location_t);
             avilable+=lowloc->availablespace;                  
          }
-         if(avilable >= chunk_num && buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P])){
+         if(avilable >= chunk_num && buzzqueue_isempty(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P])){
              buzzvm_pushi(vm, 1);    // blob sequence done
             /* Return the value found */
             return buzzvm_ret1(vm);
@@ -794,17 +1146,17 @@ int buzzbstig_setgetter(buzzvm_t vm) {
       (*vs)->getter = BUZZBLOB_GETTER;
       /* Inform the neighbours about this */
       buzzoutmsg_queue_append_blob_status(vm, BUZZMSG_BSTIG_STATUS, id,
-                                                BROADCAST_MESSAGE_CONSTANT, BUZZBLOB_SETGETTER,vm->robot);
+                                                BROADCAST_MESSAGE_CONSTANT, BUZZBLOB_SETGETTER,vm->robot,NULL);
       /* Add an elemnt in refersher to monitor and maintain when robots are moving */
-      buzzchunk_reloc_elem_t newelem =(buzzchunk_reloc_elem_t)malloc(sizeof(struct buzzchunk_reloc_elem_s));
+      buzzchunk_reloc_elem_t newelem =(buzzchunk_reloc_elem_t)calloc(1, sizeof(struct buzzchunk_reloc_elem_s));
       newelem->id = id;
       newelem->key = 0;
       newelem->cid = BUZZBLOB_GETTER;
       newelem->bidsize = 0; 
-      newelem->time_to_wait = TIME_TO_REFRESH_GETTER_STATE;
       newelem->time_to_destroy = 0;
       newelem->checkednids = buzzdarray_new(1,sizeof(buzzblob_bidder_t),buzzbstig_blob_bidderelem_destroy);
       buzzdarray_push(vm->cmonitor->getters,&newelem);
+      buzzbstig_cmonitor_wait(vm, newelem, BUZZCHUNK_TIMER_GETTER, TIME_TO_REFRESH_GETTER_STATE);
    }
    return buzzvm_ret0(vm);
 }
@@ -822,10 +1174,7 @@ int buzzbstig_getblob(buzzvm_t vm) {
       /* Look for blob key in blob bstig slot*/
       const buzzblob_elem_t* v_blob = buzzdict_get(*s, &k->i.value, buzzblob_elem_t);
       if(v_blob){
-         uint16_t vs_size = buzzdict_size((*v_blob)->data);
-         uint16_t chunk_num = ceil( (float)(*v_blob)->size/(float)BLOB_CHUNK_SIZE);
-         // printf("[Debug ] rid : 8, vs_size : %u, blob element size : %u \n",vs_size, chunk_num );
-         if(vs_size == chunk_num){
+         if(buzzbstig_blob_complete(*v_blob)){
             if(buzzbstig_construct_blob(vm,*v_blob)){
                /* Reconstruction successful */
                /* Return the value found */
@@ -1009,7 +1358,7 @@ void buzzbstig_allocate_chunks(buzzvm_t vm,
       v_blob = buzzdict_get(*s, &key, buzzblob_elem_t);
       if(v_blob){
          /* Add the chunks from the availabilty list */
-         if(bidsize <= buzzdarray_size( (*v_blob)->available_list ) ){
+         if(bidsize <= buzzbitset_count( (*v_blob)->available ) ){
             /* Create an element for key */
             buzzobj_t k = buzzobj_new(BUZZTYPE_INT);  // TODO : try to unify args and hence avoid creation of buzzobj
             k->i.value = key;
@@ -1020,7 +1369,7 @@ void buzzbstig_allocate_chunks(buzzvm_t vm,
             // printf("allocating chunk : id : %u , key : %u \n",id,k->i.value ); 
             for(int i=0;i < bidsize;i++){
 
-               uint16_t cid = buzzdarray_last((*v_blob)->available_list,uint16_t);
+               uint16_t cid = (uint16_t)buzzbitset_last((*v_blob)->available);
                const buzzblob_chunk_t* cdata = buzzdict_get((*v_blob)->data, &cid, buzzblob_chunk_t);
 
                // printf("Allocating chunk: %i , cid : %u\n",i,cid  );
@@ -1038,11 +1387,13 @@ void buzzbstig_allocate_chunks(buzzvm_t vm,
                
                /* Delete the existing element */
                buzzbstig_remove( (*v_blob), &cid); 
-               /* Remove the last element from the avilable list */
-               buzzdarray_pop((*v_blob)->available_list);
+               /* Remove the chunk from the avilable set */
+               buzzbitset_remove((*v_blob)->available, cid);
                /* Decrease the size in cmon */
                (vm->cmonitor->chunknum)--;
             }
+            /* The blob is no longer whole here: the bytes go with the last chunk view */
+            buzzbstig_blob_drop_buffer(*v_blob);
             /* Add to location list */
             struct buzzblob_bidder_s locationcmp = {.rid = bidderid, .availablespace = bidsize};
             buzzblob_location_t ploccmp = &locationcmp;
@@ -1099,15 +1450,11 @@ void buzzbstig_relocation_bider_add(buzzvm_t vm,
                                     uint8_t subtype,
                                     uint16_t receiver){
    /* Append to bidder to intiate the bid for this blob */
-   buzzchunk_reloc_elem_t newelem =(buzzchunk_reloc_elem_t)malloc(sizeof(struct buzzchunk_reloc_elem_s));
+   buzzchunk_reloc_elem_t newelem =(buzzchunk_reloc_elem_t)calloc(1, sizeof(struct buzzchunk_reloc_elem_s));
    newelem->id = id;
    newelem->key = key;
    newelem->cid = subtype;
    newelem->bidsize = availablespace; 
-   if(subtype != BUZZBSTIG_BID_NEW)
-      newelem->time_to_wait = MAX_TIME_TO_HOLD_SPACE_FOR_A_BID;
-   else   
-      newelem->time_to_wait = MAX_TIME_FOR_THE_BIDDER;
    newelem->time_to_destroy = 0;
    const buzzbstig_t* vs = buzzdict_get(vm->bstigs, &id, buzzbstig_t);
    uint8_t getter = BUZZBLOB_GETTER_OPEN;
@@ -1117,6 +1464,10 @@ void buzzbstig_relocation_bider_add(buzzvm_t vm,
    /* Create a list to store the bid list */
    newelem->checkednids = buzzdarray_new(10,sizeof(buzzblob_bidder_t),buzzbstig_blob_bidderelem_destroy);
    buzzdarray_push(vm->cmonitor->bidder,&newelem);
+   if(subtype != BUZZBSTIG_BID_NEW)
+      buzzbstig_cmonitor_wait(vm, newelem, BUZZCHUNK_TIMER_BIDDER, MAX_TIME_TO_HOLD_SPACE_FOR_A_BID);
+   else   
+      buzzbstig_cmonitor_wait(vm, newelem, BUZZCHUNK_TIMER_BIDDER, MAX_TIME_FOR_THE_BIDDER);
    buzzoutmsg_queue_append_bid(vm,
                                 BUZZMSG_BSTIG_BLOB_BID,
                                 id,
@@ -1130,35 +1481,69 @@ void buzzbstig_relocation_bider_add(buzzvm_t vm,
                                 receiver);
 }
    
+/*
+ * Computes the parity chunks of a blob whose data chunks are stored.
+ * They are views into one buffer of parity * chunk_size bytes.
+ */
+static void buzzblob_split_put_parity(buzzvm_t vm,
+                                      buzzblob_elem_t blb_struct){
+   uint16_t k = buzzbstig_blob_data_chunk_num(blb_struct);
+   uint16_t m = blb_struct->parity;
+   uint32_t chunk_size = blb_struct->chunk_size;
+   /* The code works on whole chunks: pad the last data chunk with zeros */
+   buzzblobbuf_t last = buzzblobbuf_new(chunk_size);
+   uint32_t last_size = blb_struct->size - (uint32_t)(k - 1) * chunk_size;
+   memcpy(last->data, buzzblobbuf_at(blb_struct->buf, (k - 1) * chunk_size), last_size);
+   buzzblobbuf_t par = buzzblobbuf_new(m * chunk_size);
+   const uint8_t* data[BUZZRS_MAXPIECES];
+   uint8_t* parity[BUZZRS_MAXPIECES];
+   for(uint16_t i = 0; i + 1 < k; ++i)
+      data[i] = buzzblobbuf_at(blb_struct->buf, i * chunk_size);
+   data[k - 1] = last->data;
+   for(uint16_t p = 0; p < m; ++p)
+      parity[p] = buzzblobbuf_at(par, p * chunk_size);
+   buzzrs_encode(k, m, data, parity, chunk_size);
+   buzzblobbuf_unref(&last);
+   for(uint16_t p = 0; p < m; ++p){
+      uint16_t cid = k + p;
+      uint32_t chunk_hash = buzzbstig_checksum(blb_struct->hashctx.algo, parity[p], chunk_size);
+      buzzblob_chunk_t cdata = buzzbstig_chunk_view(chunk_hash, par, p * chunk_size, chunk_size);
+      cdata->hashalgo = blb_struct->hashctx.algo;
+      cdata->status=BUZZCHUNK_READY;
+      buzzdict_set(blb_struct->data, &cid, &cdata);
+      buzzbitset_add(blb_struct->available, cid);
+      (vm->cmonitor->chunknum)++;
+   }
+   buzzblobbuf_unref(&par);
+}
+
 void buzzblob_split_put_bstig(buzzvm_t vm,
                               uint16_t id,
                               buzzobj_t blob,
                               buzzblob_elem_t blb_struct,
                               buzzobj_t key,
                               buzzbstig_elem_t e){
-   /* Chunk the blob */
-   uint32_t blb_size  = strlen(blob->s.value.str);
-   uint32_t chunk_num = ceil(((float)blb_size/(float)BLOB_CHUNK_SIZE));
+   /* Chunk the blob; the bytes are already in the slot buffer */
+   uint32_t blb_size = blb_struct->size;
+   uint32_t chunk_size = blb_struct->chunk_size;
+   uint32_t chunk_num = buzzbstig_blob_data_chunk_num(blb_struct);
    printf(" [DEBUG split] bstig  size : %u, number of chunks: %d \n", blb_size, chunk_num );
    uint32_t temp_size=0;
    for(uint32_t i=0; i< chunk_num;i++){
-      uint32_t size_to_chunk = (blb_size-i*BLOB_CHUNK_SIZE > BLOB_CHUNK_SIZE) ?
-                                 BLOB_CHUNK_SIZE : blb_size -(i*BLOB_CHUNK_SIZE);
-      char chunk_block[size_to_chunk+1];
-      /* Copy the chunk */
-      memcpy(chunk_block, blob->s.value.str + temp_size, size_to_chunk * sizeof(char));
-      /* Set termination character */
-      *(chunk_block + size_to_chunk) = 0;
-      /* Hash the chunk */
-      uint32_t* chunk_hash = buzzbstig_md5(chunk_block,size_to_chunk);
-      /* Store the blob chunk with its hash */
-      buzzblob_chunk_t cdata = buzzbstig_chunk_new(chunk_hash[0], chunk_block);
+      uint32_t size_to_chunk = (blb_size-i*chunk_size > chunk_size) ?
+                                 chunk_size : blb_size -(i*chunk_size);
+      const char* chunk_block = (char*)buzzblobbuf_at(blb_struct->buf, temp_size);
+      /* Hash the chunk with the algorithm of the blob */
+      uint32_t chunk_hash = buzzbstig_checksum(blb_struct->hashctx.algo, chunk_block, size_to_chunk);
+      /* Store a view of the blob chunk with its hash */
+      buzzblob_chunk_t cdata = buzzbstig_chunk_view(chunk_hash, blb_struct->buf, temp_size, size_to_chunk);
+      cdata->hashalgo = blb_struct->hashctx.algo;
       /* Set the chunk status to ready */
       cdata->status=BUZZCHUNK_READY;
       /* Store the blob */
       buzzdict_set(blb_struct->data, &i, &cdata);
-      /* Add to available list */
-      buzzdarray_push(blb_struct->available_list, &i);
+      /* Add to available set */
+      buzzbitset_add(blb_struct->available, i);
       /* Increase the size of cmon */   
       (vm->cmonitor->chunknum)++;
       // buzzoutmsg_queue_append_chunk(vm,
@@ -1172,9 +1557,11 @@ void buzzblob_split_put_bstig(buzzvm_t vm,
       //                              BROADCAST_MESSAGE_CONSTANT);
       //buzzbstig_put_generic(vm, t_stig_id, chunk_key, buzz_obj_hash);
       // printf(" [DEBUG split] chunk : %u, hash: %u, key: %d \n", i, chunk_hash[0], key->i.value );
-      free(chunk_hash);
       temp_size+=size_to_chunk;
    }
+   /* Add the parity chunks, spread by the bidding like the others */
+   if(blb_struct->parity)
+      buzzblob_split_put_parity(vm, blb_struct);
    /* Set the blob status and relocstatus */
    blb_struct->status=BUZZBLOB_READY;
    blb_struct->relocstate=BUZZBLOB_SOURCE;
@@ -1189,41 +1576,162 @@ void buzzblob_split_put_bstig(buzzvm_t vm,
                                    BROADCAST_MESSAGE_CONSTANT);
 }
 
+/*
+ * Pushes the decoded blob of a slot whose buffer holds all the blob bytes.
+ * Pushes nil if the codec is not known yet or the bytes do not decode.
+ */
+static buzzobj_t buzzbstig_blob_push_decoded(buzzvm_t vm, buzzblob_elem_t v_blob) {
+   switch(v_blob->codec) {
+      case BUZZBLOB_CODEC_NONE:
+         buzzvm_pushbuf(vm, v_blob->buf, 0, v_blob->size);
+         break;
+      case BUZZBLOB_CODEC_LZ4:
+         /* Decode once, later gets share the decoded buffer */
+         if(!v_blob->raw) {
+            buzzblobbuf_t raw = buzzblobbuf_new(v_blob->raw_size);
+            if(buzzlz4_decompress(v_blob->buf->data, v_blob->size, raw->data, raw->size) != v_blob->raw_size) {
+               fprintf(stderr, "[WARNING] [ROBOT %u] Blob does not decompress to %u bytes\n", vm->robot, v_blob->raw_size);
+               buzzblobbuf_unref(&raw);
+               buzzvm_pushnil(vm);
+               break;
+            }
+            v_blob->raw = raw;
+         }
+         buzzvm_pushbuf(vm, v_blob->raw, 0, v_blob->raw_size);
+         break;
+      default:
+         /* The PUT carrying the codec has not arrived yet */
+         buzzvm_pushnil(vm);
+   }
+   return buzzvm_stack_at(vm, 1);
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Rebuilds a blob from any data chunk count of its chunks.
+ * Pushes nil if there are not enough chunks or the blob hash does not match.
+ */
+static buzzobj_t buzzbstig_construct_blob_parity(buzzvm_t vm, buzzblob_elem_t v_blob){
+   uint16_t k = buzzbstig_blob_data_chunk_num(v_blob);
+   uint16_t m = v_blob->parity;
+   uint32_t chunk_size = v_blob->chunk_size;
+   /* Gather the data chunks there are, with room to pad the last one */
+   buzzblobbuf_t blob = buzzblobbuf_new(k * chunk_size);
+   const uint8_t* pieces[BUZZRS_MAXPIECES];
+   uint8_t* data[BUZZRS_MAXPIECES];
+   uint8_t algo = v_blob->hashctx.algo;
+   for(uint16_t i = 0; i < k + m; ++i){
+      buzzblob_chunk_t cdata = buzzbstig_blob_chunk_get(v_blob, i);
+      if(cdata) algo = cdata->hashalgo;
+      if(i < k){
+         data[i] = buzzblobbuf_at(blob, i * chunk_size);
+         if(cdata) memcpy(data[i], cdata->chunk, cdata->size);
+         pieces[i] = cdata ? data[i] : NULL;
+      }
+      else pieces[i] = cdata ? (const uint8_t*)cdata->chunk : NULL;
+   }
+   if(!buzzrs_decode(k, m, pieces, data, chunk_size)){
+      buzzblobbuf_unref(&blob);
+      buzzvm_pushnil(vm);
+      return buzzvm_stack_at(vm, 1);
+   }
+   blob->size = v_blob->size;
+   if(buzzbstig_checksum(algo, blob->data, blob->size) != v_blob->hash){
+      fprintf(stderr, "[WARNING] [ROBOT %u] Rebuilt blob does not match its hash %u\n", vm->robot, v_blob->hash);
+      buzzblobbuf_unref(&blob);
+      buzzvm_pushnil(vm);
+      return buzzvm_stack_at(vm, 1);
+   }
+   /* Turn the stored data chunks into views of the rebuilt buffer */
+   for(uint16_t i = 0; i < k; ++i){
+      buzzblob_chunk_t cdata = buzzbstig_blob_chunk_get(v_blob, i);
+      if(!cdata) continue;
+      buzzblobbuf_unref(&(cdata->buf));
+      cdata->buf = buzzblobbuf_ref(blob);
+      cdata->chunk = (char*)data[i];
+   }
+   v_blob->buf = blob;
+   v_blob->hashctx.algo = algo;
+   v_blob->hash_status = BUZZBLOB_HASH_VERIFIED;
+   return buzzbstig_blob_push_decoded(vm, v_blob);
+}
+
+/****************************************/
+/****************************************/
+
 buzzobj_t buzzbstig_construct_blob(buzzvm_t vm, buzzblob_elem_t v_blob){ 
     uint32_t blb_size  = v_blob->size;
-    uint32_t chunk_num = ceil(((float)blb_size/(float)BLOB_CHUNK_SIZE));
+    uint32_t chunk_num = buzzbstig_blob_data_chunk_num(v_blob);
     // printf(" [DEBUG construct] rid: %u, bstig  size : %u, number of chunks: %d \n", vm->robot, blb_size, chunk_num );
-    char blob [blb_size + 1];
-    uint32_t cpy_size = 0;
-    for(uint32_t i=0; i<chunk_num; i++){
-      const buzzblob_chunk_t* cdata = buzzdict_get(v_blob->data, &i, buzzblob_chunk_t);
-      uint16_t chunk_size = strlen((*cdata)->chunk);
-      memcpy(blob + cpy_size , (*cdata)->chunk, chunk_size * sizeof(char));
-      cpy_size+=chunk_size;
-    }
-    /* Set termination character */
-    *(blob + cpy_size) = 0;
-    /* Hash the chunk */
-    uint32_t* blob_hash = buzzbstig_md5(blob,blb_size);
-    if(blob_hash[0] == v_blob->hash){
-      printf(" [DEBUG construct] Hash verification successful \
-       rid: %u, bstig  size : %u, number of chunks: %d, actual hash : %u , calculated hash %u \n", vm->robot, blb_size, chunk_num, v_blob->hash, blob_hash[0] );
-      free(blob_hash);
-      buzzvm_pushs(vm, buzzvm_string_register(vm, blob,1));
-      //buzzvm_pushnil(vm);
-      return buzzvm_stack_at(vm, 1);
-    }
-    else {
+    /* A slot buffer only ever holds verified bytes: return a view of it */
+    if(v_blob->buf)
+      return buzzbstig_blob_push_decoded(vm, v_blob);
+    /* Hash whatever chunks were not hashed on arrival */
+    buzzbstig_blob_hash_advance(v_blob);
+    /* Data chunks are missing: rebuild them from the parity chunks */
+    if(v_blob->parity && v_blob->hash_status == BUZZBLOB_HASH_STREAMING)
+      return buzzbstig_construct_blob_parity(vm, v_blob);
+    if(v_blob->hash_status != BUZZBLOB_HASH_VERIFIED){
       printf(" [DEBUG construct] Hash verification failed \
-       rid: %u, bstig  size : %u, number of chunks: %d, actual hash : %u , calculated hash %u \n", vm->robot, blb_size, chunk_num, v_blob->hash, blob_hash[0] );
-      
-      free(blob_hash);
+       rid: %u, bstig  size : %u, number of chunks: %d, actual hash : %u , hashed chunks %u \n", vm->robot, blb_size, chunk_num, v_blob->hash, v_blob->hash_next );
       buzzvm_pushnil(vm);
       return buzzvm_stack_at(vm, 1);
+    }
+    /* The chunks arrived separately: gather them once into a single buffer */
+    buzzblobbuf_t blob = buzzblobbuf_new(blb_size);
+    for(uint32_t i=0; i<chunk_num; i++){
+      buzzblob_chunk_t cdata = *buzzdict_get(v_blob->data, &i, buzzblob_chunk_t);
+      memcpy(buzzblobbuf_at(blob, i*v_blob->chunk_size), cdata->chunk, cdata->size);
+      /* Turn the chunk into a view of the gathered buffer */
+      buzzblobbuf_unref(&(cdata->buf));
+      cdata->buf = buzzblobbuf_ref(blob);
+      cdata->chunk = (char*)buzzblobbuf_at(blob, i*v_blob->chunk_size);
+    }
+    v_blob->buf = blob;
+    printf(" [DEBUG construct] Hash verification successful \
+     rid: %u, bstig  size : %u, number of chunks: %d, actual hash : %u \n", vm->robot, blb_size, chunk_num, v_blob->hash );
+    /* The returned blob shares the slot buffer */
+    return buzzbstig_blob_push_decoded(vm, v_blob);
+}
+
+/****************************************/
+/****************************************/
+
+void buzzbstig_blob_hash_advance(buzzblob_elem_t v_blob){
+   if(v_blob->hash_status != BUZZBLOB_HASH_STREAMING) return;
+   /* Parity chunks are not part of the blob bytes */
+   uint16_t chunk_num = buzzbstig_blob_data_chunk_num(v_blob);
+   /* Hash the chunks that directly follow the last hashed one */
+   while(v_blob->hash_next < chunk_num){
+      const buzzblob_chunk_t* cdata = buzzdict_get(v_blob->data, &(v_blob->hash_next), buzzblob_chunk_t);
+      uint32_t expected = v_blob->size - v_blob->hash_next * v_blob->chunk_size;
+      if(expected > v_blob->chunk_size) expected = v_blob->chunk_size;
+      /* Stop at missing and dummy chunks */
+      if(!cdata || (*cdata)->size != expected) return;
+      /* The first chunk tells which algorithm the source used */
+      if(v_blob->hash_next == 0)
+         buzzbstig_checksum_init(&(v_blob->hashctx), (*cdata)->hashalgo);
+      buzzbstig_checksum_update(&(v_blob->hashctx), (*cdata)->chunk, (*cdata)->size);
+      ++(v_blob->hash_next);
    }
-   
+   /* All chunks are in, check the blob hash */
+   v_blob->hash_status = (buzzbstig_checksum_final(&(v_blob->hashctx)) == v_blob->hash) ?
+      BUZZBLOB_HASH_VERIFIED : BUZZBLOB_HASH_MISMATCH;
 }
 
+/****************************************/
+/****************************************/
+
+void buzzbstig_blob_drop_buffer(buzzblob_elem_t v_blob){
+   buzzblobbuf_unref(&(v_blob->buf));
+   buzzblobbuf_unref(&(v_blob->raw));
+   /* The remaining chunks must be verified again */
+   buzzbstig_checksum_init(&(v_blob->hashctx), v_blob->hashctx.algo);
+   v_blob->hash_next = 0;
+   v_blob->hash_status = BUZZBLOB_HASH_STREAMING;
+}
 
 /****************************************/
 /****************************************/
@@ -1252,6 +1760,8 @@ int buzzbstig_store_chunk(buzzvm_t vm,
                /* Set the chunk status to ready */
                cdata->status=BUZZCHUNK_READY;
                buzzdict_set((*v_blob)->data, &(chunk_index), &cdata);
+               /* Hash it now if it extends the hashed prefix */
+               buzzbstig_blob_hash_advance(*v_blob);
                // buzzoutmsg_queue_append_chunk(vm,
                //                        BUZZMSG_BSTIG_CHUNK_PUT,
                //                        id,
@@ -1268,12 +1778,11 @@ int buzzbstig_store_chunk(buzzvm_t vm,
                if((*v_blob)->relocstate == BUZZBLOB_SINK){
                   (vm->cmonitor->chunknum)++;
                }
-               /* Add it to the avilable list */
-               buzzdarray_push((*v_blob)->available_list,&chunk_index); 
-               /* If the robot got all the chunks then change the status to ready */
-               uint16_t vs_size = buzzdict_size((*v_blob)->available_list);
-               uint16_t chunk_num = ceil( (float)(*v_blob)->size/(float)BLOB_CHUNK_SIZE);
-               if(vs_size == chunk_num){
+               /* Add it to the avilable set */
+               buzzbitset_add((*v_blob)->available, chunk_index);
+               /* If the robot got enough chunks then change the status to ready */
+               uint16_t vs_size = buzzbitset_count((*v_blob)->available);
+               if(vs_size >= buzzbstig_blob_data_chunk_num(*v_blob)){
                   (*v_blob)->status=BUZZBLOB_READY;
                }
                return 1;
@@ -1295,7 +1804,7 @@ int buzzbstig_store_chunk(buzzvm_t vm,
             //    buzzdarray_push((*v_blob)->available_list,&chunk_index); 
             //    /* If the robot got all the chunks then change the status to ready */
             //    uint16_t vs_size = buzzdict_size((*v_blob)->available_list);
-            //    uint16_t chunk_num = ceil( (float)(*v_blob)->size/(float)BLOB_CHUNK_SIZE);
+            //    uint16_t chunk_num = buzzbstig_blob_chunk_num(*v_blob);
             //    if(vs_size == chunk_num){
             //       (*v_blob)->status=BUZZBLOB_READY;
             //    }
@@ -1303,9 +1812,7 @@ int buzzbstig_store_chunk(buzzvm_t vm,
             // }
             else if ((*v_blob)->relocstate == BUZZBLOB_FORWARDING){
                /* Create a dummy blob and store */
-               char chunk[1];
-               *chunk=0;
-               buzzblob_chunk_t dum = buzzbstig_chunk_new(0,chunk);
+               buzzblob_chunk_t dum = buzzbstig_chunk_new(0,NULL,0);
                /* Add it to relocated list */
                //buzzdarray_push((*v_blob)->relocated_list,&chunk_index);
                /* Store the dummy blob */
@@ -1332,25 +1839,6 @@ int buzzbstig_store_chunk(buzzvm_t vm,
 
 /****************************************/
 /****************************************/
-int buzzbstig_priority_cmp(const void* a, const void* b){
-   struct buzzbstig_blobpriority_list_param* c = *(struct buzzbstig_blobpriority_list_param**) a;
-   struct buzzbstig_blobpriority_list_param* d = *(struct buzzbstig_blobpriority_list_param**) b;
-   if(c->id == d->id && c->key == d->key) return 0;
-   return -1;
-}
-
-struct buzzbstig_blobpriority_loop2_param
-{
-   uint16_t id;
-   buzzdarray_t plist;
-   uint16_t option;  //  0 -> order including reserved and marked 
-                     //  1 -> order with marked only
-                     //  2 -> order exculding reserved and marked
-};
-void buzzpriority_struct_destroy(uint32_t pos, void* data, void* params){
- struct buzzbstig_blobpriority_loop_param* m = *(struct buzzbstig_blobpriority_loop_param**) data;
- free(m);  
-}
 void buzzbstig_blob_forcealloc_destroy(uint32_t pos, void* data, void* params){
    buzzdarray_destroy((buzzdarray_t*) data);
 }
@@ -1378,85 +1866,12 @@ void buzzbstig_blobstatus_loop2(const void* key, void* data, void* params){
 void buzzbstig_blobstatus_loop1(const void* key, void* data, void* params){
    buzzdict_foreach(*(buzzdict_t*)data, buzzbstig_blobstatus_loop2, NULL);
 }
-uint16_t buzzbstig_priority_cmp_fun(struct buzzbstig_blobpriority_list_param* a, const struct buzzbstig_blobpriority_list_param* b){
-return (a->stat && !b->stat) ||
-       (a->stat && b->stat && a->priority < b->priority )  || 
-       (a->stat && b->stat && a->priority == b->priority && a->key < b->key) ||
-       (!a->stat && !b->stat && a->priority < b->priority )||
-       (!a->stat && !b->stat && a->priority == b->priority && a->key < b->key);
-}
-void buzzbstig_blobpriority_loop2(const void* key, void* data, void* params){ // Key loop 
-   /* List to store the priority */
-   struct buzzbstig_blobpriority_loop2_param* p = (struct buzzbstig_blobpriority_loop2_param*) params;
-   buzzblob_elem_t v_blob = *(buzzblob_elem_t*) data;
-   // uint32_t available_chunk = buzzdict_size(v_blob->data);
-   // uint32_t relocated_chunk = buzzdarray_size((v_blob)->relocated_list);
-   // uint32_t marked_list = buzzdarray_size((v_blob)->marked_list);
-   // uint32_t reserved_list = buzzdarray_size((v_blob)->reserved_list);
-   // uint32_t sizeconsidered =0;
-   // if(p->option == 0 ) sizeconsidered = (available_chunk - relocated_chunk - marked_list - reserved_list);
-   // else if(p->option == 1 ) sizeconsidered = (available_chunk - relocated_chunk - marked_list);
-   // else if(p->option == 2 ) sizeconsidered = (available_chunk - relocated_chunk );
-   // /* Does it have atleast one chunk to remove ? */
-   // if( sizeconsidered > 0){ // should have atleast one chunk to relocate
-      /* This blob is a removal canditate */
-      /* Zeroing the memory taken care of calloc */
-   struct buzzbstig_blobpriority_list_param* pe = (struct buzzbstig_blobpriority_list_param*)calloc(1,sizeof(struct buzzbstig_blobpriority_list_param));
-   pe->id = p->id;
-   pe->key =  *(uint16_t*)key;
-   pe->priority = v_blob->priority;  
-   pe->stat = 0;
-   // if(v_blob->relocstate == BUZZBLOB_FORWARDING || // if the blob is moved some where else remove it without checking priority
-   //          v_blob->relocstate == BUZZBLOB_SOURCE){
-   //    pe->stat = 1;  
-   // }
-   // else{
-   //    pe->stat = 0;
-   // }
-   uint16_t size = buzzdarray_size(p->plist);
-   if(size == 0 ){
-      buzzdarray_insert(p->plist,0,&pe);
-   }
-   else{
-      uint16_t in =0;
-      for( uint16_t i=0; i<size; i++){
-         const struct buzzbstig_blobpriority_list_param* c = buzzdarray_get((p->plist), i, struct buzzbstig_blobpriority_list_param*);       
-         if(buzzbstig_priority_cmp_fun(pe,c)){
-            buzzdarray_insert(p->plist,i,&pe);
-            in=1;
-            break;
-         }
-      }
-      if(!in){
-         buzzdarray_insert(p->plist,size,&pe);
-      } 
-   }   
-}
-
-void buzzbstig_blobpriority_loop1(const void* key, void* data, void* params){ // Id loop 
-   buzzdict_t m_dict = *(buzzdict_t*) data;
-   // printf("priority loop 1 : id : %u\n", *(uint16_t*)key);
-   struct buzzbstig_blobpriority_loop2_param* p = (struct buzzbstig_blobpriority_loop2_param*) params;
-   p->id = *(uint16_t*)key;
-   buzzdict_foreach(m_dict, buzzbstig_blobpriority_loop2, params);
-}
-
 void buzzbstig_neigh_loop(const void* key, void* data, void* params){ // nid get loop
    buzzdarray_t nida = *(buzzdarray_t*) params;
    uint16_t nid = *(uint16_t*) key;
    buzzdarray_push(nida,&nid);
 }
 
-buzzdarray_t buzzbstig_get_prioritylist(buzzvm_t vm){
-   /* create a darray for storing the id and key in accending order of priority */
-   buzzdarray_t priority = buzzdarray_new(5, sizeof(struct buzzbstig_blobpriority_list_param*), 
-                                          buzzpriority_struct_destroy);
-   struct buzzbstig_blobpriority_loop2_param p = {.id =0, .plist=priority, .option = 2};
-   /* Update the priority list of blobs */
-   buzzdict_foreach(vm->blobs, buzzbstig_blobpriority_loop1, &p);
-   return priority;
-}
-
 int buzzbstig_blob_bidderpriority_key_cmp(const void* a, const void* b) {
    buzzblob_bidder_t c = *(buzzblob_bidder_t*) a;
    buzzblob_bidder_t d = *(buzzblob_bidder_t*) b;
@@ -1465,380 +1880,446 @@ int buzzbstig_blob_bidderpriority_key_cmp(const void* a, const void* b) {
    return 0;
 }
 
-void buzzbstig_blobstatus_update(buzzvm_t vm){
-   for(int i = 0; i< buzzdarray_size(vm->cmonitor->bidder); i++){
-      const buzzchunk_reloc_elem_t celem = 
-                        buzzdarray_get(vm->cmonitor->bidder,i,buzzchunk_reloc_elem_t);
-      // printf("rid %u Cmon elem %i , k: %u, id: %u type : %u  time : %u \n",vm->robot,i,celem->key,celem->id,celem->cid,celem->time_to_wait);
-      // for(int y=0; y< buzzdarray_size(celem->checkednids); y++){
-      //    const buzzblob_bidder_t bidelem = 
-      //                      buzzdarray_get(celem->checkednids,y,buzzblob_bidder_t);
-      //    printf("Bid : %i, bidderid: %u, bidsize: %u, bidder role: %u time to allocate: %u \n", y ,bidelem->rid, bidelem->availablespace, bidelem->role, celem->time_to_wait);
-      // }
-      if(celem->time_to_wait > 0){
-         celem->time_to_wait--;
-         if(celem->cid == BUZZCHUNK_BID_ALLOCATION && (celem->time_to_wait == MAX_TIME_TO_HOLD_SPACE_FOR_A_BID/4 || 
-                                                      celem->time_to_wait == MAX_TIME_TO_HOLD_SPACE_FOR_A_BID/3  ||
-                                                      celem->time_to_wait == MAX_TIME_TO_HOLD_SPACE_FOR_A_BID/2) ){
-            /* Look for blob holder */
-            const buzzdict_t* s = buzzdict_get(vm->blobs, &(celem->id), buzzdict_t);
-            const buzzblob_elem_t* v_blob = NULL;
-            /*Nothing to do, if bs id doesnot exsist*/
-            if(s){
-               /* Look for blob key in blob bstig slot*/
-               v_blob = buzzdict_get(*s, &(celem->key), buzzblob_elem_t);
-            }
-            if(v_blob){
-               for(int b = 0; b< buzzdarray_size(celem->checkednids);b++){
-                  printf("[RID %u ]Resending a new alloc message due to no responce \n",vm->robot);
-                  buzzblob_bidder_t bidelem = buzzdarray_get(celem->checkednids,b,buzzblob_bidder_t);
-                  /* ReSend an allocation messsage due to no responce */
-                  buzzoutmsg_queue_append_bid(vm,
-                                               BUZZMSG_BSTIG_BLOB_BID,
-                                               celem->id,
-                                               celem->key,
-                                               bidelem->rid,
-                                               bidelem->availablespace,
-                                               (*v_blob)->size,
-                                               (*v_blob)->hash,
-                                               bidelem->role,
-                                               (uint16_t) BUZZCHUNK_BID_ALLOCATION,
-                                               bidelem->rid);
-               }
+/****************************************/
+/****************************************/
+
+/* Removes an element from a list of the chunk monitor */
+static void buzzbstig_cmonitor_remove(buzzdarray_t list,
+                                      buzzchunk_reloc_elem_t e) {
+   for(uint32_t i = 0; i < buzzdarray_size(list); ++i) {
+      if(buzzdarray_get(list, i, buzzchunk_reloc_elem_t) == e) {
+         buzzdarray_remove(list, i);
+         return;
+      }
+   }
+}
+
+/* Steps until the next thing to do for an element of the bidder list */
+static uint32_t buzzbstig_bidder_next(buzzvm_t vm,
+                                      buzzchunk_reloc_elem_t e) {
+   static const uint16_t RESEND[] = {
+      MAX_TIME_TO_HOLD_SPACE_FOR_A_BID / 2,
+      MAX_TIME_TO_HOLD_SPACE_FOR_A_BID / 3,
+      MAX_TIME_TO_HOLD_SPACE_FOR_A_BID / 4
+   };
+   uint32_t now = buzztimerwheel_now(vm->cmonitor->timers);
+   /* A finished allocation is cleared at the next update */
+   if((e->cid == BUZZCHUNK_BID_ALLOCATION || e->cid == BUZZCHUNK_BID_FORCE_ALLOCATION) &&
+      e->checkednids && buzzdarray_isempty(e->checkednids))
+      return 1;
+   /* An allocation resends its messages when these many steps are left */
+   if(e->cid == BUZZCHUNK_BID_ALLOCATION) {
+      for(int r = 0; r < 3; ++r) {
+         int32_t d = (int32_t)(e->deadline - 1 - RESEND[r] - now);
+         if(d > 0) return d;
+      }
+   }
+   int32_t d = (int32_t)(e->deadline - now);
+   return d > 0 ? d : 1;
+}
+
+/****************************************/
+/****************************************/
+
+void buzzbstig_cmonitor_wait(buzzvm_t vm,
+                             buzzchunk_reloc_elem_t e,
+                             uint8_t type,
+                             uint16_t time) {
+   /* The timeout is handled at the update after the wait is over */
+   e->deadline = buzztimerwheel_now(vm->cmonitor->timers) + time + 1;
+   e->timer.type = type;
+   e->timer.data = e;
+   buzztimer_schedule(vm->cmonitor->timers, &e->timer,
+                      type == BUZZCHUNK_TIMER_BIDDER ? buzzbstig_bidder_next(vm, e) : time + 1);
+}
+
+/****************************************/
+/****************************************/
+
+uint16_t buzzbstig_cmonitor_left(buzzvm_t vm,
+                                 buzzchunk_reloc_elem_t e) {
+   int32_t d = (int32_t)(e->deadline - 1 - buzztimerwheel_now(vm->cmonitor->timers));
+   return d > 0 ? d : 0;
+}
+
+/****************************************/
+/****************************************/
+
+void buzzbstig_cmonitor_check(buzzvm_t vm,
+                              buzzchunk_reloc_elem_t e) {
+   buzztimer_schedule(vm->cmonitor->timers, &e->timer, buzzbstig_bidder_next(vm, e));
+}
+
+/****************************************/
+/****************************************/
+
+/* Handles the timer of an element of the bidder list, returns 1 if it was removed */
+static int buzzbstig_bidder_timeout(buzzvm_t vm,
+                                    buzzchunk_reloc_elem_t celem) {
+   /* Clear the allocations that are done */
+   if(celem->cid == BUZZCHUNK_BID_ALLOCATION && buzzdarray_isempty(celem->checkednids) ){
+      /* Clear all bid info related to this blob once allocation complete */
+      uint16_t id = celem->id, key = celem->key;
+      buzzbstig_cmonitor_remove(vm->cmonitor->bidder,celem);
+      struct buzzchunk_reloc_elem_s cmpelem = {.id = id, .key = key, .cid=BUZZBSTIG_BID_NEW};
+      buzzchunk_reloc_elem_t newelem = &cmpelem;
+      uint16_t cmonindex = buzzdarray_find(vm->cmonitor->bidder,buzzvm_cmonitor_reloc_elem_key_cmp,&newelem);
+      if(cmonindex !=buzzdarray_size(vm->cmonitor->bidder)){
+         buzzdarray_remove(vm->cmonitor->bidder,cmonindex);
+      }
+      return 1;
+   }
+   else if(celem->cid == BUZZCHUNK_BID_FORCE_ALLOCATION && buzzdarray_isempty(celem->checkednids)){
+      buzzbstig_cmonitor_remove(vm->cmonitor->bidder,celem);            
+      return 1;   
+   }
+   uint16_t left = buzzbstig_cmonitor_left(vm, celem);
+   if((int32_t)(celem->deadline - buzztimerwheel_now(vm->cmonitor->timers)) > 0){
+      if(celem->cid == BUZZCHUNK_BID_ALLOCATION && (left == MAX_TIME_TO_HOLD_SPACE_FOR_A_BID/4 || 
+                                                   left == MAX_TIME_TO_HOLD_SPACE_FOR_A_BID/3  ||
+                                                   left == MAX_TIME_TO_HOLD_SPACE_FOR_A_BID/2) ){
+         /* Look for blob holder */
+         const buzzdict_t* s = buzzdict_get(vm->blobs, &(celem->id), buzzdict_t);
+         const buzzblob_elem_t* v_blob = NULL;
+         /*Nothing to do, if bs id doesnot exsist*/
+         if(s){
+            /* Look for blob key in blob bstig slot*/
+            v_blob = buzzdict_get(*s, &(celem->key), buzzblob_elem_t);
+         }
+         if(v_blob){
+            for(int b = 0; b< buzzdarray_size(celem->checkednids);b++){
+               printf("[RID %u ]Resending a new alloc message due to no responce \n",vm->robot);
+               buzzblob_bidder_t bidelem = buzzdarray_get(celem->checkednids,b,buzzblob_bidder_t);
+               /* ReSend an allocation messsage due to no responce */
+               buzzoutmsg_queue_append_bid(vm,
+                                            BUZZMSG_BSTIG_BLOB_BID,
+                                            celem->id,
+                                            celem->key,
+                                            bidelem->rid,
+                                            bidelem->availablespace,
+                                            (*v_blob)->size,
+                                            (*v_blob)->hash,
+                                            bidelem->role,
+                                            (uint16_t) BUZZCHUNK_BID_ALLOCATION,
+                                            bidelem->rid);
             }
          }
       }
+      buzzbstig_cmonitor_check(vm, celem);
+      return 0;
+   }
+   if(celem->cid == BUZZBSTIG_BID_NEW ){
+      /* Check for queue clogging */
+      /* If yes, delay allcoaiton */
+      if(buzzqueue_size(vm->outmsgs->queues[BUZZMSG_BSTIG_BLOB_BID]) > QUEUE_CLOGGING_PROTECTOR_QUEUE_SIZE ){
+         buzzbstig_cmonitor_wait(vm, celem, BUZZCHUNK_TIMER_BIDDER, MAX_TIME_FOR_THE_BIDDER);
+      }
       else{
-         if(celem->cid == BUZZBSTIG_BID_NEW ){
-            /* Check for queue clogging */
-            /* If yes, delay allcoaiton */
-            if(buzzdarray_size(vm->outmsgs->queues[BUZZMSG_BSTIG_BLOB_BID]) > QUEUE_CLOGGING_PROTECTOR_QUEUE_SIZE ){
-                celem->time_to_wait = MAX_TIME_FOR_THE_BIDDER;
-
+         uint16_t allocsize=0;
+         /* Look for blob holder */
+         const buzzdict_t* s = buzzdict_get(vm->blobs, &(celem->id), buzzdict_t);
+         const buzzblob_elem_t* v_blob = NULL;
+         /*Nothing to do, if bs id doesnot exsist*/
+         if(s){
+            /* Look for blob key in blob bstig slot*/
+            v_blob = buzzdict_get(*s, &(celem->key), buzzblob_elem_t);
+         }
+         if(v_blob){
+            uint16_t chunkpieces =  buzzbstig_blob_chunk_num(*v_blob);
+            /* Create a new element inside cmon bidder for allocation monitoring */
+            buzzchunk_reloc_elem_t newelem =(buzzchunk_reloc_elem_t)calloc(1, sizeof(struct buzzchunk_reloc_elem_s));
+            newelem->id = celem->id;
+            newelem->key = celem->key;
+            newelem->cid = BUZZCHUNK_BID_ALLOCATION;
+            newelem->bidsize = 0; 
+            newelem->time_to_destroy = 0;
+            newelem->checkednids = buzzdarray_new(10,sizeof(buzzblob_bidder_t),buzzbstig_blob_bidderelem_destroy);
+            buzzdarray_push(vm->cmonitor->bidder,&newelem);
+            if(!buzzdarray_isempty(celem->checkednids))
+            /* Sort the allocation array in the accending order */
+            buzzdarray_sort(celem->checkednids,buzzbstig_blob_bidderpriority_key_cmp);
+            /* Time for bidders is done, start allocating */
+            for(int j = buzzdarray_size(celem->checkednids)-1; j >= 0 && allocsize < chunkpieces; j--){
+               const buzzblob_bidder_t bidelem = 
+                        buzzdarray_get(celem->checkednids,j,buzzblob_bidder_t);
+               uint16_t allocated_size = (allocsize + bidelem->availablespace < chunkpieces) ? bidelem->availablespace : chunkpieces - allocsize;  
+               /* Highest rid gets bid size, send an allocation message */
+               buzzblob_bidder_t addbider = (buzzblob_bidder_t)malloc(sizeof(struct buzzblob_bidder_s));
+               addbider->rid = bidelem->rid;
+               addbider->role =  bidelem->role; 
+               addbider->availablespace = allocated_size;
+               /* Add the size to allocated size */
+               allocsize+=allocated_size;
+               buzzdarray_push(newelem->checkednids, &(addbider) );
+               /* Send an allocation messsage */
+               buzzoutmsg_queue_append_bid(vm,
+                                            BUZZMSG_BSTIG_BLOB_BID,
+                                            celem->id,
+                                            celem->key,
+                                            bidelem->rid,
+                                            allocated_size,
+                                            (*v_blob)->size,
+                                            (*v_blob)->hash,
+                                            bidelem->role,
+                                            (uint16_t) BUZZCHUNK_BID_ALLOCATION,
+                                            bidelem->rid);
             }
-            else{
-               uint16_t allocsize=0;
-               /* Look for blob holder */
-               const buzzdict_t* s = buzzdict_get(vm->blobs, &(celem->id), buzzdict_t);
-               const buzzblob_elem_t* v_blob = NULL;
-               /*Nothing to do, if bs id doesnot exsist*/
-               if(s){
-                  /* Look for blob key in blob bstig slot*/
-                  v_blob = buzzdict_get(*s, &(celem->key), buzzblob_elem_t);
-               }
-               if(v_blob){
-                  uint16_t chunkpieces =  ceil(((float)(*v_blob)->size/(float)BLOB_CHUNK_SIZE));
-                  /* Create a new element inside cmon bidder for allocation monitoring */
-                  buzzchunk_reloc_elem_t newelem =(buzzchunk_reloc_elem_t)malloc(sizeof(struct buzzchunk_reloc_elem_s));
-                  newelem->id = celem->id;
-                  newelem->key = celem->key;
-                  newelem->cid = BUZZCHUNK_BID_ALLOCATION;
-                  newelem->bidsize = 0; 
-                  newelem->time_to_wait = MAX_TIME_TO_HOLD_SPACE_FOR_A_BID;
-                  newelem->time_to_destroy = 0;
-                  newelem->checkednids = buzzdarray_new(10,sizeof(buzzblob_bidder_t),buzzbstig_blob_bidderelem_destroy);
-                  buzzdarray_push(vm->cmonitor->bidder,&newelem);
-                  if(!buzzdarray_isempty(celem->checkednids))
-                  /* Sort the allocation array in the accending order */
-                  buzzdarray_sort(celem->checkednids,buzzbstig_blob_bidderpriority_key_cmp);
-                  /* Time for bidders is done, start allocating */
-                  for(int j = buzzdarray_size(celem->checkednids)-1; j >= 0 && allocsize < chunkpieces; j--){
-                     const buzzblob_bidder_t bidelem = 
-                              buzzdarray_get(celem->checkednids,j,buzzblob_bidder_t);
-                     uint16_t allocated_size = (allocsize + bidelem->availablespace < chunkpieces) ? bidelem->availablespace : chunkpieces - allocsize;  
-                     /* Highest rid gets bid size, send an allocation message */
-                     buzzblob_bidder_t addbider = (buzzblob_bidder_t)malloc(sizeof(struct buzzblob_bidder_s));
-                     addbider->rid = bidelem->rid;
-                     addbider->role =  bidelem->role; 
-                     addbider->availablespace = allocated_size;
-                     /* Add the size to allocated size */
-                     allocsize+=allocated_size;
-                     buzzdarray_push(newelem->checkednids, &(addbider) );
-                     /* Send an allocation messsage */
-                     buzzoutmsg_queue_append_bid(vm,
-                                                  BUZZMSG_BSTIG_BLOB_BID,
-                                                  celem->id,
-                                                  celem->key,
-                                                  bidelem->rid,
-                                                  allocated_size,
-                                                  (*v_blob)->size,
-                                                  (*v_blob)->hash,
-                                                  bidelem->role,
-                                                  (uint16_t) BUZZCHUNK_BID_ALLOCATION,
-                                                  bidelem->rid);
-                  }
-                  celem->time_to_wait = MAX_UINT16; // this will not trigger an allocation round again, TODO: Can be done better.
-                  if(allocsize < chunkpieces){
-                     /* Could not allocate all chunks, intiate the priority policy and remove the oldest blob */
-                     /* create a darray for storing the id and key in accending order of priority */
-                     buzzdarray_t priority = buzzdarray_new(5, sizeof(struct buzzbstig_blobpriority_list_param*), 
-                                                            buzzpriority_struct_destroy);
-                     struct buzzbstig_blobpriority_loop2_param p = {.id =0, .plist=priority, .option = 2};
-                     /* Update the priority list of blobs */
-                     buzzdict_foreach(vm->blobs, buzzbstig_blobpriority_loop1, &p);
-                     /* Get the first blob and try force allocation */
-                      if(!buzzdarray_isempty(priority) ){
-                        for(uint16_t pi=0; pi < buzzdarray_size(priority) && 
-                            allocsize < chunkpieces; pi++){
-                           const struct buzzbstig_blobpriority_list_param* pe = buzzdarray_get(priority, pi, struct buzzbstig_blobpriority_list_param*);
-                           /* Fetch the entries in order form priority list */
-                           const buzzdict_t* s = buzzdict_get(vm->blobs, &(pe->id), buzzdict_t);
-                           if(s){
-                              /* Look for blob key in blob bstig slot*/
-                              const buzzblob_elem_t* v_blob = buzzdict_get(*s, &(pe->key), buzzblob_elem_t);
-                              if(v_blob){
-                                 /* Create a chunk montior for force allocation */
-                                 buzzchunk_reloc_elem_t newelem =(buzzchunk_reloc_elem_t)malloc(sizeof(struct buzzchunk_reloc_elem_s));
-                                 newelem->id = celem->id;
-                                 newelem->key = celem->key;
-                                 newelem->cid = BUZZCHUNK_BID_FORCE_ALLOCATION;
-                                 newelem->bidsize = 0;  // temp hold the last id from priority list
-                                 newelem->time_to_wait = MAX_TIME_TO_HOLD_SPACE_FOR_A_BID;
-                                 newelem->time_to_destroy = 0; // temp hold the last key from priority list
-                                 newelem->checkednids = buzzdarray_new(10,sizeof(buzzblob_bidder_t),buzzbstig_blob_bidderelem_destroy);
-                           
-                                 /* Add the allocaiton element into the bidder */
-                                 buzzdarray_push(vm->cmonitor->bidder,&newelem);
-                                 for(int l=0;l<buzzdarray_size((*v_blob)->locations) && 
-                                       allocsize < chunkpieces; l++){
-                                    /* Get the first location element of lowest priority blob */
-                                    buzzblob_location_t lowloc = buzzdarray_get((*v_blob)->locations,l, buzzblob_location_t);
-                                    /* Allocate if I am not allocating to myself */
-                                    if(lowloc->rid != vm->robot){
-                                       /* Force allocate the chunk */
-                                       uint16_t allocated_size = (allocsize + lowloc->availablespace < chunkpieces) ? lowloc->availablespace : chunkpieces - allocsize;  
-                                       buzzblob_bidder_t addbider = (buzzblob_bidder_t)malloc(sizeof(struct buzzblob_bidder_s));
-                                       addbider->rid = lowloc->rid;
-                                       addbider->role =  0; 
-                                       addbider->availablespace = allocated_size;
-                                       /* Add the size to allocated size */
-                                       allocsize+=allocated_size;
-                                       buzzdarray_push(newelem->checkednids, &(addbider) );
-                                       /* Send a force allocation messsage */
-                                       buzzoutmsg_queue_append_bid(vm,
-                                                                    BUZZMSG_BSTIG_BLOB_BID,
-                                                                    celem->id,
-                                                                    celem->key,
-                                                                    lowloc->rid,
-                                                                    allocated_size,
-                                                                    pe->id,
-                                                                    pe->key,
-                                                                    0,
-                                                                    (uint16_t) BUZZCHUNK_BID_FORCE_ALLOCATION,
-                                                                    lowloc->rid);
-                                    }
-                                 }
-                                 newelem->bidsize = pe->id;  // temp hold the last id 
-                                 newelem->time_to_destroy = pe->key; // temp hold the last key
+            buzzbstig_cmonitor_wait(vm, newelem, BUZZCHUNK_TIMER_BIDDER, MAX_TIME_TO_HOLD_SPACE_FOR_A_BID);
+            buzzbstig_cmonitor_wait(vm, celem, BUZZCHUNK_TIMER_BIDDER, MAX_UINT16); // this will not trigger an allocation round again, TODO: Can be done better.
+            if(allocsize < chunkpieces){
+               /* Could not allocate all chunks, intiate the priority policy and remove the oldest blob */
+               /* Get the first blob and try force allocation */
+                if(!buzzblobprio_isempty(vm->blobprio) ){
+                  for(buzzblobprio_node_t pe = buzzblobprio_first(vm->blobprio);
+                      pe && allocsize < chunkpieces; pe = buzzblobprio_next(pe)){
+                     /* Fetch the entries in order form priority list */
+                     const buzzdict_t* s = buzzdict_get(vm->blobs, &(pe->id), buzzdict_t);
+                     if(s){
+                        /* Look for blob key in blob bstig slot*/
+                        const buzzblob_elem_t* v_blob = buzzdict_get(*s, &(pe->key), buzzblob_elem_t);
+                        if(v_blob){
+                           /* Create a chunk montior for force allocation */
+                           buzzchunk_reloc_elem_t newelem =(buzzchunk_reloc_elem_t)calloc(1, sizeof(struct buzzchunk_reloc_elem_s));
+                           newelem->id = celem->id;
+                           newelem->key = celem->key;
+                           newelem->cid = BUZZCHUNK_BID_FORCE_ALLOCATION;
+                           newelem->bidsize = 0;  // temp hold the last id from priority list
+                           newelem->time_to_destroy = 0; // temp hold the last key from priority list
+                           newelem->checkednids = buzzdarray_new(10,sizeof(buzzblob_bidder_t),buzzbstig_blob_bidderelem_destroy);
+                     
+                           /* Add the allocaiton element into the bidder */
+                           buzzdarray_push(vm->cmonitor->bidder,&newelem);
+                           for(int l=0;l<buzzdarray_size((*v_blob)->locations) && 
+                                 allocsize < chunkpieces; l++){
+                              /* Get the first location element of lowest priority blob */
+                              buzzblob_location_t lowloc = buzzdarray_get((*v_blob)->locations,l, buzzblob_location_t);
+                              /* Allocate if I am not allocating to myself */
+                              if(lowloc->rid != vm->robot){
+                                 /* Force allocate the chunk */
+                                 uint16_t allocated_size = (allocsize + lowloc->availablespace < chunkpieces) ? lowloc->availablespace : chunkpieces - allocsize;  
+                                 buzzblob_bidder_t addbider = (buzzblob_bidder_t)malloc(sizeof(struct buzzblob_bidder_s));
+                                 addbider->rid = lowloc->rid;
+                                 addbider->role =  0; 
+                                 addbider->availablespace = allocated_size;
+                                 /* Add the size to allocated size */
+                                 allocsize+=allocated_size;
+                                 buzzdarray_push(newelem->checkednids, &(addbider) );
+                                 /* Send a force allocation messsage */
+                                 buzzoutmsg_queue_append_bid(vm,
+                                                              BUZZMSG_BSTIG_BLOB_BID,
+                                                              celem->id,
+                                                              celem->key,
+                                                              lowloc->rid,
+                                                              allocated_size,
+                                                              pe->id,
+                                                              pe->key,
+                                                              0,
+                                                              (uint16_t) BUZZCHUNK_BID_FORCE_ALLOCATION,
+                                                              lowloc->rid);
                               }
-
                            }
-
+                           newelem->bidsize = pe->id;  // temp hold the last id 
+                           newelem->time_to_destroy = pe->key; // temp hold the last key
+                           buzzbstig_cmonitor_wait(vm, newelem, BUZZCHUNK_TIMER_BIDDER, MAX_TIME_TO_HOLD_SPACE_FOR_A_BID);
                         }
+
                      }
-                     else{
-                        printf("[RID: %u] ERROR, Trying to force allocate but no blob exsist to remove, try increasing available size\n", vm->robot );   
-                     }
-                     if(allocsize < chunkpieces)
-                        printf("[RID: %u] ERROR, Trying to force allocate but no blob exsist to remove, try increasing available size\n", vm->robot );
-                     buzzdarray_destroy(&priority);  
+
                   }
                }
                else{
-                  /* It is a bug, bid intiated without a blob*/
+                  printf("[RID: %u] ERROR, Trying to force allocate but no blob exsist to remove, try increasing available size\n", vm->robot );   
                }
+               if(allocsize < chunkpieces)
+                  printf("[RID: %u] ERROR, Trying to force allocate but no blob exsist to remove, try increasing available size\n", vm->robot );
             }
-
-         }
-         else if(celem->cid == BUZZBSITG_BID_REPLY){
-            /* MAX time for allocation expired, simply remove the entry  */
-            buzzdarray_remove(vm->cmonitor->bidder,i);  
-            return;       
-
          }
-         else if(celem->cid == BUZZCHUNK_BID_ALLOCATION){
-            /* Max time to allocate exceded force a robot to eject a blob and place the new one instead */   
-            printf("[RID %u] [ERROR] Max time to allocate blocks exceeded, try increasing max time to allocate \n", vm->robot);
-            //buzzdarray_remove(vm->cmonitor->bidder,i); 
-            return;       
-         }
-         else if(celem->cid == BUZZCHUNK_BID_ALLOC_ACCEPT){
-            /* MAX time for allocation expired, simply remove the entry  */
-            buzzdarray_remove(vm->cmonitor->bidder,i);         
-            return;
-         }
-         else if(celem->cid == BUZZCHUNK_BID_ALLOC_REJECT){
-            /* MAX time for allocation expired, simply remove the entry  */
-            buzzdarray_remove(vm->cmonitor->bidder,i);         
-            return;
-         }
-      }
-      if(celem->cid == BUZZCHUNK_BID_ALLOCATION && buzzdarray_isempty(celem->checkednids) ){
-         /* Clear all bid info related to this blob once allocation complete */
-         uint16_t id = celem->id, key = celem->key;
-         buzzdarray_remove(vm->cmonitor->bidder,i);
-         struct buzzchunk_reloc_elem_s cmpelem = {.id = id, .key = key, .cid=BUZZBSTIG_BID_NEW};
-         buzzchunk_reloc_elem_t newelem = &cmpelem;
-         uint16_t cmonindex = buzzdarray_find(vm->cmonitor->bidder,buzzvm_cmonitor_reloc_elem_key_cmp,&newelem);
-         if(cmonindex !=buzzdarray_size(vm->cmonitor->bidder)){
-            buzzdarray_remove(vm->cmonitor->bidder,cmonindex);
-            return;
+         else{
+            /* It is a bug, bid intiated without a blob*/
          }
       }
-      else if(celem->cid == BUZZCHUNK_BID_FORCE_ALLOCATION && buzzdarray_isempty(celem->checkednids)){
-         
-         buzzdarray_remove(vm->cmonitor->bidder,i);            
-         return;   
-      }
-
    }
+   else if(celem->cid == BUZZBSITG_BID_REPLY){
+      /* MAX time for allocation expired, simply remove the entry  */
+      buzzbstig_cmonitor_remove(vm->cmonitor->bidder,celem);  
+      return 1;       
+   }
+   else if(celem->cid == BUZZCHUNK_BID_ALLOCATION){
+      /* Max time to allocate exceded force a robot to eject a blob and place the new one instead */   
+      printf("[RID %u] [ERROR] Max time to allocate blocks exceeded, try increasing max time to allocate \n", vm->robot);
+   }
+   else if(celem->cid == BUZZCHUNK_BID_ALLOC_ACCEPT){
+      /* MAX time for allocation expired, simply remove the entry  */
+      buzzbstig_cmonitor_remove(vm->cmonitor->bidder,celem);         
+      return 1;
+   }
+   else if(celem->cid == BUZZCHUNK_BID_ALLOC_REJECT){
+      /* MAX time for allocation expired, simply remove the entry  */
+      buzzbstig_cmonitor_remove(vm->cmonitor->bidder,celem);         
+      return 1;
+   }
+   return 0;
 }
 
-void buzzbstig_blobgetters_update(buzzvm_t vm){
-   for(uint16_t ch = 0; ch< buzzdarray_size(vm->cmonitor->getters);ch++){
-      const buzzchunk_reloc_elem_t getterelem = buzzdarray_get(vm->cmonitor->getters,ch,buzzchunk_reloc_elem_t);
-      if(getterelem->time_to_wait>0){
-         getterelem->time_to_wait--;
-         //  const buzzbstig_t* vs = buzzdict_get(vm->bstigs, &(getterelem->id), buzzbstig_t);
-         // printf("RID %u role %u\n", vm->robot, (*vs)->getter );
+/* Handles the timer of an element of the getter list, returns 1 if it was removed */
+static int buzzbstig_getter_timeout(buzzvm_t vm,
+                                    buzzchunk_reloc_elem_t getterelem) {
+   if(getterelem->cid == BUZZBLOB_GETTER_NEIGH ){
+      /* Look for blob stigmergy */
+      const buzzbstig_t* vs = buzzdict_get(vm->bstigs, &(getterelem->id), buzzbstig_t);
+      if(vs){
+         (*vs)->getter = BUZZBLOB_GETTER_OPEN;
+      }
+      buzzbstig_cmonitor_remove(vm->cmonitor->getters,getterelem);
+      return 1;
+   }
+   else if(getterelem->cid == BUZZBLOB_GETTER){
+      /* Look for blob stigmergy */
+      const buzzbstig_t* vs = buzzdict_get(vm->bstigs, &(getterelem->id), buzzbstig_t);
+      if(vs){
+         /* Inform the neighbours about this */
+         buzzoutmsg_queue_append_blob_status(vm, BUZZMSG_BSTIG_STATUS, getterelem->id,
+                                                   BROADCAST_MESSAGE_CONSTANT, BUZZBLOB_SETGETTER,vm->robot,NULL); 
+         buzzbstig_cmonitor_wait(vm, getterelem, BUZZCHUNK_TIMER_GETTER, TIME_TO_REFRESH_GETTER_STATE);
       }
       else{
-         if(getterelem->cid == BUZZBLOB_GETTER_NEIGH ){
-            /* Look for blob stigmergy */
-            const buzzbstig_t* vs = buzzdict_get(vm->bstigs, &(getterelem->id), buzzbstig_t);
-            if(vs){
-               (*vs)->getter = BUZZBLOB_GETTER_OPEN;
+         buzzbstig_cmonitor_remove(vm->cmonitor->getters,getterelem);
+         return 1;
+      }
+   }  
+   return 0;
+}
+
+/* Handles the timer of an element of the blob request list, returns 1 if it was removed */
+static int buzzbstig_blobrequest_timeout(buzzvm_t vm,
+                                         buzzchunk_reloc_elem_t requestelem) {
+   if(requestelem->cid == BUZZBLOB_REQUESTED_LOCATIONS ){
+      buzzbstig_cmonitor_remove(vm->cmonitor->blobrequest,requestelem);
+      return 1;
+   }
+   else if(requestelem->cid == BUZZBLOB_WAITING_TO_REQUEST_LOCATIONS ){
+      /* Check for allocation */
+      /* look for bs */
+      const buzzdict_t* s = buzzdict_get(vm->blobs, &(requestelem->id), buzzdict_t);
+      if(s){
+         /* Look for blob key in blob bstig slot*/
+         const buzzblob_elem_t* v_blob = buzzdict_get(*s, &(requestelem->key), buzzblob_elem_t);
+         if(v_blob){
+            uint16_t chunk_num = buzzbstig_blob_chunk_num(*v_blob);
+            uint16_t avilable = 0; 
+            for(int i=0;i<buzzdarray_size((*v_blob)->locations);i++){
+               /* Get thelocation elements and calculate the space */
+               buzzblob_location_t lowloc = buzzdarray_get((*v_blob)->locations,i, buzzblob_location_t);
+               avilable+=lowloc->availablespace;                  
             }
-            buzzdarray_remove(vm->cmonitor->getters,ch);
-         }
-         else if(getterelem->cid == BUZZBLOB_GETTER){
-            /* Look for blob stigmergy */
-            const buzzbstig_t* vs = buzzdict_get(vm->bstigs, &(getterelem->id), buzzbstig_t);
-            if(vs){
-               /* Inform the neighbours about this */
-               buzzoutmsg_queue_append_blob_status(vm, BUZZMSG_BSTIG_STATUS, getterelem->id,
-                                                         BROADCAST_MESSAGE_CONSTANT, BUZZBLOB_SETGETTER,vm->robot); 
-               getterelem->time_to_wait = TIME_TO_REFRESH_GETTER_STATE;
+            /* Is the blob under transport ? then append a request to locations */
+            if(avilable >= chunk_num){
+               /* Ask all locations for the blob on behalf of the requester */
+               buzzbstig_blob_fetch(vm, requestelem->id, requestelem->key, *v_blob, requestelem->bidsize, NULL);
+               buzzbstig_cmonitor_remove(vm->cmonitor->blobrequest,requestelem);
+               return 1;
             }
             else{
-               buzzdarray_remove(vm->cmonitor->getters,ch);
+               buzzbstig_cmonitor_wait(vm, requestelem, BUZZCHUNK_TIMER_REQUEST, TIME_TO_FORGET_BLOB_REQUEST);
             }
-
-         }  
+         }
+         else{
+            buzzbstig_cmonitor_remove(vm->cmonitor->blobrequest,requestelem);
+            return 1;
+         }
       }
    }
-}
-void buzzbstig_blobrequest_update(buzzvm_t vm){
-   for(uint16_t ch = 0; ch< buzzdarray_size(vm->cmonitor->blobrequest);ch++){
-      const buzzchunk_reloc_elem_t requestelem = buzzdarray_get(vm->cmonitor->blobrequest,ch,buzzchunk_reloc_elem_t);
-      // printf("rid %u Cmon elem %i , k: %u, id: %u type : %u  time : %u \n",vm->robot,ch,requestelem->key,requestelem->id,requestelem->cid,requestelem->time_to_wait);
-      
-      if(requestelem->time_to_wait > 0)
-            requestelem->time_to_wait--;
-      else{
-         if(requestelem->cid == BUZZBLOB_REQUESTED_LOCATIONS ){
-               buzzdarray_remove(vm->cmonitor->blobrequest,ch);
-         }
-         else if(requestelem->cid == BUZZBLOB_WAITING_TO_REQUEST_LOCATIONS ){
-            /* Check for allocation */
-            /* look for bs */
-            const buzzdict_t* s = buzzdict_get(vm->blobs, &(requestelem->id), buzzdict_t);
-            if(s){
-               /* Look for blob key in blob bstig slot*/
-               const buzzblob_elem_t* v_blob = buzzdict_get(*s, &(requestelem->key), buzzblob_elem_t);
-               if(v_blob){
-                  uint16_t chunk_num = ceil( (float)(*v_blob)->size/(float)BLOB_CHUNK_SIZE);
-                  uint16_t avilable = 0; 
-                  for(int i=0;i<buzzdarray_size((*v_blob)->locations);i++){
-                     /* Get thelocation elements and calculate the space */
-                     buzzblob_location_t lowloc = buzzdarray_get((*v_blob)->locations,i, buzzblob_location_t);
-                     avilable+=lowloc->availablespace;                  
-                  }
-                  /* Is the blob under transport ? then append a request to locations */
-                  if(avilable >= chunk_num){
-                     /* Send a message to all locations  asking for blob*/
-                     for(int i=0;i<buzzdarray_size((*v_blob)->locations);i++){
-                        /* Get the first location element of lowest priority blob */
-                        buzzblob_location_t lowloc = buzzdarray_get((*v_blob)->locations,i, buzzblob_location_t);
-                        // printf("[ROBOT %u] BUZZBLOB_WAITING_TO_REQUEST_LOCATIONS Request monitor Requested blob for requester : %u id: %u key %u avilable %u chunk_num %u location %u\n",
-                        //    vm->robot,requestelem->bidsize,requestelem->id, requestelem->key,avilable, chunk_num, lowloc->rid);    
-                        buzzoutmsg_queue_append_blob_request(vm,
-                                                        BUZZMSG_BSTIG_BLOB_REQUEST,
-                                                        requestelem->id,
-                                                        requestelem->key,
-                                                        lowloc->rid,
-                                                        requestelem->bidsize);   
-                     }
-                     buzzdarray_remove(vm->cmonitor->blobrequest,ch);
-                  }
-                  else{
-                     requestelem->time_to_wait = TIME_TO_FORGET_BLOB_REQUEST;
-                  }
-               }
-               else{
-                  buzzdarray_remove(vm->cmonitor->blobrequest,ch);
-               }
+   else if(requestelem->cid == BUZZBLOB_STATUS_CHANGE_DONE ){
+      buzzbstig_cmonitor_remove(vm->cmonitor->blobrequest,requestelem);
+      return 1;
+   }
+   else if(requestelem->cid == BUZZBLOB_WAITING_FOR_BLOB_AVILABILITY ){
+      /* Find whether you have all the chunks */
+      /* Look for blob holder and create a new if none exsists */
+      const buzzdict_t* s = buzzdict_get(vm->blobs, &(requestelem->id), buzzdict_t);
+      const buzzblob_elem_t* v_blob = NULL;
+      /*Nothing to do, if bs id doesnot exsist*/
+      if(s){
+         /* Look for blob key in blob bstig slot*/
+         v_blob = buzzdict_get(*s, &(requestelem->key), buzzblob_elem_t);
+         if(v_blob){   
+            uint16_t available_size=0;
+            for(int i=0;i<buzzdarray_size((*v_blob)->locations);i++){
+               /* Get thelocation elements and calculate the space */
+               buzzblob_location_t lowloc = buzzdarray_get((*v_blob)->locations,i, buzzblob_location_t);
+               if(lowloc->rid == vm->robot){
+                  available_size = lowloc->availablespace;
+               }                  
             }
-         }
-         else if(requestelem->cid == BUZZBLOB_STATUS_CHANGE_DONE ){
-               buzzdarray_remove(vm->cmonitor->blobrequest,ch);
-
-         }
-         else if(requestelem->cid == BUZZBLOB_WAITING_FOR_BLOB_AVILABILITY ){
-            /* Find whether you have all the chunks */
-            /* Look for blob holder and create a new if none exsists */
-            const buzzdict_t* s = buzzdict_get(vm->blobs, &(requestelem->id), buzzdict_t);
-            const buzzblob_elem_t* v_blob = NULL;
-            /*Nothing to do, if bs id doesnot exsist*/
-            if(s){
-               /* Look for blob key in blob bstig slot*/
-               v_blob = buzzdict_get(*s, &(requestelem->key), buzzblob_elem_t);
-               if(v_blob){   
-                  uint16_t available_size=0;
-                  for(int i=0;i<buzzdarray_size((*v_blob)->locations);i++){
-                     /* Get thelocation elements and calculate the space */
-                     buzzblob_location_t lowloc = buzzdarray_get((*v_blob)->locations,i, buzzblob_location_t);
-                     if(lowloc->rid == vm->robot){
-                        available_size = lowloc->availablespace;
-                     }                  
-                  }
-                  /* All chunks are avilable unicast it */
-                  if(buzzdarray_size((*v_blob)->available_list) >= available_size){
-                      /* Create an element for key */
-                     buzzobj_t k = buzzobj_new(BUZZTYPE_INT);  // TODO : try to unify args and hence avoid creation of buzzobj
-                     k->i.value = requestelem->key;
-                     /* Look for virtual stigmergy */
-                     const buzzbstig_t* vs = buzzdict_get(vm->bstigs, &(requestelem->id), buzzbstig_t);
-                     /* Fetch the element */
-                     const buzzbstig_elem_t* l = buzzbstig_fetch(*vs, &k);
-                     for(int i=0;i < buzzdarray_size((*v_blob)->available_list);i++){
-                        uint16_t cid = buzzdarray_get((*v_blob)->available_list,i,uint16_t);
-                        const buzzblob_chunk_t* cdata = buzzdict_get((*v_blob)->data, &cid, buzzblob_chunk_t);
-
-                        // printf("Delayed unicasting id: %u k: %u on request from %u chunk: %i , cid : %u\n",requestelem->id, requestelem->key, requestelem->bidsize, i,cid  );
-                        /* Add to P2P Queue */
-                        buzzoutmsg_queue_append_chunk(vm,
-                                                      BUZZMSG_BSTIG_CHUNK_PUT,
-                                                      requestelem->id,
-                                                      k,
-                                                      *l,
-                                                      (*v_blob)->size,
-                                                      cid,
-                                                      *cdata,
-                                                      requestelem->bidsize);
-                     }
-                     buzzobj_destroy(&k);
-                     buzzdarray_remove(vm->cmonitor->blobrequest,ch);
-                  }
-                  else{
-                     requestelem->time_to_wait = TIME_TO_REFRESH_GETTER_STATE;
-                  }
-               }
-               else{
-                  buzzdarray_remove(vm->cmonitor->blobrequest,ch);
+            /* All chunks are avilable unicast it */
+            if(buzzbitset_count((*v_blob)->available) >= available_size){
+                /* Create an element for key */
+               buzzobj_t k = buzzobj_new(BUZZTYPE_INT);  // TODO : try to unify args and hence avoid creation of buzzobj
+               k->i.value = requestelem->key;
+               /* Look for virtual stigmergy */
+               const buzzbstig_t* vs = buzzdict_get(vm->bstigs, &(requestelem->id), buzzbstig_t);
+               /* Fetch the element */
+               const buzzbstig_elem_t* l = buzzbstig_fetch(*vs, &k);
+               for(int64_t c = buzzbitset_next((*v_blob)->available, 0); c >= 0;
+                   c = buzzbitset_next((*v_blob)->available, c + 1)){
+                  uint16_t cid = (uint16_t)c;
+                  const buzzblob_chunk_t* cdata = buzzdict_get((*v_blob)->data, &cid, buzzblob_chunk_t);
+                  /* Add to P2P Queue */
+                  buzzoutmsg_queue_append_chunk(vm,
+                                                BUZZMSG_BSTIG_CHUNK_PUT,
+                                                requestelem->id,
+                                                k,
+                                                *l,
+                                                (*v_blob)->size,
+                                                cid,
+                                                *cdata,
+                                                requestelem->bidsize);
                }
+               buzzobj_destroy(&k);
+               buzzbstig_cmonitor_remove(vm->cmonitor->blobrequest,requestelem);
+               return 1;
+            }
+            else{
+               buzzbstig_cmonitor_wait(vm, requestelem, BUZZCHUNK_TIMER_REQUEST, TIME_TO_REFRESH_GETTER_STATE);
             }
          }
+         else{
+            buzzbstig_cmonitor_remove(vm->cmonitor->blobrequest,requestelem);
+            return 1;
+         }
+      }
+   }
+   return 0;
+}
+
+/****************************************/
+/****************************************/
+
+void buzzbstig_cmonitor_update(buzzvm_t vm){
+   buzztimerwheel_t w = vm->cmonitor->timers;
+   buzztimerwheel_tick(w);
+   buzztimer_t t;
+   while((t = buzztimerwheel_pop(w))) {
+      int removed = 0;
+      switch(t->type) {
+         case BUZZCHUNK_TIMER_BIDDER:
+            removed = buzzbstig_bidder_timeout(vm, (buzzchunk_reloc_elem_t)t->data);
+            break;
+         case BUZZCHUNK_TIMER_GETTER:
+            removed = buzzbstig_getter_timeout(vm, (buzzchunk_reloc_elem_t)t->data);
+            break;
+         case BUZZCHUNK_TIMER_REQUEST:
+            removed = buzzbstig_blobrequest_timeout(vm, (buzzchunk_reloc_elem_t)t->data);
+            break;
+         case BUZZCHUNK_TIMER_ANTIFLOOD:
+            removed = buzzoutmsg_antiflooding_timeout(vm, t->data);
+            break;
+      }
+      /* Whatever was left waiting is looked at again at the next update */
+      if(!removed && !buzztimer_pending(t)) {
+         if(t->type != BUZZCHUNK_TIMER_ANTIFLOOD)
+            ((buzzchunk_reloc_elem_t)t->data)->deadline = buzztimerwheel_now(w) + 1;
+         buzztimer_schedule(w, t, 1);
       }
    }
 }
@@ -1873,117 +2354,429 @@ return -1;
 /****************************************/
 /****************************************/
    
-uint32_t* buzzbstig_md5(const char* in_blob, uint32_t size) {
-   uint8_t* blob = (uint8_t*) malloc(sizeof(char)*size);
-   memcpy(blob,in_blob,sizeof(char)*size);
-   /* Generate md5 hash */    
-   uint32_t* h = (uint32_t*) malloc(sizeof(uint32_t)*4); 
-   uint8_t *msg = NULL;
-   /* All variables are unsigned 32 bit and wrap modulo 2^32 when calculating,
-    * r specifies the per-round shift amounts
-    */ 
-   uint32_t r[] = {7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
-                   5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20,
-                   4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
-                   6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21};
-   /* Use binary integer part of the sines of integers (in radians) as constants
-    * Initialize variables:
-    */
-   uint32_t k[] = {
-        0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee,
-        0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
-        0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
-        0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
-        0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa,
-        0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
-        0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed,
-        0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
-        0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c,
-        0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
-        0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05,
-        0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
-        0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039,
-        0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
-        0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
-        0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391};
- 
-   h[0] = 0x67452301;
-   h[1] = 0xefcdab89;
-   h[2] = 0x98badcfe;
-   h[3] = 0x10325476;
- 
-   /* Pre-processing: adding a single 1 bit
-    *  append "1" bit to message    
-    *  Notice: the input bytes are considered as bits strings,
-    *  where the first bit is the most significant bit of the byte.[37] 
-    */
-   int new_len;
-   for(new_len = size*8 + 1; new_len%512!=448; new_len++);
-   new_len /= 8;
-   /* append 0bits and allocate 64 extra bytes */ 
-   msg = calloc(new_len + 64, 1); 
-   memcpy(msg, blob, size);
-   msg[size] = 128; 
-   /* append length at the end of the buffer*/
-   uint32_t bits_len = 8*size; 
-   memcpy(msg + new_len, &bits_len, 4);         
-   /*Process messages in 512-bit chunks */
-   int offset;
-   for(offset=0; offset<new_len; offset += (512/8)) {
-      /* Break chunk into sixteen 32-bit words w[j], 0 ≤ j ≤ 15 */
-      uint32_t *w = (uint32_t *) (msg + offset);
-      /* Initialize hash value for this chunk */
-      uint32_t a = h[0];
-      uint32_t b = h[1];
-      uint32_t c = h[2];
-      uint32_t d = h[3];
-      for(uint32_t i = 0; i<64; i++) {
-         uint32_t f, g;
-         if (i < 16) {
-            f = (b & c) | ((~b) & d);
-            g = i;
-         }
-         else if (i < 32) {
-            f = (d & b) | ((~d) & c);
-            g = (5*i + 1) % 16;
-         } 
-         else if (i < 48) {
-            f = b ^ c ^ d;
-            g = (3*i + 5) % 16;          
-         }
-         else {
-            f = c ^ (b | (~d));
-            g = (7*i) % 16;
-         }
-         uint32_t temp = d;
-         d = c;
-         c = b;
-         b = b + LEFTROTATE((a + f + k[i] + w[g]), r[i]);
-         a = temp;
-      }   
-      /* Add this chunk's hash to the result */
-      h[0] += a;
-      h[1] += b;
-      h[2] += c;
-      h[3] += d;
+/* Per-round shift amounts */
+static const uint32_t BUZZBSTIG_MD5_R[] = {
+   7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+   5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20, 5,  9, 14, 20,
+   4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+   6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21};
+
+/* Binary integer part of the sines of integers (in radians) */
+static const uint32_t BUZZBSTIG_MD5_K[] = {
+   0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee,
+   0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+   0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
+   0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+   0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa,
+   0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+   0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed,
+   0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+   0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c,
+   0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+   0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05,
+   0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+   0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039,
+   0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+   0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
+   0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391};
+
+/* Processes one 512-bit block */
+static void buzzbstig_md5_block(uint32_t* h, const uint8_t* block) {
+   /* Break block into sixteen little-endian 32-bit words w[j], 0 ≤ j ≤ 15 */
+   uint32_t w[16];
+   for(uint32_t j = 0; j < 16; ++j)
+      w[j] = (uint32_t)block[4*j]           |
+             ((uint32_t)block[4*j+1] << 8)  |
+             ((uint32_t)block[4*j+2] << 16) |
+             ((uint32_t)block[4*j+3] << 24);
+   /* Initialize hash value for this block */
+   uint32_t a = h[0];
+   uint32_t b = h[1];
+   uint32_t c = h[2];
+   uint32_t d = h[3];
+   for(uint32_t i = 0; i<64; i++) {
+      uint32_t f, g;
+      if (i < 16) {
+         f = (b & c) | ((~b) & d);
+         g = i;
+      }
+      else if (i < 32) {
+         f = (d & b) | ((~d) & c);
+         g = (5*i + 1) % 16;
+      } 
+      else if (i < 48) {
+         f = b ^ c ^ d;
+         g = (3*i + 5) % 16;          
+      }
+      else {
+         f = c ^ (b | (~d));
+         g = (7*i) % 16;
+      }
+      uint32_t temp = d;
+      d = c;
+      c = b;
+      b = b + LEFTROTATE((a + f + BUZZBSTIG_MD5_K[i] + w[g]), BUZZBSTIG_MD5_R[i]);
+      a = temp;
+   }   
+   /* Add this block's hash to the result */
+   h[0] += a;
+   h[1] += b;
+   h[2] += c;
+   h[3] += d;
+}
+
+/****************************************/
+/****************************************/
+
+void buzzbstig_md5_init(struct buzzbstig_md5_s* ctx) {
+   ctx->h[0] = 0x67452301;
+   ctx->h[1] = 0xefcdab89;
+   ctx->h[2] = 0x98badcfe;
+   ctx->h[3] = 0x10325476;
+   ctx->len = 0;
+   ctx->buflen = 0;
+}
+
+/****************************************/
+/****************************************/
+
+void buzzbstig_md5_update(struct buzzbstig_md5_s* ctx,
+                          const void* data,
+                          uint32_t size) {
+   const uint8_t* in = (const uint8_t*)data;
+   ctx->len += size;
+   /* Complete a partially filled block first */
+   if(ctx->buflen > 0) {
+      uint32_t n = 64 - ctx->buflen;
+      if(n > size) n = size;
+      memcpy(ctx->buf + ctx->buflen, in, n);
+      ctx->buflen += n;
+      in += n;
+      size -= n;
+      if(ctx->buflen < 64) return;
+      buzzbstig_md5_block(ctx->h, ctx->buf);
+      ctx->buflen = 0;
+   }
+   /* Process whole blocks straight from the input */
+   while(size >= 64) {
+      buzzbstig_md5_block(ctx->h, in);
+      in += 64;
+      size -= 64;
+   }
+   /* Keep the tail for later */
+   if(size > 0) memcpy(ctx->buf, in, size);
+   ctx->buflen = size;
+}
+
+/****************************************/
+/****************************************/
+
+void buzzbstig_md5_final(struct buzzbstig_md5_s* ctx,
+                         struct buzzbstig_md5_digest_s* digest) {
+   /* Append a single 1 bit, then 0 bits up to 448 bits mod 512 */
+   uint64_t bits_len = ctx->len * 8;
+   uint8_t pad[72];
+   uint32_t padlen = (ctx->buflen < 56) ? (56 - ctx->buflen) : (120 - ctx->buflen);
+   memset(pad, 0, sizeof(pad));
+   pad[0] = 128;
+   /* Append the length in bits as a little-endian 64-bit value */
+   for(uint32_t i = 0; i < 8; ++i)
+      pad[padlen + i] = (uint8_t)(bits_len >> (8*i));
+   buzzbstig_md5_update(ctx, pad, padlen + 8);
+   memcpy(digest->h, ctx->h, sizeof(digest->h));
+}
+
+/****************************************/
+/****************************************/
+
+void buzzbstig_md5(const char* blob,
+                   uint32_t size,
+                   struct buzzbstig_md5_digest_s* digest) {
+   struct buzzbstig_md5_s ctx;
+   buzzbstig_md5_init(&ctx);
+   buzzbstig_md5_update(&ctx, blob, size);
+   buzzbstig_md5_final(&ctx, digest);
+}
+
+/****************************************/
+/****************************************/
+
+/* Reflected Castagnoli polynomial */
+#define BUZZBSTIG_CRC32C_POLY 0x82F63B78
+
+static uint32_t buzzbstig_crc32c_table[256];
+/* VMs may run on several threads: the table is built once */
+static pthread_once_t buzzbstig_crc32c_table_once = PTHREAD_ONCE_INIT;
+
+static void buzzbstig_crc32c_table_init() {
+   for(uint32_t i = 0; i < 256; ++i) {
+      uint32_t c = i;
+      for(uint32_t j = 0; j < 8; ++j)
+         c = (c & 1) ? (c >> 1) ^ BUZZBSTIG_CRC32C_POLY : (c >> 1);
+      buzzbstig_crc32c_table[i] = c;
+   }
+}
+
+/* Software CRC32C, one byte at a time */
+static uint32_t buzzbstig_crc32c_sw(uint32_t crc, const uint8_t* data, uint32_t size) {
+   pthread_once(&buzzbstig_crc32c_table_once, buzzbstig_crc32c_table_init);
+   while(size--)
+      crc = buzzbstig_crc32c_table[(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+   return crc;
+}
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <nmmintrin.h>
+#define BUZZBSTIG_HAVE_CRC32C_HW 1
+
+/* Hardware CRC32C, eight bytes at a time */
+__attribute__((target("sse4.2")))
+static uint32_t buzzbstig_crc32c_hw(uint32_t crc, const uint8_t* data, uint32_t size) {
+   uint64_t c = crc;
+   while(size >= 8) {
+      uint64_t w;
+      memcpy(&w, data, 8);
+      c = _mm_crc32_u64(c, w);
+      data += 8;
+      size -= 8;
+   }
+   crc = (uint32_t)c;
+   while(size--)
+      crc = _mm_crc32_u8(crc, *data++);
+   return crc;
+}
+
+static int buzzbstig_crc32c_hw_available() {
+   return __builtin_cpu_supports("sse4.2");
+}
+#endif
+
+/* Updates a (pre- and post-inverted) CRC32C */
+static uint32_t buzzbstig_crc32c_update(uint32_t crc, const uint8_t* data, uint32_t size) {
+#ifdef BUZZBSTIG_HAVE_CRC32C_HW
+   if(buzzbstig_crc32c_hw_available())
+      return buzzbstig_crc32c_hw(crc, data, size);
+#endif
+   return buzzbstig_crc32c_sw(crc, data, size);
+}
+
+/****************************************/
+/****************************************/
+
+#define BUZZBSTIG_XXH_P1 0x9E3779B185EBCA87ULL
+#define BUZZBSTIG_XXH_P2 0xC2B2AE3D27D4EB4FULL
+#define BUZZBSTIG_XXH_P3 0x165667B19E3779F9ULL
+#define BUZZBSTIG_XXH_P4 0x85EBCA77C2B2AE63ULL
+#define BUZZBSTIG_XXH_P5 0x27D4EB2F165667C5ULL
+#define BUZZBSTIG_ROTL64(x, r) (((x) << (r)) | ((x) >> (64 - (r))))
+
+/* Reads a little-endian 64-bit word */
+static uint64_t buzzbstig_read64(const uint8_t* p) {
+   uint64_t v = 0;
+   for(int i = 7; i >= 0; --i) v = (v << 8) | p[i];
+   return v;
+}
+
+/* Reads a little-endian 32-bit word */
+static uint32_t buzzbstig_read32(const uint8_t* p) {
+   return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t buzzbstig_xxh64_round(uint64_t acc, uint64_t in) {
+   acc += in * BUZZBSTIG_XXH_P2;
+   acc = BUZZBSTIG_ROTL64(acc, 31);
+   return acc * BUZZBSTIG_XXH_P1;
+}
+
+static uint64_t buzzbstig_xxh64_merge(uint64_t acc, uint64_t v) {
+   acc ^= buzzbstig_xxh64_round(0, v);
+   return acc * BUZZBSTIG_XXH_P1 + BUZZBSTIG_XXH_P4;
+}
+
+static void buzzbstig_xxh64_init(struct buzzbstig_xxh64_s* ctx) {
+   ctx->v[0] = BUZZBSTIG_XXH_P1 + BUZZBSTIG_XXH_P2;
+   ctx->v[1] = BUZZBSTIG_XXH_P2;
+   ctx->v[2] = 0;
+   ctx->v[3] = -BUZZBSTIG_XXH_P1;
+   ctx->len = 0;
+   ctx->buflen = 0;
+}
+
+static void buzzbstig_xxh64_stripe(struct buzzbstig_xxh64_s* ctx, const uint8_t* p) {
+   ctx->v[0] = buzzbstig_xxh64_round(ctx->v[0], buzzbstig_read64(p));
+   ctx->v[1] = buzzbstig_xxh64_round(ctx->v[1], buzzbstig_read64(p + 8));
+   ctx->v[2] = buzzbstig_xxh64_round(ctx->v[2], buzzbstig_read64(p + 16));
+   ctx->v[3] = buzzbstig_xxh64_round(ctx->v[3], buzzbstig_read64(p + 24));
+}
+
+static void buzzbstig_xxh64_update(struct buzzbstig_xxh64_s* ctx, const uint8_t* in, uint32_t size) {
+   ctx->len += size;
+   /* Complete a partially filled stripe first */
+   if(ctx->buflen > 0) {
+      uint32_t n = 32 - ctx->buflen;
+      if(n > size) n = size;
+      memcpy(ctx->buf + ctx->buflen, in, n);
+      ctx->buflen += n;
+      in += n;
+      size -= n;
+      if(ctx->buflen < 32) return;
+      buzzbstig_xxh64_stripe(ctx, ctx->buf);
+      ctx->buflen = 0;
+   }
+   /* Process whole stripes straight from the input */
+   while(size >= 32) {
+      buzzbstig_xxh64_stripe(ctx, in);
+      in += 32;
+      size -= 32;
+   }
+   /* Keep the tail for later */
+   if(size > 0) memcpy(ctx->buf, in, size);
+   ctx->buflen = size;
+}
+
+static uint64_t buzzbstig_xxh64_final(struct buzzbstig_xxh64_s* ctx) {
+   uint64_t h;
+   if(ctx->len >= 32) {
+      h = BUZZBSTIG_ROTL64(ctx->v[0], 1)  + BUZZBSTIG_ROTL64(ctx->v[1], 7) +
+          BUZZBSTIG_ROTL64(ctx->v[2], 12) + BUZZBSTIG_ROTL64(ctx->v[3], 18);
+      for(int i = 0; i < 4; ++i) h = buzzbstig_xxh64_merge(h, ctx->v[i]);
+   }
+   else {
+      h = ctx->v[2] + BUZZBSTIG_XXH_P5;
    }
-   free(msg);
-   free(blob);
-   return h; 
+   h += ctx->len;
+   /* Mix in the pending tail */
+   const uint8_t* p = ctx->buf;
+   uint32_t n = ctx->buflen;
+   while(n >= 8) {
+      h ^= buzzbstig_xxh64_round(0, buzzbstig_read64(p));
+      h = BUZZBSTIG_ROTL64(h, 27) * BUZZBSTIG_XXH_P1 + BUZZBSTIG_XXH_P4;
+      p += 8;
+      n -= 8;
+   }
+   if(n >= 4) {
+      h ^= (uint64_t)buzzbstig_read32(p) * BUZZBSTIG_XXH_P1;
+      h = BUZZBSTIG_ROTL64(h, 23) * BUZZBSTIG_XXH_P2 + BUZZBSTIG_XXH_P3;
+      p += 4;
+      n -= 4;
+   }
+   while(n--) {
+      h ^= (*p++) * BUZZBSTIG_XXH_P5;
+      h = BUZZBSTIG_ROTL64(h, 11) * BUZZBSTIG_XXH_P1;
+   }
+   /* Avalanche */
+   h ^= h >> 33;
+   h *= BUZZBSTIG_XXH_P2;
+   h ^= h >> 29;
+   h *= BUZZBSTIG_XXH_P3;
+   h ^= h >> 32;
+   return h;
+}
+
+/****************************************/
+/****************************************/
+
+uint8_t buzzbstig_checksum_default() {
+#ifdef BUZZBSTIG_HAVE_CRC32C_HW
+   if(buzzbstig_crc32c_hw_available())
+      return BUZZBSTIG_CHECKSUM_CRC32C;
+#endif
+   return BUZZBSTIG_CHECKSUM_XXH64;
+}
+
+/****************************************/
+/****************************************/
+
+void buzzbstig_checksum_init(struct buzzbstig_checksum_s* ctx,
+                             uint8_t algo) {
+   ctx->algo = algo;
+   switch(algo) {
+      case BUZZBSTIG_CHECKSUM_MD5:
+         buzzbstig_md5_init(&(ctx->u.md5));
+         break;
+      case BUZZBSTIG_CHECKSUM_CRC32C:
+         ctx->u.crc32c = 0xFFFFFFFF;
+         break;
+      case BUZZBSTIG_CHECKSUM_XXH64:
+         buzzbstig_xxh64_init(&(ctx->u.xxh64));
+         break;
+      default:
+         fprintf(stderr, "[BUG] %s:%d: Unknown checksum algorithm %u\n", __FILE__, __LINE__, algo);
+         abort();
+   }
+}
+
+/****************************************/
+/****************************************/
+
+void buzzbstig_checksum_update(struct buzzbstig_checksum_s* ctx,
+                               const void* data,
+                               uint32_t size) {
+   switch(ctx->algo) {
+      case BUZZBSTIG_CHECKSUM_MD5:
+         buzzbstig_md5_update(&(ctx->u.md5), data, size);
+         break;
+      case BUZZBSTIG_CHECKSUM_CRC32C:
+         ctx->u.crc32c = buzzbstig_crc32c_update(ctx->u.crc32c, (const uint8_t*)data, size);
+         break;
+      case BUZZBSTIG_CHECKSUM_XXH64:
+         buzzbstig_xxh64_update(&(ctx->u.xxh64), (const uint8_t*)data, size);
+         break;
+   }
+}
+
+/****************************************/
+/****************************************/
+
+uint32_t buzzbstig_checksum_final(struct buzzbstig_checksum_s* ctx) {
+   switch(ctx->algo) {
+      case BUZZBSTIG_CHECKSUM_MD5: {
+         struct buzzbstig_md5_digest_s digest;
+         buzzbstig_md5_final(&(ctx->u.md5), &digest);
+         return digest.h[0];
+      }
+      case BUZZBSTIG_CHECKSUM_CRC32C:
+         return ~(ctx->u.crc32c);
+      case BUZZBSTIG_CHECKSUM_XXH64: {
+         uint64_t h = buzzbstig_xxh64_final(&(ctx->u.xxh64));
+         return (uint32_t)(h ^ (h >> 32));
+      }
+   }
+   return 0;
+}
+
+/****************************************/
+/****************************************/
+
+uint32_t buzzbstig_checksum(uint8_t algo,
+                            const void* data,
+                            uint32_t size) {
+   struct buzzbstig_checksum_s ctx;
+   buzzbstig_checksum_init(&ctx, algo);
+   buzzbstig_checksum_update(&ctx, data, size);
+   return buzzbstig_checksum_final(&ctx);
+}
+
+/****************************************/
+/****************************************/
+
+uint32_t buzzbstig_crc32c_portable(const void* data,
+                                   uint32_t size) {
+   return ~buzzbstig_crc32c_sw(0xFFFFFFFF, (const uint8_t*)data, size);
 }
 
 /****************************************/
 /****************************************/
 
 void buzzbtigs_serialize_key_foreach(const void* key, void* data, void* params){
-    buzzdarray_t bm = *(buzzdarray_t*) params;
+    buzzmsg_payload_t bm = *(buzzmsg_payload_t*) params;
     buzzbstig_elem_t belem = *(buzzbstig_elem_t*)((buzzbstig_elem_t*)data);
     buzzobj_t k = *(buzzobj_t*)((buzzobj_t*)key);
     // printf("Serializing key %u \n", k->i.value);
     buzzbstig_elem_serialize(bm,k,belem);
 }
 void buzzbtigs_serialize_id_foreach(const void* key, void* data, void* params){
-    buzzdarray_t bm = *(buzzdarray_t*) params;
+    buzzmsg_payload_t bm = *(buzzmsg_payload_t*) params;
     buzzbstig_t bst = *(buzzbstig_t*)((buzzbstig_t*)data);
     uint16_t id = *(uint16_t*)key;
     uint32_t bsize = buzzdict_size(bst->data);
@@ -1993,13 +2786,14 @@ void buzzbtigs_serialize_id_foreach(const void* key, void* data, void* params){
     buzzdict_foreach(bst->data,buzzbtigs_serialize_key_foreach, params);
 }
 void buzzbtigs_blobs_serialize_key_foreach(const void* key, void* data, void* params){
-    buzzdarray_t bm = *(buzzdarray_t*) params;
+    buzzmsg_payload_t bm = *(buzzmsg_payload_t*) params;
     buzzblob_elem_t bst = *(buzzblob_elem_t*)((buzzblob_elem_t*)data);
     uint16_t k = *(uint16_t*)key;
     // printf("serialization key %u\n",k );
     buzzmsg_serialize_u16(bm, k);
     buzzmsg_serialize_u32(bm, bst->hash);
     buzzmsg_serialize_u32(bm, bst->size);
+    buzzbstig_blob_codec_serialize(bm, bst->codec, bst->raw_size);
     buzzmsg_serialize_u8(bm, bst->priority);
     uint32_t locations_size = buzzdarray_size(bst->locations);
     buzzmsg_serialize_u32(bm, locations_size);
@@ -2013,7 +2807,7 @@ void buzzbtigs_blobs_serialize_key_foreach(const void* key, void* data, void* pa
 
 }
 void buzzbtigs_blobs_serialize_id_foreach(const void* key, void* data, void* params){
-    buzzdarray_t bm = *(buzzdarray_t*) params;
+    buzzmsg_payload_t bm = *(buzzmsg_payload_t*) params;
     buzzdict_t bst = *(buzzdict_t*)((buzzdict_t*)data);
     uint16_t id = *(uint16_t*)key;
     uint32_t bsize = buzzdict_size(bst);
@@ -2023,7 +2817,7 @@ void buzzbtigs_blobs_serialize_id_foreach(const void* key, void* data, void* par
     buzzdict_foreach(bst,buzzbtigs_blobs_serialize_key_foreach, params);
 }
 
-void buzzbstig_seralize_blb_stigs(buzzvm_t vm, buzzdarray_t bm){
+void buzzbstig_seralize_blb_stigs(buzzvm_t vm, buzzmsg_payload_t bm){
    uint32_t bstigs_size = buzzdict_size(vm->bstigs);
    // printf("Bstigs id dict size %u\n",bstigs_size );
    buzzmsg_serialize_u32(bm, bstigs_size);
@@ -2038,7 +2832,7 @@ void buzzbstig_seralize_blb_stigs(buzzvm_t vm, buzzdarray_t bm){
 /****************************************/
 /****************************************/
 
-int64_t buzzbstig_deseralize_blb_stigs_set(buzzvm_t vm,buzzdarray_t a,int64_t pos){
+int64_t buzzbstig_deseralize_blb_stigs_set(buzzvm_t vm,buzzmsg_payload_t a,int64_t pos){
    /* Deserialize and set bstig entiries */
    uint32_t bstigs_size;
    pos = buzzmsg_deserialize_u32(&bstigs_size,a,pos);
@@ -2080,15 +2874,19 @@ int64_t buzzbstig_deseralize_blb_stigs_set(buzzvm_t vm,buzzdarray_t a,int64_t po
       }
       for(int j = 0; j < k_size; ++j){
          uint16_t k;
-         uint32_t hash, size,locations_size;
-         uint8_t priority;
+         uint32_t hash, size,locations_size,raw_size;
+         uint8_t priority,codec;
          pos = buzzmsg_deserialize_u16(&k,a,pos);
          pos = buzzmsg_deserialize_u32(&hash,a,pos);
          pos = buzzmsg_deserialize_u32(&size,a,pos);
+         pos = buzzbstig_blob_codec_deserialize(&codec,&raw_size,a,pos);
          pos = buzzmsg_deserialize_u8(&priority,a,pos);
          pos = buzzmsg_deserialize_u32(&locations_size,a,pos);
-         buzzblob_elem_t v_blob = buzzchunk_slot_new(hash,size);
+         buzzblob_elem_t v_blob = buzzchunk_slot_new(hash,size,buzzbstig_chunk_size(vm, id),
+                                                     buzzbstig_blob_parity(vm, id, size));
          v_blob->priority = priority;
+         v_blob->codec = codec;
+         v_blob->raw_size = (codec == BUZZBLOB_CODEC_LZ4) ? raw_size : size;
          // printf("blob deserialization key %u hash : %u size : %u priority %u location size %u \n",
                // k,hash,size,priority,locations_size);
          for(int k=0; k<locations_size ; k++){
@@ -2104,18 +2902,18 @@ int64_t buzzbstig_deseralize_blb_stigs_set(buzzvm_t vm,buzzdarray_t a,int64_t po
          if(s){
             const buzzblob_elem_t* l = buzzdict_get(*s, &(k), buzzblob_elem_t);
             if(l){
-               if( buzzdarray_size((*l)->available_list) > 0){
+               if( buzzbitset_count((*l)->available) > 0){
                   fprintf(stderr, 
-                          "[WARNING] [ROBOT %u] Buzz blob deserialization of blobs, removing non null blob available_list to set new blob\n",
+                          "[WARNING] [ROBOT %u] Buzz blob deserialization of blobs, removing non empty blob available set to set new blob\n",
                           vm->robot);   
                }
             } 
-            buzzdict_set(*s, &k, &v_blob);
+            buzzbstig_blob_store(vm, *s, id, k, v_blob);
             // printf("Bstig Deser setting key %u\n",k);
          }
          else{
             buzzdict_destroy( &(v_blob->data) );
-            buzzdarray_destroy( &(v_blob->available_list) );
+            buzzbitset_destroy( &(v_blob->available) );
             buzzdarray_destroy( &(v_blob->locations) );
             free(v_blob);
          }
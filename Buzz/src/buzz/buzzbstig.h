@@ -3,7 +3,10 @@
 
 #include <buzz/buzztype.h>
 #include <buzz/buzzdict.h>
+#include <buzz/buzzblobprio.h>
+#include <buzz/buzzbitset.h>
 
+/* Defaults of the per-bstig parameters, see bstigmergy.create() */
 # define BLOB_CHUNK_SIZE 100
 # define MAX_BLOB_CHUNKS 2 // Max number of chunk storage 
 # define RELOCATION_OF_CHUNKS_AT 90 // in percent
@@ -28,6 +31,10 @@
 # define MAX_UINT16 65535
 /* Time to refresh getters list */
 # define TIME_TO_REFRESH_GETTER_STATE 10
+/* Blob status calls before the missing chunks of a blob are asked again */
+# define TIME_TO_REFETCH_BLOB 50
+/* Largest span of chunks a blob request names one by one */
+# define MAX_CHUNKS_IN_BLOB_REQUEST 256
 
 #ifdef __cplusplus
 extern "C" {
@@ -72,6 +79,17 @@ extern "C" {
    } buzzblob_status_e;
 
     /*
+    * Buzz blob compression codec.
+    * Blobs are compressed as a whole before they are chunked.
+    */
+   typedef enum {
+      BUZZBLOB_CODEC_NONE = 0,       // blob bytes are sent as they are
+      BUZZBLOB_CODEC_LZ4,            // blob bytes are an LZ4 block
+      BUZZBLOB_CODEC_COUNT,          // How many codecs have been defined
+      BUZZBLOB_CODEC_UNKNOWN = 0xFF  // codec not received yet
+   } buzzblob_codec_e;
+
+   /*
     * Buzz blob getter type.
     * 
     */
@@ -105,9 +123,76 @@ extern "C" {
       uint8_t getter;
       buzzobj_t onconflict;
       buzzobj_t onconflictlost;
+      uint16_t chunk_size; // Bytes per chunk of the blobs in this bstig
+      uint16_t max_chunks; // Chunks this robot offers to store
+      uint8_t reloc_hi;    // Storage percent at which the robot stops bidding
+      uint8_t reloc_lo;    // Storage percent at which the robot bids again
+      uint8_t saturated;   // Whether the storage went past reloc_hi
+      uint8_t compress;    // Whether to compress new blobs
+      uint8_t parity;      // Reed-Solomon parity chunks added to each blob
    };
    typedef struct buzzbstig_s* buzzbstig_t;
 
+   /*
+    * A md5 digest.
+    */
+   struct buzzbstig_md5_digest_s {
+      uint32_t h[4];
+   };
+
+   /*
+    * A streaming md5 hash state.
+    */
+   struct buzzbstig_md5_s {
+      uint32_t h[4];     // Running hash
+      uint64_t len;      // Number of bytes hashed so far
+      uint8_t buf[64];   // Pending bytes of the current block
+      uint32_t buflen;   // Number of pending bytes
+   };
+
+   /*
+    * A streaming 64-bit xxHash state.
+    */
+   struct buzzbstig_xxh64_s {
+      uint64_t v[4];     // Running lanes
+      uint64_t len;      // Number of bytes hashed so far
+      uint8_t buf[32];   // Pending bytes of the current stripe
+      uint32_t buflen;   // Number of pending bytes
+   };
+
+   /*
+    * Chunk and blob checksum algorithms.
+    * The id travels with each chunk, so robots with different
+    * preferences still verify each other's blobs.
+    */
+   typedef enum {
+      BUZZBSTIG_CHECKSUM_MD5 = 0,   // first word of md5, as in older robots
+      BUZZBSTIG_CHECKSUM_CRC32C,    // Castagnoli CRC, hardware-assisted with SSE4.2
+      BUZZBSTIG_CHECKSUM_XXH64,     // 64-bit xxHash folded to 32 bits
+      BUZZBSTIG_CHECKSUM_COUNT      // How many checksum algorithms have been defined
+   } buzzbstig_checksum_e;
+
+   /*
+    * A streaming checksum state for any of the algorithms.
+    */
+   struct buzzbstig_checksum_s {
+      uint8_t algo;
+      union {
+         struct buzzbstig_md5_s md5;
+         struct buzzbstig_xxh64_s xxh64;
+         uint32_t crc32c;
+      } u;
+   };
+
+   /*
+    * Blob hash verification state.
+    */
+   typedef enum {
+      BUZZBLOB_HASH_STREAMING = 0,  // chunks are being hashed as they arrive
+      BUZZBLOB_HASH_VERIFIED,       // all chunks hashed and the blob hash matched
+      BUZZBLOB_HASH_MISMATCH        // all chunks hashed and the blob hash did not match
+   } buzzblob_hash_status_e;
+
    /*
     * An blob entry data
     */
@@ -115,13 +200,23 @@ extern "C" {
    {
      uint32_t hash; // Hash of blob 
      uint32_t size;
+     uint16_t chunk_size; // Bytes per chunk, the last chunk may be shorter
+     uint8_t parity;      // Parity chunks after the data chunks, 0 if none
      uint8_t priority;
-     buzzdarray_t available_list;
+     buzzbitset_t available; // Indices of the chunks stored here
      buzzdarray_t locations;
      buzzdict_t data;
      uint8_t relocstate;
      uint8_t status;
      uint16_t request_time;
+     buzzblobbuf_t buf; // Whole blob once known, NULL while chunks are scattered
+     uint8_t codec;       // How the blob bytes are encoded
+     uint32_t raw_size;   // Size of the blob once decoded
+     buzzblobbuf_t raw;   // Decoded blob, NULL until decoded or if not encoded
+     struct buzzbstig_checksum_s hashctx; // Hash of the leading chunks received so far
+     uint16_t hash_next;                  // Index of the next chunk to hash
+     uint8_t hash_status;                 // Hash verification state
+     buzzblobprio_node_t prio;            // Entry in the eviction order, NULL if not stored
    };
    typedef struct buzzblob_elem_s* buzzblob_elem_t;
 
@@ -130,9 +225,12 @@ extern "C" {
     */
    struct buzzblob_chunk_s
    {
-     uint32_t hash; // Hash of chunk
-     char* chunk;
+     uint32_t hash;     // Hash of chunk
+     buzzblobbuf_t buf; // Buffer holding the chunk bytes
+     char* chunk;       // First chunk byte inside buf, not NUL-terminated
+     uint16_t size;     // Number of bytes in chunk
      uint8_t status;
+     uint8_t hashalgo;  // Checksum algorithm of hash and of the whole blob
    };
    typedef struct buzzblob_chunk_s* buzzblob_chunk_t;
 
@@ -150,18 +248,11 @@ extern "C" {
 
    typedef buzzblob_bidder_t buzzblob_location_t;
 
-   struct buzzbstig_blobpriority_list_param
-  {
-   uint16_t id;
-   uint32_t key;      // Here it is assumed blobs are inserted in an assending order
-   uint8_t priority;
-   uint8_t stat;
-  };
-
    /*
     * Forward declaration of the Buzz VM.
     */
    struct buzzvm_s;
+   struct buzzchunk_reloc_elem_s;
 
    /*
     * Registers the virtual stigmergy methods in the vm.
@@ -172,11 +263,42 @@ extern "C" {
    extern int buzzbstig_register(struct buzzvm_s* vm);
 
    /*
-    * TODO
-    *
+    * Creates a new blob chunk holding a copy of the given bytes.
+    * @param hash The hash of the chunk.
+    * @param chunk The chunk bytes.
+    * @param size The number of bytes in the chunk.
+    * @return The new blob chunk.
     */
    extern buzzblob_chunk_t buzzbstig_chunk_new(uint32_t hash,
-                                                char* chunk);
+                                               const char* chunk,
+                                               uint16_t size);
+
+   /*
+    * Creates a new blob chunk viewing part of a shared buffer.
+    * No bytes are copied; the chunk takes a reference to the buffer.
+    * @param hash The hash of the chunk.
+    * @param buf The buffer.
+    * @param offset The offset of the first chunk byte in the buffer.
+    * @param size The number of bytes in the chunk.
+    * @return The new blob chunk.
+    */
+   extern buzzblob_chunk_t buzzbstig_chunk_view(uint32_t hash,
+                                                buzzblobbuf_t buf,
+                                                uint32_t offset,
+                                                uint16_t size);
+
+   /*
+    * Creates a new blob chunk viewing the same bytes as another one.
+    * @param c The chunk to share.
+    * @return The new blob chunk.
+    */
+   extern buzzblob_chunk_t buzzbstig_chunk_share(const buzzblob_chunk_t c);
+
+   /*
+    * Destroys a blob chunk, dropping its reference to the buffer.
+    * @param c The chunk.
+    */
+   extern void buzzbstig_chunk_destroy(buzzblob_chunk_t* c);
 
    /*
       TODO
@@ -269,9 +391,25 @@ extern "C" {
                                              uint32_t pos,
                                              struct buzzvm_s* vm);
 
+   /*
+    * Serializes the bytes of a blob chunk.
+    * The chunk is written as its checksum algorithm, a 16-bit length and
+    * the raw bytes.
+    * @param buf The output buffer where the serialized data is appended.
+    * @param cdata The chunk to serialize.
+    */
    extern void buzzbstig_chunk_serialize(buzzmsg_payload_t buf, buzzblob_chunk_t cdata);
 
-   extern int64_t buzzbstig_chunk_deserialize(char** cdata,
+   /*
+    * Deserializes the bytes of a blob chunk.
+    * Sets the buf, chunk and size fields of the given chunk; the chunk
+    * gets its own buffer, released by buzzbstig_chunk_destroy().
+    * @param cdata The chunk to fill.
+    * @param buf The input buffer where the serialized data is stored.
+    * @param pos The position at which the data starts.
+    * @return The new position in the buffer, of -1 in case of error.
+    */
+   extern int64_t buzzbstig_chunk_deserialize(buzzblob_chunk_t cdata,
                                               buzzmsg_payload_t buf,
                                               uint32_t pos);
 
@@ -279,8 +417,137 @@ extern "C" {
 
    extern void buzzbstig_create_generic(struct buzzvm_s* vm, uint16_t id);
 
+   /*
+    * Returns the chunk size of the given bstig.
+    * Falls back to BLOB_CHUNK_SIZE when the bstig does not exist.
+    * @param vm The Buzz VM state.
+    * @param id The bstig id.
+    * @return The chunk size in bytes.
+    */
+   extern uint16_t buzzbstig_chunk_size(struct buzzvm_s* vm, uint16_t id);
+
+   /*
+    * Returns the number of chunks this robot can store for the given bstig.
+    * Falls back to MAX_BLOB_CHUNKS when the bstig does not exist.
+    * @param vm The Buzz VM state.
+    * @param id The bstig id.
+    * @return The chunk storage capacity.
+    */
+   extern uint16_t buzzbstig_max_chunks(struct buzzvm_s* vm, uint16_t id);
+
+   /*
+    * Returns the number of chunks this robot can offer in a relocation bid.
+    * The robot stops offering space once its storage reaches reloc_hi
+    * percent of max_chunks, and offers it again once the storage falls to
+    * reloc_lo percent.
+    * @param vm The Buzz VM state.
+    * @param id The bstig id.
+    * @return The number of chunks to bid, 0 if none.
+    */
+   extern int buzzbstig_bid_space(struct buzzvm_s* vm, uint16_t id);
+
+   /*
+    * Serializes the codec of a blob.
+    * Written as the codec id, followed by the decoded size if the blob is
+    * encoded.
+    * @param buf The output buffer where the serialized data is appended.
+    * @param codec The codec id.
+    * @param raw_size The decoded size of the blob.
+    */
+   extern void buzzbstig_blob_codec_serialize(buzzmsg_payload_t buf,
+                                              uint8_t codec,
+                                              uint32_t raw_size);
+
+   /*
+    * Deserializes the codec of a blob.
+    * @param codec The deserialized codec id.
+    * @param raw_size The deserialized decoded size.
+    * @param buf The input buffer where the serialized data is stored.
+    * @param pos The position at which the data starts.
+    * @return The new position in the buffer, of -1 in case of error.
+    */
+   extern int64_t buzzbstig_blob_codec_deserialize(uint8_t* codec,
+                                                   uint32_t* raw_size,
+                                                   buzzmsg_payload_t buf,
+                                                   int64_t pos);
+
+   /*
+    * Records the codec of a blob slot whose codec is not known yet.
+    * @param vm The Buzz VM state.
+    * @param id The bstig id.
+    * @param key The blob key.
+    * @param codec The codec id.
+    * @param raw_size The decoded size of the blob.
+    */
+   extern void buzzbstig_blob_set_codec(struct buzzvm_s* vm,
+                                        uint16_t id,
+                                        uint16_t key,
+                                        uint8_t codec,
+                                        uint32_t raw_size);
+
+   /*
+    * Returns the number of parity chunks of a blob of the given size.
+    * Blobs too large for the code, with the parity, get none.
+    * @param vm The Buzz VM state.
+    * @param id The bstig id.
+    * @param size The blob size in bytes.
+    * @return The number of parity chunks.
+    */
+   extern uint8_t buzzbstig_blob_parity(struct buzzvm_s* vm,
+                                        uint16_t id,
+                                        uint32_t size);
+
+   /*
+    * Returns the number of chunks of a blob, parity chunks included.
+    * @param v_blob The blob slot.
+    * @return The number of chunks.
+    */
+   extern uint16_t buzzbstig_blob_chunk_num(buzzblob_elem_t v_blob);
+
+   /*
+    * Returns the number of data chunks of a blob.
+    * This is also the number of chunks needed to rebuild it.
+    * @param v_blob The blob slot.
+    * @return The number of data chunks.
+    */
+   extern uint16_t buzzbstig_blob_data_chunk_num(buzzblob_elem_t v_blob);
+
+   /*
+    * Returns <tt>true</tt> if enough chunks of a blob are stored to rebuild it.
+    * Without parity every chunk is needed; with parity any data chunk
+    * count of them will do.
+    * @param v_blob The blob slot.
+    * @return <tt>true</tt> if the blob can be rebuilt.
+    */
+   extern int buzzbstig_blob_complete(buzzblob_elem_t v_blob);
+
+   /*
+    * Asks the holders of a blob for its chunks with a single broadcast.
+    * When the chunks of the requester are known, only the ones it misses
+    * are named; nothing is sent if none is missing.
+    * @param vm The Buzz VM data.
+    * @param id The id of the blob stigmergy.
+    * @param key The key of the blob.
+    * @param v_blob The blob slot.
+    * @param requester The robot the chunks go to.
+    * @param have The chunks the requester holds, or NULL if unknown.
+    *             Ignored when this robot is the requester.
+    */
+   extern void buzzbstig_blob_fetch(struct buzzvm_s* vm,
+                                    uint16_t id,
+                                    uint16_t key,
+                                    buzzblob_elem_t v_blob,
+                                    uint16_t requester,
+                                    const buzzbitset_t have);
+
    /*
     * Buzz C closure to create a new stigmergy object.
+    * Takes the bstig id and an optional table with any of the fields
+    * chunk_size, max_chunks, reloc_hi, reloc_lo, compress and parity;
+    * missing fields take the compile-time defaults, compress defaults to 1
+    * and parity to 0. With parity m, each blob of k chunks is stored as
+    * k + m Reed-Solomon coded chunks, and any k of them rebuild it.
+    * Every robot must use the same chunk_size and parity for a given bstig.
     * @param vm The Buzz VM state.
     * @return The updated VM state.
     */
@@ -295,6 +562,7 @@ extern "C" {
 
    /*
     * Buzz C closure to put a blbo in a stigmergy object.
+    * A blob that would need more than MAX_UINT16 chunks is an error.
     * @param vm The Buzz VM state.
     * @return The updated VM state.
     */
@@ -327,10 +595,6 @@ extern "C" {
 
    extern int buzzbstig_blobstatus(struct buzzvm_s* vm);
 
-   extern void buzzbstig_blobrequest_update(struct buzzvm_s* vm);
-
-   extern void buzzbstig_blobgetters_update(struct buzzvm_s* vm);
-
    extern int buzzbstig_getblob(struct buzzvm_s* vm);
 
    extern int buzzbstig_blob_bidderpriority_key_cmp(const void* a, const void* b);
@@ -395,9 +659,21 @@ extern "C" {
                                     uint32_t hash,
                                     uint8_t subtype,
                                     uint16_t receiver);
-   extern int buzzbstig_priority_cmp(const void* a, const void* b);
 
-   extern buzzdarray_t buzzbstig_get_prioritylist(struct buzzvm_s* vm);
+   /*
+    * Stores a blob slot and adds it to the eviction order.
+    * A slot previously stored under the same key is destroyed.
+    * @param vm The Buzz VM state.
+    * @param s The blob slot map of the stigmergy.
+    * @param id The blob stigmergy id.
+    * @param key The blob key.
+    * @param blob The blob slot.
+    */
+   extern void buzzbstig_blob_store(struct buzzvm_s* vm,
+                                    buzzdict_t s,
+                                    uint16_t id,
+                                    uint16_t key,
+                                    buzzblob_elem_t blob);
    /*
     * TODO
     *
@@ -429,19 +705,152 @@ extern "C" {
 
     extern buzzdarray_t buzzbstig_getlocations(struct buzzvm_s* vm, uint16_t id, uint16_t key);
 
-    extern void buzzbstig_blobstatus_update(struct buzzvm_s* vm);
+   /*
+    * Sets the number of steps an element of the chunk monitor waits
+    * before its timeout is handled, and schedules its timer.
+    * @param vm The Buzz VM state.
+    * @param e The element of the bidder, getter or blob request list.
+    * @param type The list of the element (a buzzchunk_timer_e).
+    * @param time The number of steps to wait.
+    */
+   extern void buzzbstig_cmonitor_wait(struct buzzvm_s* vm,
+                                       struct buzzchunk_reloc_elem_s* e,
+                                       uint8_t type,
+                                       uint16_t time);
+
+   /*
+    * Returns the number of steps left before the timeout of an element
+    * of the chunk monitor is handled.
+    * @param vm The Buzz VM state.
+    * @param e The element.
+    * @return The number of steps left.
+    */
+   extern uint16_t buzzbstig_cmonitor_left(struct buzzvm_s* vm,
+                                           struct buzzchunk_reloc_elem_s* e);
+
+   /*
+    * Has an element of the bidder list checked at the next update,
+    * e.g. when its list of bidders changed.
+    * @param vm The Buzz VM state.
+    * @param e The element.
+    */
+   extern void buzzbstig_cmonitor_check(struct buzzvm_s* vm,
+                                        struct buzzchunk_reloc_elem_s* e);
+
+   /*
+    * Advances the chunk monitor by one step.
+    * Only the elements and anti-flooding entries whose timer fires
+    * are looked at.
+    * @param vm The Buzz VM state.
+    */
+   extern void buzzbstig_cmonitor_update(struct buzzvm_s* vm);
 
    /*
     * Generates a md5 hash.
     * @param blob The blob to gererate md5 hash
     * @param size The size of blob
-    * @return pointer to the hash and the user is incharge of freeing the pointer. 
+    * @param digest The digest to fill.
+    */
+   extern void buzzbstig_md5(const char* blob,
+                             uint32_t size,
+                             struct buzzbstig_md5_digest_s* digest);
+
+   /*
+    * Initializes a streaming md5 hash.
+    * @param ctx The hash state.
+    */
+   extern void buzzbstig_md5_init(struct buzzbstig_md5_s* ctx);
+
+   /*
+    * Adds bytes to a streaming md5 hash.
+    * @param ctx The hash state.
+    * @param data The bytes.
+    * @param size The number of bytes.
+    */
+   extern void buzzbstig_md5_update(struct buzzbstig_md5_s* ctx,
+                                    const void* data,
+                                    uint32_t size);
+
+   /*
+    * Finishes a streaming md5 hash.
+    * The hash state must be initialized again before reuse.
+    * @param ctx The hash state.
+    * @param digest The digest to fill.
+    */
+   extern void buzzbstig_md5_final(struct buzzbstig_md5_s* ctx,
+                                   struct buzzbstig_md5_digest_s* digest);
+
+   /*
+    * Returns the preferred checksum algorithm of this robot.
+    * This is CRC32C if the CPU has SSE4.2, and 64-bit xxHash otherwise.
+    * @return The algorithm id.
+    */
+   extern uint8_t buzzbstig_checksum_default();
+
+   /*
+    * Initializes a streaming checksum.
+    * @param ctx The checksum state.
+    * @param algo The algorithm id.
+    */
+   extern void buzzbstig_checksum_init(struct buzzbstig_checksum_s* ctx,
+                                       uint8_t algo);
+
+   /*
+    * Adds bytes to a streaming checksum.
+    * @param ctx The checksum state.
+    * @param data The bytes.
+    * @param size The number of bytes.
+    */
+   extern void buzzbstig_checksum_update(struct buzzbstig_checksum_s* ctx,
+                                         const void* data,
+                                         uint32_t size);
+
+   /*
+    * Finishes a streaming checksum.
+    * The checksum state must be initialized again before reuse.
+    * @param ctx The checksum state.
+    * @return The 32-bit checksum.
+    */
+   extern uint32_t buzzbstig_checksum_final(struct buzzbstig_checksum_s* ctx);
+
+   /*
+    * Computes the checksum of a buffer.
+    * @param algo The algorithm id.
+    * @param data The bytes.
+    * @param size The number of bytes.
+    * @return The 32-bit checksum.
+    */
+   extern uint32_t buzzbstig_checksum(uint8_t algo,
+                                      const void* data,
+                                      uint32_t size);
+
+   /*
+    * Computes the CRC32C of a buffer with the table-driven code, even
+    * when the CPU has SSE4.2. Used to check the hardware path.
+    * @param data The bytes.
+    * @param size The number of bytes.
+    * @return The CRC32C.
+    */
+   extern uint32_t buzzbstig_crc32c_portable(const void* data,
+                                             uint32_t size);
+
+   /*
+    * Feeds the chunks that follow the last hashed one to the blob hash.
+    * Once the last chunk is hashed, the blob hash is checked.
+    * @param v_blob The blob.
+    */
+   extern void buzzbstig_blob_hash_advance(buzzblob_elem_t v_blob);
+
+   /*
+    * Drops the whole-blob buffer of a blob whose chunks are leaving.
+    * The chunk views keep the bytes alive; the blob hash is reset.
+    * @param v_blob The blob.
     */
-   extern uint32_t* buzzbstig_md5(const char* blob, uint32_t size);
+   extern void buzzbstig_blob_drop_buffer(buzzblob_elem_t v_blob);
 
-   extern void buzzbstig_seralize_blb_stigs(struct buzzvm_s* vm, buzzdarray_t bm);
+   extern void buzzbstig_seralize_blb_stigs(struct buzzvm_s* vm, buzzmsg_payload_t bm);
 
-   extern int64_t buzzbstig_deseralize_blb_stigs_set(struct buzzvm_s* vm,buzzdarray_t a,int64_t pos);
+   extern int64_t buzzbstig_deseralize_blb_stigs_set(struct buzzvm_s* vm,buzzmsg_payload_t a,int64_t pos);
 
 #ifdef __cplusplus
 }
@@ -10,6 +10,64 @@
 
 void buzzdarray_elem_destroy(uint32_t pos, void* data, void* params) {}
 
+/* Is the data kept in the inline storage? */
+#define buzzdarray_isinline(da) ((void*)(da)->data == (void*)(da)->inl)
+
+/* How many elements fit in the inline storage */
+#define buzzdarray_inlinecap(es) ((es) > 0 ? BUZZDARRAY_INLINE_SIZE / (es) : 0)
+
+/*
+ * Sets the capacity of the array, moving the data between the inline
+ * storage and the heap as needed. The capacity never drops below what
+ * the inline storage can hold.
+ */
+static void buzzdarray_setcap(buzzdarray_t da,
+                              uint32_t cap) {
+   uint32_t icap = buzzdarray_inlinecap(da->elem_size);
+   if(cap < icap) cap = icap;
+   if(cap == da->capacity && (cap > icap || buzzdarray_isinline(da))) return;
+   if(cap <= icap) {
+      /* Move back into the inline storage */
+      if(!buzzdarray_isinline(da)) {
+         memcpy(da->inl, da->data, buzzdarray_size(da) * da->elem_size);
+         free(da->data);
+         da->data = (void**)da->inl;
+      }
+   }
+   else if(buzzdarray_isinline(da)) {
+      /* Move out of the inline storage */
+      void* nd = malloc((size_t)cap * da->elem_size);
+      if(!nd) {
+         fprintf(stderr, "[FATAL] Can't reallocate dynamic array.\n");
+         abort();
+      }
+      memcpy(nd, da->inl, buzzdarray_size(da) * da->elem_size);
+      da->data = nd;
+   }
+   else {
+      void* nd = realloc(da->data, (size_t)cap * da->elem_size);
+      if(!nd) {
+         fprintf(stderr, "[FATAL] Can't reallocate dynamic array.\n");
+         abort();
+      }
+      da->data = nd;
+   }
+   da->capacity = cap;
+}
+
+/*
+ * Makes the array able to hold at least the given number of elements,
+ * keeping one free slot as buzzdarray_makeslot() does.
+ */
+static void buzzdarray_reserve(buzzdarray_t da,
+                               int64_t size) {
+   if(size >= da->capacity) {
+      uint32_t cap = da->capacity > 0 ? da->capacity : 1;
+      do { cap *= 2; } while(size >= cap);
+      buzzdarray_setcap(da, cap);
+   }
+}
+
 /****************************************/
 /****************************************/
 
@@ -23,11 +81,17 @@ buzzdarray_t buzzdarray_new(uint32_t cap,
    /* Create the dynamic array. calloc() zeroes everything. */
    buzzdarray_t da = (buzzdarray_t)calloc(1, sizeof(struct buzzdarray_s));
    /* Set info */
-   da->capacity = cap;
    da->elem_size = elem_size;
    da->elem_destroy = elem_destroy ? elem_destroy : buzzdarray_elem_destroy;
-   /* Create initial data */
-   da->data = calloc(cap, elem_size);
+   /* Create initial data, in the inline storage if it fits */
+   if(cap <= buzzdarray_inlinecap(elem_size)) {
+      da->capacity = buzzdarray_inlinecap(elem_size);
+      da->data = (void**)da->inl;
+   }
+   else {
+      da->capacity = cap;
+      da->data = calloc(cap, elem_size);
+   }
    /* Done */
    return da;
 }
@@ -43,8 +107,13 @@ buzzdarray_t buzzdarray_clone(const buzzdarray_t da) {
    clone->capacity = clone->size > 0 ? clone->size : 1;
    clone->elem_size = da->elem_size;
    clone->elem_destroy = da->elem_destroy;
-   /* Create data buffer */
-   clone->data = malloc(clone->capacity * clone->elem_size);
+   /* Create data buffer, in the inline storage if it fits */
+   if(clone->capacity <= buzzdarray_inlinecap(clone->elem_size)) {
+      clone->capacity = buzzdarray_inlinecap(clone->elem_size);
+      clone->data = (void**)clone->inl;
+   }
+   else
+      clone->data = malloc(clone->capacity * clone->elem_size);
    memcpy(clone->data, da->data, clone->size * clone->elem_size);
    /* Done */
    return clone;
@@ -64,8 +133,13 @@ buzzdarray_t buzzdarray_frombuffer(const void* buf,
    da->elem_size = elem_size;
    da->elem_destroy = elem_destroy ? elem_destroy : buzzdarray_elem_destroy;
    da->size = da->capacity;
-   /* Create initial data */
-   da->data = malloc(buf_size);
+   /* Create initial data, in the inline storage if it fits */
+   if(da->capacity <= buzzdarray_inlinecap(elem_size)) {
+      da->capacity = buzzdarray_inlinecap(elem_size);
+      da->data = (void**)da->inl;
+   }
+   else
+      da->data = malloc(buf_size);
    memcpy(da->data, buf, buf_size);
    /* Done */
    return da;
@@ -78,7 +152,7 @@ void buzzdarray_destroy(buzzdarray_t* da) {
    /* Get rid of every element */
    buzzdarray_foreach(*da, (*da)->elem_destroy, NULL);
    /* Get rid of the rest */
-   free((*da)->data);
+   if(!buzzdarray_isinline(*da)) free((*da)->data);
    free(*da);
    /* Set da to NULL */
    *da = NULL;
@@ -93,19 +167,11 @@ void* buzzdarray_makeslot(buzzdarray_t da,
       Making sure we are not adding beyond the current size */
    uint32_t i = pos < buzzdarray_size(da) ? pos : buzzdarray_size(da);
    /* Increase the capacity if necessary */
-   if(buzzdarray_size(da)+1 >= da->capacity) {
-      if(da->capacity == 0) {
-         fprintf(stderr, "[BUG] Array capacity is zero.\n");
-         abort();
-      }
-      do { da->capacity *= 2; } while(buzzdarray_size(da)+1 >= da->capacity);
-      void* nd = realloc(da->data, da->capacity * da->elem_size);
-      if(!nd) {
-         fprintf(stderr, "[FATAL] Can't reallocate dynamic array.\n");
-         abort();
-      }
-      da->data = nd;
+   if(da->capacity == 0) {
+      fprintf(stderr, "[BUG] Array capacity is zero.\n");
+      abort();
    }
+   buzzdarray_reserve(da, buzzdarray_size(da)+1);
    /* Move elements from i onwards one step to the right */
    if(!buzzdarray_isempty(da) && i < buzzdarray_size(da)) {
       memmove(
@@ -134,6 +200,31 @@ void buzzdarray_insert(buzzdarray_t da,
 /****************************************/
 /****************************************/
 
+void buzzdarray_push_n(buzzdarray_t da,
+                       const void* data,
+                       uint32_t n) {
+   if(n == 0) return;
+   /* Make room for all the elements at once */
+   buzzdarray_reserve(da, buzzdarray_size(da)+n);
+   /* Copy the elements */
+   memcpy(buzzdarray_rawget(da, buzzdarray_size(da)),
+          data,
+          (size_t)n * da->elem_size);
+   da->size += n;
+}
+
+/****************************************/
+/****************************************/
+
+void buzzdarray_append_buffer(buzzdarray_t da,
+                              const void* buf,
+                              uint32_t buf_size) {
+   buzzdarray_push_n(da, buf, buf_size / da->elem_size);
+}
+
+/****************************************/
+/****************************************/
+
 void buzzdarray_remove(buzzdarray_t da,
                        uint32_t pos) {
    /* Can't remove elements past the size */
@@ -149,15 +240,8 @@ void buzzdarray_remove(buzzdarray_t da,
    --(da->size);
    /* Shrink the capacity if necessary */
    if((da->size > 0) &&
-      (da->size <= da->capacity / 2)) {
-      da->capacity /= 2;
-      void* nd = realloc(da->data, da->capacity * da->elem_size);
-      if(!nd) {
-         fprintf(stderr, "[FATAL] Can't reallocate dynamic array.\n");
-         abort();
-      }
-      da->data = nd;
-   }
+      (da->size <= da->capacity / 2))
+      buzzdarray_setcap(da, da->capacity / 2);
 }
 
 /****************************************/
@@ -167,16 +251,9 @@ void buzzdarray_clear(buzzdarray_t da,
                       uint32_t cap) {
    /* Get rid of every element */
    buzzdarray_foreach(da, da->elem_destroy, NULL);
-   /* Resize the array */
-   da->capacity = cap;
-   void* nd = realloc(da->data, da->capacity * da->elem_size);
-   if(!nd) {
-      fprintf(stderr, "[FATAL] Can't reallocate dynamic array.\n");
-      abort();
-   }
-   da->data = nd;
-   /* Zero the size */
+   /* Zero the size and resize the array */
    da->size = 0;
+   buzzdarray_setcap(da, cap);
 }
 
 /****************************************/
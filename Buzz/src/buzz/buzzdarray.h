@@ -30,8 +30,16 @@ extern "C" {
     */
    typedef int (*buzzdarray_elem_cmpp)(const void* a, const void* b);
 
+   /*
+    * Size in bytes of the storage embedded in every dynamic array.
+    * Arrays whose data fits in it do not allocate a separate buffer.
+    */
+#define BUZZDARRAY_INLINE_SIZE 32
+
    /*
     * Buzz dynamic array data.
+    * The data points either to the inline storage or to a heap
+    * buffer, once the array has outgrown the inline storage.
     */
    struct buzzdarray_s {
       void** data;
@@ -39,6 +47,7 @@ extern "C" {
       uint32_t elem_size;
       uint32_t capacity;
       buzzdarray_elem_funp elem_destroy;
+      uint64_t inl[BUZZDARRAY_INLINE_SIZE / sizeof(uint64_t)];
    };
    typedef struct buzzdarray_s* buzzdarray_t;
 
@@ -105,6 +114,30 @@ extern "C" {
                                  uint32_t pos,
                                  const void* data);
 
+   /*
+    * Appends n elements at the end of the dynamic array.
+    * The elements are copied from the given buffer, which must
+    * contain n contiguous elements.
+    * @param da The dynamic array.
+    * @param data A pointer to the first element to add.
+    * @param n The number of elements to add.
+    */
+   extern void buzzdarray_push_n(buzzdarray_t da,
+                                 const void* data,
+                                 uint32_t n);
+
+   /*
+    * Appends the content of a buffer at the end of the dynamic array.
+    * The buffer size must be a multiple of the element size.
+    * @param da The dynamic array.
+    * @param buf The buffer.
+    * @param buf_size The size of the buffer in bytes.
+    * @see buzzdarray_push_n()
+    */
+   extern void buzzdarray_append_buffer(buzzdarray_t da,
+                                        const void* buf,
+                                        uint32_t buf_size);
+
    /*
     * Removes the element at the given position.
     * @param da The dynamic array.
@@ -19,15 +19,11 @@ buzzdebug_entry_t buzzdebug_entry_new(uint64_t l,
 }
 
 void buzzdebug_off2script_destroyf(const void* key, void* data, void* params) {
-   free((void*)key);
    free(*(buzzdebug_entry_t*)data);
-   free(data);
 }
 
 void buzzdebug_script2off_destroyf(const void* key, void* data, void* params) {
    free(*(buzzdebug_entry_t*)key);
-   free((void*)key);
-   free(data);
 }
 
 uint32_t buzzdebug_entryhash(const void* key) {
@@ -395,6 +391,8 @@ static void buzzdebug_print_table(FILE* stream,
 void buzzdebug_print_obj(FILE* stream,
                          buzzobj_t o,
                          buzzvm_t vm) {
+   union buzzobj_u v;
+   o = buzzobj_unbox(o, &v);
    switch(o->o.type) {
       case BUZZTYPE_NIL:
          fprintf(stream, "[nil]");
@@ -417,6 +415,9 @@ void buzzdebug_print_obj(FILE* stream,
       case BUZZTYPE_STRING:
          fprintf(stream, "[string] %d:'%s'", o->s.value.sid, o->s.value.str);
          break;
+      case BUZZTYPE_BLOB:
+         fprintf(stream, "[blob] %u bytes", o->b.value.size);
+         break;
       default:
          fprintf(stream, "[TODO] type = %d", o->o.type);
    }
@@ -522,3 +523,20 @@ void buzzdebug_backtrace(buzzvm_t vm,
 
 /****************************************/
 /****************************************/
+
+void buzzdebug_profile_dump(buzzvm_t vm,
+                            FILE* stream) {
+   fprintf(stream, "%-8s %12s %12s %9s\n", "instr", "lookups", "hits", "hit rate");
+   for(int i = 0; i < BUZZVM_INSTR_COUNT; ++i) {
+      uint64_t n = vm->icstats[i].hits + vm->icstats[i].misses;
+      if(n == 0) continue;
+      fprintf(stream, "%-8s %12" PRIu64 " %12" PRIu64 " %8.1f%%\n",
+              buzzvm_instr_desc[i],
+              n,
+              vm->icstats[i].hits,
+              100.0 * vm->icstats[i].hits / n);
+   }
+}
+
+/****************************************/
+/****************************************/
@@ -194,6 +194,17 @@ extern "C" {
                                    buzzdebug_t dbg,
                                    FILE* stream);
 
+   /**
+    * Prints the inline cache profile of the VM.
+    * For each instruction with a lookup cache (gload, gstore, tget,
+    * tput), prints the number of lookups and how many were answered by
+    * the cache.
+    * @param vm The VM data.
+    * @param stream The output stream.
+    */
+   extern void buzzdebug_profile_dump(buzzvm_t vm,
+                                      FILE* stream);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,25 +1,151 @@
 #include "buzzdict.h"
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 /****************************************/
 /****************************************/
 
-struct buzzdict_entry_s {
-   void* key;
-   void* data;
-};
+/* Minimum number of slots */
+#define BUZZDICT_MIN_SLOTS 8
 
-#define buzzdict_entry_new(dt, e, k, d)         \
-   struct buzzdict_entry_s e;                   \
-   e.key = malloc(dt->key_size);                \
-   memcpy(e.key, k, dt->key_size);              \
-   e.data = malloc(dt->data_size);              \
-   memcpy(e.data, d, dt->data_size);
+/* Bytes are padded so data and entries stay pointer-aligned */
+#define BUZZDICT_ALIGN(x) (((x) + 7) & ~7u)
 
-void buzzdict_entry_destroy(const void* key, void* data, void* params) {
-   free((void*)key);
-   free(data);
+/* Marker bit that makes every stored hash non-zero */
+#define BUZZDICT_USED 0x80000000u
+
+/* Hashes a key, the result is never zero */
+#define buzzdict_hash(dt, key) ((dt)->hashf(key) | BUZZDICT_USED)
+
+/* Home slot of a hash (Fibonacci hashing) */
+#define buzzdict_home(dt, h) (((h) * 2654435769u) >> (dt)->shift)
+
+/* Distance of the element in slot i from its home slot */
+#define buzzdict_dist(dt, i, h) (((i) - buzzdict_home(dt, h)) & ((dt)->num_buckets - 1))
+
+/****************************************/
+/****************************************/
+
+static void buzzdict_alloc_slots(buzzdict_t dt,
+                                 uint32_t num) {
+   dt->num_buckets = num;
+   dt->shift = 32;
+   while(num > 1) { num >>= 1; --dt->shift; }
+   dt->slots = (struct buzzdict_slot_s*)calloc(dt->num_buckets, sizeof(struct buzzdict_slot_s));
+   if(!dt->slots) {
+      fprintf(stderr, "[FATAL] Can't allocate dictionary of %u slots.\n", dt->num_buckets);
+      abort();
+   }
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Returns the index of an unused entry, adding a chunk if needed.
+ */
+static uint32_t buzzdict_new_entry(buzzdict_t dt) {
+   uint32_t e = dt->free_entry;
+   if(e != BUZZDICT_NO_ENTRY) {
+      /* Reuse the entry of a removed element */
+      memcpy(&dt->free_entry, buzzdict_entry(dt, e), sizeof(uint32_t));
+      return e;
+   }
+   e = dt->num_entries++;
+   /* The last chunk is full: add one twice as large */
+   uint32_t c = 31 - __builtin_clz(e / BUZZDICT_CHUNK_MIN + 1);
+   if(c == dt->num_chunks) {
+      dt->chunks = (uint8_t**)realloc(dt->chunks, (c + 1) * sizeof(uint8_t*));
+      if(dt->chunks)
+         dt->chunks[c] = (uint8_t*)malloc((size_t)(BUZZDICT_CHUNK_MIN << c) * dt->slot_size);
+      if(!dt->chunks || !dt->chunks[c]) {
+         fprintf(stderr, "[FATAL] Can't allocate %u dictionary entries.\n", BUZZDICT_CHUNK_MIN << c);
+         abort();
+      }
+      ++dt->num_chunks;
+   }
+   return e;
+}
+
+/*
+ * Makes an entry available for reuse.
+ */
+static void buzzdict_free_entry(buzzdict_t dt,
+                                uint32_t e) {
+   memcpy(buzzdict_entry(dt, e), &dt->free_entry, sizeof(uint32_t));
+   dt->free_entry = e;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Places the entry e, whose hash is h, into the table. The key
+ * must not be present already. Returns the slot of the element.
+ */
+static uint32_t buzzdict_place(buzzdict_t dt,
+                               uint32_t h,
+                               uint32_t e) {
+   uint32_t mask = dt->num_buckets - 1;
+   uint32_t i = buzzdict_home(dt, h);
+   uint32_t d = 0, sd;
+   int64_t pos = -1;
+   struct buzzdict_slot_s elem = { h, e }, swp;
+   while(dt->slots[i].hash) {
+      /* Steal the slot from elements closer to their home */
+      sd = buzzdict_dist(dt, i, dt->slots[i].hash);
+      if(sd < d) {
+         /* From now on, elem holds the evicted element */
+         if(pos < 0) pos = i;
+         swp = dt->slots[i];
+         dt->slots[i] = elem;
+         elem = swp;
+         d = sd;
+      }
+      i = (i + 1) & mask;
+      ++d;
+   }
+   dt->slots[i] = elem;
+   return pos < 0 ? i : (uint32_t)pos;
+}
+
+/****************************************/
+/****************************************/
+
+static void buzzdict_grow(buzzdict_t dt) {
+   /* Keep the old slots around */
+   struct buzzdict_slot_s* slots = dt->slots;
+   uint32_t num = dt->num_buckets, i;
+   /* Double the table and reinsert the elements using the stored hashes */
+   buzzdict_alloc_slots(dt, num * 2);
+   for(i = 0; i < num; ++i)
+      if(slots[i].hash)
+         buzzdict_place(dt, slots[i].hash, slots[i].entry);
+   free(slots);
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Returns the slot of the element with the given key and hash, or
+ * -1 if the element is not there.
+ */
+static int64_t buzzdict_find(buzzdict_t dt,
+                             const void* key,
+                             uint32_t h) {
+   uint32_t mask = dt->num_buckets - 1;
+   uint32_t i = buzzdict_home(dt, h);
+   uint32_t d;
+   for(d = 0; dt->slots[i].hash; ++d, i = (i + 1) & mask) {
+      /* Past this point the key would have stolen the slot */
+      if(buzzdict_dist(dt, i, dt->slots[i].hash) < d) return -1;
+      if(dt->slots[i].hash == h &&
+         dt->keycmpf(key, buzzdict_slot_key(dt, i)) == 0)
+         return i;
+   }
+   return -1;
 }
 
 /****************************************/
@@ -34,14 +160,21 @@ buzzdict_t buzzdict_new(uint32_t buckets,
    /* Create new dict. calloc() zeroes everything */
    buzzdict_t dt = (buzzdict_t)calloc(1, sizeof(struct buzzdict_s));
    /* Fill in the info */
-   dt->num_buckets = buckets;
    dt->hashf = hashf;
    dt->keycmpf = keycmpf;
-   dt->dstryf = dstryf ? dstryf : buzzdict_entry_destroy;
+   dt->dstryf = dstryf;
    dt->key_size = key_size;
    dt->data_size = data_size;
-   /* Create buckets. Unused buckets are NULL by default. */
-   dt->buckets = (buzzdarray_t*)calloc(dt->num_buckets, sizeof(buzzdarray_t*));
+   dt->data_offset = BUZZDICT_ALIGN(key_size);
+   dt->slot_size = BUZZDICT_ALIGN(dt->data_offset + data_size);
+   /* Removed entries are chained through their first bytes */
+   if(dt->slot_size < sizeof(uint32_t)) dt->slot_size = BUZZDICT_ALIGN(sizeof(uint32_t));
+   dt->tmp = (uint8_t*)malloc(dt->slot_size);
+   dt->free_entry = BUZZDICT_NO_ENTRY;
+   /* Create slots, rounding the count up to a power of two */
+   uint32_t num = BUZZDICT_MIN_SLOTS;
+   while(num < buckets) num <<= 1;
+   buzzdict_alloc_slots(dt, num);
    /* All done */
    return dt;
 }
@@ -50,22 +183,22 @@ buzzdict_t buzzdict_new(uint32_t buckets,
 /****************************************/
 
 void buzzdict_destroy(buzzdict_t* dt) {
-   /* Destroy buckets */
-   uint32_t i, j;
-   for(i = 0; i < (*dt)->num_buckets; ++i) {
-      /* Is the bucket used? */
-      if((*dt)->buckets[i] != NULL) {
-         /* Destroy elements in the bucket */
-         for(j = 0; j < buzzdarray_size((*dt)->buckets[i]); ++j) {
-            const struct buzzdict_entry_s* e = &buzzdarray_get((*dt)->buckets[i], j, struct buzzdict_entry_s);
-            (*dt)->dstryf(e->key, e->data, *dt);
-         }
-         /* Destroy bucket */
-         buzzdarray_destroy(&((*dt)->buckets[i]));
-      }
+   /* Destroy elements */
+   if((*dt)->dstryf) {
+      uint32_t i;
+      for(i = 0; i < (*dt)->num_buckets; ++i)
+         if((*dt)->slots[i].hash)
+            (*dt)->dstryf(buzzdict_slot_key(*dt, i),
+                          buzzdict_slot_data(*dt, i),
+                          *dt);
    }
-   free((*dt)->buckets);
    /* Destroy the rest */
+   uint32_t c;
+   for(c = 0; c < (*dt)->num_chunks; ++c)
+      free((*dt)->chunks[c]);
+   free((*dt)->chunks);
+   free((*dt)->slots);
+   free((*dt)->tmp);
    free(*dt);
    *dt = NULL;
 }
@@ -75,57 +208,51 @@ void buzzdict_destroy(buzzdict_t* dt) {
 
 void* buzzdict_rawget(buzzdict_t dt,
                       const void* key) {
-   /* Hash the key */
-   uint32_t h = dt->hashf(key) % dt->num_buckets, i;
-   /* Is the bucket empty? */
-   if(!dt->buckets[h]) return NULL;
-   /* Bucket not empty - is the entry present? */
-   for(i = 0; i < buzzdarray_size(dt->buckets[h]); ++i) {
-      const struct buzzdict_entry_s* e = &buzzdarray_get(dt->buckets[h], i, struct buzzdict_entry_s);
-      if(dt->keycmpf(key, e->key) == 0)
-         return e->data;
-   }
-   /* Entry not found */
-   return NULL;
+   int64_t i = buzzdict_find(dt, key, buzzdict_hash(dt, key));
+   return (i < 0) ? NULL : buzzdict_slot_data(dt, i);
 }
 
 /****************************************/
 /****************************************/
 
-void buzzdict_set(buzzdict_t dt,
-                  const void* key,
-                  const void* data) {
+int64_t buzzdict_slot_find(buzzdict_t dt,
+                           const void* key) {
+   return buzzdict_find(dt, key, buzzdict_hash(dt, key));
+}
+
+/****************************************/
+/****************************************/
+
+void* buzzdict_set(buzzdict_t dt,
+                   const void* key,
+                   const void* data) {
    /* Hash the key */
-   uint32_t h = dt->hashf(key) % dt->num_buckets;
-   /* Is the bucket empty? */
-   if(!dt->buckets[h]) {
-      /* Create new entry list */
-      dt->buckets[h] = buzzdarray_new(1, sizeof(struct buzzdict_entry_s), NULL);
-      /* Add entry */
-      buzzdict_entry_new(dt, e, key, data);
-      buzzdarray_push(dt->buckets[h], &e);
-      /* Increase size */
-      ++(dt->size);
-   }
-   else {
-      /* Bucket not empty - is the entry present? */
-      uint32_t i;
-      for(i = 0; i < buzzdarray_size(dt->buckets[h]); ++i) {
-         const struct buzzdict_entry_s* e = &buzzdarray_get(dt->buckets[h], i, struct buzzdict_entry_s);
-         if(dt->keycmpf(key, e->key) == 0) {
-            /* Yes, destroy the entry */
-            dt->dstryf(e->key, e->data, dt);
-            buzzdarray_remove(dt->buckets[h], i);
-            --(dt->size);
-            break;
-         }
-      }
-      /* Add new entry */
-      buzzdict_entry_new(dt, e, key, data);
-      buzzdarray_push(dt->buckets[h], &e);
-      /* Increase size */
-      ++(dt->size);
+   uint32_t h = buzzdict_hash(dt, key);
+   /* Is the entry present? */
+   int64_t i = buzzdict_find(dt, key, h);
+   if(i >= 0) {
+      /* Yes, destroy the element and replace it in place */
+      uint8_t* p = (uint8_t*)buzzdict_slot_key(dt, i);
+      /* The new key and data could point into the entry itself */
+      memcpy(dt->tmp, key, dt->key_size);
+      memcpy(dt->tmp + dt->data_offset, data, dt->data_size);
+      if(dt->dstryf)
+         dt->dstryf(p, p + dt->data_offset, dt);
+      memcpy(p, dt->tmp, dt->slot_size);
+      return p + dt->data_offset;
    }
+   /* Make room if the load factor would exceed 7/8 */
+   if((uint64_t)(dt->size + 1) * 8 > (uint64_t)dt->num_buckets * 7)
+      buzzdict_grow(dt);
+   /* Add new entry; the other entries stay where they are */
+   uint32_t e = buzzdict_new_entry(dt);
+   uint8_t* p = buzzdict_entry(dt, e);
+   memcpy(p, key, dt->key_size);
+   memcpy(p + dt->data_offset, data, dt->data_size);
+   buzzdict_place(dt, h, e);
+   /* Increase size */
+   ++(dt->size);
+   return p + dt->data_offset;
 }
 
 /****************************************/
@@ -133,28 +260,26 @@ void buzzdict_set(buzzdict_t dt,
 
 int buzzdict_remove(buzzdict_t dt,
                     const void* key) {
-   /* Hash the key */
-   uint32_t h = dt->hashf(key) % dt->num_buckets, i;
-   /* Is the bucket empty? */
-   if(!dt->buckets[h]) return 0;
-   /* Bucket not empty - is the entry present? */
-   for(i = 0; i < buzzdarray_size(dt->buckets[h]); ++i) {
-      const struct buzzdict_entry_s* e = &buzzdarray_get(dt->buckets[h], i, struct buzzdict_entry_s);
-      if(dt->keycmpf(key, e->key) == 0) {
-         /* Entry found - remove it */
-         dt->dstryf(e->key, e->data, dt);
-         buzzdarray_remove(dt->buckets[h], i);
-         /* Is the entry list empty? If so, free the memory */
-         if(buzzdarray_isempty(dt->buckets[h]))
-            buzzdarray_destroy(&(dt->buckets[h]));
-         /* Increase size */
-         --(dt->size);
-         /* Done */
-         return 1;
-      }
+   /* Is the entry present? */
+   int64_t i = buzzdict_find(dt, key, buzzdict_hash(dt, key));
+   if(i < 0) return 0;
+   /* Entry found - remove it */
+   if(dt->dstryf)
+      dt->dstryf(buzzdict_slot_key(dt, i), buzzdict_slot_data(dt, i), dt);
+   buzzdict_free_entry(dt, dt->slots[i].entry);
+   /* Shift the following elements back until one sits at its home */
+   uint32_t mask = dt->num_buckets - 1;
+   uint32_t j = ((uint32_t)i + 1) & mask;
+   while(dt->slots[j].hash && buzzdict_dist(dt, j, dt->slots[j].hash) > 0) {
+      dt->slots[i] = dt->slots[j];
+      i = j;
+      j = (j + 1) & mask;
    }
-   /* Entry not found, nothing to do */
-   return 0;
+   dt->slots[i].hash = 0;
+   /* Decrease size */
+   --(dt->size);
+   /* Done */
+   return 1;
 }
 
 /****************************************/
@@ -163,18 +288,11 @@ int buzzdict_remove(buzzdict_t dt,
 void buzzdict_foreach(buzzdict_t dt,
                       buzzdict_elem_funp fun,
                       void* params) {
-   /* Go through buckets */
-   uint32_t i, j;
-   for(i = 0; i < dt->num_buckets; ++i) {
-      /* Is the bucket used? */
-      if(dt->buckets[i] != NULL) {
-         /* Go through elements in the bucket */
-         for(j = 0; j < buzzdarray_size(dt->buckets[i]); ++j) {
-            const struct buzzdict_entry_s* e = &buzzdarray_get(dt->buckets[i], j, struct buzzdict_entry_s);
-            fun(e->key, e->data, params);
-         }
-      }
-   }
+   /* Go through the used slots */
+   uint32_t i;
+   for(i = 0; i < dt->num_buckets; ++i)
+      if(dt->slots[i].hash)
+         fun(buzzdict_slot_key(dt, i), buzzdict_slot_data(dt, i), params);
 }
 
 /****************************************/
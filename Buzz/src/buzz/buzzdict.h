@@ -7,9 +7,15 @@
 extern "C" {
 #endif
 
-   // TODO
-   // CONSIDER USING BRENT'S VARIATION ON HASH COLLISION SOLVING
-   // TODO
+   /*
+    * Number of entries in the first entry chunk.
+    */
+#define BUZZDICT_CHUNK_MIN 8
+
+   /*
+    * Entry index marking the end of the reusable entry list.
+    */
+#define BUZZDICT_NO_ENTRY 0xFFFFFFFFu
 
    /*
     * Function pointer for an element-wise function:
@@ -19,6 +25,10 @@ extern "C" {
     * This function pointer is used to destroy elements by
     * buzzdict_destroy() and in methods such as
     * buzzdict_foreach().
+    *
+    * Keys and data are stored inline in the dictionary, so a
+    * destroy function must only release what the key and the
+    * data point to, never the key and data pointers themselves.
     */
    typedef void (*buzzdict_elem_funp)(const void* key, void* data, void* params);
 
@@ -41,13 +51,42 @@ extern "C" {
     */
    typedef int (*buzzdict_key_cmpp)(const void* a, const void* b);
 
+   /*
+    * A slot of the dictionary table.
+    */
+   struct buzzdict_slot_s {
+      uint32_t hash;  // Key hash, 0 for empty slots
+      uint32_t entry; // Index of the entry holding the key and data
+   };
+
    /*
     * The Buzz dictionary.
+    *
+    * This is an open-addressing hash table with Robin Hood
+    * insertion and backward-shift deletion. The table slots only
+    * hold the key hash and the index of the entry storing the key
+    * and the data, so probing touches as little memory as
+    * possible. The table doubles its size when the load factor
+    * exceeds 7/8.
+    *
+    * Entries live in chunks that are never moved: chunk c holds
+    * BUZZDICT_CHUNK_MIN << c entries. Pointers returned by
+    * buzzdict_rawget() and buzzdict_set() thus stay valid until
+    * their element is removed, whatever happens to the other
+    * elements. The entries of removed elements are reused.
     */
    struct buzzdict_s {
-      buzzdarray_t* buckets;     // Bucket data
+      struct buzzdict_slot_s* slots; // Table slots
+      uint8_t** chunks;          // Entry chunks
+      uint32_t num_chunks;       // Number of entry chunks
+      uint32_t num_entries;      // Number of entries ever used
+      uint32_t free_entry;       // First reusable entry, or BUZZDICT_NO_ENTRY
+      uint8_t* tmp;              // Scratch space for one entry
       uint32_t size;             // Number of inserted elements
-      uint32_t num_buckets;      // Number of buckets
+      uint32_t num_buckets;      // Number of slots, a power of two
+      uint32_t shift;            // 32 - log2(num_buckets)
+      uint32_t slot_size;        // Entry size in bytes
+      uint32_t data_offset;      // Offset of the data in an entry
       buzzdict_hashfunp hashf;   // Key hashing function
       buzzdict_key_cmpp keycmpf; // Key comparison function
       buzzdict_elem_funp dstryf; // Element destroy function
@@ -58,7 +97,7 @@ extern "C" {
 
    /*
     * Create a new dictionary.
-    * @param buckets The number of buckets.
+    * @param buckets The initial number of slots, rounded up to a power of two.
     * @param key_size The size of a key.
     * @param data_size The size of a data element.
     * @param hashf The function to hash the keys.
@@ -94,10 +133,11 @@ extern "C" {
     * @param dt The dictionary.
     * @param key The key.
     * @param data The data.
+    * @return A pointer to the stored data, valid until the element is removed.
     */
-   extern void buzzdict_set(buzzdict_t dt,
-                            const void* key,
-                            const void* data);
+   extern void* buzzdict_set(buzzdict_t dt,
+                             const void* key,
+                             const void* data);
 
    /*
     * Removes the element with the given key.
@@ -109,6 +149,16 @@ extern "C" {
    extern int buzzdict_remove(buzzdict_t dt,
                               const void* key);
 
+   /*
+    * Looks for the slot of the element with the given key.
+    * @param dt The dictionary.
+    * @param key The key.
+    * @return The slot index, or -1 if the element is not found.
+    * @see buzzdict_slot_data
+    */
+   extern int64_t buzzdict_slot_find(buzzdict_t dt,
+                                     const void* key);
+
    /*
     * Applies the given function to each element in the dictionary.
     * @param dt The dictionary.
@@ -212,6 +262,38 @@ extern "C" {
  */
 #define buzzdict_isempty(dt) ((dt)->size == 0)
 
+/*
+ * Returns a pointer to the entry of the given index.
+ * @param dt The dictionary.
+ * @param e The entry index, in [0,num_entries).
+ */
+#define buzzdict_entry(dt, e)                                           \
+   ((dt)->chunks[31 - __builtin_clz(((e) / BUZZDICT_CHUNK_MIN) + 1)] +   \
+    (size_t)((e) + BUZZDICT_CHUNK_MIN -                                 \
+             (BUZZDICT_CHUNK_MIN << (31 - __builtin_clz(((e) / BUZZDICT_CHUNK_MIN) + 1)))) * \
+    (dt)->slot_size)
+
+/*
+ * Returns 1 if the given slot holds an element, 0 otherwise.
+ * @param dt The dictionary.
+ * @param i The slot index, in [0,num_buckets).
+ */
+#define buzzdict_slot_isused(dt, i) ((dt)->slots[(i)].hash != 0)
+
+/*
+ * Returns a pointer to the key stored in the given slot.
+ * @param dt The dictionary.
+ * @param i The slot index, in [0,num_buckets).
+ */
+#define buzzdict_slot_key(dt, i) ((void*)buzzdict_entry(dt, (dt)->slots[(i)].entry))
+
+/*
+ * Returns a pointer to the data stored in the given slot.
+ * @param dt The dictionary.
+ * @param i The slot index, in [0,num_buckets).
+ */
+#define buzzdict_slot_data(dt, i) ((void*)(buzzdict_entry(dt, (dt)->slots[(i)].entry) + (dt)->data_offset))
+
 /*
  * Returns 1 if an element with the given key exists, 0 otherwise.
  * @param dt The dictionary.
@@ -2,28 +2,92 @@
 #include "buzzvm.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 /****************************************/
 /****************************************/
 
 #define BUZZHEAP_GC_INIT_MAXOBJS 1
 
+/* Default number of objects marked or swept per call */
+#define BUZZHEAP_GC_DEFAULT_BUDGET 256
+
+/* Number of objects in a slab */
+#define BUZZHEAP_SLAB_SIZE 1024
+
 /****************************************/
 /****************************************/
 
 void buzzheap_destroy_obj(uint32_t pos, void* data, void* params) {
-   buzzobj_destroy((buzzobj_t*)data);
+   buzzobj_clear(*(buzzobj_t*)data);
+}
+
+void buzzheap_destroy_slab(uint32_t pos, void* data, void* params) {
+   free(*(union buzzheap_slot_u**)data);
+}
+
+/*
+ * Returns the memory for a new object.
+ * The slot of the last destroyed object is used first, to keep the
+ * memory in use compact; otherwise the next slot of the last slab.
+ */
+static buzzobj_t buzzheap_alloc(buzzheap_t h) {
+   union buzzheap_slot_u* s;
+   ++h->allocstats.objs;
+   if(h->free_slots) {
+      s = h->free_slots;
+      h->free_slots = s->next;
+      ++h->allocstats.reused;
+      return &s->obj;
+   }
+   if(buzzdarray_isempty(h->slabs) || h->slab_pos == BUZZHEAP_SLAB_SIZE) {
+      s = (union buzzheap_slot_u*)malloc(BUZZHEAP_SLAB_SIZE * sizeof(union buzzheap_slot_u));
+      if(!s) {
+         fprintf(stderr, "[FATAL] Can't allocate object slab.\n");
+         abort();
+      }
+      buzzdarray_push(h->slabs, &s);
+      h->slab_pos = 0;
+      ++h->allocstats.slabs;
+   }
+   s = (union buzzheap_slot_u*)buzzdarray_last(h->slabs, union buzzheap_slot_u*) + h->slab_pos;
+   ++h->slab_pos;
+   return &s->obj;
+}
+
+/*
+ * Destroys an object and makes its slot available.
+ */
+static void buzzheap_release(buzzheap_t h,
+                             buzzobj_t o) {
+   buzzobj_clear(o);
+   union buzzheap_slot_u* s = (union buzzheap_slot_u*)o;
+   s->next = h->free_slots;
+   h->free_slots = s;
 }
 
 buzzheap_t buzzheap_new() {
    /* Create heap state */
    buzzheap_t h = (buzzheap_t)malloc(sizeof(struct buzzheap_s));
    /* Create object list */
-   h->objs = buzzdarray_new(10, sizeof(buzzobj_t), buzzheap_destroy_obj);
+   h->objs = buzzdarray_new(10, sizeof(buzzobj_t), NULL);
    /* Initialize GC max object threshold */
    h->max_objs = BUZZHEAP_GC_INIT_MAXOBJS;
    /* Initialize the marker */
    h->marker = 0;
+   /* Initialize the incremental collector */
+   h->gcstate = BUZZHEAP_GC_IDLE;
+   h->grey = buzzdarray_new(10, sizeof(buzzobj_t), NULL);
+   h->sweep_pos = 0;
+   h->sweep_end = 0;
+   h->budget = BUZZHEAP_GC_DEFAULT_BUDGET;
+   memset(&h->stats, 0, sizeof(h->stats));
+   /* Initialize the object slabs */
+   h->slabs = buzzdarray_new(1, sizeof(union buzzheap_slot_u*), buzzheap_destroy_slab);
+   h->slab_pos = 0;
+   h->free_slots = NULL;
+   memset(&h->allocstats, 0, sizeof(h->allocstats));
    /* All done */
    return h;
 }
@@ -32,8 +96,11 @@ buzzheap_t buzzheap_new() {
 /****************************************/
 
 void buzzheap_destroy(buzzheap_t* h) {
-   /* Get rid of object list */
+   /* Get rid of the objects, then of their memory */
+   buzzdarray_foreach((*h)->objs, buzzheap_destroy_obj, NULL);
    buzzdarray_destroy(&((*h)->objs));
+   buzzdarray_destroy(&((*h)->grey));
+   buzzdarray_destroy(&((*h)->slabs));
    /* Get rid of heap state */
    free(*h);
    /* Set heap to NULL */
@@ -45,8 +112,9 @@ void buzzheap_destroy(buzzheap_t* h) {
 
 buzzobj_t buzzheap_newobj(buzzvm_t vm,
                           uint16_t type) {
-   /* Create a new object. calloc() fills it with zeroes */
-   buzzobj_t o = buzzobj_new(type);
+   /* Create a new object in a slab */
+   buzzobj_t o = buzzheap_alloc(vm->heap);
+   buzzobj_init(o, type);
    /* Set the object marker */
    o->o.marker = vm->heap->marker;
    /* Add object to list */
@@ -58,6 +126,21 @@ buzzobj_t buzzheap_newobj(buzzvm_t vm,
 /****************************************/
 /****************************************/
 
+buzzobj_t buzzheap_box(buzzvm_t vm,
+                       buzzobj_t o) {
+   if(!buzzobj_isunboxed(o)) return o;
+   union buzzobj_u v;
+   buzzobj_unbox(o, &v);
+   buzzobj_t x = buzzheap_alloc(vm->heap);
+   *x = v;
+   x->o.marker = vm->heap->marker;
+   buzzdarray_push(vm->heap->objs, &x);
+   return x;
+}
+
+/****************************************/
+/****************************************/
+
 struct buzzheap_clone_tableelem_s {
    buzzvm_t vm;
    buzzdict_t t;
@@ -71,9 +154,12 @@ void buzzheap_clone_tableelem(const void* key, void* data, void* params) {
 }
 
 buzzobj_t buzzheap_clone(buzzvm_t vm, const buzzobj_t o) {
-   buzzobj_t x = (buzzobj_t)malloc(sizeof(union buzzobj_u));
+   /* Unboxed values are immutable copies already */
+   if(buzzobj_isunboxed(o)) return o;
+   buzzobj_t x = buzzheap_alloc(vm->heap);
    x->o.type = o->o.type;
-   x->o.marker = o->o.marker;
+   /* Like any new object, the clone survives the current collection */
+   x->o.marker = vm->heap->marker;
    buzzdarray_push(vm->heap->objs, &x);
    switch(o->o.type) {
       case BUZZTYPE_NIL: {
@@ -96,6 +182,13 @@ buzzobj_t buzzheap_clone(buzzvm_t vm, const buzzobj_t o) {
          x->u.value = o->u.value;
          return x;
       }
+      case BUZZTYPE_BLOB: {
+         /* Blob bytes are immutable, so the clone shares the buffer */
+         x->b.value.size = o->b.value.size;
+         x->b.value.data = o->b.value.data;
+         x->b.value.buf = buzzblobbuf_ref(o->b.value.buf);
+         return x;
+      }
       case BUZZTYPE_CLOSURE: {
          x->c.value.ref = o->c.value.ref;
          x->c.value.actrec = buzzdarray_clone(o->c.value.actrec);
@@ -131,19 +224,15 @@ void buzzheap_obj_mark(buzzobj_t o,
    /*
     * Nothing to do if the object is already marked
     * This avoids infinite looping when cycles are present
+    * Unboxed values are not in the heap
     */
-   if(o->o.marker == vm->heap->marker) return;
+   if(buzzobj_isunboxed(o) || o->o.marker == vm->heap->marker) return;
    /* Update marker */
    o->o.marker = vm->heap->marker;
-   /* Take care of composite types */
-   if(o->o.type == BUZZTYPE_TABLE)
-      buzzdict_foreach(o->t.value,
-                       buzzheap_dictobj_mark,
-                       vm);
-   else if(o->o.type == BUZZTYPE_CLOSURE)
-      buzzdarray_foreach(o->c.value.actrec,
-                         buzzheap_darrayobj_mark,
-                         vm);
+   /* The children of composite types are marked later */
+   if(o->o.type == BUZZTYPE_TABLE ||
+      o->o.type == BUZZTYPE_CLOSURE)
+      buzzdarray_push(vm->heap->grey, &o);
    else if(o->o.type == BUZZTYPE_STRING)
       buzzstrman_gc_mark(vm->strings,
                          o->s.value.sid);
@@ -201,10 +290,20 @@ void buzzheap_gsymobj_mark(const void* key, void* data, void* params) {
    buzzheap_obj_mark(*(buzzobj_t*)data, params);
 }
 
-void buzzheap_gc(struct buzzvm_s* vm) {
+/*
+ * Returns a monotonic time, in ns.
+ */
+static uint64_t buzzheap_clock() {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/*
+ * Starts a collection cycle by marking the roots.
+ */
+static void buzzheap_gc_start(buzzvm_t vm) {
    buzzheap_t h = vm->heap;
-   /* Is GC necessary? */
-   if(buzzdarray_size(h->objs) < h->max_objs) return;
    /* Increase the marker */
    ++h->marker;
    /* Prepare string gc */
@@ -223,21 +322,110 @@ void buzzheap_gc(struct buzzvm_s* vm) {
    buzzdict_foreach(vm->listeners, buzzheap_listener_mark, vm);
    /* Go through all the objects in the out message queue and mark them */
    buzzoutmsg_gc(vm);
-   /* Go through all the objects in the object list and delete the unmarked ones */
-   int64_t i = buzzdarray_size(h->objs) - 1;
-   while(i >= 0) {
-      /* Check whether the marker is set to the latest value */
-      if(buzzdarray_get(h->objs, i, buzzobj_t)->o.marker != h->marker) {
-         /* No, erase the element */
-         buzzdarray_remove(h->objs, i);
+   h->gcstate = BUZZHEAP_GC_MARK;
+}
+
+/*
+ * Marks the children of the pending objects, within the given budget.
+ * Returns the budget left.
+ */
+static uint32_t buzzheap_gc_mark(buzzvm_t vm,
+                                 uint32_t work) {
+   buzzheap_t h = vm->heap;
+   while(work > 0 && !buzzdarray_isempty(h->grey)) {
+      buzzobj_t o = buzzdarray_last(h->grey, buzzobj_t);
+      buzzdarray_pop(h->grey);
+      if(o->o.type == BUZZTYPE_TABLE) {
+         buzzdict_foreach(o->t.value, buzzheap_dictobj_mark, vm);
+         work -= work > buzzdict_size(o->t.value) ? buzzdict_size(o->t.value) + 1 : work;
+      }
+      else {
+         buzzdarray_foreach(o->c.value.actrec, buzzheap_darrayobj_mark, vm);
+         --work;
       }
-      /* Next element */
-      --i;
    }
-   /* Perform string gc */
-   buzzstrman_gc_prune(vm->strings);
-   /* Update the max objects threshold */
-   h->max_objs = buzzdarray_isempty(h->objs) ? BUZZHEAP_GC_INIT_MAXOBJS : 2 * buzzdarray_size(h->objs);
+   if(buzzdarray_isempty(h->grey)) {
+      /* Marking done: every live string is marked too */
+      buzzstrman_gc_prune(vm->strings);
+      /* Objects created from now on are not swept in this cycle */
+      h->sweep_pos = 0;
+      h->sweep_end = buzzdarray_size(h->objs);
+      h->gcstate = BUZZHEAP_GC_SWEEP;
+   }
+   return work;
+}
+
+/*
+ * Destroys unmarked objects, within the given budget.
+ */
+static void buzzheap_gc_sweep(buzzvm_t vm,
+                              uint32_t work) {
+   buzzheap_t h = vm->heap;
+   while(work > 0 && h->sweep_pos < h->sweep_end) {
+      buzzobj_t o = buzzdarray_get(h->objs, h->sweep_pos, buzzobj_t);
+      if(o->o.marker != h->marker) {
+         /* Dead object: move the last one in its place and recycle its slot */
+         uint32_t last = buzzdarray_size(h->objs) - 1;
+         buzzdarray_set(h->objs, h->sweep_pos, &buzzdarray_get(h->objs, last, buzzobj_t));
+         buzzdarray_pop(h->objs);
+         buzzheap_release(h, o);
+         /* The moved object needs a check, unless it was created during the sweep */
+         if(h->sweep_end > last) h->sweep_end = last;
+         ++h->stats.freed;
+      }
+      else {
+         ++h->sweep_pos;
+      }
+      --work;
+   }
+   if(h->sweep_pos >= h->sweep_end) {
+      /* Cycle done, update the max objects threshold */
+      h->max_objs = buzzdarray_isempty(h->objs) ? BUZZHEAP_GC_INIT_MAXOBJS : 2 * buzzdarray_size(h->objs);
+      h->gcstate = BUZZHEAP_GC_IDLE;
+      ++h->stats.cycles;
+   }
+}
+
+void buzzheap_gc(struct buzzvm_s* vm) {
+   buzzheap_t h = vm->heap;
+   /* Is GC necessary? */
+   if(h->gcstate == BUZZHEAP_GC_IDLE &&
+      buzzdarray_size(h->objs) < h->max_objs) return;
+   uint64_t t0 = buzzheap_clock();
+   uint32_t work = h->budget > 0 ? h->budget : UINT32_MAX;
+   if(h->gcstate == BUZZHEAP_GC_IDLE)
+      buzzheap_gc_start(vm);
+   if(h->gcstate == BUZZHEAP_GC_MARK)
+      work = buzzheap_gc_mark(vm, work);
+   if(h->gcstate == BUZZHEAP_GC_SWEEP && work > 0)
+      buzzheap_gc_sweep(vm, work);
+   /* Update the statistics */
+   uint64_t dt = buzzheap_clock() - t0;
+   ++h->stats.pauses;
+   h->stats.pause_total += dt;
+   if(dt > h->stats.pause_max) h->stats.pause_max = dt;
+}
+
+/****************************************/
+/****************************************/
+
+void buzzheap_gc_set_budget(struct buzzvm_s* vm,
+                            uint32_t budget) {
+   vm->heap->budget = budget;
+}
+
+/****************************************/
+/****************************************/
+
+void buzzheap_table_barrier(struct buzzvm_s* vm,
+                            buzzobj_t t,
+                            buzzobj_t k) {
+   if(vm->heap->gcstate != BUZZHEAP_GC_MARK) return;
+   uint8_t* d = (uint8_t*)buzzdict_rawget(t->t.value, &k);
+   if(!d) return;
+   /* The key is stored right before the value */
+   buzzheap_obj_mark(*(buzzobj_t*)(d - t->t.value->data_offset), vm);
+   buzzheap_obj_mark(*(buzzobj_t*)d, vm);
 }
 
 /****************************************/
@@ -13,6 +13,51 @@ extern "C" {
     */
    struct buzzvm_s;
 
+   /**
+    * Phases of a garbage collection cycle
+    */
+   typedef enum {
+      BUZZHEAP_GC_IDLE = 0, // No collection in progress
+      BUZZHEAP_GC_MARK,     // Marking the reachable objects
+      BUZZHEAP_GC_SWEEP     // Destroying the unmarked objects
+   } buzzheap_gcstate_e;
+
+   /**
+    * Garbage collection statistics
+    */
+   struct buzzheap_gcstats_s {
+      /* Completed collection cycles */
+      uint64_t cycles;
+      /* Calls to buzzheap_gc() that did some collection work */
+      uint64_t pauses;
+      /* Total time spent collecting, in ns */
+      uint64_t pause_total;
+      /* Longest pause, in ns */
+      uint64_t pause_max;
+      /* Objects destroyed */
+      uint64_t freed;
+   };
+
+   /**
+    * A slot of an object slab. Free slots are linked together.
+    */
+   union buzzheap_slot_u {
+      union buzzobj_u obj;
+      union buzzheap_slot_u* next;
+   };
+
+   /**
+    * Object allocation statistics
+    */
+   struct buzzheap_allocstats_s {
+      /* Objects created */
+      uint64_t objs;
+      /* Objects created in the slot of a destroyed object */
+      uint64_t reused;
+      /* Slabs allocated */
+      uint32_t slabs;
+   };
+
    /**
     * The state of the object heap
     */
@@ -23,6 +68,26 @@ extern "C" {
       uint32_t max_objs;
       /* Current marker for garbage collection */
       uint16_t marker;
+      /* Current collection phase */
+      buzzheap_gcstate_e gcstate;
+      /* Objects marked whose children are still to mark */
+      buzzdarray_t grey;
+      /* Next object to sweep */
+      uint32_t sweep_pos;
+      /* End of the objects to sweep */
+      uint32_t sweep_end;
+      /* Objects marked or swept per call, 0 for no limit */
+      uint32_t budget;
+      /* Statistics */
+      struct buzzheap_gcstats_s stats;
+      /* Slabs the objects live in (union buzzheap_slot_u*) */
+      buzzdarray_t slabs;
+      /* Next never used slot of the last slab */
+      uint32_t slab_pos;
+      /* Slots of destroyed objects */
+      union buzzheap_slot_u* free_slots;
+      /* Allocation statistics */
+      struct buzzheap_allocstats_s allocstats;
    };
    typedef struct buzzheap_s* buzzheap_t;
 
@@ -47,6 +112,16 @@ extern "C" {
    buzzobj_t buzzheap_newobj(struct buzzvm_s* vm,
                              uint16_t type);
 
+   /*
+    * Returns a heap object holding the passed value.
+    * Boxed values are returned as they are.
+    * @param vm The Buzz VM.
+    * @param o The value.
+    * @return The heap object.
+    */
+   extern buzzobj_t buzzheap_box(struct buzzvm_s* vm,
+                                 buzzobj_t o);
+
    /*
     * Internally used to clones a Buzz object.
     * @param vm The Buzz VM.
@@ -58,11 +133,36 @@ extern "C" {
 
    /**
     * Performs garbage collection, if necessary.
-    * Internally uses a simple mark-and-sweep algorithm.
+    * The collector is an incremental mark-and-sweep. A cycle starts when
+    * the heap grows past a threshold: the roots are marked all at once,
+    * then each call marks or sweeps at most h->budget objects. Objects
+    * created during a cycle survive it. A budget of 0 performs the whole
+    * cycle in a single call.
     * @param vm The Buzz VM.
     */
    void buzzheap_gc(struct buzzvm_s* vm);
 
+   /**
+    * Sets the maximum number of objects marked or swept per call to
+    * buzzheap_gc().
+    * @param vm The Buzz VM.
+    * @param budget The budget, or 0 to collect without interruption.
+    */
+   extern void buzzheap_gc_set_budget(struct buzzvm_s* vm,
+                                      uint32_t budget);
+
+   /**
+    * Tells the collector that a table entry is about to be replaced or removed.
+    * While marking is in progress, the current key and value are marked,
+    * so that objects reachable when the cycle started are not lost.
+    * @param vm The Buzz VM.
+    * @param t The table.
+    * @param k The key of the entry.
+    */
+   extern void buzzheap_table_barrier(struct buzzvm_s* vm,
+                                      buzzobj_t t,
+                                      buzzobj_t k);
+
    extern void buzzheap_obj_mark(buzzobj_t o, struct buzzvm_s* vm);
    extern void buzzheap_darrayobj_mark(uint32_t pos, void* data, void* params);
    extern void buzzheap_dictobj_mark(const void* key, void* data, void* params);
@@ -4,14 +4,68 @@
 #include <string.h>
 #include <arpa/inet.h>
 #include <math.h>
+#include <time.h>
 
 /****************************************/
 /****************************************/
 
 void buzzvm_inmsg_queue_destroy_entry(const void* key, void* data, void* param) {
-   free((void*)key);
-   buzzdarray_destroy((buzzdarray_t*)data);
-   free(data);
+   buzzqueue_t q = *(buzzqueue_t*)data;
+   while(!buzzqueue_isempty(q)) {
+      buzzmsg_payload_t m = buzzqueue_first(q, buzzmsg_payload_t);
+      buzzqueue_pop(q);
+      buzzmsg_payload_destroy(&m);
+   }
+   buzzqueue_destroy(&q);
+}
+
+/*
+ * Returns a monotonic time, in ns.
+ */
+static uint64_t buzzinmsg_clock() {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/****************************************/
+/****************************************/
+
+buzzinmsg_queue_t buzzinmsg_queue_new() {
+   buzzinmsg_queue_t q = (buzzinmsg_queue_t)calloc(1, sizeof(struct buzzinmsg_queue_s));
+   q->senders = buzzdict_new(20,
+                             sizeof(uint16_t),
+                             sizeof(buzzqueue_t),
+                             buzzdict_uint16keyhash,
+                             buzzdict_uint16keycmp,
+                             buzzvm_inmsg_queue_destroy_entry);
+   q->pending = buzzqueue_new(20, sizeof(uint16_t), NULL);
+   for(int i = 0; i < BUZZINMSG_TYPE_COUNT; ++i)
+      q->batches[i] = buzzqueue_new(1, sizeof(struct buzzinmsg_s), NULL);
+   return q;
+}
+
+/****************************************/
+/****************************************/
+
+void buzzinmsg_queue_destroy(buzzinmsg_queue_t* msgq) {
+   /* Batches are empty between dispatches */
+   for(int i = 0; i < BUZZINMSG_TYPE_COUNT; ++i)
+      buzzqueue_destroy(&(*msgq)->batches[i]);
+   buzzqueue_destroy(&(*msgq)->pending);
+   buzzdict_destroy(&(*msgq)->senders);
+   free(*msgq);
+   *msgq = NULL;
+}
+
+/****************************************/
+/****************************************/
+
+void buzzinmsg_queue_set_handler(buzzinmsg_queue_t msgq,
+                                 int type,
+                                 buzzinmsg_handler_t handler) {
+   if(type < 0 || type >= BUZZINMSG_TYPE_COUNT) return;
+   msgq->handlers[type] = handler;
 }
 
 /****************************************/
@@ -20,53 +74,188 @@ void buzzvm_inmsg_queue_destroy_entry(const void* key, void* data, void* param)
 void buzzinmsg_queue_append(buzzvm_t vm,
                             uint16_t rid,
                             buzzmsg_payload_t payload) {
-   /* Check if id is already present */
-   if(!buzzdict_exists(vm->inmsgs, &rid)) {
-      /* Not present, create a new queue */
-      buzzdarray_t q = buzzdarray_new(1, sizeof(buzzmsg_payload_t), NULL);
-      /* Add it to the dict */
-      buzzdict_set(vm->inmsgs, &rid, &q);
+   buzzinmsg_queue_t mq = vm->inmsgs;
+   /* Get the queue of the robot, creating it if needed */
+   const buzzqueue_t* pq = buzzdict_get(mq->senders, &rid, buzzqueue_t);
+   buzzqueue_t q;
+   if(pq) q = *pq;
+   else {
+      q = buzzqueue_new(1, sizeof(buzzmsg_payload_t), NULL);
+      buzzdict_set(mq->senders, &rid, &q);
    }
-   /* Get queue corresponding to given robot id */
-   buzzdarray_t* q = (buzzdarray_t*)buzzdict_rawget(vm->inmsgs, &rid);
+   /* A robot becomes pending with its first queued message */
+   if(buzzqueue_isempty(q)) buzzqueue_push(mq->pending, &rid);
    /* Append payload to queue */
-   buzzdarray_push(*q, &payload);
+   buzzqueue_push(q, &payload);
+   ++mq->size;
 }
 
 /****************************************/
 /****************************************/
 
-struct buzzdict_entry_s {
-   void* key;
-   void* data;
-};
-
 int buzzinmsg_queue_extract(buzzvm_t vm,
                             uint16_t* rid,
                             buzzmsg_payload_t* payload) {
+   buzzinmsg_queue_t mq = vm->inmsgs;
    /* Nothing to do if queue is empty */
-   if(buzzinmsg_queue_isempty(vm->inmsgs)) return 0;
-   /* Look for (id,queue) in first non-empty bucket in dict */
-   buzzdarray_t q = NULL;
-   for(uint32_t i = 0; i < vm->inmsgs->num_buckets; ++i) {
-      if(vm->inmsgs->buckets[i]) {
-         const struct buzzdict_entry_s* e =
-            &buzzdarray_get(vm->inmsgs->buckets[i],
-                            0,
-                            struct buzzdict_entry_s);
-         *rid = *(uint16_t*)(e->key);
-         q = *(buzzdarray_t*)(e->data);
-         break;
+   if(buzzinmsg_queue_isempty(mq)) return 0;
+   /* Take the oldest message of the first pending robot */
+   *rid = buzzqueue_first(mq->pending, uint16_t);
+   buzzqueue_t q = *buzzdict_get(mq->senders, rid, buzzqueue_t);
+   *payload = buzzqueue_first(q, buzzmsg_payload_t);
+   buzzqueue_pop(q);
+   --mq->size;
+   /* Move on to the next robot when this one is done */
+   if(buzzqueue_isempty(q)) buzzqueue_pop(mq->pending);
+   /* All done */
+   return 1;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Returns the batch of a message type.
+ * Joins, leaves and lists of a swarm depend on each other, so they
+ * go in the same batch to keep their order.
+ */
+static int buzzinmsg_batch(int type) {
+   if(type == BUZZMSG_SWARM_JOIN || type == BUZZMSG_SWARM_LEAVE)
+      return BUZZMSG_SWARM_LIST;
+   return type;
+}
+
+/****************************************/
+/****************************************/
+
+void buzzinmsg_queue_dispatch(buzzvm_t vm) {
+   buzzinmsg_queue_t mq = vm->inmsgs;
+   struct buzzinmsg_s m;
+   /* Sort the messages by type, one robot at a time */
+   while(!buzzqueue_isempty(mq->pending)) {
+      m.rid = buzzqueue_first(mq->pending, uint16_t);
+      buzzqueue_pop(mq->pending);
+      buzzqueue_t q = *buzzdict_get(mq->senders, &m.rid, buzzqueue_t);
+      /* Mark the neighbor active, once for all its messages */
+      buzzvm_neighbors_touch(vm, m.rid);
+      while(!buzzqueue_isempty(q)) {
+         m.payload = buzzqueue_first(q, buzzmsg_payload_t);
+         buzzqueue_pop(q);
+         /* Drop empty messages and messages nobody handles */
+         int t = buzzmsg_payload_size(m.payload) > 0 ? buzzmsg_payload_get(m.payload, 0) : -1;
+         if(t >= 0 && t < BUZZINMSG_TYPE_COUNT && mq->handlers[t]) {
+            m.type = t;
+            buzzqueue_push(mq->batches[buzzinmsg_batch(t)], &m);
+         }
+         else
+            buzzmsg_payload_destroy(&m.payload);
+      }
+   }
+   mq->size = 0;
+   /* Messages and time of this dispatch, by type */
+   uint32_t count[BUZZINMSG_TYPE_COUNT] = { 0 };
+   uint64_t spent[BUZZINMSG_TYPE_COUNT] = { 0 };
+   /* Go through the batches */
+   for(int b = 0; b < BUZZINMSG_TYPE_COUNT; ++b) {
+      buzzqueue_t q = mq->batches[b];
+      if(buzzqueue_isempty(q)) continue;
+      /* The clock is read again only when the type changes */
+      int t = -1;
+      uint64_t t0 = 0;
+      while(!buzzqueue_isempty(q)) {
+         m = buzzqueue_first(q, struct buzzinmsg_s);
+         buzzqueue_pop(q);
+         if(m.type != t) {
+            uint64_t t1 = buzzinmsg_clock();
+            if(t >= 0) spent[t] += t1 - t0;
+            t = m.type;
+            t0 = t1;
+         }
+         ++count[t];
+         /* After an error, only get rid of the messages */
+         if(vm->state == BUZZVM_STATE_READY)
+            mq->handlers[t](vm, m.rid, m.payload);
+         buzzmsg_payload_destroy(&m.payload);
       }
+      spent[t] += buzzinmsg_clock() - t0;
    }
-   /* Extract payload from array */
-   *payload = buzzdarray_last(q, buzzmsg_payload_t);
-   buzzdarray_pop(q);
-   /* If array is empty, remove (id,array entry) from dict */
-   if(buzzdarray_isempty(q))
-      buzzdict_remove(vm->inmsgs, rid);
+   /* Update the counters */
+   for(int t = 0; t < BUZZINMSG_TYPE_COUNT; ++t) {
+      if(!count[t]) continue;
+      struct buzzinmsg_stats_s* st = &mq->stats[t];
+      st->received += count[t];
+      ++st->batches;
+      st->time_total += spent[t];
+      if(spent[t] > st->time_max) st->time_max = spent[t];
+   }
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Pushes a counter, saturating at the largest integer the VM holds.
+ */
+static void buzzinmsg_pushcount(buzzvm_t vm, uint64_t n) {
+   buzzvm_pushi(vm, n > INT32_MAX ? INT32_MAX : (int32_t)n);
+}
+
+/****************************************/
+/****************************************/
+
+int buzzinmsg_stats(buzzvm_t vm) {
+   buzzvm_lnum_assert(vm, 1);
+   buzzvm_lload(vm, 1);
+   buzzvm_type_assert(vm, 1, BUZZTYPE_STRING);
+   const char* name = buzzvm_stack_at(vm, 1)->s.value.str;
+   buzzvm_pop(vm);
+   int t = buzzoutmsg_sched_type(name);
+   if(t < 0) {
+      buzzvm_seterror(vm,
+                      BUZZVM_ERROR_TYPE,
+                      "unknown message type \"%s\"",
+                      name);
+      return vm->state;
+   }
+   const struct buzzinmsg_stats_s* st = &vm->inmsgs->stats[t];
+   /* Make a table with the counters of the type, times in microseconds */
+   buzzvm_pusht(vm);
+   buzzobj_t r = buzzvm_stack_at(vm, 1);
+   buzzvm_push(vm, r);
+   buzzvm_pushs(vm, buzzvm_string_register(vm, "received", 1));
+   buzzinmsg_pushcount(vm, st->received);
+   buzzvm_tput(vm);
+   buzzvm_push(vm, r);
+   buzzvm_pushs(vm, buzzvm_string_register(vm, "batches", 1));
+   buzzinmsg_pushcount(vm, st->batches);
+   buzzvm_tput(vm);
+   buzzvm_push(vm, r);
+   buzzvm_pushs(vm, buzzvm_string_register(vm, "time_avg", 1));
+   buzzvm_pushf(vm, st->received > 0 ? st->time_total / 1000.0f / st->received : 0.0f);
+   buzzvm_tput(vm);
+   buzzvm_push(vm, r);
+   buzzvm_pushs(vm, buzzvm_string_register(vm, "time_max", 1));
+   buzzvm_pushf(vm, st->time_max / 1000.0f);
+   buzzvm_tput(vm);
+   return buzzvm_ret1(vm);
+}
+
+/****************************************/
+/****************************************/
+
+int buzzinmsg_register(buzzvm_t vm) {
+   /* Make "inmsgs" table */
+   buzzobj_t t = buzzheap_newobj(vm, BUZZTYPE_TABLE);
+   buzzvm_push(vm, t);
+   buzzvm_pushs(vm, buzzvm_string_register(vm, "stats", 1));
+   buzzvm_pushcc(vm, buzzvm_function_register(vm, buzzinmsg_stats));
+   buzzvm_tput(vm);
+   /* Register "inmsgs" table */
+   buzzvm_pushs(vm, buzzvm_string_register(vm, "inmsgs", 1));
+   buzzvm_push(vm, t);
+   buzzvm_gstore(vm);
    /* All done */
-   return 1;
+   return vm->state;
 }
 
 /****************************************/
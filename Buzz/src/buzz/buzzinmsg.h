@@ -1,19 +1,101 @@
 #ifndef BUZZINMSG_H
 #define BUZZINMSG_H
 
-#include <buzz/buzzdarray.h>
+#include <buzz/buzzdict.h>
+#include <buzz/buzzqueue.h>
 #include <buzz/buzzmsg.h>
 
 struct buzzvm_s;
 
+/*
+ * Number of incoming message types.
+ * Blob requests come after BUZZMSG_TYPE_COUNT in the type enum, but
+ * have a handler of their own.
+ */
+#define BUZZINMSG_TYPE_COUNT (BUZZMSG_BSTIG_BLOB_REQUEST + 1)
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+   /*
+    * Handler of a type of incoming message.
+    * The payload stays owned by the queue: the handler must not
+    * destroy it.
+    * @param vm The Buzz VM.
+    * @param rid The id of the robot who sent the message.
+    * @param payload The message payload.
+    */
+   typedef void (*buzzinmsg_handler_t)(struct buzzvm_s* vm,
+                                       uint16_t rid,
+                                       buzzmsg_payload_t payload);
+
+   /*
+    * Processing counters of a type of incoming message.
+    */
+   struct buzzinmsg_stats_s {
+      uint64_t received;   // Messages dispatched
+      uint64_t batches;    // Dispatches with at least one message
+      uint64_t time_total; // Time spent in the handler, in ns
+      uint64_t time_max;   // Time spent on the longest batch, in ns
+   };
+
+   /*
+    * A queued message with its sender.
+    */
+   struct buzzinmsg_s {
+      uint16_t rid;
+      uint8_t type;
+      buzzmsg_payload_t payload;
+   };
+
    /*
     * Data of a Buzz message queue.
+    * Messages are kept in a FIFO per sender. At dispatch time they are
+    * sorted into one batch per message type, and each batch is passed
+    * to the handler of its type in one go. The swarm membership types
+    * share a batch, so that they are applied in the order they arrived.
+    */
+   struct buzzinmsg_queue_s {
+      /* Robot id -> buzzqueue_t of payloads */
+      buzzdict_t senders;
+      /* Ids of the robots with queued messages, in arrival order */
+      buzzqueue_t pending;
+      /* Number of queued messages */
+      uint32_t size;
+      /* Messages being dispatched, by batch (struct buzzinmsg_s) */
+      buzzqueue_t batches[BUZZINMSG_TYPE_COUNT];
+      /* Handlers, by type */
+      buzzinmsg_handler_t handlers[BUZZINMSG_TYPE_COUNT];
+      /* Counters, by type */
+      struct buzzinmsg_stats_s stats[BUZZINMSG_TYPE_COUNT];
+   };
+   typedef struct buzzinmsg_queue_s* buzzinmsg_queue_t;
+
+   /*
+    * Creates a new message queue.
+    * No handler is set.
+    * @return A new message queue.
     */
-   typedef buzzdict_t buzzinmsg_queue_t;
+   extern buzzinmsg_queue_t buzzinmsg_queue_new();
+
+   /*
+    * Destroys a message queue.
+    * The queued payloads are destroyed too.
+    * @param msgq The message queue.
+    */
+   extern void buzzinmsg_queue_destroy(buzzinmsg_queue_t* msgq);
+
+   /*
+    * Sets the handler of a message type.
+    * Messages of a type without a handler are dropped.
+    * @param msgq The message queue.
+    * @param type The message type.
+    * @param handler The handler, or NULL.
+    */
+   extern void buzzinmsg_queue_set_handler(buzzinmsg_queue_t msgq,
+                                           int type,
+                                           buzzinmsg_handler_t handler);
 
    /*
     * Appends a message to the queue.
@@ -29,6 +111,7 @@ extern "C" {
 
    /*
     * Extracts a message from the queue.
+    * The messages of a robot come out in the order they were appended.
     * You are in charge of freeing both the message data and the payload.
     * If the queue is empty, the values of *id and *payload are left untouched.
     * @param vm The Buzz VM.
@@ -40,10 +123,29 @@ extern "C" {
                                       uint16_t* id,
                                       buzzmsg_payload_t* payload);
 
+   /*
+    * Dispatches every queued message to its handler.
+    * Senders are marked as active neighbors once each. The messages are
+    * then handled type by type, in the order of buzzmsg_payload_type_e;
+    * the messages of a type keep their per-sender order. The swarm
+    * joins, leaves and lists are handled together, when the swarm lists
+    * are, in the per-sender order they arrived in. If a handler puts the
+    * VM in an error state, the remaining messages are dropped.
+    * @param vm The Buzz VM.
+    */
+   extern void buzzinmsg_queue_dispatch(struct buzzvm_s* vm);
+
+   /*
+    * Registers the in-message statistics methods into the VM.
+    * @param vm The Buzz VM.
+    * @return The VM state.
+    */
+   extern int buzzinmsg_register(struct buzzvm_s* vm);
+
    /**
     * Internally used to cleanup a queue entry.
     * @param key A pointer to the robot id (uint16_t)
-    * @param data A pointer to buzzdarray_t
+    * @param data A pointer to buzzqueue_t
     * @param param Unused
     */
    extern void buzzvm_inmsg_queue_destroy_entry(const void* key,
@@ -54,37 +156,18 @@ extern "C" {
 }
 #endif
 
-/*
- * Create a new message queue.
- */
-#define buzzinmsg_queue_new() buzzdict_new(20, sizeof(uint16_t), sizeof(buzzmsg_payload_t), buzzdict_uint16keyhash, buzzdict_uint16keycmp, buzzvm_inmsg_queue_destroy_entry)
-
-/*
- * Destroys a message queue.
- * @param msgq The message queue.
- */
-#define buzzinmsg_queue_destroy(msgq) buzzdict_destroy(msgq)
-
 /*
  * Returns the size of a message queue.
  * @param msgq The message queue.
  * @return The size of a message queue.
  */
-#define buzzinmsg_queue_size(msgq) buzzdict_size(msgq)
+#define buzzinmsg_queue_size(msgq) (msgq)->size
 
 /*
  * Returns <tt>true</tt> if the message queue is empty.
  * @param msgq The message queue.
  * @return <tt>true</tt> if the message queue is empty.
  */
-#define buzzinmsg_queue_isempty(msgq) buzzdict_isempty(msgq)
-
-/*
- * Returns the message at the given position in the queue.
- * @param msg The message queue.
- * @param pos The position.
- * @return The message at the given position.
- */
-#define buzzinmsg_queue_get(msg, pos) buzzdict_get(msg, pos, buzzmsg_payload_t)
+#define buzzinmsg_queue_isempty(msgq) (buzzinmsg_queue_size(msgq) == 0)
 
 #endif
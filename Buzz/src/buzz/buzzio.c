@@ -229,6 +229,9 @@ int buzzio_fwrite(buzzvm_t vm) {
          case BUZZTYPE_USERDATA:
             err = fprintf(f, "[userdata @%p]", o->u.value);
             break;
+         case BUZZTYPE_BLOB:
+            err = fprintf(f, "[blob with %" PRIu32 " bytes]", o->b.value.size);
+            break;
          default:
             err = -1;
             break;
@@ -0,0 +1,161 @@
+#include "buzzlz4.h"
+#include <string.h>
+
+/* Shortest match */
+#define BUZZLZ4_MINMATCH     4
+/* The last match must start at least this many bytes before the end */
+#define BUZZLZ4_MFLIMIT      12
+/* The last bytes of a block are always literals */
+#define BUZZLZ4_LASTLITERALS 5
+/* Size of the match finder hash table, in bits */
+#define BUZZLZ4_HASHLOG      12
+/* Largest match offset */
+#define BUZZLZ4_MAXOFFSET    65535
+
+/****************************************/
+/****************************************/
+
+static uint32_t buzzlz4_read32(const uint8_t* p) {
+   uint32_t v;
+   memcpy(&v, p, sizeof(v));
+   return v;
+}
+
+static uint32_t buzzlz4_hash(uint32_t v) {
+   return (v * 2654435761U) >> (32 - BUZZLZ4_HASHLOG);
+}
+
+/* Writes the extra bytes of a length longer than 14 */
+static uint8_t* buzzlz4_write_len(uint8_t* op, uint32_t len) {
+   len -= 15;
+   while(len >= 255) {
+      *op++ = 255;
+      len -= 255;
+   }
+   *op++ = (uint8_t)len;
+   return op;
+}
+
+/* Reads the extra bytes of a length, 0 on truncated input */
+static int buzzlz4_read_len(const uint8_t** ip, const uint8_t* iend, uint32_t* len) {
+   uint8_t b;
+   do {
+      if(*ip >= iend) return 0;
+      b = *(*ip)++;
+      *len += b;
+   } while(b == 255);
+   return 1;
+}
+
+/****************************************/
+/****************************************/
+
+uint32_t buzzlz4_bound(uint32_t size) {
+   return size + size / 255 + 16;
+}
+
+/****************************************/
+/****************************************/
+
+uint32_t buzzlz4_compress(const uint8_t* src,
+                          uint32_t size,
+                          uint8_t* dst,
+                          uint32_t cap) {
+   uint32_t table[1 << BUZZLZ4_HASHLOG];
+   const uint8_t* ip = src;
+   const uint8_t* anchor = src;
+   const uint8_t* end = src + size;
+   uint8_t* op = dst;
+   uint8_t* oend = dst + cap;
+   if(size > BUZZLZ4_MFLIMIT) {
+      const uint8_t* mflimit = end - BUZZLZ4_MFLIMIT;
+      const uint8_t* matchlimit = end - BUZZLZ4_LASTLITERALS;
+      memset(table, 0, sizeof(table));
+      while(ip <= mflimit) {
+         /* Look for a previous occurrence of the next four bytes */
+         uint32_t seq = buzzlz4_read32(ip);
+         uint32_t h = buzzlz4_hash(seq);
+         const uint8_t* ref = src + table[h];
+         table[h] = ip - src;
+         if(ref >= ip ||
+            ip - ref > BUZZLZ4_MAXOFFSET ||
+            buzzlz4_read32(ref) != seq) {
+            ++ip;
+            continue;
+         }
+         /* Extend the match */
+         const uint8_t* mp = ip + BUZZLZ4_MINMATCH;
+         const uint8_t* rp = ref + BUZZLZ4_MINMATCH;
+         while(mp < matchlimit && *mp == *rp) { ++mp; ++rp; }
+         uint32_t litlen = ip - anchor;
+         uint32_t mlen = (mp - ip) - BUZZLZ4_MINMATCH;
+         /* Make sure the sequence fits */
+         if((uint32_t)(oend - op) < 1 + litlen / 255 + 1 + litlen + 2 + mlen / 255 + 1)
+            return 0;
+         /* Token, literals, offset and match length */
+         uint8_t* token = op++;
+         *token = (uint8_t)(((litlen >= 15) ? 15 : litlen) << 4);
+         if(litlen >= 15) op = buzzlz4_write_len(op, litlen);
+         memcpy(op, anchor, litlen);
+         op += litlen;
+         uint16_t off = ip - ref;
+         *op++ = (uint8_t)(off & 0xFF);
+         *op++ = (uint8_t)(off >> 8);
+         *token |= (uint8_t)((mlen >= 15) ? 15 : mlen);
+         if(mlen >= 15) op = buzzlz4_write_len(op, mlen);
+         ip = mp;
+         anchor = ip;
+      }
+   }
+   /* The remaining bytes go as literals */
+   uint32_t litlen = end - anchor;
+   if((uint32_t)(oend - op) < 1 + litlen / 255 + 1 + litlen)
+      return 0;
+   uint8_t* token = op++;
+   *token = (uint8_t)(((litlen >= 15) ? 15 : litlen) << 4);
+   if(litlen >= 15) op = buzzlz4_write_len(op, litlen);
+   memcpy(op, anchor, litlen);
+   op += litlen;
+   return op - dst;
+}
+
+/****************************************/
+/****************************************/
+
+int64_t buzzlz4_decompress(const uint8_t* src,
+                           uint32_t size,
+                           uint8_t* dst,
+                           uint32_t cap) {
+   const uint8_t* ip = src;
+   const uint8_t* iend = src + size;
+   uint8_t* op = dst;
+   uint8_t* oend = dst + cap;
+   while(ip < iend) {
+      uint8_t token = *ip++;
+      /* Literals */
+      uint32_t len = token >> 4;
+      if(len == 15 && !buzzlz4_read_len(&ip, iend, &len)) return -1;
+      if(len > (uint32_t)(iend - ip) || len > (uint32_t)(oend - op)) return -1;
+      memcpy(op, ip, len);
+      op += len;
+      ip += len;
+      /* The last sequence has no match */
+      if(ip == iend) break;
+      /* Match */
+      if(iend - ip < 2) return -1;
+      uint32_t off = ip[0] | (ip[1] << 8);
+      ip += 2;
+      if(off == 0 || off > (uint32_t)(op - dst)) return -1;
+      len = token & 0x0F;
+      if(len == 15 && !buzzlz4_read_len(&ip, iend, &len)) return -1;
+      len += BUZZLZ4_MINMATCH;
+      if(len > (uint32_t)(oend - op)) return -1;
+      /* Byte by byte, since the match may overlap the output */
+      const uint8_t* mp = op - off;
+      while(len-- > 0) *op++ = *mp++;
+   }
+   return op - dst;
+}
+
+/****************************************/
+/****************************************/
@@ -0,0 +1,50 @@
+#ifndef BUZZLZ4_H
+#define BUZZLZ4_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+   /*
+    * Returns the largest size a compressed block can take.
+    * @param size The number of bytes to compress.
+    * @return The worst-case compressed size.
+    */
+   extern uint32_t buzzlz4_bound(uint32_t size);
+
+   /*
+    * Compresses a buffer into an LZ4 block.
+    * The output is a raw LZ4 block, without frame header or checksum.
+    * @param src The bytes to compress.
+    * @param size The number of bytes to compress.
+    * @param dst The output buffer.
+    * @param cap The capacity of the output buffer.
+    * @return The compressed size, or 0 if it does not fit in cap.
+    */
+   extern uint32_t buzzlz4_compress(const uint8_t* src,
+                                    uint32_t size,
+                                    uint8_t* dst,
+                                    uint32_t cap);
+
+   /*
+    * Decompresses an LZ4 block.
+    * Every read and write is bounds-checked, so malformed input is
+    * rejected instead of overrunning a buffer.
+    * @param src The compressed block.
+    * @param size The size of the compressed block.
+    * @param dst The output buffer.
+    * @param cap The capacity of the output buffer.
+    * @return The decompressed size, or -1 if the block is malformed.
+    */
+   extern int64_t buzzlz4_decompress(const uint8_t* src,
+                                     uint32_t size,
+                                     uint8_t* dst,
+                                     uint32_t cap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
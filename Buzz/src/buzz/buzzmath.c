@@ -31,7 +31,7 @@ void mt_setseed(buzzvm_t vm,
 
 uint32_t mt_uniform32(buzzvm_t vm) {
    uint32_t y;
-   static uint32_t mag01[2] = { 0x0UL, MATRIX_A };
+   static const uint32_t mag01[2] = { 0x0UL, MATRIX_A };
    /* mag01[x] = x * MATRIX_A  for x=0,1 */
    if (vm->rngidx >= N) { /* generate N words at one time */
       int32_t kk;
@@ -147,7 +147,8 @@ int buzzmath_abs(buzzvm_t vm) {
    buzzvm_lnum_assert(vm, 1);
    /* Get argument */
    buzzvm_lload(vm, 1);
-   buzzobj_t o = buzzvm_stack_at(vm, 1);
+   union buzzobj_u v;
+   buzzobj_t o = buzzvm_stack_peek(vm, 1, &v);
    if(o->o.type == BUZZTYPE_FLOAT)    buzzvm_pushf(vm, fabsf(o->f.value));
    else if(o->o.type == BUZZTYPE_INT) buzzvm_pushi(vm, abs(o->i.value));
    else buzzmath_error(o);
@@ -162,7 +163,8 @@ int buzzmath_floor(buzzvm_t vm) {
    buzzvm_lnum_assert(vm, 1);
    /* Get argument */
    buzzvm_lload(vm, 1);
-   buzzobj_t o = buzzvm_stack_at(vm, 1);
+   union buzzobj_u v;
+   buzzobj_t o = buzzvm_stack_peek(vm, 1, &v);
    if(o->o.type == BUZZTYPE_FLOAT)    buzzvm_pushi(vm, floor(o->f.value));
    else if(o->o.type == BUZZTYPE_INT) buzzvm_pushi(vm, o->i.value);
    else buzzmath_error(o);
@@ -177,7 +179,8 @@ int buzzmath_ceil(buzzvm_t vm) {
    buzzvm_lnum_assert(vm, 1);
    /* Get argument */
    buzzvm_lload(vm, 1);
-   buzzobj_t o = buzzvm_stack_at(vm, 1);
+   union buzzobj_u v;
+   buzzobj_t o = buzzvm_stack_peek(vm, 1, &v);
    if(o->o.type == BUZZTYPE_FLOAT)    buzzvm_pushi(vm, ceil(o->f.value));
    else if(o->o.type == BUZZTYPE_INT) buzzvm_pushi(vm, o->i.value);
    else buzzmath_error(o);
@@ -192,7 +195,8 @@ int buzzmath_round(buzzvm_t vm) {
    buzzvm_lnum_assert(vm, 1);
    /* Get argument */
    buzzvm_lload(vm, 1);
-   buzzobj_t o = buzzvm_stack_at(vm, 1);
+   union buzzobj_u v;
+   buzzobj_t o = buzzvm_stack_peek(vm, 1, &v);
    if(o->o.type == BUZZTYPE_FLOAT)    buzzvm_pushi(vm, round(o->f.value));
    else if(o->o.type == BUZZTYPE_INT) buzzvm_pushi(vm, o->i.value);
    else buzzmath_error(o);
@@ -208,7 +212,8 @@ int buzzmath_log(buzzvm_t vm) {
    /* Get argument */
    float arg;
    buzzvm_lload(vm, 1);
-   buzzobj_t o = buzzvm_stack_at(vm, 1);
+   union buzzobj_u v;
+   buzzobj_t o = buzzvm_stack_peek(vm, 1, &v);
    if(o->o.type == BUZZTYPE_FLOAT)    arg = o->f.value;
    else if(o->o.type == BUZZTYPE_INT) arg = o->i.value;
    else buzzmath_error(o);
@@ -226,7 +231,8 @@ int buzzmath_log2(buzzvm_t vm) {
    /* Get argument */
    float arg;
    buzzvm_lload(vm, 1);
-   buzzobj_t o = buzzvm_stack_at(vm, 1);
+   union buzzobj_u v;
+   buzzobj_t o = buzzvm_stack_peek(vm, 1, &v);
    if(o->o.type == BUZZTYPE_FLOAT)    arg = o->f.value;
    else if(o->o.type == BUZZTYPE_INT) arg = o->i.value;
    else buzzmath_error(o);
@@ -244,7 +250,8 @@ int buzzmath_log10(buzzvm_t vm) {
    /* Get argument */
    float arg;
    buzzvm_lload(vm, 1);
-   buzzobj_t o = buzzvm_stack_at(vm, 1);
+   union buzzobj_u v;
+   buzzobj_t o = buzzvm_stack_peek(vm, 1, &v);
    if(o->o.type == BUZZTYPE_FLOAT)    arg = o->f.value;
    else if(o->o.type == BUZZTYPE_INT) arg = o->i.value;
    else buzzmath_error(o);
@@ -262,7 +269,8 @@ int buzzmath_exp(buzzvm_t vm) {
    /* Get argument */
    float arg;
    buzzvm_lload(vm, 1);
-   buzzobj_t o = buzzvm_stack_at(vm, 1);
+   union buzzobj_u v;
+   buzzobj_t o = buzzvm_stack_peek(vm, 1, &v);
    if(o->o.type == BUZZTYPE_FLOAT)    arg = o->f.value;
    else if(o->o.type == BUZZTYPE_INT) arg = o->i.value;
    else buzzmath_error(o);
@@ -280,7 +288,8 @@ int buzzmath_sqrt(buzzvm_t vm) {
    /* Get argument */
    float arg;
    buzzvm_lload(vm, 1);
-   buzzobj_t o = buzzvm_stack_at(vm, 1);
+   union buzzobj_u v;
+   buzzobj_t o = buzzvm_stack_peek(vm, 1, &v);
    if(o->o.type == BUZZTYPE_FLOAT)    arg = o->f.value;
    else if(o->o.type == BUZZTYPE_INT) arg = o->i.value;
    else buzzmath_error(o);
@@ -298,7 +307,8 @@ int buzzmath_sin(buzzvm_t vm) {
    /* Get argument */
    float arg;
    buzzvm_lload(vm, 1);
-   buzzobj_t o = buzzvm_stack_at(vm, 1);
+   union buzzobj_u v;
+   buzzobj_t o = buzzvm_stack_peek(vm, 1, &v);
    if(o->o.type == BUZZTYPE_FLOAT)    arg = o->f.value;
    else if(o->o.type == BUZZTYPE_INT) arg = o->i.value;
    else buzzmath_error(o);
@@ -316,7 +326,8 @@ int buzzmath_cos(buzzvm_t vm) {
    /* Get argument */
    float arg;
    buzzvm_lload(vm, 1);
-   buzzobj_t o = buzzvm_stack_at(vm, 1);
+   union buzzobj_u v;
+   buzzobj_t o = buzzvm_stack_peek(vm, 1, &v);
    if(o->o.type == BUZZTYPE_FLOAT)    arg = o->f.value;
    else if(o->o.type == BUZZTYPE_INT) arg = o->i.value;
    else buzzmath_error(o);
@@ -334,7 +345,8 @@ int buzzmath_tan(buzzvm_t vm) {
    /* Get argument */
    float arg;
    buzzvm_lload(vm, 1);
-   buzzobj_t o = buzzvm_stack_at(vm, 1);
+   union buzzobj_u v;
+   buzzobj_t o = buzzvm_stack_peek(vm, 1, &v);
    if(o->o.type == BUZZTYPE_FLOAT)    arg = o->f.value;
    else if(o->o.type == BUZZTYPE_INT) arg = o->i.value;
    else buzzmath_error(o);
@@ -352,7 +364,8 @@ int buzzmath_asin(buzzvm_t vm) {
    /* Get argument */
    float arg;
    buzzvm_lload(vm, 1);
-   buzzobj_t o = buzzvm_stack_at(vm, 1);
+   union buzzobj_u v;
+   buzzobj_t o = buzzvm_stack_peek(vm, 1, &v);
    if(o->o.type == BUZZTYPE_FLOAT)    arg = o->f.value;
    else if(o->o.type == BUZZTYPE_INT) arg = o->i.value;
    else buzzmath_error(o);
@@ -370,7 +383,8 @@ int buzzmath_acos(buzzvm_t vm) {
    /* Get argument */
    float arg;
    buzzvm_lload(vm, 1);
-   buzzobj_t o = buzzvm_stack_at(vm, 1);
+   union buzzobj_u v;
+   buzzobj_t o = buzzvm_stack_peek(vm, 1, &v);
    if(o->o.type == BUZZTYPE_FLOAT)    arg = o->f.value;
    else if(o->o.type == BUZZTYPE_INT) arg = o->i.value;
    else buzzmath_error(o);
@@ -388,7 +402,8 @@ int buzzmath_atan(buzzvm_t vm) {
    /* Get first argument */
    float y;
    buzzvm_lload(vm, 1);
-   buzzobj_t o = buzzvm_stack_at(vm, 1);
+   union buzzobj_u v;
+   buzzobj_t o = buzzvm_stack_peek(vm, 1, &v);
    if(o->o.type == BUZZTYPE_FLOAT)    y = o->f.value;
    else if(o->o.type == BUZZTYPE_INT) y = o->i.value;
    else {
@@ -403,7 +418,7 @@ int buzzmath_atan(buzzvm_t vm) {
    /* Get second argument */
    float x;
    buzzvm_lload(vm, 2);
-   o = buzzvm_stack_at(vm, 1);
+   o = buzzvm_stack_peek(vm, 1, &v);
    if(o->o.type == BUZZTYPE_FLOAT)    x = o->f.value;
    else if(o->o.type == BUZZTYPE_INT) x = o->i.value;
    else {
@@ -8,83 +8,158 @@
 /****************************************/
 /****************************************/
 
-static int32_t MAX_MANTISSA = 2147483646; // 2 << 31 - 2;
+static const int32_t MAX_MANTISSA = 2147483646; // 2 << 31 - 2;
 
 /****************************************/
 /****************************************/
 
-void buzzmsg_serialize_u8(buzzdarray_t buf,
+/* The bytes of a payload made by buzzmsg_payload_frombuffer() follow the struct */
+#define buzzmsg_payload_isembedded(msg) ((msg)->data == (uint8_t*)((msg) + 1))
+
+buzzmsg_payload_t buzzmsg_payload_new(uint32_t cap) {
+   buzzmsg_payload_t msg = (buzzmsg_payload_t)malloc(sizeof(struct buzzmsg_payload_s));
+   msg->size = 0;
+   msg->capacity = cap > 0 ? cap : 1;
+   msg->data = (uint8_t*)malloc(msg->capacity);
+   return msg;
+}
+
+/****************************************/
+/****************************************/
+
+buzzmsg_payload_t buzzmsg_payload_frombuffer(const void* buf,
+                                             uint32_t buf_size) {
+   /* One allocation for the struct and the bytes */
+   buzzmsg_payload_t msg = (buzzmsg_payload_t)malloc(sizeof(struct buzzmsg_payload_s) + buf_size);
+   msg->data = (uint8_t*)(msg + 1);
+   msg->size = buf_size;
+   msg->capacity = buf_size;
+   memcpy(msg->data, buf, buf_size);
+   return msg;
+}
+
+/****************************************/
+/****************************************/
+
+void buzzmsg_payload_destroy(buzzmsg_payload_t* msg) {
+   if(!buzzmsg_payload_isembedded(*msg)) free((*msg)->data);
+   free(*msg);
+   *msg = NULL;
+}
+
+/****************************************/
+/****************************************/
+
+void buzzmsg_payload_reserve(buzzmsg_payload_t msg,
+                             uint32_t size) {
+   if(size <= msg->capacity) return;
+   /* Grow geometrically */
+   uint32_t cap = msg->capacity > 0 ? msg->capacity : 1;
+   while(cap < size) cap *= 2;
+   uint8_t* nd;
+   if(buzzmsg_payload_isembedded(msg)) {
+      nd = (uint8_t*)malloc(cap);
+      if(nd) memcpy(nd, msg->data, msg->size);
+   }
+   else
+      nd = (uint8_t*)realloc(msg->data, cap);
+   if(!nd) {
+      fprintf(stderr, "[FATAL] Can't reallocate message payload.\n");
+      abort();
+   }
+   msg->data = nd;
+   msg->capacity = cap;
+}
+
+/****************************************/
+/****************************************/
+
+void buzzmsg_payload_append(buzzmsg_payload_t msg,
+                            const void* data,
+                            uint32_t size) {
+   if(size == 0) return;
+   buzzmsg_payload_reserve(msg, msg->size + size);
+   memcpy(msg->data + msg->size, data, size);
+   msg->size += size;
+}
+
+/****************************************/
+/****************************************/
+
+int64_t buzzmsg_payload_read(void* data,
+                             uint32_t size,
+                             buzzmsg_payload_t msg,
+                             int64_t pos) {
+   if(pos < 0 || pos + size > msg->size) return -1;
+   memcpy(data, msg->data + pos, size);
+   return pos + size;
+}
+
+/****************************************/
+/****************************************/
+
+void buzzmsg_serialize_u8(buzzmsg_payload_t buf,
                           uint8_t data) {
-   buzzdarray_push(buf, &data);
+   buzzmsg_payload_append(buf, &data, sizeof(data));
 }
 
 /****************************************/
 /****************************************/
 
 int64_t buzzmsg_deserialize_u8(uint8_t* data,
-                               buzzdarray_t buf,
+                               buzzmsg_payload_t buf,
                                uint32_t pos) {
-   if(pos + sizeof(uint8_t) > buzzdarray_size(buf)) return -1;
-   *data = buzzdarray_get(buf, pos, uint8_t);
-   return pos + sizeof(uint8_t);
+   return buzzmsg_payload_read(data, sizeof(uint8_t), buf, pos);
 }
 
 /****************************************/
 /****************************************/
 
-void buzzmsg_serialize_u16(buzzdarray_t buf,
+void buzzmsg_serialize_u16(buzzmsg_payload_t buf,
                            uint16_t data) {
    uint16_t x = htons(data);
-   buzzdarray_push(buf, (uint8_t*)(&x));
-   buzzdarray_push(buf, (uint8_t*)(&x)+1);
+   buzzmsg_payload_append(buf, &x, sizeof(x));
 }
 
 /****************************************/
 /****************************************/
 
 int64_t buzzmsg_deserialize_u16(uint16_t* data,
-                                buzzdarray_t buf,
+                                buzzmsg_payload_t buf,
                                 uint32_t pos) {
-   if(pos + sizeof(uint16_t) > buzzdarray_size(buf)) return -1;
-   *data =
-      buzzdarray_get(buf, pos,   uint8_t)       +
-      (buzzdarray_get(buf, pos+1, uint8_t) << 8);
-   *data = ntohs(*data);
-   return pos + sizeof(uint16_t);
+   uint16_t x;
+   int64_t p = buzzmsg_payload_read(&x, sizeof(x), buf, pos);
+   if(p < 0) return -1;
+   *data = ntohs(x);
+   return p;
 }
 
 /****************************************/
 /****************************************/
 
-void buzzmsg_serialize_u32(buzzdarray_t buf,
+void buzzmsg_serialize_u32(buzzmsg_payload_t buf,
                            uint32_t data) {
    uint32_t x = htonl(data);
-   buzzdarray_push(buf, (uint8_t*)(&x));
-   buzzdarray_push(buf, (uint8_t*)(&x)+1);
-   buzzdarray_push(buf, (uint8_t*)(&x)+2);
-   buzzdarray_push(buf, (uint8_t*)(&x)+3);
+   buzzmsg_payload_append(buf, &x, sizeof(x));
 }
 
 /****************************************/
 /****************************************/
 
 int64_t buzzmsg_deserialize_u32(uint32_t* data,
-                                buzzdarray_t buf,
+                                buzzmsg_payload_t buf,
                                 uint32_t pos) {
-   if(pos + sizeof(uint32_t) > buzzdarray_size(buf)) return -1;
-   *data =
-      buzzdarray_get(buf, pos,   uint8_t)         +
-      (buzzdarray_get(buf, pos+1, uint8_t) << 8)  +
-      (buzzdarray_get(buf, pos+2, uint8_t) << 16) +
-      (buzzdarray_get(buf, pos+3, uint8_t) << 24);
-   *data = ntohl(*data);
-   return pos + sizeof(uint32_t);
+   uint32_t x;
+   int64_t p = buzzmsg_payload_read(&x, sizeof(x), buf, pos);
+   if(p < 0) return -1;
+   *data = ntohl(x);
+   return p;
 }
 
 /****************************************/
 /****************************************/
 
-void buzzmsg_serialize_float(buzzdarray_t buf,
+void buzzmsg_serialize_float(buzzmsg_payload_t buf,
                              float data) {
    /* The mantissa */
    int32_t mant;
@@ -127,10 +202,10 @@ void buzzmsg_serialize_float(buzzdarray_t buf,
 /****************************************/
 
 int64_t buzzmsg_deserialize_float(float* data,
-                                  buzzdarray_t buf,
+                                  buzzmsg_payload_t buf,
                                   uint32_t pos) {
    /* Make sure enough bytes are left to read */
-   if(pos + 2*sizeof(uint32_t) > buzzdarray_size(buf)) return -1;
+   if(pos + 2*sizeof(uint32_t) > buzzmsg_payload_size(buf)) return -1;
    /* Read the mantissa and the exponent */
    int32_t mant;
    int32_t exp;
@@ -165,37 +240,33 @@ int64_t buzzmsg_deserialize_float(float* data,
 /****************************************/
 /****************************************/
 
-void buzzmsg_serialize_string(buzzdarray_t buf,
+void buzzmsg_serialize_string(buzzmsg_payload_t buf,
                               const char* data) {
    /* Get the length of the string */
    uint16_t len = strlen(data);
    /* Push that into the buffer */
    buzzmsg_serialize_u16(buf, len);
-   /* Go through the characters and push them into the buffer */
-   const char* c = data;
-   while(*c) {
-      buzzdarray_push(buf, (uint8_t*)(c));
-      ++c;
-   }
+   /* Push the characters into the buffer */
+   buzzmsg_payload_append(buf, data, len);
 }
 
 /****************************************/
 /****************************************/
 
 int64_t buzzmsg_deserialize_string(char** data,
-                                   buzzdarray_t buf,
+                                   buzzmsg_payload_t buf,
                                    uint32_t pos) {
    /* Make sure there are enough bytes to read the string length */
-   if(pos + sizeof(uint16_t) > buzzdarray_size(buf)) return -1;
+   if(pos + sizeof(uint16_t) > buzzmsg_payload_size(buf)) return -1;
    /* Read the string length */
    uint16_t len;
    pos = buzzmsg_deserialize_u16(&len, buf, pos);
    /* Make sure there are enough bytes to read the string itself */   
-   if(pos + len > buzzdarray_size(buf)) return -1;
+   if(pos + len > buzzmsg_payload_size(buf)) return -1;
    /* Create a buffer for the string */
    *data = (char*)malloc(len * sizeof(char) + 1);
    /* Read the string characters */
-   memcpy(*data, (uint8_t*)buf->data + pos, len * sizeof(char));
+   memcpy(*data, buf->data + pos, len * sizeof(char));
    /* Set the termination character */
    *(*data + len) = 0;
    /* Return new position */
@@ -204,3 +275,35 @@ int64_t buzzmsg_deserialize_string(char** data,
 
 /****************************************/
 /****************************************/
+
+void buzzmsg_serialize_bytes(buzzmsg_payload_t buf,
+                             const uint8_t* data,
+                             uint32_t size) {
+   /* Push the length into the buffer */
+   buzzmsg_serialize_u32(buf, size);
+   /* Push the bytes into the buffer */
+   buzzmsg_payload_append(buf, data, size);
+}
+
+/****************************************/
+/****************************************/
+
+int64_t buzzmsg_deserialize_bytes(uint8_t** data,
+                                  uint32_t* size,
+                                  buzzmsg_payload_t buf,
+                                  uint32_t pos) {
+   /* Make sure there are enough bytes to read the length */
+   /* Read the length */
+   int64_t p = buzzmsg_deserialize_u32(size, buf, pos);
+   if(p < 0) return -1;
+   /* Make sure there are enough bytes to read the data itself */
+   if(p + *size > buzzmsg_payload_size(buf)) return -1;
+   /* Copy the bytes; never hand out a NULL buffer */
+   *data = (uint8_t*)malloc(*size > 0 ? *size : 1);
+   memcpy(*data, buf->data + p, *size);
+   /* Return new position */
+   return p + *size;
+}
+
+/****************************************/
+/****************************************/
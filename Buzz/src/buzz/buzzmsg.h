@@ -71,8 +71,16 @@ extern "C" {
 
    /*
     * Data of a Buzz message.
+    * This is a growable byte buffer. Writes append bytes with
+    * memcpy(). Reads go through the buzzmsg_deserialize_*() functions,
+    * which take a cursor position and check it against the size.
     */
-   typedef buzzdarray_t buzzmsg_payload_t;
+   struct buzzmsg_payload_s {
+      uint8_t* data;     // The bytes
+      int64_t size;      // Number of bytes written
+      uint32_t capacity; // Number of bytes allocated
+   };
+   typedef struct buzzmsg_payload_s* buzzmsg_payload_t;
 
    struct buzzp2poutmsg_payload_s{
     buzzmsg_payload_t msg;
@@ -80,10 +88,63 @@ extern "C" {
    };
    typedef struct buzzp2poutmsg_payload_s* buzzp2poutmsg_payload_t;
 
+   /*
+    * Create a new message payload.
+    * @param cap The initial capacity of the message payload in bytes.
+    * @return A new message payload.
+    */
+   extern buzzmsg_payload_t buzzmsg_payload_new(uint32_t cap);
+
+   /*
+    * Create a new message payload from the given buffer.
+    * The payload and its bytes are allocated in a single block.
+    * @param buf The buffer.
+    * @param buf_size The size of the buffer in bytes.
+    * @return A new message payload.
+    */
+   extern buzzmsg_payload_t buzzmsg_payload_frombuffer(const void* buf,
+                                                       uint32_t buf_size);
+
+   /*
+    * Destroys a message payload.
+    * @param msg The message payload.
+    */
+   extern void buzzmsg_payload_destroy(buzzmsg_payload_t* msg);
+
+   /*
+    * Makes sure the payload can hold the given number of bytes.
+    * @param msg The message payload.
+    * @param size The number of bytes.
+    */
+   extern void buzzmsg_payload_reserve(buzzmsg_payload_t msg,
+                                       uint32_t size);
+
+   /*
+    * Appends bytes at the end of a message payload.
+    * @param msg The message payload.
+    * @param data The bytes to append.
+    * @param size The number of bytes to append.
+    */
+   extern void buzzmsg_payload_append(buzzmsg_payload_t msg,
+                                      const void* data,
+                                      uint32_t size);
+
+   /*
+    * Reads bytes from a message payload.
+    * @param data The buffer where the bytes are copied.
+    * @param size The number of bytes to read.
+    * @param msg The message payload.
+    * @param pos The position at which the bytes start.
+    * @return The new position in the buffer, or -1 if fewer than size bytes are left.
+    */
+   extern int64_t buzzmsg_payload_read(void* data,
+                                       uint32_t size,
+                                       buzzmsg_payload_t msg,
+                                       int64_t pos);
+
    /*
     * Serializes a 8-bit unsigned integer.
-    * The data is appended to the given buffer. The buffer is treated as a
-    * dynamic array of uint8_t.
+    * The data is appended to the given buffer.
     * @param buf The output buffer where the serialized data is appended.
     * @param data The data to serialize.
     */
@@ -93,7 +154,6 @@ extern "C" {
    /*
     * Deserializes a 8-bit unsigned integer.
     * The data is read from the given buffer starting at the given position.
-    * The buffer is treated as a dynamic array of uint8_t.
     * @param data The deserialized data of the element.
     * @param buf The input buffer where the serialized data is stored.
     * @param pos The position at which the data starts.
@@ -105,8 +165,7 @@ extern "C" {
 
    /*
     * Serializes a 16-bit unsigned integer.
-    * The data is appended to the given buffer. The buffer is treated as a
-    * dynamic array of uint8_t.
+    * The data is appended to the given buffer.
     * @param buf The output buffer where the serialized data is appended.
     * @param data The data to serialize.
     */
@@ -116,7 +175,6 @@ extern "C" {
    /*
     * Deserializes a 16-bit unsigned integer.
     * The data is read from the given buffer starting at the given position.
-    * The buffer is treated as a dynamic array of uint8_t.
     * @param data The deserialized data of the element.
     * @param buf The input buffer where the serialized data is stored.
     * @param pos The position at which the data starts.
@@ -128,8 +186,7 @@ extern "C" {
 
    /*
     * Serializes a 32-bit unsigned integer.
-    * The data is appended to the given buffer. The buffer is treated as a
-    * dynamic array of uint8_t.
+    * The data is appended to the given buffer.
     * @param buf The output buffer where the serialized data is appended.
     * @param data The data to serialize.
     */
@@ -139,7 +196,6 @@ extern "C" {
    /*
     * Deserializes a 32-bit unsigned integer.
     * The data is read from the given buffer starting at the given position.
-    * The buffer is treated as a dynamic array of uint8_t.
     * @param data The deserialized data of the element.
     * @param buf The input buffer where the serialized data is stored.
     * @param pos The position at which the data starts.
@@ -151,8 +207,7 @@ extern "C" {
 
    /*
     * Serializes a float.
-    * The data is appended to the given buffer. The buffer is treated as a
-    * dynamic array of uint8_t.
+    * The data is appended to the given buffer.
     * @param buf The output buffer where the serialized data is appended.
     * @param data The data to serialize.
     */
@@ -162,7 +217,6 @@ extern "C" {
    /*
     * Deserializes a float.
     * The data is read from the given buffer starting at the given position.
-    * The buffer is treated as a dynamic array of uint8_t.
     * @param data The deserialized data of the element.
     * @param buf The input buffer where the serialized data is stored.
     * @param pos The position at which the data starts.
@@ -174,8 +228,7 @@ extern "C" {
 
    /*
     * Serializes a string.
-    * The data is appended to the given buffer. The buffer is treated as a
-    * dynamic array of uint8_t.
+    * The data is appended to the given buffer.
     * @param buf The output buffer where the serialized data is appended.
     * @param data The data to serialize.
     */
@@ -185,7 +238,6 @@ extern "C" {
    /*
     * Deserializes a string.
     * The data is read from the given buffer starting at the given position.
-    * The buffer is treated as a dynamic array of uint8_t.
     * @param data The deserialized data of the element. You are in charge of freeing it.
     * @param buf The input buffer where the serialized data is stored.
     * @param pos The position at which the data starts.
@@ -195,35 +247,43 @@ extern "C" {
                                              buzzmsg_payload_t buf,
                                              uint32_t pos);
 
+   /*
+    * Serializes a byte buffer.
+    * The buffer is written as a 32-bit length followed by the raw bytes,
+    * so it may contain any value, including zeroes.
+    * The data is appended to the given buffer.
+    * @param buf The output buffer where the serialized data is appended.
+    * @param data The bytes to serialize.
+    * @param size The number of bytes to serialize.
+    */
+   extern void buzzmsg_serialize_bytes(buzzmsg_payload_t buf,
+                                       const uint8_t* data,
+                                       uint32_t size);
+
+   /*
+    * Deserializes a byte buffer.
+    * The data is read from the given buffer starting at the given position.
+    * @param data The deserialized bytes. You are in charge of freeing them.
+    * @param size The number of deserialized bytes.
+    * @param buf The input buffer where the serialized data is stored.
+    * @param pos The position at which the data starts.
+    * @return The new position in the buffer, of -1 in case of error.
+    */
+   extern int64_t buzzmsg_deserialize_bytes(uint8_t** data,
+                                            uint32_t* size,
+                                            buzzmsg_payload_t buf,
+                                            uint32_t pos);
+
 #ifdef __cplusplus
 }
 #endif
 
-/*
- * Create a new message payload.
- * @param cap The initial capacity of the message payload. Must be >0.
- */
-#define buzzmsg_payload_new(cap) buzzdarray_new(cap, sizeof(uint8_t), NULL)
-
-/*
- * Create a new message payload from the given buffer.
- * @param buf The buffer.
- * @param buf_size The size of the buffer in bytes.
- */
-#define buzzmsg_payload_frombuffer(buf, buf_size) buzzdarray_frombuffer(buf, buf_size, sizeof(uint8_t), NULL)
-
-/*
- * Destroys a message payload.
- * @param msg The message payload.
- */
-#define buzzmsg_payload_destroy(msg) buzzdarray_destroy(msg)
-
 /*
  * Returns the size of a message payload.
  * @param msg The message payload.
  * @return The size of a message payload.
  */
-#define buzzmsg_payload_size(msg) buzzdarray_size(msg)
+#define buzzmsg_payload_size(msg) (msg)->size
 
 /*
  * Returns the byte at the given position.
@@ -231,6 +291,6 @@ extern "C" {
  * @param pos The position.
  * @return The byte at the given position.
  */
-#define buzzmsg_payload_get(msg, pos) buzzdarray_get(msg, pos, uint8_t)
+#define buzzmsg_payload_get(msg, pos) ((msg)->data[(pos)])
 
 #endif
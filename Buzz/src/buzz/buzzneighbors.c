@@ -139,10 +139,11 @@ int buzzneighbors_listen(buzzvm_t vm) {
    buzzvm_lload(vm, 2);
    buzzvm_type_assert(vm, 1, BUZZTYPE_CLOSURE);
    /* Install listener */
+   buzzobj_t l = buzzvm_stack_at(vm, 1);
    buzzdict_set(
       vm->listeners,
       &buzzvm_stack_at(vm, 2)->s.value.sid,
-      &buzzvm_stack_at(vm, 1));
+      &l);
    return buzzvm_ret0(vm);
 }
 
@@ -190,8 +191,9 @@ int buzzneighbors_kin(buzzvm_t vm) {
    if(!buzzdarray_isempty(vm->swarmstack)) {
       /* Get position in swarm stack */
       uint16_t sstackpos = 1;
+      union buzzobj_u v;
       if(buzzdarray_size(vm->lsyms->syms) > 1)
-         sstackpos = buzzdarray_get(vm->lsyms->syms, 1, buzzobj_t)->i.value;
+         sstackpos = buzzobj_unbox(buzzdarray_get(vm->lsyms->syms, 1, buzzobj_t), &v)->i.value;
       /* Get swarm id */
       if(sstackpos <= buzzdarray_size(vm->swarmstack))
          swarmid = buzzdarray_get(vm->swarmstack,
@@ -253,8 +255,9 @@ int buzzneighbors_nonkin(buzzvm_t vm) {
    if(!buzzdarray_isempty(vm->swarmstack)) {
       /* Get position in swarm stack */
       uint16_t sstackpos = 1;
+      union buzzobj_u v;
       if(buzzdarray_size(vm->lsyms->syms) > 1)
-         sstackpos = buzzdarray_get(vm->lsyms->syms, 1, buzzobj_t)->i.value;
+         sstackpos = buzzobj_unbox(buzzdarray_get(vm->lsyms->syms, 1, buzzobj_t), &v)->i.value;
       /* Get swarm id */
       if(sstackpos <= buzzdarray_size(vm->swarmstack))
          swarmid = buzzdarray_get(vm->swarmstack,
@@ -7,14 +7,28 @@
 #include <math.h>
 #include <string.h>
 
+/* Room reserved for the fields preceding the bytes in a chunk message */
+#define BUZZOUTMSG_CHUNK_HEADER_SIZE 64
+
 /****************************************/
 /****************************************/
 
+/*
+ * Fields shared by every message
+ */
+struct buzzoutmsg_header_s {
+   int type;
+   uint32_t stamp;         // scheduler step when queued
+   buzzmsg_payload_t wire; // cached serialized form, or NULL
+};
+
 /*
  * Broadcast message data
  */
 struct buzzoutmsg_broadcast_s {
    int type;
+   uint32_t stamp;         // scheduler step when queued
+   buzzmsg_payload_t wire; // cached serialized form, or NULL
    buzzobj_t topic;
    buzzobj_t value;
 };
@@ -24,6 +38,8 @@ struct buzzoutmsg_broadcast_s {
  */
 struct buzzoutmsg_swarm_s {
    int type;
+   uint32_t stamp;         // scheduler step when queued
+   buzzmsg_payload_t wire; // cached serialized form, or NULL
    uint16_t* ids;
    uint16_t size;
 };
@@ -33,6 +49,8 @@ struct buzzoutmsg_swarm_s {
  */
 struct buzzoutmsg_vstig_s {
    int type;
+   uint32_t stamp;         // scheduler step when queued
+   buzzmsg_payload_t wire; // cached serialized form, or NULL
    uint16_t id;
    buzzobj_t key;
    buzzvstig_elem_t data;
@@ -43,11 +61,15 @@ struct buzzoutmsg_vstig_s {
  */
 struct buzzoutmsg_bstig_s {
    int type;
+   uint32_t stamp;         // scheduler step when queued
+   buzzmsg_payload_t wire; // cached serialized form, or NULL
    uint16_t id;
    buzzobj_t key;
    buzzbstig_elem_t data;
    uint32_t blob_size;
    uint8_t  blob_entry;
+   uint8_t  codec;         // blob codec
+   uint32_t raw_size;      // blob size once decoded
 };
 
 /*
@@ -55,6 +77,8 @@ struct buzzoutmsg_bstig_s {
  */
 struct buzzoutmsg_bstig_chunk_s {
    int type;
+   uint32_t stamp;         // scheduler step when queued
+   buzzmsg_payload_t wire; // cached serialized form, or NULL
    uint16_t id;            // bstig id
    buzzobj_t key;          // bstig key the blob belongs
    buzzbstig_elem_t data;  // bstig  entry in bstig.
@@ -70,10 +94,13 @@ struct buzzoutmsg_bstig_chunk_s {
  */
 struct buzzoutmsg_bstig_status_s {
    int type;
+   uint32_t stamp;         // scheduler step when queued
+   buzzmsg_payload_t wire; // cached serialized form, or NULL
    uint16_t id;            // bstig id
    uint16_t key;           // bstig key the blob belongs
    uint8_t  status;        // status of blob
    uint16_t requester;     // rid requesting status change
+   buzzbitset_t have;      // chunks the requester holds, or NULL
 };
 
 /*
@@ -82,16 +109,23 @@ struct buzzoutmsg_bstig_status_s {
  */
 struct buzzoutmsg_blob_request_s {
    int type;
+   uint32_t stamp;         // scheduler step when queued
+   buzzmsg_payload_t wire; // cached serialized form, or NULL
    uint16_t id;
    uint16_t key; 
    uint16_t receiver;
    uint16_t sender;
+   uint16_t first;         // first chunk index covered by want
+   uint16_t count;         // chunk indices covered by want, 0 for all chunks
+   uint8_t* want;          // bitmap of the wanted chunks, or NULL
 };
 /*
  * Blob stigmergy blob status
  */
 struct buzzoutmsg_bstig_reloc_s {
    int type;
+   uint32_t stamp;         // scheduler step when queued
+   buzzmsg_payload_t wire; // cached serialized form, or NULL
    uint16_t id;            // bstig id
    uint16_t key;           // bstig key the blob belongs
    uint16_t cid;
@@ -105,11 +139,13 @@ struct buzzoutmsg_bstig_reloc_s {
  */
 struct buzzoutmsg_bstig_chunkremoval_s {
    int type;
+   uint32_t stamp;         // scheduler step when queued
+   buzzmsg_payload_t wire; // cached serialized form, or NULL
    uint16_t id;            // bstig id
    uint16_t key;           // bstig key the blob belongs
    uint16_t cid;           // bstig  cid in bstig.
    uint16_t subtype;       // Subtype of message
-   uint16_t timer;
+   struct buzztimer_s timer; // Anti-flooding timeout
 };
 
 /*
@@ -117,6 +153,8 @@ struct buzzoutmsg_bstig_chunkremoval_s {
  */
 struct buzzoutmsg_bstig_bidder_s {
    int type;
+   uint32_t stamp;         // scheduler step when queued
+   buzzmsg_payload_t wire; // cached serialized form, or NULL
    uint16_t id;            // bstig id
    uint16_t key;           // bstig key the blob belongs
    uint16_t bidderid;      // bidder id
@@ -125,7 +163,7 @@ struct buzzoutmsg_bstig_bidder_s {
    uint16_t availablespace; // available space to store chunks
    uint8_t  subtype;       // message subtype
    uint8_t getter;
-   uint16_t timer;         // time to destroy
+   struct buzztimer_s timer; // Anti-flooding timeout
    uint16_t receiver;
 };
 
@@ -135,6 +173,7 @@ struct buzzoutmsg_bstig_bidder_s {
  */
 union buzzoutmsg_u {
    int type;
+   struct buzzoutmsg_header_s            hd;
    struct buzzoutmsg_broadcast_s         bc;
    struct buzzoutmsg_swarm_s             sw;
    struct buzzoutmsg_vstig_s             vs;
@@ -180,17 +219,20 @@ void buzzoutmsg_destroy(uint32_t pos, void* data, void* params) {
       case BUZZMSG_BSTIG_CHUNK_PUT_P2P:
       case BUZZMSG_BSTIG_CHUNK_PUT:
          free(m->bsc.data);
-         free(m->bsc.cdata->chunk);
-         free(m->bsc.cdata);
+         buzzbstig_chunk_destroy(&(m->bsc.cdata));
+         break;
+      case BUZZMSG_BSTIG_BLOB_REQUEST:
+         free(m->brm.want);
+         break;
+      case BUZZMSG_BSTIG_STATUS:
+         if(m->bss.have) buzzbitset_destroy(&m->bss.have);
          break;
-      case BUZZMSG_BSTIG_STATUS:        
       case BUZZMSG_BSTIG_CHUNK_STATUS_QUERY:
       case BUZZMSG_BSTIG_CHUNK_REMOVED:
-      case BUZZMSG_BSTIG_BLOB_REQUEST:
          break;
       
    }
-   
+   if(m->hd.wire) buzzmsg_payload_destroy(&m->hd.wire);
    free(m);
 }
 
@@ -198,15 +240,14 @@ void buzzp2poutmsg_destroy(uint32_t pos, void* data, void* params){
 
 }
 void buzzoutmsg_vstig_destroy(const void* key, void* data, void* params) {
-   free((void*)key);
    buzzdict_destroy((buzzdict_t*)data);
-   free(data);
 }
 void buzzoutmsg_bstig_chunkremoval_destroy(const void* key, void* data, void* params) {
-   free((void*)key);
    buzzoutmsg_t m = *(buzzoutmsg_t*)data;
+   if(m->type == BUZZMSG_BSTIG_CHUNK_REMOVED) buzztimer_cancel(&m->cr.timer);
+   else buzztimer_cancel(&m->bid.timer);
+   if(m->hd.wire) buzzmsg_payload_destroy(&m->hd.wire);
    free(m);
-   free(data);
 }
 int buzzoutmsg_vstig_cmp(const void* a, const void* b) {
    if((uintptr_t)(*(buzzoutmsg_t*)a) < (uintptr_t)(*(buzzoutmsg_t*)b)) return -1;
@@ -215,15 +256,11 @@ int buzzoutmsg_vstig_cmp(const void* a, const void* b) {
 }
 
 void buzzoutmsg_bstig_destroy(const void* key, void* data, void* params) {
-   free((void*)key);
    buzzdict_destroy((buzzdict_t*)data);
-   free(data);
 }
 
 void buzzoutmsg_bstig_p2p_destroy(const void* key, void* data, void* params) {
-   free((void*)key);
    buzzdarray_destroy((buzzdarray_t*)data);
-   free(data);
 }
 
 int buzzoutmsg_bstig_cmp(const void* a, const void* b) {
@@ -241,23 +278,288 @@ int buzzoutmsg_bstig_keyquery_cmp(const void* a, const void* b) {
 /****************************************/
 /****************************************/
 
+/*
+ * Queues served by buzzoutmsg_queue_first(), in round robin order.
+ * The P2P chunk queue has its own sending path and is not scheduled.
+ */
+static const int BUZZOUTMSG_SCHED_ORDER[] = {
+   BUZZMSG_BROADCAST,
+   BUZZMSG_SWARM_LIST,
+   BUZZMSG_VSTIG_PUT,
+   BUZZMSG_VSTIG_QUERY,
+   BUZZMSG_BSTIG_PUT,
+   BUZZMSG_BSTIG_QUERY,
+   BUZZMSG_SWARM_JOIN,
+   BUZZMSG_SWARM_LEAVE,
+   BUZZMSG_BSTIG_STATUS,
+   BUZZMSG_BSTIG_BLOB_BID,
+   BUZZMSG_BSTIG_BLOB_REQUEST,
+   BUZZMSG_BSTIG_CHUNK_REMOVED,
+   BUZZMSG_BSTIG_CHUNK_STATUS_QUERY,
+   BUZZMSG_BSTIG_CHUNK_PUT,
+   BUZZMSG_BSTIG_CHUNK_QUERY
+};
+#define BUZZOUTMSG_SCHED_COUNT (sizeof(BUZZOUTMSG_SCHED_ORDER) / sizeof(BUZZOUTMSG_SCHED_ORDER[0]))
+
+/* Names of the message types, as used by the controller and the scripts */
+static const char* BUZZOUTMSG_TYPE_NAMES[BUZZOUTMSG_TYPE_COUNT] = {
+   [BUZZMSG_BROADCAST]                = "broadcast",
+   [BUZZMSG_SWARM_LIST]               = "swarm_list",
+   [BUZZMSG_VSTIG_PUT]                = "vstig_put",
+   [BUZZMSG_VSTIG_QUERY]              = "vstig_query",
+   [BUZZMSG_BSTIG_PUT]                = "bstig_put",
+   [BUZZMSG_BSTIG_QUERY]              = "bstig_query",
+   [BUZZMSG_SWARM_JOIN]               = "swarm_join",
+   [BUZZMSG_SWARM_LEAVE]              = "swarm_leave",
+   [BUZZMSG_BSTIG_STATUS]             = "bstig_status",
+   [BUZZMSG_BSTIG_BLOB_BID]           = "blob_bid",
+   [BUZZMSG_BSTIG_CHUNK_REMOVED]      = "chunk_removed",
+   [BUZZMSG_BSTIG_CHUNK_STATUS_QUERY] = "chunk_status_query",
+   [BUZZMSG_BSTIG_CHUNK_PUT]          = "chunk_put",
+   [BUZZMSG_BSTIG_CHUNK_PUT_P2P]      = "chunk_put_p2p",
+   [BUZZMSG_BSTIG_CHUNK_QUERY]        = "chunk_query",
+   [BUZZMSG_BSTIG_BLOB_REQUEST]       = "blob_request"
+};
+
+/* Default weights, favoring the traffic the old strict priority favored */
+static const uint16_t BUZZOUTMSG_SCHED_WEIGHTS[BUZZOUTMSG_TYPE_COUNT] = {
+   [BUZZMSG_BROADCAST]                = 4,
+   [BUZZMSG_SWARM_LIST]               = 2,
+   [BUZZMSG_VSTIG_PUT]                = 4,
+   [BUZZMSG_VSTIG_QUERY]              = 2,
+   [BUZZMSG_BSTIG_PUT]                = 4,
+   [BUZZMSG_BSTIG_QUERY]              = 2,
+   [BUZZMSG_SWARM_JOIN]               = 2,
+   [BUZZMSG_SWARM_LEAVE]              = 2,
+   [BUZZMSG_BSTIG_STATUS]             = 2,
+   [BUZZMSG_BSTIG_BLOB_BID]           = 2,
+   [BUZZMSG_BSTIG_CHUNK_REMOVED]      = 2,
+   [BUZZMSG_BSTIG_CHUNK_STATUS_QUERY] = 2,
+   [BUZZMSG_BSTIG_CHUNK_PUT]          = 1,
+   [BUZZMSG_BSTIG_CHUNK_PUT_P2P]      = 1,
+   [BUZZMSG_BSTIG_CHUNK_QUERY]        = 1,
+   [BUZZMSG_BSTIG_BLOB_REQUEST]       = 2
+};
+
+/* Default number of steps after which a waiting message is served first */
+#define BUZZOUTMSG_SCHED_MAX_WAIT 50
+
+/*
+ * Appends a message to a queue, recording when it was queued.
+ */
+static void buzzoutmsg_enqueue(buzzvm_t vm, int type, buzzoutmsg_t m) {
+   m->hd.stamp = vm->outmsgs->sched.now;
+   buzzqueue_push(vm->outmsgs->queues[type], &m);
+}
+
+static void buzzoutmsg_rewire(int t, buzzoutmsg_t f);
+
+/*
+ * Chooses the queue that feeds the next frame slot.
+ * The choice sticks until buzzoutmsg_queue_next() sends the message,
+ * so repeated calls to buzzoutmsg_queue_first() return the same one.
+ * Returns the message type, or -1 if every scheduled queue is empty.
+ */
+static int buzzoutmsg_sched_pick(buzzvm_t vm) {
+   struct buzzoutmsg_sched_s* s = &vm->outmsgs->sched;
+   uint32_t i;
+   if(s->cur >= 0 && !buzzqueue_isempty(vm->outmsgs->queues[s->cur]))
+      return s->cur;
+   s->cur = -1;
+   s->aged = 0;
+   /* Aging: the message that waited the longest past max_wait goes first */
+   if(s->max_wait > 0) {
+      uint32_t oldest = s->max_wait;
+      for(i = 0; i < BUZZOUTMSG_SCHED_COUNT; ++i) {
+         int t = BUZZOUTMSG_SCHED_ORDER[i];
+         if(buzzqueue_isempty(vm->outmsgs->queues[t])) continue;
+         uint32_t w = s->now - buzzqueue_first(vm->outmsgs->queues[t], buzzoutmsg_t)->hd.stamp;
+         if(w > oldest) {
+            oldest = w;
+            s->cur = t;
+         }
+      }
+      if(s->cur >= 0) {
+         s->aged = 1;
+         return s->cur;
+      }
+   }
+   /* Deficit round robin: each turn, a non-empty queue earns its weight
+    * in credits and spends one per message sent */
+   for(i = 0; i <= BUZZOUTMSG_SCHED_COUNT; ++i) {
+      int t = BUZZOUTMSG_SCHED_ORDER[s->rr];
+      if(!buzzqueue_isempty(vm->outmsgs->queues[t])) {
+         if(!s->granted) {
+            s->deficit[t] += s->weight[t];
+            s->granted = 1;
+         }
+         if(s->deficit[t] > 0) {
+            s->cur = t;
+            return t;
+         }
+      }
+      else {
+         /* Empty queues don't bank credits */
+         s->deficit[t] = 0;
+      }
+      s->rr = (s->rr + 1) % BUZZOUTMSG_SCHED_COUNT;
+      s->granted = 0;
+   }
+   return -1;
+}
+
+/****************************************/
+/****************************************/
+
+int buzzoutmsg_sched_type(const char* name) {
+   int t;
+   for(t = 0; t < BUZZOUTMSG_TYPE_COUNT; ++t)
+      if(BUZZOUTMSG_TYPE_NAMES[t] && strcmp(BUZZOUTMSG_TYPE_NAMES[t], name) == 0) return t;
+   return -1;
+}
+
+/****************************************/
+/****************************************/
+
+const char* buzzoutmsg_sched_type_name(int type) {
+   if(type < 0 || type >= BUZZOUTMSG_TYPE_COUNT) return NULL;
+   return BUZZOUTMSG_TYPE_NAMES[type];
+}
+
+/****************************************/
+/****************************************/
+
+void buzzoutmsg_sched_set_weight(buzzvm_t vm,
+                                 int type,
+                                 uint16_t weight) {
+   if(type < 0 || type >= BUZZOUTMSG_TYPE_COUNT || !BUZZOUTMSG_TYPE_NAMES[type]) return;
+   vm->outmsgs->sched.weight[type] = weight > 0 ? weight : 1;
+}
+
+/****************************************/
+/****************************************/
+
+void buzzoutmsg_sched_set_max_wait(buzzvm_t vm,
+                                   uint32_t steps) {
+   vm->outmsgs->sched.max_wait = steps;
+}
+
+/****************************************/
+/****************************************/
+
+void buzzoutmsg_sched_tick(buzzvm_t vm) {
+   ++vm->outmsgs->sched.now;
+}
+
+/****************************************/
+/****************************************/
+
+#define function_register(TABLE, FNAME)                                       \
+   buzzvm_push(vm, TABLE);                                                    \
+   buzzvm_pushs(vm, buzzvm_string_register(vm, #FNAME, 1));                   \
+   buzzvm_pushcc(vm, buzzvm_function_register(vm, buzzoutmsg_sched_ ## FNAME)); \
+   buzzvm_tput(vm);
+
+/*
+ * Gets the message type named by the first parameter of a closure.
+ */
+static int buzzoutmsg_sched_type_arg(buzzvm_t vm) {
+   buzzvm_lload(vm, 1);
+   buzzvm_type_assert(vm, 1, BUZZTYPE_STRING);
+   const char* name = buzzvm_stack_at(vm, 1)->s.value.str;
+   buzzvm_pop(vm);
+   int t = buzzoutmsg_sched_type(name);
+   if(t < 0)
+      buzzvm_seterror(vm,
+                      BUZZVM_ERROR_TYPE,
+                      "unknown message type \"%s\"",
+                      name);
+   return t;
+}
+
+int buzzoutmsg_sched_weight(buzzvm_t vm) {
+   buzzvm_lnum_assert(vm, 2);
+   int t = buzzoutmsg_sched_type_arg(vm);
+   if(t < 0) return vm->state;
+   buzzvm_lload(vm, 2);
+   buzzvm_type_assert(vm, 1, BUZZTYPE_INT);
+   buzzoutmsg_sched_set_weight(vm, t, buzzvm_stack_at(vm, 1)->i.value);
+   buzzvm_pop(vm);
+   return buzzvm_ret0(vm);
+}
+
+int buzzoutmsg_sched_max_wait(buzzvm_t vm) {
+   buzzvm_lnum_assert(vm, 1);
+   buzzvm_lload(vm, 1);
+   buzzvm_type_assert(vm, 1, BUZZTYPE_INT);
+   buzzoutmsg_sched_set_max_wait(vm, buzzvm_stack_at(vm, 1)->i.value);
+   buzzvm_pop(vm);
+   return buzzvm_ret0(vm);
+}
+
+int buzzoutmsg_sched_stats(buzzvm_t vm) {
+   buzzvm_lnum_assert(vm, 1);
+   int t = buzzoutmsg_sched_type_arg(vm);
+   if(t < 0) return vm->state;
+   const struct buzzoutmsg_stats_s* st = &vm->outmsgs->sched.stats[t];
+   /* Make a table with the counters of the type */
+   buzzvm_pusht(vm);
+   buzzobj_t r = buzzvm_stack_at(vm, 1);
+   buzzvm_push(vm, r);
+   buzzvm_pushs(vm, buzzvm_string_register(vm, "sent", 1));
+   buzzvm_pushi(vm, st->sent);
+   buzzvm_tput(vm);
+   buzzvm_push(vm, r);
+   buzzvm_pushs(vm, buzzvm_string_register(vm, "wait_avg", 1));
+   buzzvm_pushf(vm, st->sent > 0 ? (float)st->wait_total / st->sent : 0.0f);
+   buzzvm_tput(vm);
+   buzzvm_push(vm, r);
+   buzzvm_pushs(vm, buzzvm_string_register(vm, "wait_max", 1));
+   buzzvm_pushi(vm, st->wait_max);
+   buzzvm_tput(vm);
+   buzzvm_push(vm, r);
+   buzzvm_pushs(vm, buzzvm_string_register(vm, "queued", 1));
+   buzzvm_pushi(vm, buzzqueue_size(vm->outmsgs->queues[t]));
+   buzzvm_tput(vm);
+   return buzzvm_ret1(vm);
+}
+
+int buzzoutmsg_register(buzzvm_t vm) {
+   /* Make "msgsched" table */
+   buzzobj_t t = buzzheap_newobj(vm, BUZZTYPE_TABLE);
+   /* Register methods */
+   function_register(t, weight);
+   function_register(t, max_wait);
+   function_register(t, stats);
+   /* Register "msgsched" table */
+   buzzvm_pushs(vm, buzzvm_string_register(vm, "msgsched", 1));
+   buzzvm_push(vm, t);
+   buzzvm_gstore(vm);
+   /* All done */
+   return vm->state;
+}
+
+/****************************************/
+/****************************************/
+
 buzzoutmsg_queue_t buzzoutmsg_queue_new() {
-   buzzoutmsg_queue_t q = (buzzoutmsg_queue_t)malloc(sizeof(struct buzzoutmsg_queue_s));
-   q->queues[BUZZMSG_BROADCAST]           = buzzdarray_new(1, sizeof(buzzoutmsg_t), buzzoutmsg_destroy);
-   q->queues[BUZZMSG_SWARM_LIST]  	      = buzzdarray_new(1, sizeof(buzzoutmsg_t), buzzoutmsg_destroy);
-   q->queues[BUZZMSG_SWARM_JOIN]  	      = buzzdarray_new(1, sizeof(buzzoutmsg_t), buzzoutmsg_destroy);
-   q->queues[BUZZMSG_SWARM_LEAVE] 	      = buzzdarray_new(1, sizeof(buzzoutmsg_t), buzzoutmsg_destroy);
-   q->queues[BUZZMSG_VSTIG_PUT]   	      = buzzdarray_new(1, sizeof(buzzoutmsg_t), buzzoutmsg_destroy);
-   q->queues[BUZZMSG_VSTIG_QUERY] 	      = buzzdarray_new(1, sizeof(buzzoutmsg_t), buzzoutmsg_destroy);
-   q->queues[BUZZMSG_BSTIG_PUT]   	      = buzzdarray_new(1, sizeof(buzzoutmsg_t), buzzoutmsg_destroy);
-   q->queues[BUZZMSG_BSTIG_QUERY] 	      = buzzdarray_new(1, sizeof(buzzoutmsg_t), buzzoutmsg_destroy);
-   q->queues[BUZZMSG_BSTIG_STATUS]    = buzzdarray_new(1, sizeof(buzzoutmsg_t), buzzoutmsg_destroy);
-   q->queues[BUZZMSG_BSTIG_BLOB_BID] = buzzdarray_new(1, sizeof(buzzoutmsg_t), NULL);
-   q->queues[BUZZMSG_BSTIG_CHUNK_STATUS_QUERY]         = buzzdarray_new(1, sizeof(buzzoutmsg_t), buzzoutmsg_destroy);
-   q->queues[BUZZMSG_BSTIG_CHUNK_REMOVED] = buzzdarray_new(1, sizeof(buzzoutmsg_t), NULL);
-   q->queues[BUZZMSG_BSTIG_CHUNK_PUT]         = buzzdarray_new(1, sizeof(buzzoutmsg_t), buzzoutmsg_destroy);
-   q->queues[BUZZMSG_BSTIG_CHUNK_QUERY]         = buzzdarray_new(1, sizeof(buzzoutmsg_t), buzzoutmsg_destroy);
-   q->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P]       = buzzdarray_new(1, sizeof(buzzoutmsg_t), buzzoutmsg_destroy);
+   buzzoutmsg_queue_t q = (buzzoutmsg_queue_t)calloc(1, sizeof(struct buzzoutmsg_queue_s));
+   q->queues[BUZZMSG_BROADCAST]           = buzzqueue_new(1, sizeof(buzzoutmsg_t), buzzoutmsg_destroy);
+   q->queues[BUZZMSG_SWARM_LIST]  	      = buzzqueue_new(1, sizeof(buzzoutmsg_t), buzzoutmsg_destroy);
+   q->queues[BUZZMSG_SWARM_JOIN]  	      = buzzqueue_new(1, sizeof(buzzoutmsg_t), buzzoutmsg_destroy);
+   q->queues[BUZZMSG_SWARM_LEAVE] 	      = buzzqueue_new(1, sizeof(buzzoutmsg_t), buzzoutmsg_destroy);
+   q->queues[BUZZMSG_VSTIG_PUT]   	      = buzzqueue_new(1, sizeof(buzzoutmsg_t), buzzoutmsg_destroy);
+   q->queues[BUZZMSG_VSTIG_QUERY] 	      = buzzqueue_new(1, sizeof(buzzoutmsg_t), buzzoutmsg_destroy);
+   q->queues[BUZZMSG_BSTIG_PUT]   	      = buzzqueue_new(1, sizeof(buzzoutmsg_t), buzzoutmsg_destroy);
+   q->queues[BUZZMSG_BSTIG_QUERY] 	      = buzzqueue_new(1, sizeof(buzzoutmsg_t), buzzoutmsg_destroy);
+   q->queues[BUZZMSG_BSTIG_STATUS]    = buzzqueue_new(1, sizeof(buzzoutmsg_t), buzzoutmsg_destroy);
+   q->queues[BUZZMSG_BSTIG_BLOB_BID] = buzzqueue_new(1, sizeof(buzzoutmsg_t), NULL);
+   q->queues[BUZZMSG_BSTIG_BLOB_REQUEST] = buzzqueue_new(1, sizeof(buzzoutmsg_t), buzzoutmsg_destroy);
+   q->queues[BUZZMSG_BSTIG_CHUNK_STATUS_QUERY]         = buzzqueue_new(1, sizeof(buzzoutmsg_t), buzzoutmsg_destroy);
+   q->queues[BUZZMSG_BSTIG_CHUNK_REMOVED] = buzzqueue_new(1, sizeof(buzzoutmsg_t), NULL);
+   q->queues[BUZZMSG_BSTIG_CHUNK_PUT]         = buzzqueue_new(1, sizeof(buzzoutmsg_t), buzzoutmsg_destroy);
+   q->queues[BUZZMSG_BSTIG_CHUNK_QUERY]         = buzzqueue_new(1, sizeof(buzzoutmsg_t), buzzoutmsg_destroy);
+   q->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P]       = buzzqueue_new(1, sizeof(buzzoutmsg_t), buzzoutmsg_destroy);
    q->vstig = buzzdict_new(10,
                            sizeof(uint16_t),
                            sizeof(buzzdict_t),
@@ -301,6 +603,11 @@ buzzoutmsg_queue_t buzzoutmsg_queue_new() {
                            buzzdict_uint16keycmp,
                            buzzoutmsg_bstig_destroy);
    q->bstigrecon = buzzdarray_new(10, sizeof(buzzoutmsg_t), NULL);
+   /* Start the scheduler with the default weights */
+   memset(&q->sched, 0, sizeof(struct buzzoutmsg_sched_s));
+   memcpy(q->sched.weight, BUZZOUTMSG_SCHED_WEIGHTS, sizeof(q->sched.weight));
+   q->sched.max_wait = BUZZOUTMSG_SCHED_MAX_WAIT;
+   q->sched.cur = -1;
    return q;
 }
 
@@ -308,23 +615,24 @@ buzzoutmsg_queue_t buzzoutmsg_queue_new() {
 /****************************************/
 
 void buzzoutmsg_queue_destroy(buzzoutmsg_queue_t* msgq) {
-   buzzdarray_destroy(&((*msgq)->queues[BUZZMSG_BROADCAST]));
-   buzzdarray_destroy(&((*msgq)->queues[BUZZMSG_SWARM_LIST]));
-   buzzdarray_destroy(&((*msgq)->queues[BUZZMSG_SWARM_JOIN]));
-   buzzdarray_destroy(&((*msgq)->queues[BUZZMSG_SWARM_LEAVE]));
-   buzzdarray_destroy(&((*msgq)->queues[BUZZMSG_VSTIG_PUT]));
-   buzzdarray_destroy(&((*msgq)->queues[BUZZMSG_VSTIG_QUERY]));
+   buzzqueue_destroy(&((*msgq)->queues[BUZZMSG_BROADCAST]));
+   buzzqueue_destroy(&((*msgq)->queues[BUZZMSG_SWARM_LIST]));
+   buzzqueue_destroy(&((*msgq)->queues[BUZZMSG_SWARM_JOIN]));
+   buzzqueue_destroy(&((*msgq)->queues[BUZZMSG_SWARM_LEAVE]));
+   buzzqueue_destroy(&((*msgq)->queues[BUZZMSG_VSTIG_PUT]));
+   buzzqueue_destroy(&((*msgq)->queues[BUZZMSG_VSTIG_QUERY]));
    buzzdict_destroy(&((*msgq)->vstig));
-   buzzdarray_destroy(&((*msgq)->queues[BUZZMSG_BSTIG_PUT]));
-   buzzdarray_destroy(&((*msgq)->queues[BUZZMSG_BSTIG_QUERY]));
+   buzzqueue_destroy(&((*msgq)->queues[BUZZMSG_BSTIG_PUT]));
+   buzzqueue_destroy(&((*msgq)->queues[BUZZMSG_BSTIG_QUERY]));
    buzzdict_destroy(&((*msgq)->bstig));
-   buzzdarray_destroy(&((*msgq)->queues[BUZZMSG_BSTIG_STATUS])); 
-   buzzdarray_destroy(&((*msgq)->queues[BUZZMSG_BSTIG_BLOB_BID])); 
-   buzzdarray_destroy(&((*msgq)->queues[BUZZMSG_BSTIG_CHUNK_REMOVED])); 
-   buzzdarray_destroy(&((*msgq)->queues[BUZZMSG_BSTIG_CHUNK_STATUS_QUERY]));
-   buzzdarray_destroy(&((*msgq)->queues[BUZZMSG_BSTIG_CHUNK_PUT]));
-   buzzdarray_destroy(&((*msgq)->queues[BUZZMSG_BSTIG_CHUNK_QUERY])); 
-   buzzdarray_destroy(&((*msgq)->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P])); 
+   buzzqueue_destroy(&((*msgq)->queues[BUZZMSG_BSTIG_STATUS])); 
+   buzzqueue_destroy(&((*msgq)->queues[BUZZMSG_BSTIG_BLOB_BID])); 
+   buzzqueue_destroy(&((*msgq)->queues[BUZZMSG_BSTIG_BLOB_REQUEST]));
+   buzzqueue_destroy(&((*msgq)->queues[BUZZMSG_BSTIG_CHUNK_REMOVED])); 
+   buzzqueue_destroy(&((*msgq)->queues[BUZZMSG_BSTIG_CHUNK_STATUS_QUERY]));
+   buzzqueue_destroy(&((*msgq)->queues[BUZZMSG_BSTIG_CHUNK_PUT]));
+   buzzqueue_destroy(&((*msgq)->queues[BUZZMSG_BSTIG_CHUNK_QUERY])); 
+   buzzqueue_destroy(&((*msgq)->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P])); 
    buzzdict_destroy(&((*msgq)->chunkbstig));
    buzzdict_destroy(&((*msgq)->bstigstatus));
    buzzdict_destroy(&((*msgq)->bidprotect));
@@ -339,30 +647,31 @@ void buzzoutmsg_queue_destroy(buzzoutmsg_queue_t* msgq) {
 
 uint32_t buzzoutmsg_queue_size(buzzvm_t vm) {
    return
-      buzzdarray_size(vm->outmsgs->queues[BUZZMSG_BROADCAST]) +
-      buzzdarray_size(vm->outmsgs->queues[BUZZMSG_SWARM_LIST]) +
-      buzzdarray_size(vm->outmsgs->queues[BUZZMSG_SWARM_JOIN]) +
-      buzzdarray_size(vm->outmsgs->queues[BUZZMSG_SWARM_LEAVE]) +
-      buzzdarray_size(vm->outmsgs->queues[BUZZMSG_VSTIG_PUT]) +
-      buzzdarray_size(vm->outmsgs->queues[BUZZMSG_VSTIG_QUERY])+
-      buzzdarray_size(vm->outmsgs->queues[BUZZMSG_BSTIG_PUT]) +
-      buzzdarray_size(vm->outmsgs->queues[BUZZMSG_BSTIG_QUERY]) +
-      buzzdarray_size(vm->outmsgs->queues[BUZZMSG_BSTIG_STATUS]) +
-      buzzdarray_size(vm->outmsgs->queues[BUZZMSG_BSTIG_BLOB_BID]) +
-      buzzdarray_size(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_REMOVED]) +
-      buzzdarray_size(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_STATUS_QUERY]) +
-      buzzdarray_size(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT])+
-      buzzdarray_size(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_QUERY]);
+      buzzqueue_size(vm->outmsgs->queues[BUZZMSG_BROADCAST]) +
+      buzzqueue_size(vm->outmsgs->queues[BUZZMSG_SWARM_LIST]) +
+      buzzqueue_size(vm->outmsgs->queues[BUZZMSG_SWARM_JOIN]) +
+      buzzqueue_size(vm->outmsgs->queues[BUZZMSG_SWARM_LEAVE]) +
+      buzzqueue_size(vm->outmsgs->queues[BUZZMSG_VSTIG_PUT]) +
+      buzzqueue_size(vm->outmsgs->queues[BUZZMSG_VSTIG_QUERY])+
+      buzzqueue_size(vm->outmsgs->queues[BUZZMSG_BSTIG_PUT]) +
+      buzzqueue_size(vm->outmsgs->queues[BUZZMSG_BSTIG_QUERY]) +
+      buzzqueue_size(vm->outmsgs->queues[BUZZMSG_BSTIG_STATUS]) +
+      buzzqueue_size(vm->outmsgs->queues[BUZZMSG_BSTIG_BLOB_BID]) +
+      buzzqueue_size(vm->outmsgs->queues[BUZZMSG_BSTIG_BLOB_REQUEST]) +
+      buzzqueue_size(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_REMOVED]) +
+      buzzqueue_size(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_STATUS_QUERY]) +
+      buzzqueue_size(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT])+
+      buzzqueue_size(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_QUERY]);
 }
 
 uint32_t buzzoutmsg_chunk_queue_size(buzzvm_t vm) {
    return
-      buzzdarray_size(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT]);
+      buzzqueue_size(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT]);
 }
 
 uint32_t buzzoutmsg_p2p_chunk_queue_size(buzzvm_t vm){
    return 
-      buzzdarray_size(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P]);
+      buzzqueue_size(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P]);
 }
 /****************************************/
 /****************************************/
@@ -375,12 +684,12 @@ void buzzoutmsg_queue_append_broadcast(buzzvm_t vm,
                                        buzzobj_t topic,
                                        buzzobj_t value) {
    /* Make a new BROADCAST message */
-   buzzoutmsg_t m = (buzzoutmsg_t)malloc(sizeof(union buzzoutmsg_u));
+   buzzoutmsg_t m = (buzzoutmsg_t)calloc(1, sizeof(union buzzoutmsg_u));
    m->bc.type = BUZZMSG_BROADCAST;
    m->bc.topic = buzzheap_clone(vm, topic);
    m->bc.value = buzzheap_clone(vm, value);
    /* Queue it */
-   buzzdarray_push(vm->outmsgs->queues[BUZZMSG_BROADCAST], &m);   
+   buzzoutmsg_enqueue(vm, BUZZMSG_BROADCAST, m);   
 }
 
 /****************************************/
@@ -417,9 +726,9 @@ void buzzoutmsg_queue_append_swarm_list(buzzvm_t vm,
     * - If a list message is already queued, join/leave messages are not
     */
    /* Delete every existing SWARM related message */
-   buzzdarray_clear(vm->outmsgs->queues[BUZZMSG_SWARM_LIST], 1);
-   buzzdarray_clear(vm->outmsgs->queues[BUZZMSG_SWARM_JOIN], 1);
-   buzzdarray_clear(vm->outmsgs->queues[BUZZMSG_SWARM_LEAVE], 1);
+   buzzqueue_clear(vm->outmsgs->queues[BUZZMSG_SWARM_LIST]);
+   buzzqueue_clear(vm->outmsgs->queues[BUZZMSG_SWARM_JOIN]);
+   buzzqueue_clear(vm->outmsgs->queues[BUZZMSG_SWARM_LEAVE]);
    /* Make an array of current swarm id dictionary */
    struct dict_to_array_s da = {
       .count = 0,
@@ -428,60 +737,61 @@ void buzzoutmsg_queue_append_swarm_list(buzzvm_t vm,
    };
    buzzdict_foreach(ids, dict_to_array, &da);
    /* Make a new LIST message */
-   buzzoutmsg_t m = (buzzoutmsg_t)malloc(sizeof(union buzzoutmsg_u));
+   buzzoutmsg_t m = (buzzoutmsg_t)calloc(1, sizeof(union buzzoutmsg_u));
    m->sw.type = BUZZMSG_SWARM_LIST;
    m->sw.size = da.count;
    m->sw.ids = (uint16_t*)malloc(m->sw.size * sizeof(uint16_t));
    memcpy(m->sw.ids, da.data, m->sw.size * sizeof(uint16_t));
    free(da.data);
    /* Queue the new LIST message */
-   buzzdarray_push(vm->outmsgs->queues[BUZZMSG_SWARM_LIST], &m);
+   buzzoutmsg_enqueue(vm, BUZZMSG_SWARM_LIST, m);
 }
 
 /****************************************/
 /****************************************/
 
-static void append_to_swarm_queue(buzzdarray_t q, uint16_t id, int type) {
+static void append_to_swarm_queue(buzzvm_t vm, uint16_t id, int type) {
+   buzzqueue_t q = vm->outmsgs->queues[type];
    /* Is the queue empty? */
-   if(buzzdarray_isempty(q)) {
+   if(buzzqueue_isempty(q)) {
       /* Yes, add the element at the end */
-      buzzoutmsg_t m = (buzzoutmsg_t)malloc(sizeof(union buzzoutmsg_u));
+      buzzoutmsg_t m = (buzzoutmsg_t)calloc(1, sizeof(union buzzoutmsg_u));
       m->sw.type = type;
       m->sw.size = 1;
       m->sw.ids = (uint16_t*)malloc(sizeof(uint16_t));
       m->sw.ids[0] = id;
-      buzzdarray_push(q, &m);
+      buzzoutmsg_enqueue(vm, type, m);
    }
    else {
       /* Queue not empty - look for a message with the same id */
       int found = 0;
       uint32_t i;
-      for(i = 0; i < buzzdarray_size(q) && !found; ++i) {
-         found = buzzdarray_get(q, i, buzzoutmsg_t)->sw.ids[0] == id;
+      for(i = 0; i < buzzqueue_size(q) && !found; ++i) {
+         found = buzzqueue_get(q, i, buzzoutmsg_t)->sw.ids[0] == id;
       }
       /* Message found? */
       if(!found) {
          /* No, append a new message the passed id */
-         buzzoutmsg_t m = (buzzoutmsg_t)malloc(sizeof(union buzzoutmsg_u));
+         buzzoutmsg_t m = (buzzoutmsg_t)calloc(1, sizeof(union buzzoutmsg_u));
          m->sw.type = type;
          m->sw.size = 1;
          m->sw.ids = (uint16_t*)malloc(sizeof(uint16_t));
          m->sw.ids[0] = id;
-         buzzdarray_push(q, &m);
+         buzzoutmsg_enqueue(vm, type, m);
       }
    }
 }
 
-static void remove_from_swarm_queue(buzzdarray_t q, uint16_t id) {
+static void remove_from_swarm_queue(buzzqueue_t q, uint16_t id) {
    /* Is the queue empty? If so, nothing to do */
-   if(buzzdarray_isempty(q)) return;
+   if(buzzqueue_isempty(q)) return;
    /* Queue not empty - look for a message with the same id */
    uint32_t i;
-   for(i = 0; i < buzzdarray_size(q); ++i) {
-      if(buzzdarray_get(q, i, buzzoutmsg_t)->sw.ids[0] == id) break;
+   for(i = 0; i < buzzqueue_size(q); ++i) {
+      if(buzzqueue_get(q, i, buzzoutmsg_t)->sw.ids[0] == id) break;
    }
    /* Message found? If so, remove it */
-   if(i < buzzdarray_size(q)) buzzdarray_remove(q, i);
+   if(i < buzzqueue_size(q)) buzzqueue_remove(q, i);
 }
 
 void buzzoutmsg_queue_append_swarm_joinleave(buzzvm_t vm,
@@ -492,9 +802,9 @@ void buzzoutmsg_queue_append_swarm_joinleave(buzzvm_t vm,
     * - If a list message is already queued, join/leave messages are not
     */
    /* Is there a LIST message? */
-   if(!buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_SWARM_LIST])) {
+   if(!buzzqueue_isempty(vm->outmsgs->queues[BUZZMSG_SWARM_LIST])) {
       /* Yes, get a handle to the message */
-      buzzoutmsg_t l = buzzdarray_get(vm->outmsgs->queues[BUZZMSG_SWARM_LIST], 0, buzzoutmsg_t);
+      buzzoutmsg_t l = buzzqueue_get(vm->outmsgs->queues[BUZZMSG_SWARM_LIST], 0, buzzoutmsg_t);
       /* Go through the ids in the list and look for the passed id */
       uint16_t i = 0;
       while(i < l->sw.size && l->sw.ids[i] != id) ++i;
@@ -505,6 +815,7 @@ void buzzoutmsg_queue_append_swarm_joinleave(buzzvm_t vm,
             /* Yes: remove it from the list */
             --(l->sw.size);
             memmove(l->sw.ids+i, l->sw.ids+i+1, (l->sw.size-i) * sizeof(uint16_t));
+            buzzoutmsg_rewire(BUZZMSG_SWARM_LIST, l);
          }
          /* If the message is a JOIN, there's nothing to do */
       }
@@ -515,6 +826,7 @@ void buzzoutmsg_queue_append_swarm_joinleave(buzzvm_t vm,
             ++(l->sw.size);
             l->sw.ids = realloc(l->sw.ids, l->sw.size * sizeof(uint16_t));
             l->sw.ids[l->sw.size-1] = id;
+            buzzoutmsg_rewire(BUZZMSG_SWARM_LIST, l);
          }
          /* If the message is a LEAVE, there's nothing to do */
       }
@@ -523,7 +835,7 @@ void buzzoutmsg_queue_append_swarm_joinleave(buzzvm_t vm,
       /* No LIST message present - send an individual message */
       if(type == BUZZMSG_SWARM_JOIN) {
          /* Look for a duplicate in the JOIN queue - if not add one  */
-         append_to_swarm_queue(vm->outmsgs->queues[BUZZMSG_SWARM_JOIN], id, BUZZMSG_SWARM_JOIN);
+         append_to_swarm_queue(vm, id, BUZZMSG_SWARM_JOIN);
          /* Look for an entry in the LEAVE queue and remove it  */
          remove_from_swarm_queue(vm->outmsgs->queues[BUZZMSG_SWARM_LEAVE], id);
       }
@@ -531,7 +843,7 @@ void buzzoutmsg_queue_append_swarm_joinleave(buzzvm_t vm,
          /* Look for an entry in the JOIN queue and remove it */
          remove_from_swarm_queue(vm->outmsgs->queues[BUZZMSG_SWARM_JOIN], id);
          /* Look for a duplicate in the LEAVE queue - if not add one  */
-         append_to_swarm_queue(vm->outmsgs->queues[BUZZMSG_SWARM_LEAVE], id, BUZZMSG_SWARM_LEAVE);
+         append_to_swarm_queue(vm, id, BUZZMSG_SWARM_LEAVE);
       }
    }
 }
@@ -570,12 +882,20 @@ void buzzoutmsg_queue_append_vstig(buzzvm_t vm,
    if(e) {
       /* Yes; if the duplicate is newer than the passed message, nothing to do */
       if((*e)->data->timestamp >= data->timestamp) return;
-      /* The duplicate is older, store data to remove it later */
+      /* The duplicate is older; if it is in the same queue, refresh it in place */
+      if((*e)->type == type) {
+         buzzoutmsg_t o = (buzzoutmsg_t)(*e);
+         free(o->vs.data);
+         o->vs.data = buzzvstig_elem_clone(vm, data);
+         buzzoutmsg_rewire(type, o);
+         return;
+      }
+      /* Otherwise, store data to remove it later */
       etype = (*e)->type;
-      eidx = buzzdarray_find(vm->outmsgs->queues[etype], buzzoutmsg_vstig_cmp, e);
+      eidx = buzzqueue_find(vm->outmsgs->queues[etype], buzzoutmsg_vstig_cmp, e);
    }
    /* Create a new message */
-   buzzoutmsg_t m = (buzzoutmsg_t)malloc(sizeof(union buzzoutmsg_u));
+   buzzoutmsg_t m = (buzzoutmsg_t)calloc(1, sizeof(union buzzoutmsg_u));
    m->vs.type = type;
    m->vs.id = id;
    m->vs.key = buzzheap_clone(vm, key);
@@ -584,10 +904,10 @@ void buzzoutmsg_queue_append_vstig(buzzvm_t vm,
    buzzdict_set(vs, &m->vs.key, &m);
    if(etype > -1) {
       /* Remove the entry from the queue */
-      buzzdarray_remove(vm->outmsgs->queues[etype], eidx);
+      buzzqueue_remove(vm->outmsgs->queues[etype], eidx);
    }
    /* Add a new message to the queue */
-   buzzdarray_push(vm->outmsgs->queues[type], &m);
+   buzzoutmsg_enqueue(vm, type, m);
 }
 
 /****************************************/
@@ -628,20 +948,34 @@ void buzzoutmsg_queue_append_bstig(buzzvm_t vm,
    }
    /* Do we have a more recent duplicate? */
    int etype = -1, eidx = -1; /* No message to remove from the queue */
+   buzzoutmsg_t m = NULL;
+   int inplace = 0;
    if(e) {
       /* Yes; if the duplicate is newer than the passed message, nothing to do */
       if((*e)->data->timestamp >= data->timestamp) return;
-      /* The duplicate is older, store data to remove it later */
-      etype = (*e)->type;
-      eidx = buzzdarray_find(vm->outmsgs->queues[etype], buzzoutmsg_bstig_cmp, e);
+      if((*e)->type == type) {
+         /* The duplicate is older and in the same queue, refresh it in place */
+         m = (buzzoutmsg_t)(*e);
+         free(m->bs.data);
+         inplace = 1;
+      }
+      else {
+         /* The duplicate is older, store data to remove it later */
+         etype = (*e)->type;
+         eidx = buzzqueue_find(vm->outmsgs->queues[etype], buzzoutmsg_bstig_cmp, e);
+      }
+   }
+   if(!m) {
+      /* Create a new message */
+      m = (buzzoutmsg_t)calloc(1, sizeof(union buzzoutmsg_u));
+      m->bs.type = type;
+      m->bs.id = id;
+      m->bs.key = buzzheap_clone(vm, key);
    }
-   /* Create a new message */
-   buzzoutmsg_t m = (buzzoutmsg_t)malloc(sizeof(union buzzoutmsg_u));
-   m->bs.type = type;
    m->bs.blob_entry = blob_entry;
-   m->bs.id = id;
-   m->bs.key = buzzheap_clone(vm, key);
    m->bs.data = buzzbstig_elem_clone(vm, data);
+   m->bs.codec = BUZZBLOB_CODEC_UNKNOWN;
+   m->bs.raw_size = 0;
    if(data->data->o.type == BUZZTYPE_NIL || !blob_entry){
       m->bs.blob_size=0;
    }
@@ -650,16 +984,23 @@ void buzzoutmsg_queue_append_bstig(buzzvm_t vm,
       buzzdict_t s = *(buzzdict_get(vm->blobs, &id, buzzdict_t));
       const buzzblob_elem_t* v_blob = buzzdict_get(s, &(key->i.value), buzzblob_elem_t);
       m->bs.blob_size=(*v_blob)->size;
+      m->bs.codec=(*v_blob)->codec;
+      m->bs.raw_size=(*v_blob)->raw_size;
    }
    //printf("[DEBUG] bstig blob put size: %u \n", m->bs.blob_size);
+   /* A message refreshed in place is already in the dictionary and the queue */
+   if(inplace) {
+      buzzoutmsg_rewire(type, m);
+      return;
+   }
    /* Update the dictionary - this also invalidates e */
    buzzdict_set(bs, &m->bs.key, &m);
    if(etype > -1) {
       /* Remove the entry from the queue */
-      buzzdarray_remove(vm->outmsgs->queues[etype], eidx);
+      buzzqueue_remove(vm->outmsgs->queues[etype], eidx);
    }
    /* Add a new message to the queue */
-   buzzdarray_push(vm->outmsgs->queues[type], &m);
+   buzzoutmsg_enqueue(vm, type, m);
 }
 
 /****************************************/
@@ -727,10 +1068,10 @@ void buzzoutmsg_queue_append_chunk(buzzvm_t vm,
          /* The duplicate is a query new is a put, store data to remove it later :
          TODO: versioning not completely implemented  */
          ctype = (*c)->type;
-         cidx = buzzdarray_find(vm->outmsgs->queues[ctype], buzzoutmsg_bstig_cmp, c);
+         cidx = buzzqueue_find(vm->outmsgs->queues[ctype], buzzoutmsg_bstig_cmp, c);
       }
       /* Create a new message */
-      buzzoutmsg_t m = (buzzoutmsg_t)malloc(sizeof(union buzzoutmsg_u));
+      buzzoutmsg_t m = (buzzoutmsg_t)calloc(1, sizeof(union buzzoutmsg_u));
       m->bsc.type = type;
       m->bsc.id = id;
       m->bsc.key = buzzheap_clone(vm, key);
@@ -738,15 +1079,15 @@ void buzzoutmsg_queue_append_chunk(buzzvm_t vm,
       m->bsc.blob_size = blob_size;
       m->bsc.chunk_index = chunk_index;
       m->bsc.receiver = receiver;
-      m->bsc.cdata = buzzbstig_chunk_new(cdata->hash,cdata->chunk);
+      m->bsc.cdata = buzzbstig_chunk_share(cdata);
       /* Update the dictionary - this also invalidates e */
       buzzdict_set(bsc, &m->bsc.chunk_index, &m);
       if(ctype > -1) {
          /* Remove the entry from the queue */
-         buzzdarray_remove(vm->outmsgs->queues[ctype], cidx);
+         buzzqueue_remove(vm->outmsgs->queues[ctype], cidx);
       }
       /* Add a new message to the queue */
-      buzzdarray_push(vm->outmsgs->queues[type], &m);
+      buzzoutmsg_enqueue(vm, type, m);
    }
    else{ // P2P message to be sent
       /* Retrive the p2p dict for fast optimisation */ 
@@ -760,9 +1101,18 @@ void buzzoutmsg_queue_append_chunk(buzzvm_t vm,
       else {
          /* queue found  */
          rq = *prq;
+         /* A chunk asked for again while still queued is sent once */
+         for(uint32_t i = 0; i < buzzdarray_size(rq); ++i) {
+            buzzoutmsg_t f = buzzdarray_get(rq, i, buzzoutmsg_t);
+            if(f->type == BUZZMSG_BSTIG_CHUNK_PUT_P2P &&
+               f->bsc.id == id &&
+               f->bsc.key->i.value == key->i.value &&
+               f->bsc.chunk_index == chunk_index)
+               return;
+         }
       }
        /* Create a new message */
-      buzzoutmsg_t m = (buzzoutmsg_t)malloc(sizeof(union buzzoutmsg_u));
+      buzzoutmsg_t m = (buzzoutmsg_t)calloc(1, sizeof(union buzzoutmsg_u));
       m->bsc.type = BUZZMSG_BSTIG_CHUNK_PUT_P2P;
       m->bsc.id = id;
       m->bsc.key = buzzheap_clone(vm, key);
@@ -770,9 +1120,9 @@ void buzzoutmsg_queue_append_chunk(buzzvm_t vm,
       m->bsc.blob_size = blob_size;
       m->bsc.chunk_index = chunk_index;
       m->bsc.receiver = receiver;
-      m->bsc.cdata = buzzbstig_chunk_new(cdata->hash,cdata->chunk);
+      m->bsc.cdata = buzzbstig_chunk_share(cdata);
       /* Add a new message to the out msg queue */
-      buzzdarray_push(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P], &m);
+      buzzoutmsg_enqueue(vm, BUZZMSG_BSTIG_CHUNK_PUT_P2P, m);
       /* Add the message to fast optimization queue */
       buzzdarray_push(rq, &m);
    }
@@ -788,7 +1138,8 @@ void buzzoutmsg_queue_append_blob_status(buzzvm_t vm,
                                          uint16_t id,
                                          uint16_t key,
                                          uint8_t  status,
-                                         uint16_t requester) { 
+                                         uint16_t requester,
+                                         const buzzbitset_t have) { 
    // printf("[rid :%u] Got an append request for blob status\n",vm->robot );
   /* Look for bstig element in id */
    const struct buzzoutmsg_bstig_s** e = NULL;
@@ -816,25 +1167,29 @@ void buzzoutmsg_queue_append_blob_status(buzzvm_t vm,
    if(e) {
       // printf(" [RID : %u] Chunk Status message exsists \n",vm->robot);
       etype = type;
-      eidx = buzzdarray_find(vm->outmsgs->queues[type], buzzoutmsg_bstig_cmp, e);
+      eidx = buzzqueue_find(vm->outmsgs->queues[type], buzzoutmsg_bstig_cmp, e);
    }
    /* Create a new message */
-   buzzoutmsg_t m = (buzzoutmsg_t)malloc(sizeof(union buzzoutmsg_u));
+   buzzoutmsg_t m = (buzzoutmsg_t)calloc(1, sizeof(union buzzoutmsg_u));
    m->bss.type = type;
    m->bss.id = id;
    m->bss.key = key;
    m->bss.status = status;
    m->bss.requester = requester;
+   /* Send the chunks held along, if they fit */
+   if(have && buzzbitset_count(have) &&
+      buzzbitset_nbytes(have) <= MAX_CHUNKS_IN_BLOB_REQUEST / 8)
+      m->bss.have = buzzbitset_clone(have);
    // printf("status msg added to queue to out msg : id: %u key %u status %u\n",m->bss.id, m->bss.key,m->bss.status );
             
    /* Update the dictionary - this also invalidates e */
    buzzdict_set(bs, &key, &m);
    if(etype > -1) {
       /* Remove the entry from the queue */
-      buzzdarray_remove(vm->outmsgs->queues[type], eidx);
+      buzzqueue_remove(vm->outmsgs->queues[type], eidx);
    }
    /* Add a new message to the queue */
-   buzzdarray_push(vm->outmsgs->queues[type], &m);
+   buzzoutmsg_enqueue(vm, type, m);
 }
 
 /****************************************/
@@ -857,7 +1212,7 @@ void buzzoutmsg_queue_append_chunk_reloc(buzzvm_t vm,
                                          uint8_t subtype,
                                          uint16_t  msg) { 
    /* Create a new message */
-   buzzoutmsg_t m = (buzzoutmsg_t)malloc(sizeof(union buzzoutmsg_u));
+   buzzoutmsg_t m = (buzzoutmsg_t)calloc(1, sizeof(union buzzoutmsg_u));
    m->brl.type = type;
    m->brl.id = id;
    m->brl.key = key;
@@ -866,10 +1221,10 @@ void buzzoutmsg_queue_append_chunk_reloc(buzzvm_t vm,
    m->brl.subtype = subtype;
    m->brl.msg = msg;
    /* Check for duplicates :TODO better duplicate management than this, too much time consuming */
-   uint16_t index = buzzdarray_find(vm->outmsgs->queues[type],buzzoutmsg_chunk_Reloc_cmp,&m);
-   if(index == buzzdarray_size(vm->outmsgs->queues[type])){
+   uint16_t index = buzzqueue_find(vm->outmsgs->queues[type],buzzoutmsg_chunk_Reloc_cmp,&m);
+   if(index == buzzqueue_size(vm->outmsgs->queues[type])){
       /* Add a new message to the queue */
-      buzzdarray_push(vm->outmsgs->queues[type], &m);
+      buzzoutmsg_enqueue(vm, type, m);
    }
    else{
       /* Message already exsist cleanup */
@@ -881,7 +1236,7 @@ void buzzoutmsg_queue_append_chunk_reloc(buzzvm_t vm,
 int buzzoutmsg_blob_request_cmp(const void* a, const void* b){
    buzzoutmsg_t c = *(buzzoutmsg_t*) a;
    buzzoutmsg_t d = *(buzzoutmsg_t*) b;
-   if((uint16_t)c->brm.id == (uint16_t)d->brm.id && (uint16_t)c->brm.key == (uint16_t)d->brm.key 
+   if(c->type == d->type && (uint16_t)c->brm.id == (uint16_t)d->brm.id && (uint16_t)c->brm.key == (uint16_t)d->brm.key 
       && (uint16_t)c->brm.receiver == (uint16_t)d->brm.receiver)
       return 0;
    else return -1;
@@ -892,14 +1247,43 @@ void buzzoutmsg_queue_append_blob_request(buzzvm_t vm,
                                          uint16_t id,
                                          uint16_t key,
                                          uint16_t receiver,
-                                         uint16_t sender) { 
+                                         uint16_t sender,
+                                         uint16_t first,
+                                         uint16_t count,
+                                         const uint8_t* want) { 
    /* Create a new message */
-   buzzoutmsg_t m = (buzzoutmsg_t)malloc(sizeof(union buzzoutmsg_u));
+   buzzoutmsg_t m = (buzzoutmsg_t)calloc(1, sizeof(union buzzoutmsg_u));
    m->brm.type = type;
    m->brm.id = id;
    m->brm.key = key;
    m->brm.receiver = receiver;
    m->brm.sender = sender;
+   if(count) {
+      m->brm.first = first;
+      m->brm.count = count;
+      m->brm.want = (uint8_t*)malloc((count + 7) / 8);
+      memcpy(m->brm.want, want, (count + 7) / 8);
+   }
+   if(receiver == BROADCAST_MESSAGE_CONSTANT) {
+      /* One request reaches every holder */
+      buzzqueue_t q = vm->outmsgs->queues[BUZZMSG_BSTIG_BLOB_REQUEST];
+      uint32_t index = buzzqueue_find(q, buzzoutmsg_blob_request_cmp, &m);
+      if(index < buzzqueue_size(q)) {
+         /* A request is already waiting, ask for the chunks missing now instead */
+         buzzoutmsg_t f = buzzqueue_get(q, index, buzzoutmsg_t);
+         free(f->brm.want);
+         f->brm.sender = m->brm.sender;
+         f->brm.first = m->brm.first;
+         f->brm.count = m->brm.count;
+         f->brm.want = m->brm.want;
+         free(m);
+         buzzoutmsg_rewire(BUZZMSG_BSTIG_BLOB_REQUEST, f);
+      }
+      else {
+         buzzoutmsg_enqueue(vm, BUZZMSG_BSTIG_BLOB_REQUEST, m);
+      }
+      return;
+   }
    /* Retrive the p2p dict for fast optimisation */ 
    buzzdarray_t rq = NULL;
    /* Look for the receiver queue */
@@ -919,12 +1303,13 @@ void buzzoutmsg_queue_append_blob_request(buzzvm_t vm,
       /* Add a new message to the dup manager */
       buzzdarray_push(vm->outmsgs->bstigrecon, &m);
       /* Add a new message to the out msg queue */
-      buzzdarray_insert(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P],0, &m);
+      buzzqueue_push_front(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P], &m);
       /* Add the message to fast optimization queue */
       buzzdarray_insert(rq,0, &m);
    }
    else{
       /* Message already exsist cleanup */
+      free(m->brm.want);
       free(m);
    }
    
@@ -1002,22 +1387,24 @@ void buzzoutmsg_queue_append_chunk_removal(buzzvm_t vm,
    if(sbt) return;
    // printf("[Adding a new msg] \n");
    /* Create a new message */
-   buzzoutmsg_t m = (buzzoutmsg_t)malloc(sizeof(union buzzoutmsg_u));
+   buzzoutmsg_t m = (buzzoutmsg_t)calloc(1, sizeof(union buzzoutmsg_u));
    m->cr.type = type;
    m->cr.id = id;
    m->cr.key = key;
    m->cr.cid = cid;
    m->cr.subtype = subtype16;
+   m->cr.timer.type = BUZZCHUNK_TIMER_ANTIFLOOD;
+   m->cr.timer.data = m;
    if(subtype16 < BUZZCHUNK_NEIGHBOUR_QUERY)
-      m->cr.timer = MAX_TIME_TO_REMOVE_FLOODING_PROTECTION; // A global message has to be protected from flooding
+      buzztimer_schedule(vm->cmonitor->timers, &m->cr.timer, MAX_TIME_TO_REMOVE_FLOODING_PROTECTION + 1); // A global message has to be protected from flooding
    else
-      m->cr.timer = 0;  // A local message can be removed as soon as it is sent. Anti-flooder takes care of this.
+      buzztimer_schedule(vm->cmonitor->timers, &m->cr.timer, 1);  // A local message can be removed as soon as it is sent. Anti-flooder takes care of this.
    
    /* Add the entry to dictionary - used for anti-flooding */
    buzzdict_set(bsbt, &subtype16, &m);
    
    /* Add a new message to the queue */
-   buzzdarray_push(vm->outmsgs->queues[type], &m);
+   buzzoutmsg_enqueue(vm, type, m);
 
 }
 
@@ -1097,7 +1484,7 @@ void buzzoutmsg_queue_append_bid(buzzvm_t vm,
    if(sbt) return;
    // printf("[Adding a new msg] \n");
    /* Create a new message */
-   buzzoutmsg_t m = (buzzoutmsg_t)malloc(sizeof(union buzzoutmsg_u));
+   buzzoutmsg_t m = (buzzoutmsg_t)calloc(1, sizeof(union buzzoutmsg_u));
    m->bid.type = type;
    m->bid.id = id;
    m->bid.key = key;
@@ -1108,14 +1495,16 @@ void buzzoutmsg_queue_append_bid(buzzvm_t vm,
    m->bid.hash = hash;
    m->bid.getter = BUZZBLOB_GETTER_OPEN;
    m->bid.getter = getter;
-   m->bid.timer = MAX_TIME_TO_REMOVE_FLOODING_PROTECTION; // A global message has to be protected from flooding
    m->bid.receiver = receiver;
 
    if(subtype == BUZZBSTIG_BID_NEW){
       /* Add the entry to dictionary - used for anti-flooding */
       buzzdict_set(bsbt, &subtype, &m);
+      m->bid.timer.type = BUZZCHUNK_TIMER_ANTIFLOOD;
+      m->bid.timer.data = m;
+      buzztimer_schedule(vm->cmonitor->timers, &m->bid.timer, MAX_TIME_TO_REMOVE_FLOODING_PROTECTION + 1); // A global message has to be protected from flooding
       /* Add a new message to the queue */
-      buzzdarray_push(vm->outmsgs->queues[type], &m);
+      buzzoutmsg_enqueue(vm, type, m);
       // printf("added to broadcast queue\n");
    }
    else{
@@ -1132,7 +1521,7 @@ void buzzoutmsg_queue_append_bid(buzzvm_t vm,
          rq = *prq;
       }     
       /* Add a new message to the out msg queue */
-      buzzdarray_insert(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P],0, &m);
+      buzzqueue_push_front(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P], &m);
       /* Add the message to fast optimization queue */
       buzzdarray_insert(rq,0, &m);
       // printf("added to p2p queue\n");
@@ -1166,9 +1555,9 @@ void buzzoutmsg_remove_chunk_put_msg_for_each(const void* key, void* data, void*
    buzzvm_t vm = *(buzzvm_t*)params;
    struct buzzoutmsg_bstig_chunk_s**  c = (struct buzzoutmsg_bstig_chunk_s**)data;
    /* strip the messages from queue and delete */
-   int cidx = buzzdarray_find(vm->outmsgs->queues[(*c)->type], buzzoutmsg_bstig_cmp, c);
+   int cidx = buzzqueue_find(vm->outmsgs->queues[(*c)->type], buzzoutmsg_bstig_cmp, c);
    /* Remove the entry from the queue */
-   buzzdarray_remove(vm->outmsgs->queues[(*c)->type], cidx);
+   buzzqueue_remove(vm->outmsgs->queues[(*c)->type], cidx);
 }
 
 void buzzoutmsg_remove_chunk_put_msg(buzzvm_t vm,
@@ -1183,7 +1572,7 @@ void buzzoutmsg_remove_chunk_put_msg(buzzvm_t vm,
          buzzdict_remove(*tbc,&key);
          // if(buzzdict_get(*tbc, &key, buzzdict_t)) printf("after removal dict exsist\n");
          // else printf("Out msg dict removed succesfully \n");
-         // printf("out msg put chunk size : %u\n",buzzdarray_size(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT]) );
+         // printf("out msg put chunk size : %u\n",buzzqueue_size(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT]) );
       }
 
    }
@@ -1192,518 +1581,423 @@ void buzzoutmsg_remove_chunk_put_msg(buzzvm_t vm,
 /****************************************/
 /****************************************/
 
-struct buzzoutmsg_antiflood_removelist_param
-{
-   uint16_t id;
-   uint16_t key;      // Here it is assumed blobs are inserted in an assending order
-   uint16_t cid;
-   uint16_t subtype;
-};
+int buzzoutmsg_antiflooding_timeout(buzzvm_t vm, void* data){
+   buzzoutmsg_t m = (buzzoutmsg_t)data;
+   /* Keep the entry as long as the message is in the outmsg queue */
+   int cidx = buzzqueue_find(vm->outmsgs->queues[m->type], buzzoutmsg_bstig_cmp, &m);
+   if(cidx != buzzqueue_size(vm->outmsgs->queues[m->type])) return 0;
+   /* Look for the entry: id, key, cid (bidder for bids), subtype */
+   buzzdict_t d;
+   uint16_t id, key, cid, subtype;
+   if(m->type == BUZZMSG_BSTIG_CHUNK_REMOVED){
+      d = vm->outmsgs->cremovalprotect;
+      id = m->cr.id;
+      key = m->cr.key;
+      cid = m->cr.cid;
+      subtype = m->cr.subtype;
+   }
+   else{
+      d = vm->outmsgs->bidprotect;
+      id = m->bid.id;
+      key = m->bid.key;
+      cid = m->bid.bidderid;
+      subtype = m->bid.subtype;
+   }
+   const buzzdict_t* trid = buzzdict_get(d, &id, buzzdict_t);
+   if(!trid) return 0;
+   const buzzdict_t* trkey = buzzdict_get(*trid, &key, buzzdict_t);
+   if(!trkey) return 0;
+   const buzzdict_t* trcid = buzzdict_get(*trkey, &cid, buzzdict_t);
+   if(!trcid) return 0;
+   /* Strip the message from dict and delete it */
+   buzzdict_remove(*trcid, &subtype);
+   return 1;
+}
 
-struct buzzoutmsg_antiflood_blackboard_param
-{
-   uint16_t id;
-   uint16_t key;      // Here it is assumed blobs are inserted in an assending order
-   uint16_t cid;
-   buzzdarray_t a;
-};
+/****************************************/
+/****************************************/
 
-void buzzoutmsg_anitflooding_darray_destroy(uint32_t pos, void* data, void* params) {
-   struct buzzoutmsg_antiflood_removelist_param* m = *(struct buzzoutmsg_antiflood_removelist_param**) data;
-   free(m);
+/*
+ * Serializes a blob request into the given payload.
+ */
+static void buzzoutmsg_encode_blob_request(buzzmsg_payload_t m, buzzoutmsg_t f) {
+   buzzmsg_serialize_u8(m,  BUZZMSG_BSTIG_BLOB_REQUEST);
+   buzzmsg_serialize_u16(m, f->brm.id);
+   buzzmsg_serialize_u16(m, f->brm.key);
+   buzzmsg_serialize_u16(m, f->brm.sender);
+   /* Without a bitmap, every chunk is wanted */
+   if(f->brm.count) {
+      buzzmsg_serialize_u16(m, f->brm.first);
+      buzzmsg_serialize_u16(m, f->brm.count);
+      for(uint16_t i = 0; i < (f->brm.count + 7) / 8; ++i)
+         buzzmsg_serialize_u8(m, f->brm.want[i]);
+   }
 }
 
-void buzzoutmsg_anitflooding_subtypeloop(const void* key, void* data, void* params){ // chunk loop 
-   buzzoutmsg_t m=*(buzzoutmsg_t*) data;
-   struct buzzoutmsg_antiflood_blackboard_param* a = (struct buzzoutmsg_antiflood_blackboard_param*)params;
-   uint16_t subtype = *(uint16_t*) key;
-   // printf("[subtype : %u, timer : %u ] ", subtype, m->cr.timer);
-   if(m->type == BUZZMSG_BSTIG_CHUNK_REMOVED){
-      if(m->cr.timer <= 0 ){
-         /* This entry has to be removed add to the array */
-         struct buzzoutmsg_antiflood_removelist_param* e = 
-            (struct buzzoutmsg_antiflood_removelist_param*)malloc(sizeof(struct buzzoutmsg_antiflood_removelist_param));
-         e->id = a->id;
-         e->key = a->key;
-         e->cid = a->cid;
-         e->subtype = subtype;
-         buzzdarray_push((a)->a,&e);
+/*
+ * Serializes a queued message into the given payload.
+ */
+static void buzzoutmsg_encode(buzzmsg_payload_t m, int t, buzzoutmsg_t f) {
+   switch(t) {
+      case BUZZMSG_BROADCAST: {
+         buzzmsg_serialize_u8(m, BUZZMSG_BROADCAST);
+         buzzobj_serialize(m, f->bc.topic);
+         buzzobj_serialize(m, f->bc.value);
+         break;
       }
-      else{
-         m->cr.timer--;
+      case BUZZMSG_SWARM_LIST: {
+         uint16_t i;
+         buzzmsg_serialize_u8(m, BUZZMSG_SWARM_LIST);
+         buzzmsg_serialize_u16(m, f->sw.size);
+         for(i = 0; i < f->sw.size; ++i) {
+            buzzmsg_serialize_u16(m, f->sw.ids[i]);
+         }
+         break;
       }
-   }
-   else if (m->type == BUZZMSG_BSTIG_BLOB_BID){
-      if(m->bid.timer <= 0 ){
-         /* This entry has to be removed add to the array */
-         struct buzzoutmsg_antiflood_removelist_param* e = 
-            (struct buzzoutmsg_antiflood_removelist_param*)malloc(sizeof(struct buzzoutmsg_antiflood_removelist_param));
-         e->id = a->id;
-         e->key = a->key;
-         e->cid = a->cid;
-         e->subtype = subtype;
-         buzzdarray_push((a)->a,&e);
+      case BUZZMSG_VSTIG_PUT: {
+         buzzmsg_serialize_u8(m, BUZZMSG_VSTIG_PUT);
+         buzzmsg_serialize_u16(m, f->vs.id);
+         buzzvstig_elem_serialize(m, f->vs.key, f->vs.data);
+         break;
+      }
+      case BUZZMSG_VSTIG_QUERY: {
+         buzzmsg_serialize_u8(m, BUZZMSG_VSTIG_QUERY);
+         buzzmsg_serialize_u16(m, f->vs.id);
+         buzzvstig_elem_serialize(m, f->vs.key, f->vs.data);
+         break;
+      }
+      case BUZZMSG_BSTIG_PUT: {
+         buzzmsg_serialize_u8(m, BUZZMSG_BSTIG_PUT);
+         buzzmsg_serialize_u8(m, f->bs.blob_entry);
+         if(f->bs.blob_entry){
+            buzzmsg_serialize_u32(m, f->bs.blob_size);
+            buzzbstig_blob_codec_serialize(m, f->bs.codec, f->bs.raw_size);
+         }
+         buzzmsg_serialize_u16(m, f->bs.id);
+         buzzbstig_elem_serialize(m, f->bs.key, f->bs.data);
+         break;
+      }
+      case BUZZMSG_BSTIG_QUERY: {
+         buzzmsg_serialize_u8(m, BUZZMSG_BSTIG_QUERY);
+         buzzmsg_serialize_u8(m, f->bs.blob_entry);
+         if(f->bs.blob_entry){
+            buzzmsg_serialize_u32(m, f->bs.blob_size);
+            buzzbstig_blob_codec_serialize(m, f->bs.codec, f->bs.raw_size);
+         }
+         buzzmsg_serialize_u16(m, f->bs.id);
+         buzzbstig_elem_serialize(m, f->bs.key, f->bs.data);
+         break;
+      }
+      case BUZZMSG_SWARM_JOIN: {
+         buzzmsg_serialize_u8(m, BUZZMSG_SWARM_JOIN);
+         buzzmsg_serialize_u16(m, f->sw.ids[0]);
+         break;
+      }
+      case BUZZMSG_SWARM_LEAVE: {
+         buzzmsg_serialize_u8(m, BUZZMSG_SWARM_LEAVE);
+         buzzmsg_serialize_u16(m, f->sw.ids[0]);
+         break;
+      }
+      case BUZZMSG_BSTIG_STATUS: {
+         buzzmsg_serialize_u8(m, BUZZMSG_BSTIG_STATUS);
+         buzzmsg_serialize_u16(m, f->bss.id);
+         buzzmsg_serialize_u16(m, f->bss.key);
+         buzzmsg_serialize_u8(m, f->bss.status);
+         buzzmsg_serialize_u16(m, f->bss.requester);
+         if(f->bss.have) {
+            uint16_t n = buzzbitset_nbytes(f->bss.have);
+            uint8_t have[MAX_CHUNKS_IN_BLOB_REQUEST / 8];
+            buzzbitset_tobytes(f->bss.have, 0, n, have);
+            buzzmsg_serialize_u16(m, n);
+            buzzmsg_payload_append(m, have, n);
+         }
+         break;
       }
-      else{
-         m->bid.timer--;
+      case BUZZMSG_BSTIG_BLOB_REQUEST: {
+         buzzoutmsg_encode_blob_request(m, f);
+         break;
       }
+      case BUZZMSG_BSTIG_BLOB_BID: {
+         buzzmsg_serialize_u8(m, BUZZMSG_BSTIG_BLOB_BID);
+         buzzmsg_serialize_u16(m, f->bid.id);
+         buzzmsg_serialize_u16(m, f->bid.key);
+         buzzmsg_serialize_u16(m, f->bid.bidderid);
+         uint8_t subtype8 = f->bid.subtype;
+         buzzmsg_serialize_u8(m, subtype8);
+         if(subtype8 == BUZZBSTIG_BID_NEW){
+            buzzmsg_serialize_u32(m,f->bid.blob_size);
+            buzzmsg_serialize_u32(m,f->bid.hash);
+         }
+         else if(subtype8 == BUZZBSITG_BID_REPLY){
+            buzzmsg_serialize_u8(m, f->bid.getter);
+            buzzmsg_serialize_u16(m, f->bid.availablespace);
+         }
+         else if (subtype8 == BUZZCHUNK_BID_FORCE_ALLOCATION ||
+                  subtype8 == BUZZCHUNK_BID_FORCE_ALLOCATION_REJECT){
+            uint16_t removeid = f->bid.blob_size;
+            uint16_t removekey = f->bid.hash;
+            buzzmsg_serialize_u16(m,removeid);
+            buzzmsg_serialize_u16(m,removekey);
+            buzzmsg_serialize_u16(m, f->bid.availablespace);
+         }
+         else
+            buzzmsg_serialize_u16(m, f->bid.availablespace);
+         // printf("[RID: %u] sent a bidder msg id: %u, key: %u, bidderid : %u, subtype: %u \n",vm->robot,f->bid.id, f->bid.key, f->bid.bidderid, f->bid.subtype );
+         // printf("[RID : %u] queue size : %u\n",vm->robot, buzzqueue_size(vm->outmsgs->queues[BUZZMSG_BSTIG_BLOB_BID]));
 
-   }
+         break;
+      }
+      case BUZZMSG_BSTIG_CHUNK_REMOVED: {
+         buzzmsg_serialize_u8(m, BUZZMSG_BSTIG_CHUNK_REMOVED);
+         buzzmsg_serialize_u16(m, f->cr.id);
+         buzzmsg_serialize_u16(m, f->cr.key);
+         buzzmsg_serialize_u16(m, f->cr.cid);
+         uint8_t subtype8 = f->cr.subtype;
+         buzzmsg_serialize_u8(m, subtype8);
+         // printf("[RID: %u] sent a chunk removal msg id: %u, key: %u, cid : %u, subtype: %u \n",vm->robot,f->cr.id, f->cr.key, f->cr.cid, f->cr.subtype );
+         // printf("[RID : %u] queue size : %u\n",vm->robot, buzzqueue_size(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_REMOVED]));
 
-}
+         break;
+      }
+      case BUZZMSG_BSTIG_CHUNK_STATUS_QUERY: {
+         buzzmsg_serialize_u8(m, BUZZMSG_BSTIG_CHUNK_STATUS_QUERY);
+         buzzmsg_serialize_u16(m, f->brl.receiver);
+         buzzmsg_serialize_u16(m, f->brl.id);
+         buzzmsg_serialize_u16(m, f->brl.key);
+         buzzmsg_serialize_u16(m, f->brl.cid);
+         buzzmsg_serialize_u8(m, f->brl.subtype);
+         buzzmsg_serialize_u16(m, f->brl.msg);
+         // if(f->brl.subtype ==BUZZRELOCATION_REQUEST )
+         // printf("BUZZRELOCATION_REQUEST out msg sent from queue : receiver: %u cid %u msg %u\n",f->brl.receiver, f->brl.cid, f->brl.msg );
+         // if(f->brl.subtype ==BUZZRELOCATION_RESPONCE )
+         // printf("BUZZRELOCATION_RESPONCE out msg sent from queue : receiver: %u cid %u msg %u\n",f->brl.receiver, f->brl.cid, f->brl.msg );
 
-void buzzoutmsg_anitflooding_chunkloop(const void* key, void* data, void* params){ // key loop 
-   buzzdict_t m_dict = *(buzzdict_t*) data;
-   struct buzzoutmsg_antiflood_blackboard_param* a = (struct buzzoutmsg_antiflood_blackboard_param*)params;
-   a->cid= *(uint16_t*)key;
-   // printf("chunk : %u ", *(uint16_t*)key);
-   buzzdict_foreach(m_dict, buzzoutmsg_anitflooding_subtypeloop, params);
+         break;
+      }
+      case BUZZMSG_BSTIG_CHUNK_PUT: {
+         buzzmsg_serialize_u8(m, BUZZMSG_BSTIG_CHUNK_PUT);
+         buzzmsg_serialize_u32(m, f->bsc.blob_size);
+         buzzmsg_serialize_u16(m, f->bsc.id);
+         buzzbstig_elem_serialize(m, f->bsc.key, f->bsc.data);
+         buzzmsg_serialize_u16(m, f->bsc.chunk_index);
+         buzzbstig_chunk_serialize(m, f->bsc.cdata);
+         break;
+      }
+      case BUZZMSG_BSTIG_CHUNK_QUERY: {
+         buzzmsg_serialize_u8(m, BUZZMSG_BSTIG_CHUNK_QUERY);
+         buzzmsg_serialize_u32(m, f->bsc.blob_size);
+         buzzmsg_serialize_u16(m, f->bsc.id);
+         buzzbstig_elem_serialize(m, f->bsc.key, f->bsc.data);
+         buzzmsg_serialize_u16(m, f->bsc.chunk_index);
+         break;
+      }
+   }
 }
 
-void buzzoutmsg_anitflooding_keyloop(const void* key, void* data, void* params){ // key loop 
-   buzzdict_t m_dict = *(buzzdict_t*) data;
-   struct buzzoutmsg_antiflood_blackboard_param* a = (struct buzzoutmsg_antiflood_blackboard_param*)params;
-   a->key= *(uint16_t*)key;
-   // printf("key : %u ", *(uint16_t*)key);
-   buzzdict_foreach(m_dict, buzzoutmsg_anitflooding_chunkloop, params);
+/*
+ * Returns the serialized form of a queued message. The message is
+ * serialized the first time and the bytes are kept with it, so a
+ * message that waits for room in a frame is not serialized again.
+ */
+static buzzmsg_payload_t buzzoutmsg_wire(int t, buzzoutmsg_t f) {
+   if(!f->hd.wire) {
+      f->hd.wire = buzzmsg_payload_new(
+         t == BUZZMSG_BSTIG_CHUNK_PUT ?
+         BUZZOUTMSG_CHUNK_HEADER_SIZE + f->bsc.cdata->size :
+         16);
+      buzzoutmsg_encode(f->hd.wire, t, f);
+   }
+   return f->hd.wire;
 }
 
-void buzzoutmsg_anitflooding_idloop(const void* key, void* data, void* params){ // Id loop 
-   buzzdict_t m_dict = *(buzzdict_t*) data;
-   struct buzzoutmsg_antiflood_blackboard_param* a = (struct buzzoutmsg_antiflood_blackboard_param*)params;
-   a->id= *(uint16_t*)key;
-   // printf("id : %u ", *(uint16_t*)key);
-   buzzdict_foreach(m_dict, buzzoutmsg_anitflooding_keyloop, params);
+/*
+ * Serializes again a queued message whose content has changed.
+ */
+static void buzzoutmsg_rewire(int t, buzzoutmsg_t f) {
+   if(f->hd.wire) {
+      f->hd.wire->size = 0;
+      buzzoutmsg_encode(f->hd.wire, t, f);
+   }
 }
 
-void buzzoutmsg_update_antiflooding_entry(buzzvm_t vm){
-   /* create a darray for storing the entries to remove */
-   // printf("rid %u ",vm->robot);
-   buzzdarray_t a = buzzdarray_new(5, sizeof(struct buzzoutmsg_antiflood_removelist_param*), 
-                                          buzzoutmsg_anitflooding_darray_destroy);
-   struct buzzoutmsg_antiflood_blackboard_param p = {.id=0, .key=0, .cid=0, .a=a};
-   buzzdict_foreach(vm->outmsgs->cremovalprotect, buzzoutmsg_anitflooding_idloop, &p);   
-   for(uint16_t i=0; i < buzzdarray_size(a); i++){
-      const struct buzzoutmsg_antiflood_removelist_param* e = buzzdarray_get(a,i,struct buzzoutmsg_antiflood_removelist_param*);
-      // printf("array to remove: index : %u id : %u , key: %u, cid %u, subtype: %u\n",i ,e->id,e->key,e->cid, e->subtype );
-      const buzzdict_t* trid = buzzdict_get(vm->outmsgs->cremovalprotect, &(e->id), buzzdict_t);
-      const buzzdict_t* trkey = buzzdict_get(*trid, &(e->key), buzzdict_t);
-      const buzzdict_t* trcid = buzzdict_get(*trkey, &(e->cid), buzzdict_t);
-      const buzzoutmsg_t*  sbt = buzzdict_get(*trcid, &(e->subtype), buzzoutmsg_t);
-      /* strip the messages from dict and delete, if they donot exsist in outmsg queue */
-      int cidx = buzzdarray_find(vm->outmsgs->queues[(*sbt)->type], buzzoutmsg_bstig_cmp, sbt);
-      if(cidx == buzzdarray_size(vm->outmsgs->queues[(*sbt)->type])){
-         buzzdict_remove(*trcid, &(e->subtype));
-      }
-   }
-   buzzdarray_destroy(&a);
+/****************************************/
+/****************************************/
 
-   /* Bidder anti-flooding management */
-   a = buzzdarray_new(5, sizeof(struct buzzoutmsg_antiflood_removelist_param*), 
-                                          buzzoutmsg_anitflooding_darray_destroy);
-   struct buzzoutmsg_antiflood_blackboard_param  pr = {.id=0, .key=0, .cid=0, .a=a};
-   buzzdict_foreach(vm->outmsgs->bidprotect, buzzoutmsg_anitflooding_idloop, &pr);   
-   for(uint16_t i=0; i < buzzdarray_size(a); i++){
-      const struct buzzoutmsg_antiflood_removelist_param* e = buzzdarray_get(a,i,struct buzzoutmsg_antiflood_removelist_param*);
-      // printf("array to remove: index : %u id : %u , key: %u, cid %u, subtype: %u\n",i ,e->id,e->key,e->cid, e->subtype );
-      const buzzdict_t* trid = buzzdict_get(vm->outmsgs->bidprotect, &(e->id), buzzdict_t);
-      const buzzdict_t* trkey = buzzdict_get(*trid, &(e->key), buzzdict_t);
-      const buzzdict_t* trcid = buzzdict_get(*trkey, &(e->cid), buzzdict_t);
-      const buzzoutmsg_t*  sbt = buzzdict_get(*trcid, &(e->subtype), buzzoutmsg_t);
-      /* strip the messages from dict and delete, if they donot exsist in outmsg queue */
-      int cidx = buzzdarray_find(vm->outmsgs->queues[(*sbt)->type], buzzoutmsg_bstig_cmp, sbt);
-      if(cidx == buzzdarray_size(vm->outmsgs->queues[(*sbt)->type])){
-         buzzdict_remove(*trcid, &(e->subtype));
-      }
-   }
-   buzzdarray_destroy(&a);
-   // printf("\n");
+buzzmsg_payload_t buzzoutmsg_queue_peek(buzzvm_t vm) {
+   /* Ask the scheduler which queue goes next */
+   int t = buzzoutmsg_sched_pick(vm);
+   /* Empty queue */
+   if(t < 0) return NULL;
+   /* Take the first message in the queue */
+   return buzzoutmsg_wire(t, buzzqueue_first(vm->outmsgs->queues[t], buzzoutmsg_t));
 }
 
 /****************************************/
 /****************************************/
 
 buzzmsg_payload_t buzzoutmsg_queue_first(buzzvm_t vm) {
-   if(!buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_BROADCAST])) {
-      /* Take the first message in the queue */
-      buzzoutmsg_t f = buzzdarray_get(vm->outmsgs->queues[BUZZMSG_BROADCAST],
-                                      0, buzzoutmsg_t);
-      /* Make a new message */
-      buzzmsg_payload_t m = buzzmsg_payload_new(10);
-      buzzmsg_serialize_u8(m, BUZZMSG_BROADCAST);
-      buzzobj_serialize(m, f->bc.topic);
-      buzzobj_serialize(m, f->bc.value);
-      /* Return message */
-      return m;
-   }
-   else if(!buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_SWARM_LIST])) {
-      uint16_t i;
-      /* Take the first message in the queue */
-      buzzoutmsg_t f = buzzdarray_get(vm->outmsgs->queues[BUZZMSG_SWARM_LIST],
-                                      0, buzzoutmsg_t);
-      /* Make a new message */
-      buzzmsg_payload_t m = buzzmsg_payload_new(10);
-      buzzmsg_serialize_u8(m, BUZZMSG_SWARM_LIST);
-      buzzmsg_serialize_u16(m, f->sw.size);
-      for(i = 0; i < f->sw.size; ++i) {
-         buzzmsg_serialize_u16(m, f->sw.ids[i]);
-      }
-      /* Return message */
-      return m;      
-   }
-   else if(!buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_VSTIG_PUT])) {
-      /* Take the first message in the queue */
-      buzzoutmsg_t f = buzzdarray_get(vm->outmsgs->queues[BUZZMSG_VSTIG_PUT],
-                                      0, buzzoutmsg_t);
-      /* Make a new message */
-      buzzmsg_payload_t m = buzzmsg_payload_new(10);
-      buzzmsg_serialize_u8(m, BUZZMSG_VSTIG_PUT);
-      buzzmsg_serialize_u16(m, f->vs.id);
-      buzzvstig_elem_serialize(m, f->vs.key, f->vs.data);
-      /* Return message */
-      return m;
-   }
-   else if(!buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_VSTIG_QUERY])) {
-      /* Take the first message in the queue */
-      buzzoutmsg_t f = buzzdarray_get(vm->outmsgs->queues[BUZZMSG_VSTIG_QUERY],
-                                      0, buzzoutmsg_t);
-      /* Make a new message */
-      buzzmsg_payload_t m = buzzmsg_payload_new(10);
-      buzzmsg_serialize_u8(m, BUZZMSG_VSTIG_QUERY);
-      buzzmsg_serialize_u16(m, f->vs.id);
-      buzzvstig_elem_serialize(m, f->vs.key, f->vs.data);
-      /* Return message */
-      return m;
-   }
-   else if(!buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_BSTIG_PUT])) {
-      /* Take the first message in the queue */
-      buzzoutmsg_t f = buzzdarray_get(vm->outmsgs->queues[BUZZMSG_BSTIG_PUT],
-                                      0, buzzoutmsg_t);
-      /* Make a new message */
-      buzzmsg_payload_t m = buzzmsg_payload_new(10);
-      buzzmsg_serialize_u8(m, BUZZMSG_BSTIG_PUT);
-      buzzmsg_serialize_u8(m, f->bs.blob_entry);
-      if(f->bs.blob_entry){
-         buzzmsg_serialize_u32(m, f->bs.blob_size);   
-      }
-      buzzmsg_serialize_u16(m, f->bs.id);
-      buzzbstig_elem_serialize(m, f->bs.key, f->bs.data);
-      /* Return message */
-      return m;
-   }
-   else if(!buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_BSTIG_QUERY])) {
-      /* Take the first message in the queue */
-      buzzoutmsg_t f = buzzdarray_get(vm->outmsgs->queues[BUZZMSG_BSTIG_QUERY],
-                                      0, buzzoutmsg_t);
-      /* Make a new message */
-      buzzmsg_payload_t m = buzzmsg_payload_new(10);
-      buzzmsg_serialize_u8(m, BUZZMSG_BSTIG_QUERY);
-      buzzmsg_serialize_u8(m, f->bs.blob_entry);
-      if(f->bs.blob_entry){
-         buzzmsg_serialize_u32(m, f->bs.blob_size);   
-      }
-      buzzmsg_serialize_u16(m, f->bs.id);
-      buzzbstig_elem_serialize(m, f->bs.key, f->bs.data);
-      /* Return message */
-      return m;
-   }
-   else if(!buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_SWARM_JOIN])) {
-      /* Take the first message in the queue */
-      buzzoutmsg_t f = buzzdarray_get(vm->outmsgs->queues[BUZZMSG_SWARM_JOIN],
-                                      0, buzzoutmsg_t);
-      /* Make a new message */
-      buzzmsg_payload_t m = buzzmsg_payload_new(5);
-      buzzmsg_serialize_u8(m, BUZZMSG_SWARM_JOIN);
-      buzzmsg_serialize_u16(m, f->sw.ids[0]);
-      /* Return message */
-      return m;      
-   }
-   else if(!buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_SWARM_LEAVE])) {
-      /* Take the first message in the queue */
-      buzzoutmsg_t f = buzzdarray_get(vm->outmsgs->queues[BUZZMSG_SWARM_LEAVE],
-                                      0, buzzoutmsg_t);
-      /* Make a new message */
-      buzzmsg_payload_t m = buzzmsg_payload_new(5);
-      buzzmsg_serialize_u8(m, BUZZMSG_SWARM_LEAVE);
-      buzzmsg_serialize_u16(m, f->sw.ids[0]);
-      /* Return message */
-      return m;      
-   }
-   else if(!buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_BSTIG_STATUS])) {
-     /* Take the first message in the queue */
-      buzzoutmsg_t f = buzzdarray_get(vm->outmsgs->queues[BUZZMSG_BSTIG_STATUS],
-                                      0, buzzoutmsg_t);
-      /* Make a new message */
-      buzzmsg_payload_t m = buzzmsg_payload_new(10);
-      buzzmsg_serialize_u8(m, BUZZMSG_BSTIG_STATUS);
-      buzzmsg_serialize_u16(m, f->bss.id);   
-      buzzmsg_serialize_u16(m, f->bss.key);
-      buzzmsg_serialize_u8(m, f->bss.status);
-      buzzmsg_serialize_u16(m, f->bss.requester);
-      /* Return message */
-      return m;
-   }
-   else if(!buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_BSTIG_BLOB_BID])) {
-     /* Take the first message in the queue */
-      buzzoutmsg_t f = buzzdarray_get(vm->outmsgs->queues[BUZZMSG_BSTIG_BLOB_BID],
-                                      0, buzzoutmsg_t);
-      /* Make a new message */
-      buzzmsg_payload_t m = buzzmsg_payload_new(10);
-      buzzmsg_serialize_u8(m, BUZZMSG_BSTIG_BLOB_BID);
-      buzzmsg_serialize_u16(m, f->bid.id);   
-      buzzmsg_serialize_u16(m, f->bid.key);
-      buzzmsg_serialize_u16(m, f->bid.bidderid);
-      uint8_t subtype8 = f->bid.subtype;
-      buzzmsg_serialize_u8(m, subtype8);
-      if(subtype8 == BUZZBSTIG_BID_NEW){
-         buzzmsg_serialize_u32(m,f->bid.blob_size);
-         buzzmsg_serialize_u32(m,f->bid.hash);
-      }
-      else if(subtype8 == BUZZBSITG_BID_REPLY){
-         buzzmsg_serialize_u8(m, f->bid.getter);
-         buzzmsg_serialize_u16(m, f->bid.availablespace);
-      }
-      else if (subtype8 == BUZZCHUNK_BID_FORCE_ALLOCATION ||
-               subtype8 == BUZZCHUNK_BID_FORCE_ALLOCATION_REJECT){
-         uint16_t removeid = f->bid.blob_size;
-         uint16_t removekey = f->bid.hash;
-         buzzmsg_serialize_u16(m,removeid);
-         buzzmsg_serialize_u16(m,removekey);
-         buzzmsg_serialize_u16(m, f->bid.availablespace);
-      }
-      else 
-         buzzmsg_serialize_u16(m, f->bid.availablespace);
-      // printf("[RID: %u] sent a bidder msg id: %u, key: %u, bidderid : %u, subtype: %u \n",vm->robot,f->bid.id, f->bid.key, f->bid.bidderid, f->bid.subtype );
-      // printf("[RID : %u] queue size : %u\n",vm->robot, buzzdarray_size(vm->outmsgs->queues[BUZZMSG_BSTIG_BLOB_BID]));
-      
-      /* Return message */
-      return m;
-   }
-   else if(!buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_REMOVED])) {
-     /* Take the first message in the queue */
-      buzzoutmsg_t f = buzzdarray_get(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_REMOVED],
-                                      0, buzzoutmsg_t);
-      /* Make a new message */
-      buzzmsg_payload_t m = buzzmsg_payload_new(10);
-      buzzmsg_serialize_u8(m, BUZZMSG_BSTIG_CHUNK_REMOVED);
-      buzzmsg_serialize_u16(m, f->cr.id);   
-      buzzmsg_serialize_u16(m, f->cr.key);
-      buzzmsg_serialize_u16(m, f->cr.cid);
-      uint8_t subtype8 = f->cr.subtype;
-      buzzmsg_serialize_u8(m, subtype8);
-      // printf("[RID: %u] sent a chunk removal msg id: %u, key: %u, cid : %u, subtype: %u \n",vm->robot,f->cr.id, f->cr.key, f->cr.cid, f->cr.subtype );
-      // printf("[RID : %u] queue size : %u\n",vm->robot, buzzdarray_size(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_REMOVED]));
-      
-      /* Return message */
-      return m;
-   }
-   else if(!buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_STATUS_QUERY])) {
-     /* Take the first message in the queue */
-      buzzoutmsg_t f = buzzdarray_get(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_STATUS_QUERY],
-                                      0, buzzoutmsg_t);
-      /* Make a new message */
-      buzzmsg_payload_t m = buzzmsg_payload_new(10);
-      buzzmsg_serialize_u8(m, BUZZMSG_BSTIG_CHUNK_STATUS_QUERY);
-      buzzmsg_serialize_u16(m, f->brl.receiver);
-      buzzmsg_serialize_u16(m, f->brl.id);   
-      buzzmsg_serialize_u16(m, f->brl.key);
-      buzzmsg_serialize_u16(m, f->brl.cid);
-      buzzmsg_serialize_u8(m, f->brl.subtype);
-      buzzmsg_serialize_u16(m, f->brl.msg);
-      // if(f->brl.subtype ==BUZZRELOCATION_REQUEST )
-      // printf("BUZZRELOCATION_REQUEST out msg sent from queue : receiver: %u cid %u msg %u\n",f->brl.receiver, f->brl.cid, f->brl.msg );
-      // if(f->brl.subtype ==BUZZRELOCATION_RESPONCE )
-      // printf("BUZZRELOCATION_RESPONCE out msg sent from queue : receiver: %u cid %u msg %u\n",f->brl.receiver, f->brl.cid, f->brl.msg );
-   
-      /* Return message */
-      return m;
-   }
-   else if(!buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT])) {
-      /* Take the first message in the queue */
-      buzzoutmsg_t f = buzzdarray_get(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT],
-                                      0, buzzoutmsg_t);
-      /* Make a new message */
-      buzzmsg_payload_t m = buzzmsg_payload_new(10);
-      buzzmsg_serialize_u8(m, BUZZMSG_BSTIG_CHUNK_PUT);
-      buzzmsg_serialize_u32(m, f->bsc.blob_size);   
-      buzzmsg_serialize_u16(m, f->bsc.id);
-      buzzbstig_elem_serialize(m, f->bsc.key, f->bsc.data);
-      buzzmsg_serialize_u16(m, f->bsc.chunk_index);
-      buzzbstig_chunk_serialize(m, f->bsc.cdata);
-      /* Return message */
-      return m;
-   }
-   else if(!buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_QUERY])) {
-      /* Take the first message in the queue */
-      buzzoutmsg_t f = buzzdarray_get(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_QUERY],
-                                      0, buzzoutmsg_t);
-      /* Make a new message */
-      buzzmsg_payload_t m = buzzmsg_payload_new(10);
-      buzzmsg_serialize_u8(m, BUZZMSG_BSTIG_CHUNK_QUERY);
-      buzzmsg_serialize_u32(m, f->bsc.blob_size);   
-      buzzmsg_serialize_u16(m, f->bsc.id);
-      buzzbstig_elem_serialize(m, f->bsc.key, f->bsc.data);
-      buzzmsg_serialize_u16(m, f->bsc.chunk_index);
-      /* Return message */
-      return m;
-   }
-   /* Empty queue */
-   return NULL;
+   buzzmsg_payload_t w = buzzoutmsg_queue_peek(vm);
+   if(!w) return NULL;
+   return buzzmsg_payload_frombuffer(w->data, buzzmsg_payload_size(w));
 }
 
 /****************************************/
 /****************************************/
 
 void buzzoutmsg_queue_next(buzzvm_t vm) {
-   if(!buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_BROADCAST])) {
-      /* Remove the first message in the queue */
-      buzzdarray_remove(vm->outmsgs->queues[BUZZMSG_BROADCAST], 0);
-   }
-   else if(!buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_SWARM_LIST])) {
-      /* Remove the first message in the queue */
-      buzzdarray_remove(vm->outmsgs->queues[BUZZMSG_SWARM_LIST], 0);
-   }
-   else if(!buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_VSTIG_PUT])) {
-      /* Take the first message in the queue */
-      buzzoutmsg_t f = buzzdarray_get(vm->outmsgs->queues[BUZZMSG_VSTIG_PUT],
-                                      0, buzzoutmsg_t);
-      /* Remove the element in the vstig dictionary */
-      buzzdict_remove(
-         *buzzdict_get(vm->outmsgs->vstig, &f->vs.id, buzzdict_t),
-         &f->vs.key);
-      /* Remove the first message in the queue */
-      buzzdarray_remove(vm->outmsgs->queues[BUZZMSG_VSTIG_PUT], 0);
-   }
-   else if(!buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_VSTIG_QUERY])) {
-      /* Take the first message in the queue */
-      buzzoutmsg_t f = buzzdarray_get(vm->outmsgs->queues[BUZZMSG_VSTIG_QUERY],
-                                      0, buzzoutmsg_t);
-      /* Remove the element in the vstig dictionary */
-      buzzdict_remove(
-         *buzzdict_get(vm->outmsgs->vstig, &f->vs.id, buzzdict_t),
-         &f->vs.key);
-      /* Remove the first message in the queue */
-      buzzdarray_remove(vm->outmsgs->queues[BUZZMSG_VSTIG_QUERY], 0);
-   }
-   else if(!buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_BSTIG_PUT])) {
-      /* Take the first message in the queue */
-      buzzoutmsg_t f = buzzdarray_get(vm->outmsgs->queues[BUZZMSG_BSTIG_PUT],
-                                      0, buzzoutmsg_t);
-      /* Remove the element in the bstig dictionary */
+   struct buzzoutmsg_sched_s* s = &vm->outmsgs->sched;
+   /* Get the queue of the message just sent */
+   int t = buzzoutmsg_sched_pick(vm);
+   if(t < 0) return;
+   /* Take the first message in the queue */
+   buzzoutmsg_t f = buzzqueue_first(vm->outmsgs->queues[t], buzzoutmsg_t);
+   /* Update the latency counters and spend a credit */
+   uint32_t wait = s->now - f->hd.stamp;
+   ++s->stats[t].sent;
+   s->stats[t].wait_total += wait;
+   if(wait > s->stats[t].wait_max) s->stats[t].wait_max = wait;
+   if(!s->aged) --s->deficit[t];
+   s->cur = -1;
+   switch(t) {
+      case BUZZMSG_BROADCAST: {
+         /* Remove the first message in the queue */
+         buzzqueue_pop(vm->outmsgs->queues[BUZZMSG_BROADCAST]);
+         break;
+      }
+      case BUZZMSG_SWARM_LIST: {
+         /* Remove the first message in the queue */
+         buzzqueue_pop(vm->outmsgs->queues[BUZZMSG_SWARM_LIST]);
+         break;
+      }
+      case BUZZMSG_VSTIG_PUT: {
+         /* Remove the element in the vstig dictionary */
          buzzdict_remove(
-         *buzzdict_get(vm->outmsgs->bstig, &f->bs.id, buzzdict_t),
-         &f->bs.key);
-      /* Remove the first message in the queue */
-      buzzdarray_remove(vm->outmsgs->queues[BUZZMSG_BSTIG_PUT], 0);
-   }
-   else if(!buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_BSTIG_QUERY])) {
-      /* Take the first message in the queue */
-      buzzoutmsg_t f = buzzdarray_get(vm->outmsgs->queues[BUZZMSG_BSTIG_QUERY],
-                                      0, buzzoutmsg_t);
-      /* Remove the element in the bstig dictionary */
+            *buzzdict_get(vm->outmsgs->vstig, &f->vs.id, buzzdict_t),
+            &f->vs.key);
+         /* Remove the first message in the queue */
+         buzzqueue_pop(vm->outmsgs->queues[BUZZMSG_VSTIG_PUT]);
+         break;
+      }
+      case BUZZMSG_VSTIG_QUERY: {
+         /* Remove the element in the vstig dictionary */
          buzzdict_remove(
+            *buzzdict_get(vm->outmsgs->vstig, &f->vs.id, buzzdict_t),
+            &f->vs.key);
+         /* Remove the first message in the queue */
+         buzzqueue_pop(vm->outmsgs->queues[BUZZMSG_VSTIG_QUERY]);
+         break;
+      }
+      case BUZZMSG_BSTIG_PUT: {
+         /* Remove the element in the bstig dictionary */
+            buzzdict_remove(
             *buzzdict_get(vm->outmsgs->bstig, &f->bs.id, buzzdict_t),
             &f->bs.key);
-      /* Remove the first message in the queue */
-      buzzdarray_remove(vm->outmsgs->queues[BUZZMSG_BSTIG_QUERY], 0);
-   }
-   else if(!buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_SWARM_JOIN])) {
-      /* Remove the first message in the queue */
-      buzzdarray_remove(vm->outmsgs->queues[BUZZMSG_SWARM_JOIN], 0);
-   }
-   else if(!buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_SWARM_LEAVE])) {
-      /* Remove the first message in the queue */
-      buzzdarray_remove(vm->outmsgs->queues[BUZZMSG_SWARM_LEAVE], 0);
-   }
-   else if(!buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_BSTIG_STATUS])) {
-      /* Take the first message in the queue */
-      buzzoutmsg_t f = buzzdarray_get(vm->outmsgs->queues[BUZZMSG_BSTIG_STATUS],
-                                      0, buzzoutmsg_t);
-      /* Remove the element in the bstig status dictionary */
-         buzzdict_remove(
-            *buzzdict_get(vm->outmsgs->bstigstatus, &(f->bss.id), buzzdict_t)
-               , &(f->bss.key));
-      /* Remove the first message in the queue */
-      buzzdarray_remove(vm->outmsgs->queues[BUZZMSG_BSTIG_STATUS], 0);
-   }
-   else if(!buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_BSTIG_BLOB_BID])) {
-      /* Remove the first message in the queue */
-      buzzdarray_remove(vm->outmsgs->queues[BUZZMSG_BSTIG_BLOB_BID], 0);
-      // printf("[RID : %u] Removed bid msg queue size : %u \n",vm->robot, buzzdarray_size(vm->outmsgs->queues[BUZZMSG_BSTIG_BLOB_BID]));
-      
-   }
-   else if(!buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_REMOVED])) {
-      /* Remove the first message in the queue */
-      buzzdarray_remove(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_REMOVED], 0);
-      // printf("[RID : %u]Removed chunk remove msg queue size : %u \n",vm->robot, buzzdarray_size(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_REMOVED]));
-      
-   }
-   else if(!buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_STATUS_QUERY])) {
-      /* Remove the first message in the queue */
-      buzzdarray_remove(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_STATUS_QUERY], 0);
-   }
-   else if(!buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT])) {
-      /* Take the first message in the queue */
-      buzzoutmsg_t f = buzzdarray_get(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT],
-                                      0, buzzoutmsg_t);
-      
-      /* Remove the element in the bstig chunk dictionary */
-         buzzdict_remove(
-            *buzzdict_get(*buzzdict_get(vm->outmsgs->chunkbstig, &(f->bsc.id), buzzdict_t)
-            , &(f->bsc.key->i.value), buzzdict_t), &(f->bsc.chunk_index));
-      /* Remove the first message in the queue */
-      buzzdarray_remove(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT], 0);
-   }
-   else if(!buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_QUERY])) {
-      /* Take the first message in the queue */
-      buzzoutmsg_t f = buzzdarray_get(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_QUERY],
-                                      0, buzzoutmsg_t);
-      /* Remove the element in the bstig chunk dictionary */
-         buzzdict_remove(
-            *buzzdict_get(*buzzdict_get(vm->outmsgs->chunkbstig, &f->bsc.id, buzzdict_t)
-            , &f->bsc.key->i.value, buzzdict_t), &f->bsc.chunk_index);
-      /* Remove the first message in the queue */
-      buzzdarray_remove(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_QUERY], 0);
+         /* Remove the first message in the queue */
+         buzzqueue_pop(vm->outmsgs->queues[BUZZMSG_BSTIG_PUT]);
+         break;
+      }
+      case BUZZMSG_BSTIG_QUERY: {
+         /* Remove the element in the bstig dictionary */
+            buzzdict_remove(
+               *buzzdict_get(vm->outmsgs->bstig, &f->bs.id, buzzdict_t),
+               &f->bs.key);
+         /* Remove the first message in the queue */
+         buzzqueue_pop(vm->outmsgs->queues[BUZZMSG_BSTIG_QUERY]);
+         break;
+      }
+      case BUZZMSG_SWARM_JOIN: {
+         /* Remove the first message in the queue */
+         buzzqueue_pop(vm->outmsgs->queues[BUZZMSG_SWARM_JOIN]);
+         break;
+      }
+      case BUZZMSG_SWARM_LEAVE: {
+         /* Remove the first message in the queue */
+         buzzqueue_pop(vm->outmsgs->queues[BUZZMSG_SWARM_LEAVE]);
+         break;
+      }
+      case BUZZMSG_BSTIG_STATUS: {
+         /* Remove the element in the bstig status dictionary */
+            buzzdict_remove(
+               *buzzdict_get(vm->outmsgs->bstigstatus, &(f->bss.id), buzzdict_t)
+                  , &(f->bss.key));
+         /* Remove the first message in the queue */
+         buzzqueue_pop(vm->outmsgs->queues[BUZZMSG_BSTIG_STATUS]);
+         break;
+      }
+      case BUZZMSG_BSTIG_BLOB_BID: {
+         /* Remove the first message in the queue */
+         buzzqueue_pop(vm->outmsgs->queues[BUZZMSG_BSTIG_BLOB_BID]);
+         // printf("[RID : %u] Removed bid msg queue size : %u \n",vm->robot, buzzqueue_size(vm->outmsgs->queues[BUZZMSG_BSTIG_BLOB_BID]));
+         break;
+      }
+      case BUZZMSG_BSTIG_BLOB_REQUEST: {
+         /* Remove the first message in the queue */
+         buzzqueue_pop(vm->outmsgs->queues[BUZZMSG_BSTIG_BLOB_REQUEST]);
+         break;
+      }
+      case BUZZMSG_BSTIG_CHUNK_REMOVED: {
+         /* Remove the first message in the queue */
+         buzzqueue_pop(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_REMOVED]);
+         // printf("[RID : %u]Removed chunk remove msg queue size : %u \n",vm->robot, buzzqueue_size(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_REMOVED]));
+         break;
+      }
+      case BUZZMSG_BSTIG_CHUNK_STATUS_QUERY: {
+         /* Remove the first message in the queue */
+         buzzqueue_pop(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_STATUS_QUERY]);
+         break;
+      }
+      case BUZZMSG_BSTIG_CHUNK_PUT: {
+         /* Remove the element in the bstig chunk dictionary */
+            buzzdict_remove(
+               *buzzdict_get(*buzzdict_get(vm->outmsgs->chunkbstig, &(f->bsc.id), buzzdict_t)
+               , &(f->bsc.key->i.value), buzzdict_t), &(f->bsc.chunk_index));
+         /* Remove the first message in the queue */
+         buzzqueue_pop(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT]);
+         break;
+      }
+      case BUZZMSG_BSTIG_CHUNK_QUERY: {
+         /* Remove the element in the bstig chunk dictionary */
+            buzzdict_remove(
+               *buzzdict_get(*buzzdict_get(vm->outmsgs->chunkbstig, &f->bsc.id, buzzdict_t)
+               , &f->bsc.key->i.value, buzzdict_t), &f->bsc.chunk_index);
+         /* Remove the first message in the queue */
+         buzzqueue_pop(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_QUERY]);
+         break;
+      }
    }
 }
 
 /****************************************/
 /****************************************/
 
+buzzmsg_payload_t buzzoutmsg_chunk_queue_peek(buzzvm_t vm){
+   if(buzzqueue_isempty(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT])) return NULL;
+   return buzzoutmsg_wire(BUZZMSG_BSTIG_CHUNK_PUT,
+                          buzzqueue_first(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT],
+                                          buzzoutmsg_t));
+}
+
+/****************************************/
+/****************************************/
+
 buzzmsg_payload_t buzzoutmsg_chunk_queue_first(buzzvm_t vm){
-   if(!buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT])) {
-      
-      /* Take the first message in the queue */
-      buzzoutmsg_t f = buzzdarray_get(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT],
-                                      0, buzzoutmsg_t);
-     
-      /* Make a new message */
-      buzzmsg_payload_t m = buzzmsg_payload_new(10);
-      buzzmsg_serialize_u8(m, BUZZMSG_BSTIG_CHUNK_PUT);
-      buzzmsg_serialize_u32(m, f->bsc.blob_size);   
-      buzzmsg_serialize_u16(m, f->bsc.id);
-      buzzbstig_elem_serialize(m, f->bsc.key, f->bsc.data);
-      buzzmsg_serialize_u16(m, f->bsc.chunk_index);
-      buzzbstig_chunk_serialize(m, f->bsc.cdata);
-      /* Return message */
-      return m;
-   }
-   /* Empty queue */
-   return NULL;
+   buzzmsg_payload_t w = buzzoutmsg_chunk_queue_peek(vm);
+   if(!w) return NULL;
+   return buzzmsg_payload_frombuffer(w->data, buzzmsg_payload_size(w));
 }
 
 /****************************************/
 /****************************************/
 
 buzzp2poutmsg_payload_t buzzoutmsg_p2p_chunk_queue_first(buzzvm_t vm){
-   if(!buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P])) {
+   if(!buzzqueue_isempty(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P])) {
       
       /* Take the first message in the queue */
-      buzzoutmsg_t f = buzzdarray_get(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P],
+      buzzoutmsg_t f = buzzqueue_get(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P],
                                       0, buzzoutmsg_t);
       if(f->type == BUZZMSG_BSTIG_CHUNK_PUT_P2P){                              
-         /* Make a new message */
-         buzzmsg_payload_t m = buzzmsg_payload_new(10);
+         /* Make a new message, sized for the chunk bytes */
+         buzzmsg_payload_t m = buzzmsg_payload_new(BUZZOUTMSG_CHUNK_HEADER_SIZE + f->bsc.cdata->size);
          buzzmsg_serialize_u8(m, BUZZMSG_BSTIG_CHUNK_PUT);
          buzzmsg_serialize_u32(m, f->bsc.blob_size);   
          buzzmsg_serialize_u16(m, f->bsc.id);
@@ -1718,10 +2012,7 @@ buzzp2poutmsg_payload_t buzzoutmsg_p2p_chunk_queue_first(buzzvm_t vm){
       else if(f->type == BUZZMSG_BSTIG_BLOB_REQUEST){
          /* Make a new message */
          buzzmsg_payload_t m = buzzmsg_payload_new(10);
-         buzzmsg_serialize_u8(m,  BUZZMSG_BSTIG_BLOB_REQUEST);
-         buzzmsg_serialize_u16(m, f->brm.id);   
-         buzzmsg_serialize_u16(m, f->brm.key);
-         buzzmsg_serialize_u16(m, f->brm.sender);
+         buzzoutmsg_encode_blob_request(m, f);
          // printf("GOt a blob request message id %u k %u recev %u send %u\n",f->brm.id,f->brm.key,f->brm.receiver,f->brm.sender );
    
          buzzp2poutmsg_payload_t p2pm = (buzzp2poutmsg_payload_t)malloc(sizeof(struct buzzp2poutmsg_payload_s));
@@ -1775,7 +2066,7 @@ void buzzoutmsg_getp2pqueue_foreach(const void* key, void* data, void* params){
    buzzdarray_t p2pq = *(buzzdarray_t*) data;
    if(buzzdarray_size(p2pq)>0){
       buzzp2poutmsg_payload_t p2pm = (buzzp2poutmsg_payload_t)malloc(sizeof(struct buzzp2poutmsg_payload_s));
-      p2pm->msg = p2pq;
+      p2pm->msg = (buzzmsg_payload_t)p2pq;
       p2pm->receiver = *(uint16_t*)key;
       buzzdarray_push(p,&p2pm);
    }      
@@ -1792,9 +2083,9 @@ buzzdarray_t buzzoutmsg_getp2pqueue(buzzvm_t vm){
 /****************************************/
 /****************************************/
 void buzzoutmsg_p2p_chunk_queue_next(buzzvm_t vm){
-   if(!buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P])) {
+   if(!buzzqueue_isempty(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P])) {
       /* Take the first message in the queue */
-      buzzoutmsg_t f = buzzdarray_get(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P],
+      buzzoutmsg_t f = buzzqueue_get(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P],
                                       0, buzzoutmsg_t);
       if(f->type == BUZZMSG_BSTIG_CHUNK_PUT_P2P){                              
          /* Find the index of this message in receiver id queue and remove*/
@@ -1802,7 +2093,7 @@ void buzzoutmsg_p2p_chunk_queue_next(buzzvm_t vm){
          uint32_t index = buzzdarray_find(*rqp,buzzoutmsg_bstig_cmp, &f);
          buzzdarray_remove(*rqp, index);
          /* Remove the first message in the queue */
-         buzzdarray_remove(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P], 0);
+         buzzqueue_pop(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P]);
       }
       else if(f->type == BUZZMSG_BSTIG_BLOB_REQUEST){
          /* Find the index of this message in receiver id queue and remove*/
@@ -1813,7 +2104,7 @@ void buzzoutmsg_p2p_chunk_queue_next(buzzvm_t vm){
          index = buzzdarray_find(vm->outmsgs->bstigrecon,buzzoutmsg_bstig_cmp, &f);
          buzzdarray_remove(vm->outmsgs->bstigrecon, index);
          /* Remove the first message in the queue */
-         buzzdarray_remove(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P], 0);
+         buzzqueue_pop(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P]);
 
       }
       else if(f->type == BUZZMSG_BSTIG_BLOB_BID){
@@ -1822,7 +2113,7 @@ void buzzoutmsg_p2p_chunk_queue_next(buzzvm_t vm){
          uint32_t index = buzzdarray_find(*rqp,buzzoutmsg_bstig_cmp, &f);
          buzzdarray_remove(*rqp, index);
          /* Remove the first message in the queue */
-         buzzdarray_remove(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P], 0);
+         buzzqueue_pop(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P]);
 
       }
    }
@@ -1832,9 +2123,9 @@ void buzzoutmsg_p2p_chunk_queue_next(buzzvm_t vm){
 /****************************************/
 /****************************************/
 void buzzoutmsg_chunk_queue_next(buzzvm_t vm){
-   if(!buzzdarray_isempty(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT])) {
+   if(!buzzqueue_isempty(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT])) {
       /* Take the first message in the queue */
-      buzzoutmsg_t f = buzzdarray_get(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT],
+      buzzoutmsg_t f = buzzqueue_get(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT],
                                       0, buzzoutmsg_t);
       
       /* Remove the element in the bstig dictionary */
@@ -1842,7 +2133,7 @@ void buzzoutmsg_chunk_queue_next(buzzvm_t vm){
             *buzzdict_get(*buzzdict_get(vm->outmsgs->chunkbstig, &(f->bsc.id), buzzdict_t)
             , &(f->bsc.key->i.value), buzzdict_t), &f->bsc.chunk_index);
       /* Remove the first message in the queue */
-      buzzdarray_remove(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT], 0);
+      buzzqueue_pop(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT]);
    }
 
 }
@@ -1858,8 +2149,8 @@ buzzmsg_payload_t buzzoutmsg_p2p_chunk_receiver_queue_first(buzzvm_t vm, uint16_
                                       0, buzzoutmsg_t);
 
       if(f->type == BUZZMSG_BSTIG_CHUNK_PUT_P2P){
-         /* Make a new message */
-         buzzmsg_payload_t m = buzzmsg_payload_new(10);
+         /* Make a new message, sized for the chunk bytes */
+         buzzmsg_payload_t m = buzzmsg_payload_new(BUZZOUTMSG_CHUNK_HEADER_SIZE + f->bsc.cdata->size);
          buzzmsg_serialize_u8(m, BUZZMSG_BSTIG_CHUNK_PUT);
          buzzmsg_serialize_u32(m, f->bsc.blob_size);   
          buzzmsg_serialize_u16(m, f->bsc.id);
@@ -1872,10 +2163,7 @@ buzzmsg_payload_t buzzoutmsg_p2p_chunk_receiver_queue_first(buzzvm_t vm, uint16_
       else if(f->type == BUZZMSG_BSTIG_BLOB_REQUEST){
          /* Make a new message */
          buzzmsg_payload_t m = buzzmsg_payload_new(10);
-         buzzmsg_serialize_u8(m,  BUZZMSG_BSTIG_BLOB_REQUEST);
-         buzzmsg_serialize_u16(m, f->brm.id);   
-         buzzmsg_serialize_u16(m, f->brm.key);
-         buzzmsg_serialize_u16(m, f->brm.sender);
+         buzzoutmsg_encode_blob_request(m, f);
          /* Return message */
          return m;
       }
@@ -1919,8 +2207,8 @@ void buzzoutmsg_p2p_chunk_receiver_queue_next(buzzvm_t vm, uint16_t receiver){
       buzzoutmsg_t f = buzzdarray_get(rq,
                                       0, buzzoutmsg_t);
       if(f->type == BUZZMSG_BSTIG_CHUNK_PUT_P2P){
-         uint32_t index = buzzdarray_find(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P],buzzoutmsg_bstig_cmp, &f);
-         buzzdarray_remove(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P], index);
+         uint32_t index = buzzqueue_find(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P],buzzoutmsg_bstig_cmp, &f);
+         buzzqueue_remove(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P], index);
          /* Remove the first message in the receiver queue */
          buzzdarray_remove(rq, 0);
       }
@@ -1929,15 +2217,15 @@ void buzzoutmsg_p2p_chunk_receiver_queue_next(buzzvm_t vm, uint16_t receiver){
          uint32_t index = buzzdarray_find(vm->outmsgs->bstigrecon,buzzoutmsg_bstig_cmp, &f);
          buzzdarray_remove(vm->outmsgs->bstigrecon, index);
          /* Remove it from the p2p queue */
-         index = buzzdarray_find(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P],buzzoutmsg_bstig_cmp, &f);
-         buzzdarray_remove(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P], index);
+         index = buzzqueue_find(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P],buzzoutmsg_bstig_cmp, &f);
+         buzzqueue_remove(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P], index);
          /* Remove the first message in the receiver queue */
          buzzdarray_remove(rq, 0);
       }
       else if(f->type == BUZZMSG_BSTIG_BLOB_BID){
          /* Remove it from the p2p queue */
-         uint32_t index = buzzdarray_find(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P],buzzoutmsg_bstig_cmp, &f);
-         buzzdarray_remove(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P], index);
+         uint32_t index = buzzqueue_find(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P],buzzoutmsg_bstig_cmp, &f);
+         buzzqueue_remove(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P], index);
          /* Remove the first message in the receiver queue */
          buzzdarray_remove(rq, 0);
       }
@@ -1976,30 +2264,30 @@ void buzzoutmsg_p2p_mark(uint32_t pos, void* data, void* params) {
 
 void buzzoutmsg_gc(struct buzzvm_s* vm) {
    /* Go through all the broadcast topic strings and mark them */
-   buzzdarray_foreach(vm->outmsgs->queues[BUZZMSG_BROADCAST],
+   buzzqueue_foreach(vm->outmsgs->queues[BUZZMSG_BROADCAST],
                       buzzoutmsg_broadcast_mark,
                       vm);
    /* Go through all the vstig keys and values and mark them */
-   buzzdarray_foreach(vm->outmsgs->queues[BUZZMSG_VSTIG_PUT],
+   buzzqueue_foreach(vm->outmsgs->queues[BUZZMSG_VSTIG_PUT],
                       buzzoutmsg_vstig_mark,
                       vm);
-   buzzdarray_foreach(vm->outmsgs->queues[BUZZMSG_VSTIG_QUERY],
+   buzzqueue_foreach(vm->outmsgs->queues[BUZZMSG_VSTIG_QUERY],
                       buzzoutmsg_vstig_mark,
                       vm);
    /* Go through all the bstig keys and values and mark them */
-   buzzdarray_foreach(vm->outmsgs->queues[BUZZMSG_BSTIG_PUT],
+   buzzqueue_foreach(vm->outmsgs->queues[BUZZMSG_BSTIG_PUT],
                       buzzoutmsg_bstig_mark,
                       vm);
-   buzzdarray_foreach(vm->outmsgs->queues[BUZZMSG_BSTIG_QUERY],
+   buzzqueue_foreach(vm->outmsgs->queues[BUZZMSG_BSTIG_QUERY],
                       buzzoutmsg_bstig_mark,
                       vm);
-    buzzdarray_foreach(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_QUERY],
+    buzzqueue_foreach(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_QUERY],
                       buzzoutmsg_bstig_mark,
                       vm);
-   buzzdarray_foreach(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT],
+   buzzqueue_foreach(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT],
                       buzzoutmsg_bstig_mark,
                       vm);
-   buzzdarray_foreach(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P],
+   buzzqueue_foreach(vm->outmsgs->queues[BUZZMSG_BSTIG_CHUNK_PUT_P2P],
                       buzzoutmsg_p2p_mark,
                       vm);
    }
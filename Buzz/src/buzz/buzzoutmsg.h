@@ -2,6 +2,7 @@
 #define BUZZOUTMSG_H
 
 #include <buzz/buzzdarray.h>
+#include <buzz/buzzqueue.h>
 #include <buzz/buzzmsg.h>
 #include <buzz/buzzbstig.h>
 #include <buzz/buzzvstig.h>
@@ -10,16 +11,65 @@ struct buzzvm_s;
 
 # define MAX_TIME_TO_REMOVE_FLOODING_PROTECTION 500
 
+/*
+ * Number of out-message queues.
+ * Blob requests come after BUZZMSG_TYPE_COUNT in the type enum, but
+ * broadcast blob requests have a queue of their own.
+ */
+#define BUZZOUTMSG_TYPE_COUNT (BUZZMSG_BSTIG_BLOB_REQUEST + 1)
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+   /*
+    * Latency counters of a message type.
+    * Waits are counted in calls to buzzvm_process_outmsgs(), that is,
+    * in control steps.
+    */
+   struct buzzoutmsg_stats_s {
+      /* Messages sent */
+      uint64_t sent;
+      /* Sum of the waits of the sent messages */
+      uint64_t wait_total;
+      /* Longest wait of a sent message */
+      uint32_t wait_max;
+   };
+
+   /*
+    * State of the scheduler that picks which queue feeds the next
+    * frame slot. It runs deficit round robin over the queues: each
+    * turn, a non-empty queue earns its weight in credits and spends
+    * one per message sent. A message that waited more than max_wait
+    * steps is sent first.
+    */
+   struct buzzoutmsg_sched_s {
+      /* Credits earned per turn, for each message type */
+      uint16_t weight[BUZZOUTMSG_TYPE_COUNT];
+      /* Credits left, for each message type */
+      int32_t deficit[BUZZOUTMSG_TYPE_COUNT];
+      /* Latency counters, for each message type */
+      struct buzzoutmsg_stats_s stats[BUZZOUTMSG_TYPE_COUNT];
+      /* Wait after which a message is sent first; 0 disables aging */
+      uint32_t max_wait;
+      /* Current step */
+      uint32_t now;
+      /* Queue chosen for the next message, or -1 */
+      int cur;
+      /* Whether cur was chosen by aging */
+      uint8_t aged;
+      /* Position in the round robin */
+      uint8_t rr;
+      /* Whether the queue at rr has earned its credits this turn */
+      uint8_t granted;
+   };
+
    /*
     * Data of a Buzz message queue.
     */
    struct buzzoutmsg_queue_s {
-      /* One queue for each message type */
-      buzzdarray_t queues[BUZZMSG_TYPE_COUNT];
+      /* One queue for each message type, indexed by type */
+      buzzqueue_t queues[BUZZOUTMSG_TYPE_COUNT];
       /* Vstig and bstig message dict for fast duplicate management */
       buzzdict_t vstig;
       buzzdict_t bstig;
@@ -35,6 +85,8 @@ extern "C" {
       buzzdict_t chunkp2p;
       /* Blob reconstruction duplicate management */
       buzzdarray_t bstigrecon;
+      /* Scheduler across the queues */
+      struct buzzoutmsg_sched_s sched;
    };
    typedef struct buzzoutmsg_queue_s* buzzoutmsg_queue_t;
 
@@ -50,6 +102,56 @@ extern "C" {
     */
    extern void buzzoutmsg_queue_destroy(buzzoutmsg_queue_t* msgq);
 
+   /*
+    * Registers the "msgsched" table, which lets scripts tune the
+    * scheduler and read its counters.
+    * @param vm The Buzz VM.
+    * @return The VM state.
+    */
+   extern int buzzoutmsg_register(struct buzzvm_s* vm);
+
+   /*
+    * Returns the message type with the given name.
+    * The names are the lowercase message types without the BUZZMSG_
+    * prefix, e.g., "broadcast", "bstig_status" or "blob_bid".
+    * @param name The name.
+    * @return The message type, or -1 if the name is unknown.
+    */
+   extern int buzzoutmsg_sched_type(const char* name);
+
+   /*
+    * Returns the name of a message type.
+    * @param type The message type.
+    * @return The name, or NULL if the type is invalid.
+    * @see buzzoutmsg_sched_type
+    */
+   extern const char* buzzoutmsg_sched_type_name(int type);
+
+   /*
+    * Sets the weight of a message type in the scheduler.
+    * @param vm The Buzz VM.
+    * @param type The message type.
+    * @param weight The weight. A weight of 0 is raised to 1.
+    */
+   extern void buzzoutmsg_sched_set_weight(struct buzzvm_s* vm,
+                                           int type,
+                                           uint16_t weight);
+
+   /*
+    * Sets the wait after which a message is sent first.
+    * @param vm The Buzz VM.
+    * @param steps The wait in steps, 0 to disable aging.
+    */
+   extern void buzzoutmsg_sched_set_max_wait(struct buzzvm_s* vm,
+                                             uint32_t steps);
+
+   /*
+    * Advances the scheduler clock by one step.
+    * Called by buzzvm_process_outmsgs().
+    * @param vm The Buzz VM.
+    */
+   extern void buzzoutmsg_sched_tick(struct buzzvm_s* vm);
+
    /*
     * Returns the size of a message queue.
     * @param vm The Buzz VM.
@@ -156,12 +258,23 @@ extern "C" {
                                    const buzzblob_chunk_t cdata,
                                    uint16_t receiver);
 
+   /*
+    * Appends a new blob status message.
+    * @param vm The Buzz VM.
+    * @param type The message type (BUZZMSG_BSTIG_STATUS)
+    * @param id The id of the blob stigmergy.
+    * @param key The key of the blob.
+    * @param status The new status of the blob.
+    * @param requester The robot requesting the status change.
+    * @param have The chunks the requester already holds, or NULL if unknown.
+    */
    extern void buzzoutmsg_queue_append_blob_status(struct buzzvm_s* vm,
                                    int type,
                                    uint16_t id,
                                    uint16_t key,
                                    uint8_t  status,
-                                   uint16_t requester);
+                                   uint16_t requester,
+                                   const buzzbitset_t have);
 
    extern int buzzoutmsg_check_chunk_put_msg(struct buzzvm_s* vm,
                                             uint16_t id, 
@@ -177,12 +290,30 @@ extern "C" {
                                          uint8_t subtype,
                                          uint16_t  msg);
 
+   /*
+    * Appends a request for the chunks of a blob.
+    * With BROADCAST_MESSAGE_CONSTANT as receiver, one message asks every
+    * holder in range; a queued broadcast request for the same blob is
+    * replaced.
+    * @param vm The Buzz VM.
+    * @param type The message type (BUZZMSG_BSTIG_BLOB_REQUEST)
+    * @param id The id of the blob stigmergy.
+    * @param key The key of the blob.
+    * @param receiver The holder asked, or BROADCAST_MESSAGE_CONSTANT.
+    * @param sender The robot the chunks go to.
+    * @param first The first chunk index covered by want.
+    * @param count The number of chunk indices covered by want, 0 for all chunks.
+    * @param want Bitmap of the wanted chunks from first on, copied.
+    */
    extern void buzzoutmsg_queue_append_blob_request(struct buzzvm_s* vm,
                                                      int type,
                                                      uint16_t id,
                                                      uint16_t key,
                                                      uint16_t receiver,
-                                                     uint16_t sender);
+                                                     uint16_t sender,
+                                                     uint16_t first,
+                                                     uint16_t count,
+                                                     const uint8_t* want);
 
    extern void buzzoutmsg_queue_append_chunk_removal(struct buzzvm_s* vm,
                                          uint8_t type,
@@ -204,9 +335,18 @@ extern "C" {
    extern void buzzoutmsg_remove_chunk_put_msg(struct buzzvm_s* vm,
                                               uint16_t id,
                                               uint16_t key);
-   extern void buzzoutmsg_update_antiflooding_entry(struct buzzvm_s* vm);
+   /*
+    * Handles the timeout of an anti-flooding entry.
+    * The entry is removed, unless its message is still queued.
+    * @param vm The Buzz VM data.
+    * @param m The message of the entry.
+    * @return 1 if the entry was removed, 0 otherwise.
+    */
+   extern int buzzoutmsg_antiflooding_timeout(struct buzzvm_s* vm, void* m);
    /*
     * Returns the first serialized message in the queue.
+    * The message comes from the queue chosen by the scheduler. The
+    * choice holds until buzzoutmsg_queue_next() is called.
     * You are in charge of freeing both the message data and the payload.
     * @param vm The Buzz VM.
     * @return The message data or NULL.
@@ -215,7 +355,19 @@ extern "C" {
    extern buzzmsg_payload_t buzzoutmsg_queue_first(struct buzzvm_s* vm);
 
    /*
-    * Removes the first message from the queue.
+    * Returns the first serialized message in the queue, without copying it.
+    * Same as buzzoutmsg_queue_first(), but the payload belongs to the
+    * queued message: it stays valid until buzzoutmsg_queue_next() is
+    * called and must not be destroyed.
+    * @param vm The Buzz VM.
+    * @return The message data or NULL.
+    * @see buzzoutmsg_queue_first
+    */
+   extern buzzmsg_payload_t buzzoutmsg_queue_peek(struct buzzvm_s* vm);
+
+   /*
+    * Removes the message returned by buzzoutmsg_queue_first() and
+    * updates the scheduler counters.
     * @param vm The Buzz VM.
     * @see buzzoutmsg_queue_first
     */
@@ -230,6 +382,17 @@ extern "C" {
     */
    extern buzzmsg_payload_t buzzoutmsg_chunk_queue_first(struct buzzvm_s* vm);
 
+   /*
+    * Returns the first serialized chunk message in the queue, without
+    * copying it. The payload belongs to the queued message: it stays
+    * valid until buzzoutmsg_chunk_queue_next() is called and must not
+    * be destroyed.
+    * @param vm The Buzz VM.
+    * @return The message data or NULL.
+    * @see buzzoutmsg_chunk_queue_first
+    */
+   extern buzzmsg_payload_t buzzoutmsg_chunk_queue_peek(struct buzzvm_s* vm);
+
    extern buzzp2poutmsg_payload_t buzzoutmsg_p2p_chunk_queue_first(struct buzzvm_s* vm);
 
    extern void buzzoutmsg_p2p_chunk_queue_next(struct buzzvm_s* vm);
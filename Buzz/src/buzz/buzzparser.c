@@ -155,8 +155,6 @@ void sym_destroy(const void* key,
                 void* data,
                 void* params) {
    free(*(char**)key);
-   free((void*)key);
-   free(data);
 }
 
 #define SYMT_BUCKETS 100
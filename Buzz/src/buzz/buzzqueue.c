@@ -0,0 +1,186 @@
+#include "buzzqueue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/****************************************/
+/****************************************/
+
+/* Smallest capacity the queue ever shrinks to */
+#define BUZZQUEUE_MIN_CAPACITY 8
+
+void buzzqueue_elem_destroy(uint32_t pos, void* data, void* params) {}
+
+/*
+ * Moves the elements into a buffer of the given capacity. The
+ * elements end up unwrapped, starting at index 0.
+ */
+static void buzzqueue_setcap(buzzqueue_t q,
+                             uint32_t cap) {
+   void* nd = malloc((size_t)cap * q->elem_size);
+   if(!nd) {
+      fprintf(stderr, "[FATAL] Can't reallocate queue.\n");
+      abort();
+   }
+   if(q->size > 0) {
+      /* Copy the part from head to the end of the buffer, then the wrapped part */
+      uint32_t n1 = q->capacity - q->head;
+      if(n1 > q->size) n1 = q->size;
+      memcpy(nd,
+             (uint8_t*)q->data + (size_t)q->head * q->elem_size,
+             (size_t)n1 * q->elem_size);
+      memcpy((uint8_t*)nd + (size_t)n1 * q->elem_size,
+             q->data,
+             (size_t)(q->size - n1) * q->elem_size);
+   }
+   free(q->data);
+   q->data = nd;
+   q->capacity = cap;
+   q->head = 0;
+}
+
+/*
+ * Halves the capacity when the queue is mostly empty.
+ */
+static void buzzqueue_shrink(buzzqueue_t q) {
+   if(q->capacity > BUZZQUEUE_MIN_CAPACITY &&
+      q->size <= q->capacity / 4)
+      buzzqueue_setcap(q, q->capacity / 2);
+}
+
+/****************************************/
+/****************************************/
+
+buzzqueue_t buzzqueue_new(uint32_t cap,
+                          uint32_t elem_size,
+                          buzzdarray_elem_funp elem_destroy) {
+   if(cap == 0) {
+      fprintf(stderr, "[FATAL] Can't initialize a queue with zero capacity.");
+      abort();
+   }
+   /* Create the queue. calloc() zeroes everything. */
+   buzzqueue_t q = (buzzqueue_t)calloc(1, sizeof(struct buzzqueue_s));
+   /* Set info */
+   q->elem_size = elem_size;
+   q->elem_destroy = elem_destroy ? elem_destroy : buzzqueue_elem_destroy;
+   /* Round the capacity up to a power of two */
+   q->capacity = BUZZQUEUE_MIN_CAPACITY;
+   while(q->capacity < cap) q->capacity *= 2;
+   q->data = malloc((size_t)q->capacity * elem_size);
+   /* Done */
+   return q;
+}
+
+/****************************************/
+/****************************************/
+
+void buzzqueue_destroy(buzzqueue_t* q) {
+   /* Get rid of every element */
+   buzzqueue_foreach(*q, (*q)->elem_destroy, NULL);
+   /* Get rid of the rest */
+   free((*q)->data);
+   free(*q);
+   /* Set q to NULL */
+   *q = NULL;
+}
+
+/****************************************/
+/****************************************/
+
+void buzzqueue_push(buzzqueue_t q,
+                    const void* data) {
+   if(q->size == q->capacity) buzzqueue_setcap(q, q->capacity * 2);
+   ++(q->size);
+   memcpy(buzzqueue_rawget(q, q->size - 1), data, q->elem_size);
+}
+
+/****************************************/
+/****************************************/
+
+void buzzqueue_push_front(buzzqueue_t q,
+                          const void* data) {
+   if(q->size == q->capacity) buzzqueue_setcap(q, q->capacity * 2);
+   q->head = (q->head + q->capacity - 1) & (q->capacity - 1);
+   ++(q->size);
+   memcpy(buzzqueue_rawget(q, 0), data, q->elem_size);
+}
+
+/****************************************/
+/****************************************/
+
+void buzzqueue_pop(buzzqueue_t q) {
+   if(buzzqueue_isempty(q)) return;
+   q->elem_destroy(0, buzzqueue_rawget(q, 0), NULL);
+   q->head = (q->head + 1) & (q->capacity - 1);
+   --(q->size);
+   if(q->size == 0) q->head = 0;
+   buzzqueue_shrink(q);
+}
+
+/****************************************/
+/****************************************/
+
+void buzzqueue_remove(buzzqueue_t q,
+                      uint32_t pos) {
+   /* Can't remove elements past the size */
+   if(pos >= buzzqueue_size(q)) return;
+   /* Destroy element */
+   q->elem_destroy(pos, buzzqueue_rawget(q, pos), NULL);
+   uint32_t i;
+   if(pos < q->size / 2) {
+      /* Closer to the front: move the preceding elements one spot right */
+      for(i = pos; i > 0; --i)
+         memcpy(buzzqueue_rawget(q, i), buzzqueue_rawget(q, i-1), q->elem_size);
+      q->head = (q->head + 1) & (q->capacity - 1);
+   }
+   else {
+      /* Closer to the back: move the following elements one spot left */
+      for(i = pos; i + 1 < q->size; ++i)
+         memcpy(buzzqueue_rawget(q, i), buzzqueue_rawget(q, i+1), q->elem_size);
+   }
+   --(q->size);
+   if(q->size == 0) q->head = 0;
+   buzzqueue_shrink(q);
+}
+
+/****************************************/
+/****************************************/
+
+void buzzqueue_clear(buzzqueue_t q) {
+   /* Get rid of every element */
+   buzzqueue_foreach(q, q->elem_destroy, NULL);
+   /* Zero the size and go back to the minimum capacity */
+   q->size = 0;
+   q->head = 0;
+   if(q->capacity > BUZZQUEUE_MIN_CAPACITY)
+      buzzqueue_setcap(q, BUZZQUEUE_MIN_CAPACITY);
+}
+
+/****************************************/
+/****************************************/
+
+void buzzqueue_foreach(buzzqueue_t q,
+                       buzzdarray_elem_funp fun,
+                       void* params) {
+   uint32_t i;
+   for(i = 0; i < buzzqueue_size(q); ++i) {
+      fun(i, buzzqueue_rawget(q, i), params);
+   }
+}
+
+/****************************************/
+/****************************************/
+
+uint32_t buzzqueue_find(buzzqueue_t q,
+                        buzzdarray_elem_cmpp cmp,
+                        const void* data) {
+   uint32_t i;
+   for(i = 0; i < buzzqueue_size(q); ++i) {
+      if(cmp(data, buzzqueue_rawget(q, i)) == 0)
+         return i;
+   }
+   return buzzqueue_size(q);
+}
+
+/****************************************/
+/****************************************/
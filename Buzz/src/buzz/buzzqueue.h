@@ -0,0 +1,151 @@
+#ifndef BUZZQUEUE_H
+#define BUZZQUEUE_H
+
+#include <buzz/buzzdarray.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+   /*
+    * Buzz queue data.
+    * The queue is a growable ring buffer: pushing at either end and
+    * popping the first element take constant time. The capacity is
+    * always a power of two, so positions wrap around with a mask.
+    * Element functions have the same signatures as for buzzdarray.
+    */
+   struct buzzqueue_s {
+      void* data;
+      int64_t size;
+      uint32_t elem_size;
+      uint32_t capacity;
+      uint32_t head;
+      buzzdarray_elem_funp elem_destroy;
+   };
+   typedef struct buzzqueue_s* buzzqueue_t;
+
+   /*
+    * Creates a new Buzz queue.
+    * @param cap The initial capacity of the queue. Must be >0.
+    * @param elem_size The size of an element.
+    * @param elem_destroy The function to destroy an element. Can be NULL.
+    * @return A new queue.
+    */
+   extern buzzqueue_t buzzqueue_new(uint32_t cap,
+                                    uint32_t elem_size,
+                                    buzzdarray_elem_funp elem_destroy);
+
+   /*
+    * Destroys a queue.
+    * Internally calls q.elem_destroy(), if not NULL.
+    * @param q The queue.
+    */
+   extern void buzzqueue_destroy(buzzqueue_t* q);
+
+   /*
+    * Appends an element at the end of the queue.
+    * The pointed data is copied into the queue.
+    * @param q The queue.
+    * @param data A pointer to the element to add.
+    */
+   extern void buzzqueue_push(buzzqueue_t q,
+                              const void* data);
+
+   /*
+    * Adds an element at the front of the queue.
+    * The pointed data is copied into the queue.
+    * @param q The queue.
+    * @param data A pointer to the element to add.
+    */
+   extern void buzzqueue_push_front(buzzqueue_t q,
+                                    const void* data);
+
+   /*
+    * Removes the first element of the queue.
+    * @param q The queue.
+    */
+   extern void buzzqueue_pop(buzzqueue_t q);
+
+   /*
+    * Removes the element at the given position.
+    * The elements on the shorter side of the position are moved,
+    * so removing close to either end is cheap.
+    * @param q The queue.
+    * @param pos The position.
+    */
+   extern void buzzqueue_remove(buzzqueue_t q,
+                                uint32_t pos);
+
+   /*
+    * Erases all the elements of the queue.
+    * @param q The queue.
+    */
+   extern void buzzqueue_clear(buzzqueue_t q);
+
+   /*
+    * Applies a function to each element of the queue, front to back.
+    * @param q The queue.
+    * @param fun The function to apply to each element.
+    * @param params A data structure to pass along.
+    */
+   extern void buzzqueue_foreach(buzzqueue_t q,
+                                 buzzdarray_elem_funp fun,
+                                 void* params);
+
+   /*
+    * Finds the position of an element.
+    * If the element is not found, the returned position
+    * is equal to the queue size.
+    * @param q The queue.
+    * @param cmp The element comparison function.
+    * @param data The element to find.
+    * @return The position of the found element, or q.size if not found.
+    */
+   extern uint32_t buzzqueue_find(buzzqueue_t q,
+                                  buzzdarray_elem_cmpp cmp,
+                                  const void* data);
+
+#ifdef __cplusplus
+}
+#endif
+
+/*
+ * Returns a pointer to the slot of the element at the given position.
+ * @param q The queue.
+ * @param pos The position, counted from the front of the queue.
+ * @return A pointer to the slot.
+ */
+#define buzzqueue_rawget(q, pos) ((uint8_t*)(q)->data + (((q)->head + (pos)) & ((q)->capacity - 1)) * (q)->elem_size)
+
+/*
+ * Returns the element at the given position.
+ * @param q The queue.
+ * @param pos The position, counted from the front of the queue.
+ * @param type The type of the element to return.
+ * @return The element at the given position.
+ */
+#define buzzqueue_get(q, pos, type) (*((const type*)buzzqueue_rawget(q, pos)))
+
+/*
+ * Returns the first element of the queue.
+ * @param q The queue.
+ * @param type The type of the element to return.
+ * @return The first element of the queue.
+ */
+#define buzzqueue_first(q, type) buzzqueue_get(q, 0, type)
+
+/*
+ * Returns the size of the queue.
+ * @param q The queue.
+ * @return The size of the queue.
+ */
+#define buzzqueue_size(q) (q)->size
+
+/*
+ * Returns <tt>true</tt> if the queue is empty.
+ * @param q The queue.
+ * @return <tt>true</tt> if the queue is empty.
+ */
+#define buzzqueue_isempty(q) (buzzqueue_size(q) == 0)
+
+#endif
@@ -0,0 +1,160 @@
+#include "buzzrs.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* GF(256) reduction polynomial, x^8 + x^4 + x^3 + x^2 + 1 */
+#define BUZZRS_POLY 0x11D
+
+static uint8_t buzzrs_exp[512];
+static uint8_t buzzrs_log[256];
+/* Products of every pair of field elements */
+static uint8_t buzzrs_multab[256][256];
+/* VMs may run on several threads: the tables are built once */
+static pthread_once_t buzzrs_tables_once = PTHREAD_ONCE_INIT;
+
+static void buzzrs_tables_init() {
+   uint32_t x = 1;
+   for(uint32_t i = 0; i < 255; ++i) {
+      buzzrs_exp[i] = x;
+      buzzrs_log[x] = i;
+      x <<= 1;
+      if(x & 0x100) x ^= BUZZRS_POLY;
+   }
+   /* Doubled, so that the sum of two logs needs no modulo */
+   for(uint32_t i = 255; i < 512; ++i)
+      buzzrs_exp[i] = buzzrs_exp[i - 255];
+   for(uint32_t a = 1; a < 256; ++a)
+      for(uint32_t b = 1; b < 256; ++b)
+         buzzrs_multab[a][b] = buzzrs_exp[buzzrs_log[a] + buzzrs_log[b]];
+}
+
+static uint8_t buzzrs_mul(uint8_t a, uint8_t b) {
+   return buzzrs_multab[a][b];
+}
+
+static uint8_t buzzrs_inv(uint8_t a) {
+   return buzzrs_exp[255 - buzzrs_log[a]];
+}
+
+/* Adds c times src to dst */
+static void buzzrs_muladd(uint8_t* dst,
+                          const uint8_t* src,
+                          uint8_t c,
+                          uint32_t size) {
+   if(c == 0) return;
+   if(c == 1) {
+      for(uint32_t i = 0; i < size; ++i) dst[i] ^= src[i];
+      return;
+   }
+   const uint8_t* t = buzzrs_multab[c];
+   for(uint32_t i = 0; i < size; ++i) dst[i] ^= t[src[i]];
+}
+
+/*
+ * Writes the coefficients giving a piece from the data pieces.
+ * Parity rows form a Cauchy matrix, 1 / (x_p + y_j) with x_p = k + p
+ * and y_j = j, so any k rows of the code are independent.
+ */
+static void buzzrs_row(uint16_t k,
+                       uint16_t piece,
+                       uint8_t* row) {
+   if(piece < k) {
+      memset(row, 0, k);
+      row[piece] = 1;
+      return;
+   }
+   for(uint16_t j = 0; j < k; ++j)
+      row[j] = buzzrs_inv(piece ^ j);
+}
+
+static void* buzzrs_alloc(uint32_t size) {
+   void* p = malloc(size);
+   if(!p) {
+      fprintf(stderr, "[FATAL] Can't allocate Reed-Solomon matrix of %u bytes.\n", size);
+      abort();
+   }
+   return p;
+}
+
+/****************************************/
+/****************************************/
+
+void buzzrs_encode(uint16_t k,
+                   uint16_t m,
+                   const uint8_t* const* data,
+                   uint8_t* const* parity,
+                   uint32_t size) {
+   pthread_once(&buzzrs_tables_once, buzzrs_tables_init);
+   uint8_t row[BUZZRS_MAXPIECES];
+   for(uint16_t p = 0; p < m; ++p) {
+      buzzrs_row(k, k + p, row);
+      memset(parity[p], 0, size);
+      for(uint16_t j = 0; j < k; ++j)
+         buzzrs_muladd(parity[p], data[j], row[j], size);
+   }
+}
+
+/****************************************/
+/****************************************/
+
+int buzzrs_decode(uint16_t k,
+                  uint16_t m,
+                  const uint8_t* const* pieces,
+                  uint8_t* const* data,
+                  uint32_t size) {
+   pthread_once(&buzzrs_tables_once, buzzrs_tables_init);
+   /* Pick k pieces, data pieces first as their rows are trivial */
+   uint16_t rows[BUZZRS_MAXPIECES];
+   uint16_t n = 0;
+   for(uint16_t i = 0; i < k + m && n < k; ++i)
+      if(pieces[i]) rows[n++] = i;
+   if(n < k) return 0;
+   /* All data pieces are there, nothing to rebuild */
+   if(rows[k - 1] == k - 1) return 1;
+   /* Invert the matrix of the picked pieces by Gauss-Jordan elimination */
+   uint8_t* a = (uint8_t*)buzzrs_alloc(k * k);
+   uint8_t* b = (uint8_t*)buzzrs_alloc(k * k);
+   memset(b, 0, k * k);
+   for(uint16_t r = 0; r < k; ++r) {
+      buzzrs_row(k, rows[r], a + r * k);
+      b[r * k + r] = 1;
+   }
+   uint8_t tmp[BUZZRS_MAXPIECES];
+   for(uint16_t c = 0; c < k; ++c) {
+      /* Any k rows are independent, so there is always a pivot */
+      uint16_t r = c;
+      while(!a[r * k + c]) ++r;
+      if(r != c) {
+         memcpy(tmp, a + r * k, k); memcpy(a + r * k, a + c * k, k); memcpy(a + c * k, tmp, k);
+         memcpy(tmp, b + r * k, k); memcpy(b + r * k, b + c * k, k); memcpy(b + c * k, tmp, k);
+      }
+      uint8_t s = buzzrs_inv(a[c * k + c]);
+      for(uint16_t j = 0; j < k; ++j) {
+         a[c * k + j] = buzzrs_mul(a[c * k + j], s);
+         b[c * k + j] = buzzrs_mul(b[c * k + j], s);
+      }
+      for(r = 0; r < k; ++r) {
+         uint8_t f = a[r * k + c];
+         if(r == c || !f) continue;
+         for(uint16_t j = 0; j < k; ++j) {
+            a[r * k + j] ^= buzzrs_mul(f, a[c * k + j]);
+            b[r * k + j] ^= buzzrs_mul(f, b[c * k + j]);
+         }
+      }
+   }
+   /* Each missing data piece is a row of the inverse times the picked pieces */
+   for(uint16_t i = 0; i < k; ++i) {
+      if(pieces[i]) continue;
+      memset(data[i], 0, size);
+      for(uint16_t r = 0; r < k; ++r)
+         buzzrs_muladd(data[i], pieces[rows[r]], b[i * k + r], size);
+   }
+   free(a);
+   free(b);
+   return 1;
+}
+
+/****************************************/
+/****************************************/
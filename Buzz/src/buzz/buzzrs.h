@@ -0,0 +1,50 @@
+#ifndef BUZZRS_H
+#define BUZZRS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+   /*
+    * Largest number of pieces, data and parity together, of a code.
+    */
+#define BUZZRS_MAXPIECES 256
+
+   /*
+    * Computes the parity pieces of a systematic Reed-Solomon code over
+    * GF(256). Piece i < k is data piece i as is; piece k + p is parity
+    * piece p. Any k of the k + m pieces give back the data.
+    * @param k The number of data pieces.
+    * @param m The number of parity pieces, k + m <= BUZZRS_MAXPIECES.
+    * @param data The k data pieces.
+    * @param parity The m output parity pieces.
+    * @param size The number of bytes of every piece.
+    */
+   extern void buzzrs_encode(uint16_t k,
+                             uint16_t m,
+                             const uint8_t* const* data,
+                             uint8_t* const* parity,
+                             uint32_t size);
+
+   /*
+    * Rebuilds the missing data pieces of a code.
+    * @param k The number of data pieces.
+    * @param m The number of parity pieces.
+    * @param pieces The k + m pieces, NULL for the missing ones.
+    * @param data The k output data pieces; only those missing in pieces are written.
+    * @param size The number of bytes of every piece.
+    * @return 1 on success, 0 if fewer than k pieces are there.
+    */
+   extern int buzzrs_decode(uint16_t k,
+                            uint16_t m,
+                            const uint8_t* const* pieces,
+                            uint8_t* const* data,
+                            uint32_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -4,7 +4,7 @@
 #include <string.h>
 
 void usage(const char* path, int status) {
-   fprintf(stderr, "Usage:\n\t%s [--trace] <file.bo> <file.bdb>\n\n", path);
+   fprintf(stderr, "Usage:\n\t%s [--trace|--profile] <file.bo> <file.bdb>\n\n", path);
    exit(status);
 }
 
@@ -38,6 +38,9 @@ int print(buzzvm_t vm) {
          case BUZZTYPE_USERDATA:
             fprintf(stdout, "[userdata @%p]", o->u.value);
             break;
+         case BUZZTYPE_BLOB:
+            fprintf(stdout, "[blob with %u bytes]", o->b.value.size);
+            break;
          default:
             break;
       }
@@ -53,6 +56,8 @@ int main(int argc, char** argv) {
    char* dbgfname;
    /* Whether or not to show the assembly information */
    int trace = 0;
+   /* Whether or not to show the inline cache profile */
+   int profile = 0;
    /* Parse command line */
    if(argc < 3 || argc > 4) usage(argv[0], 0);
    if(argc == 3) {
@@ -62,11 +67,14 @@ int main(int argc, char** argv) {
    else {
       bcfname = argv[2];
       dbgfname = argv[3];
-      if(strcmp(argv[1], "--trace") != 0) {
+      if(strcmp(argv[1], "--trace") == 0)
+         trace = 1;
+      else if(strcmp(argv[1], "--profile") == 0)
+         profile = 1;
+      else {
          fprintf(stderr, "error: %s: unrecognized option '%s'\n", argv[0], argv[1]);
          usage(argv[0], 1);
       }
-      trace = 1;
    }
    /* Read bytecode and fill in data structure */
    FILE* fd = fopen(bcfname, "rb");
@@ -92,9 +100,12 @@ int main(int argc, char** argv) {
    buzzvm_pushs(vm, buzzvm_string_register(vm, "print", 1));
    buzzvm_pushcc(vm, buzzvm_function_register(vm, print));
    buzzvm_gstore(vm);
-   /* Run byte code */
-   do if(trace) buzzdebug_stack_dump(vm, 1, stdout);
-   while(buzzvm_step(vm) == BUZZVM_STATE_READY);
+   /* Run byte code, one step at a time when tracing */
+   if(trace) {
+      do buzzdebug_stack_dump(vm, 1, stdout);
+      while(buzzvm_step(vm) == BUZZVM_STATE_READY);
+   }
+   else buzzvm_execute_script(vm);
    /* Done running, check final state */
    int retval;
    if(vm->state == BUZZVM_STATE_DONE) {
@@ -124,6 +135,7 @@ int main(int argc, char** argv) {
       }
       retval = 1;
    }
+   if(profile) buzzdebug_profile_dump(vm, stdout);
    /* Destroy VM */
    free(bcode_buf);
    buzzdebug_destroy(&dbg_buf);
@@ -11,7 +11,6 @@ extern "C" {
       buzzdict_t str2id;  /* string -> id data */
       buzzdict_t id2str;  /* id -> string data */
       uint16_t maxsid;    /* maximum string id ever assigned */
-      void* gcdata;       /* pointer to data for garbage collection */
    };
    typedef struct buzzstrman_s* buzzstrman_t;
 
@@ -42,8 +42,6 @@ void buzzswarm_elem_destroy(const void* key, void* data, void* params) {
    buzzswarm_elem_t e = *(buzzswarm_elem_t*)data;
    buzzdarray_destroy(&(e->swarms));
    free(e);
-   free((void*)key);
-   free(data);
 }
 
 /****************************************/
@@ -207,7 +205,7 @@ void buzzswarm_members_print(FILE* stream,
 /****************************************/
 
 /* Maximum age (in steps) for swarm membership to be remembered */
-static int MEMBERSHIP_AGE_MAX = 50;
+static const int MEMBERSHIP_AGE_MAX = 50;
 
 /* Information on element to delete */
 struct buzzswarm_members_todelete_s {
@@ -509,9 +507,7 @@ int buzzswarm_exec(buzzvm_t vm) {
       int32_t numargs = 0;
       buzzvm_pushi(vm, numargs);
       buzzvm_calls(vm);
-      do if(buzzvm_step(vm) != BUZZVM_STATE_READY) return vm->state;
-      while(stacks < buzzdarray_size(vm->stacks));
-      return vm->state;
+      return buzzvm_run(vm, stacks);
    }
    else {
       /* Get rid of the current call structure */
@@ -0,0 +1,250 @@
+#include "buzzswarmrt.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/****************************************/
+/****************************************/
+
+/*
+ * A thread of the pool, with the range of VMs it works on.
+ */
+struct buzzswarm_runtime_worker_s {
+   buzzswarm_runtime_t rt;
+   uint32_t idx;
+   pthread_t thread;
+   /* Range of VM indices left in the current phase, [lo,hi) */
+   pthread_mutex_t lock;
+   uint32_t lo;
+   uint32_t hi;
+   struct buzzswarm_runtime_stats_s stats;
+};
+
+struct buzzswarm_runtime_s {
+   /* The VMs (buzzvm_t) */
+   buzzdarray_t vms;
+   /* The threads, the first one being the caller's */
+   struct buzzswarm_runtime_worker_s* workers;
+   uint32_t nworkers;
+   /* Hooks */
+   buzzswarm_runtime_hook_t prestep;
+   buzzswarm_runtime_hook_t poststep;
+   void* param;
+   /* Barrier */
+   pthread_mutex_t lock;
+   pthread_cond_t cond;
+   uint32_t waiting;
+   uint32_t generation;
+   /* Set to stop the threads */
+   int quit;
+};
+
+/****************************************/
+/****************************************/
+
+/* Splits the VMs into one range per thread */
+static void buzzswarm_runtime_fill(buzzswarm_runtime_t rt) {
+   uint64_t n = buzzdarray_size(rt->vms);
+   for(uint32_t i = 0; i < rt->nworkers; ++i) {
+      rt->workers[i].lo = n * i / rt->nworkers;
+      rt->workers[i].hi = n * (i + 1) / rt->nworkers;
+   }
+}
+
+/*
+ * Waits for all the threads. The last one in sets up the ranges of
+ * the given phase, if any, while all the others are waiting.
+ */
+static void buzzswarm_runtime_barrier(buzzswarm_runtime_t rt, int phase) {
+   pthread_mutex_lock(&rt->lock);
+   if(++rt->waiting == rt->nworkers) {
+      rt->waiting = 0;
+      ++rt->generation;
+      if(phase < BUZZSWARM_RUNTIME_PHASE_COUNT)
+         buzzswarm_runtime_fill(rt);
+      pthread_cond_broadcast(&rt->cond);
+   }
+   else {
+      uint32_t gen = rt->generation;
+      while(gen == rt->generation)
+         pthread_cond_wait(&rt->cond, &rt->lock);
+   }
+   pthread_mutex_unlock(&rt->lock);
+}
+
+/*
+ * Takes the next VM for a thread: first from the front of its own
+ * range, then from the back of the others'.
+ */
+static int buzzswarm_runtime_take(buzzswarm_runtime_t rt,
+                                  struct buzzswarm_runtime_worker_s* w,
+                                  uint32_t* vmidx) {
+   pthread_mutex_lock(&w->lock);
+   if(w->lo < w->hi) {
+      *vmidx = w->lo++;
+      pthread_mutex_unlock(&w->lock);
+      return 1;
+   }
+   pthread_mutex_unlock(&w->lock);
+   for(uint32_t i = 1; i < rt->nworkers; ++i) {
+      struct buzzswarm_runtime_worker_s* v = rt->workers + (w->idx + i) % rt->nworkers;
+      pthread_mutex_lock(&v->lock);
+      if(v->lo < v->hi) {
+         *vmidx = --v->hi;
+         pthread_mutex_unlock(&v->lock);
+         ++w->stats.steals;
+         return 1;
+      }
+      pthread_mutex_unlock(&v->lock);
+   }
+   return 0;
+}
+
+/* Takes VMs through a phase until there are none left */
+static void buzzswarm_runtime_run(buzzswarm_runtime_t rt,
+                                  struct buzzswarm_runtime_worker_s* w,
+                                  int phase) {
+   uint32_t i;
+   while(buzzswarm_runtime_take(rt, w, &i)) {
+      buzzvm_t vm = buzzdarray_get(rt->vms, i, buzzvm_t);
+      switch(phase) {
+         case BUZZSWARM_RUNTIME_INMSG:
+            if(rt->prestep) rt->prestep(vm, rt->param);
+            if(vm->state != BUZZVM_STATE_ERROR)
+               buzzvm_process_inmsgs(vm);
+            break;
+         case BUZZSWARM_RUNTIME_STEP:
+            if(vm->state != BUZZVM_STATE_ERROR)
+               buzzvm_function_call(vm, "step", 0);
+            break;
+         case BUZZSWARM_RUNTIME_OUTMSG:
+            if(vm->state != BUZZVM_STATE_ERROR)
+               buzzvm_process_outmsgs(vm);
+            if(rt->poststep) rt->poststep(vm, rt->param);
+            break;
+      }
+      ++w->stats.runs;
+   }
+}
+
+/* Goes through the phases of a step, then waits for the next step */
+static void buzzswarm_runtime_phases(buzzswarm_runtime_t rt,
+                                     struct buzzswarm_runtime_worker_s* w) {
+   for(int p = 0; p < BUZZSWARM_RUNTIME_PHASE_COUNT; ++p) {
+      buzzswarm_runtime_run(rt, w, p);
+      buzzswarm_runtime_barrier(rt, p + 1);
+   }
+}
+
+static void* buzzswarm_runtime_thread(void* arg) {
+   struct buzzswarm_runtime_worker_s* w = (struct buzzswarm_runtime_worker_s*)arg;
+   buzzswarm_runtime_t rt = w->rt;
+   while(1) {
+      buzzswarm_runtime_barrier(rt, BUZZSWARM_RUNTIME_INMSG);
+      if(rt->quit) break;
+      buzzswarm_runtime_phases(rt, w);
+   }
+   return NULL;
+}
+
+/****************************************/
+/****************************************/
+
+buzzswarm_runtime_t buzzswarm_runtime_new(uint32_t threads) {
+   if(threads == 0) {
+      long n = sysconf(_SC_NPROCESSORS_ONLN);
+      threads = n > 0 ? n : 1;
+   }
+   buzzswarm_runtime_t rt = (buzzswarm_runtime_t)calloc(1, sizeof(struct buzzswarm_runtime_s));
+   rt->vms = buzzdarray_new(16, sizeof(buzzvm_t), NULL);
+   rt->nworkers = threads;
+   rt->workers = (struct buzzswarm_runtime_worker_s*)calloc(threads, sizeof(struct buzzswarm_runtime_worker_s));
+   pthread_mutex_init(&rt->lock, NULL);
+   pthread_cond_init(&rt->cond, NULL);
+   for(uint32_t i = 0; i < threads; ++i) {
+      rt->workers[i].rt = rt;
+      rt->workers[i].idx = i;
+      pthread_mutex_init(&rt->workers[i].lock, NULL);
+   }
+   /* Thread 0 is the caller of buzzswarm_runtime_step() */
+   for(uint32_t i = 1; i < threads; ++i) {
+      if(pthread_create(&rt->workers[i].thread, NULL,
+                        buzzswarm_runtime_thread, rt->workers + i) != 0) {
+         fprintf(stderr, "[FATAL] Can't create runtime thread %u\n", i);
+         abort();
+      }
+   }
+   return rt;
+}
+
+/****************************************/
+/****************************************/
+
+void buzzswarm_runtime_destroy(buzzswarm_runtime_t* rt) {
+   /* Release the threads waiting for a step */
+   (*rt)->quit = 1;
+   buzzswarm_runtime_barrier(*rt, BUZZSWARM_RUNTIME_PHASE_COUNT);
+   for(uint32_t i = 1; i < (*rt)->nworkers; ++i)
+      pthread_join((*rt)->workers[i].thread, NULL);
+   for(uint32_t i = 0; i < (*rt)->nworkers; ++i)
+      pthread_mutex_destroy(&(*rt)->workers[i].lock);
+   pthread_cond_destroy(&(*rt)->cond);
+   pthread_mutex_destroy(&(*rt)->lock);
+   free((*rt)->workers);
+   buzzdarray_destroy(&(*rt)->vms);
+   free(*rt);
+   *rt = NULL;
+}
+
+/****************************************/
+/****************************************/
+
+void buzzswarm_runtime_add(buzzswarm_runtime_t rt,
+                           buzzvm_t vm) {
+   buzzdarray_push(rt->vms, &vm);
+}
+
+/****************************************/
+/****************************************/
+
+void buzzswarm_runtime_set_hooks(buzzswarm_runtime_t rt,
+                                 buzzswarm_runtime_hook_t prestep,
+                                 buzzswarm_runtime_hook_t poststep,
+                                 void* param) {
+   rt->prestep = prestep;
+   rt->poststep = poststep;
+   rt->param = param;
+}
+
+/****************************************/
+/****************************************/
+
+uint32_t buzzswarm_runtime_step(buzzswarm_runtime_t rt) {
+   buzzswarm_runtime_barrier(rt, BUZZSWARM_RUNTIME_INMSG);
+   buzzswarm_runtime_phases(rt, rt->workers);
+   /* The threads are waiting for the next step */
+   uint32_t errors = 0;
+   for(uint32_t i = 0; i < buzzdarray_size(rt->vms); ++i)
+      if(buzzdarray_get(rt->vms, i, buzzvm_t)->state == BUZZVM_STATE_ERROR)
+         ++errors;
+   return errors;
+}
+
+/****************************************/
+/****************************************/
+
+uint32_t buzzswarm_runtime_threads(buzzswarm_runtime_t rt) {
+   return rt->nworkers;
+}
+
+/****************************************/
+/****************************************/
+
+const struct buzzswarm_runtime_stats_s* buzzswarm_runtime_stats(buzzswarm_runtime_t rt,
+                                                                uint32_t thread) {
+   return &rt->workers[thread].stats;
+}
+
+/****************************************/
+/****************************************/
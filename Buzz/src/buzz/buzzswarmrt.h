@@ -0,0 +1,118 @@
+#ifndef BUZZSWARMRT_H
+#define BUZZSWARMRT_H
+
+#include <buzz/buzzvm.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+   /*
+    * Phases of a swarm step.
+    * Every VM goes through a phase before any VM starts the next one.
+    */
+   typedef enum {
+      BUZZSWARM_RUNTIME_INMSG = 0, // Incoming messages are processed
+      BUZZSWARM_RUNTIME_STEP,      // The "step" function is called
+      BUZZSWARM_RUNTIME_OUTMSG,    // Outgoing messages are processed
+      BUZZSWARM_RUNTIME_PHASE_COUNT
+   } buzzswarm_runtime_phase_e;
+
+   /*
+    * Function called on a VM by the runtime.
+    * @param vm The Buzz VM.
+    * @param param The parameter passed when the hook was set.
+    */
+   typedef void (*buzzswarm_runtime_hook_t)(buzzvm_t vm, void* param);
+
+   /*
+    * Runtime stepping a set of VMs on a pool of threads.
+    * The VMs of a phase are split into one range per thread. A thread
+    * takes VMs from the front of its range and, once done, steals from
+    * the back of the ranges of the others.
+    */
+   typedef struct buzzswarm_runtime_s* buzzswarm_runtime_t;
+
+   /*
+    * Per-thread counters of a runtime.
+    */
+   struct buzzswarm_runtime_stats_s {
+      uint64_t runs;   // VMs taken through a phase
+      uint64_t steals; // VMs taken from the range of another thread
+   };
+
+   /*
+    * Creates a new runtime.
+    * The calling thread works as one of the threads of the pool.
+    * @param threads The number of threads, 0 for one per core.
+    * @return A new runtime.
+    */
+   extern buzzswarm_runtime_t buzzswarm_runtime_new(uint32_t threads);
+
+   /*
+    * Destroys a runtime.
+    * The VMs are not destroyed.
+    * @param rt The runtime.
+    */
+   extern void buzzswarm_runtime_destroy(buzzswarm_runtime_t* rt);
+
+   /*
+    * Adds a VM to the runtime.
+    * The VM must be ready to have its "step" function called. From now
+    * on, it must not be touched while buzzswarm_runtime_step() runs.
+    * @param rt The runtime.
+    * @param vm The Buzz VM.
+    */
+   extern void buzzswarm_runtime_add(buzzswarm_runtime_t rt,
+                                     buzzvm_t vm);
+
+   /*
+    * Sets the hooks called around a step.
+    * The pre-step hook is called on each VM in the inmsg phase, right
+    * before its incoming messages are processed: this is the place to
+    * queue messages and update the neighbors. The post-step hook is
+    * called in the outmsg phase, right after the outgoing messages are
+    * processed: this is the place to collect them. A hook only touches
+    * the VM it is passed and the data of that robot; the data of the
+    * other robots may only be read, and only if it is not written in
+    * the same phase.
+    * @param rt The runtime.
+    * @param prestep The pre-step hook, or NULL.
+    * @param poststep The post-step hook, or NULL.
+    * @param param The parameter passed to the hooks.
+    */
+   extern void buzzswarm_runtime_set_hooks(buzzswarm_runtime_t rt,
+                                           buzzswarm_runtime_hook_t prestep,
+                                           buzzswarm_runtime_hook_t poststep,
+                                           void* param);
+
+   /*
+    * Takes every VM through one step.
+    * VMs in an error state are skipped.
+    * @param rt The runtime.
+    * @return The number of VMs in an error state after the step.
+    */
+   extern uint32_t buzzswarm_runtime_step(buzzswarm_runtime_t rt);
+
+   /*
+    * Returns the number of threads of a runtime.
+    * @param rt The runtime.
+    * @return The number of threads.
+    */
+   extern uint32_t buzzswarm_runtime_threads(buzzswarm_runtime_t rt);
+
+   /*
+    * Returns the counters of a thread of the runtime.
+    * Thread 0 is the one calling buzzswarm_runtime_step().
+    * @param rt The runtime.
+    * @param thread The thread index.
+    * @return The counters of the thread.
+    */
+   extern const struct buzzswarm_runtime_stats_s* buzzswarm_runtime_stats(buzzswarm_runtime_t rt,
+                                                                          uint32_t thread);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
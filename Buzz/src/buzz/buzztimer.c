@@ -0,0 +1,122 @@
+#include "buzztimer.h"
+#include <stdlib.h>
+
+#define BUZZTIMER_MASK     (BUZZTIMER_SLOTS - 1)
+#define BUZZTIMER_MAXDELAY ((1u << (BUZZTIMER_SLOTBITS * BUZZTIMER_LEVELS)) - 1)
+
+/****************************************/
+/****************************************/
+
+static void buzztimer_link(buzztimer_t* head,
+                           buzztimer_t t) {
+   t->next = *head;
+   if(t->next) t->next->pprev = &t->next;
+   t->pprev = head;
+   *head = t;
+}
+
+/* Puts a timer in the slot matching its expiry, seen from the next tick */
+static void buzztimer_place(buzztimerwheel_t w,
+                            buzztimer_t t) {
+   uint32_t d = t->expires - (w->now + 1);
+   int l = 0;
+   while(l < BUZZTIMER_LEVELS - 1 &&
+         d >= (1u << (BUZZTIMER_SLOTBITS * (l + 1))))
+      ++l;
+   buzztimer_link(&w->slots[l][(t->expires >> (BUZZTIMER_SLOTBITS * l)) & BUZZTIMER_MASK], t);
+}
+
+/* Moves the timers of a slot down, returns the slot index */
+static uint32_t buzztimer_cascade(buzztimerwheel_t w,
+                                  int level,
+                                  uint32_t tick) {
+   uint32_t idx = (tick >> (BUZZTIMER_SLOTBITS * level)) & BUZZTIMER_MASK;
+   buzztimer_t t = w->slots[level][idx];
+   w->slots[level][idx] = NULL;
+   while(t) {
+      buzztimer_t next = t->next;
+      buzztimer_place(w, t);
+      t = next;
+   }
+   return idx;
+}
+
+/****************************************/
+/****************************************/
+
+buzztimerwheel_t buzztimerwheel_new() {
+   return (buzztimerwheel_t)calloc(1, sizeof(struct buzztimerwheel_s));
+}
+
+/****************************************/
+/****************************************/
+
+void buzztimerwheel_destroy(buzztimerwheel_t* w) {
+   free(*w);
+   *w = NULL;
+}
+
+/****************************************/
+/****************************************/
+
+void buzztimerwheel_tick(buzztimerwheel_t w) {
+   uint32_t tick = w->now + 1;
+   /* At the start of a turn, bring down the next slot of the level above */
+   for(int l = 1; l < BUZZTIMER_LEVELS &&
+          ((tick >> (BUZZTIMER_SLOTBITS * (l - 1))) & BUZZTIMER_MASK) == 0; ++l)
+      buzztimer_cascade(w, l, tick);
+   w->now = tick;
+   /* Append the slot of this tick to the expired list */
+   buzztimer_t* slot = &w->slots[0][tick & BUZZTIMER_MASK];
+   if(!*slot) return;
+   buzztimer_t* tail = &w->expired;
+   while(*tail) tail = &(*tail)->next;
+   *tail = *slot;
+   (*slot)->pprev = tail;
+   *slot = NULL;
+}
+
+/****************************************/
+/****************************************/
+
+buzztimer_t buzztimerwheel_pop(buzztimerwheel_t w) {
+   buzztimer_t t = w->expired;
+   if(t) buzztimer_cancel(t);
+   return t;
+}
+
+/****************************************/
+/****************************************/
+
+void buzztimer_schedule(buzztimerwheel_t w,
+                        buzztimer_t t,
+                        uint32_t delay) {
+   buzztimer_cancel(t);
+   if(delay == 0) {
+      /* Fire at once: append to the expired list */
+      buzztimer_t* tail = &w->expired;
+      while(*tail) tail = &(*tail)->next;
+      t->expires = w->now;
+      t->next = NULL;
+      t->pprev = tail;
+      *tail = t;
+      return;
+   }
+   if(delay > BUZZTIMER_MAXDELAY) delay = BUZZTIMER_MAXDELAY;
+   t->expires = w->now + delay;
+   buzztimer_place(w, t);
+}
+
+/****************************************/
+/****************************************/
+
+void buzztimer_cancel(buzztimer_t t) {
+   if(!t->pprev) return;
+   *t->pprev = t->next;
+   if(t->next) t->next->pprev = t->pprev;
+   t->next = NULL;
+   t->pprev = NULL;
+}
+
+/****************************************/
+/****************************************/
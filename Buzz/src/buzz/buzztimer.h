@@ -0,0 +1,112 @@
+#ifndef BUZZTIMER_H
+#define BUZZTIMER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+   /*
+    * Number of bits of a wheel level, and number of slots per level.
+    */
+#define BUZZTIMER_SLOTBITS 6
+#define BUZZTIMER_SLOTS    (1 << BUZZTIMER_SLOTBITS)
+
+   /*
+    * Number of levels of a wheel. Timers can be up to
+    * 2^(BUZZTIMER_SLOTBITS * BUZZTIMER_LEVELS) - 1 ticks away.
+    */
+#define BUZZTIMER_LEVELS   4
+
+   /*
+    * A timer, meant to be embedded in the object it times.
+    * It must be zeroed before its first use.
+    */
+   struct buzztimer_s {
+      struct buzztimer_s* next;   // Next timer in the same slot
+      struct buzztimer_s** pprev; // Link pointing to this timer, NULL if not scheduled
+      uint32_t expires;           // Tick at which the timer fires
+      uint8_t type;               // Kind of timer, free for the user
+      void* data;                 // Timed object, free for the user
+   };
+   typedef struct buzztimer_s* buzztimer_t;
+
+   /*
+    * A hierarchical timer wheel. Level 0 has one slot per tick, every
+    * other level one slot per turn of the level below. Timers move down
+    * a level when their slot comes up, so scheduling and canceling are
+    * O(1) and a tick only touches the timers that fire or move down.
+    */
+   struct buzztimerwheel_s {
+      uint32_t now;                                           // Last tick done
+      buzztimer_t slots[BUZZTIMER_LEVELS][BUZZTIMER_SLOTS];   // Pending timers
+      buzztimer_t expired;                                    // Fired timers not taken yet
+   };
+   typedef struct buzztimerwheel_s* buzztimerwheel_t;
+
+   /*
+    * Creates a new timer wheel, at tick 0.
+    * @return A new timer wheel.
+    */
+   extern buzztimerwheel_t buzztimerwheel_new();
+
+   /*
+    * Destroys a timer wheel.
+    * The timers must have been canceled, the wheel does not own them.
+    * @param w The timer wheel.
+    */
+   extern void buzztimerwheel_destroy(buzztimerwheel_t* w);
+
+   /*
+    * Advances the wheel by one tick.
+    * The timers firing at the new tick are moved to the expired list.
+    * @param w The timer wheel.
+    */
+   extern void buzztimerwheel_tick(buzztimerwheel_t w);
+
+   /*
+    * Takes the next timer from the expired list.
+    * The returned timer is no longer scheduled.
+    * @param w The timer wheel.
+    * @return The timer, or NULL if there is none left.
+    */
+   extern buzztimer_t buzztimerwheel_pop(buzztimerwheel_t w);
+
+   /*
+    * Schedules a timer to fire the given number of ticks from now.
+    * A timer already scheduled is moved. With a delay of 0, the timer
+    * goes straight to the expired list.
+    * @param w The timer wheel.
+    * @param t The timer.
+    * @param delay The number of ticks.
+    */
+   extern void buzztimer_schedule(buzztimerwheel_t w,
+                                  buzztimer_t t,
+                                  uint32_t delay);
+
+   /*
+    * Cancels a timer. Nothing is done if it is not scheduled.
+    * @param t The timer.
+    */
+   extern void buzztimer_cancel(buzztimer_t t);
+
+#ifdef __cplusplus
+}
+#endif
+
+/*
+ * Returns <tt>true</tt> if the timer is scheduled or expired but not taken yet.
+ * @param t The timer.
+ * @return <tt>true</tt> if the timer is scheduled.
+ */
+#define buzztimer_pending(t) ((t)->pprev != NULL)
+
+/*
+ * Returns the current tick of a timer wheel.
+ * @param w The timer wheel.
+ * @return The current tick.
+ */
+#define buzztimerwheel_now(w) ((w)->now)
+
+#endif
@@ -8,7 +8,7 @@
 
 #define BUZZTYPE_TABLE_BUCKETS 10
 
-const char *buzztype_desc[] = { "nil", "integer", "float", "string", "table", "closure", "userdata" };
+const char *buzztype_desc[] = { "nil", "integer", "float", "string", "table", "closure", "userdata", "blob" };
 
 /****************************************/
 /****************************************/
@@ -36,12 +36,20 @@ int buzzobj_table_keycmp(const void* a, const void* b) {
 }
 
 buzzobj_t buzzobj_new(uint16_t type) {
-   /* Create a new object. calloc() fills it with zeroes */
-   buzzobj_t o = (buzzobj_t)calloc(1, sizeof(union buzzobj_u));
+   buzzobj_t o = (buzzobj_t)malloc(sizeof(union buzzobj_u));
+   buzzobj_init(o, type);
+   return o;
+}
+
+/****************************************/
+/****************************************/
+
+void buzzobj_init(buzzobj_t o,
+                  uint16_t type) {
+   /* Fill the object with zeroes */
+   memset(o, 0, sizeof(union buzzobj_u));
    /* Set the object type */
    o->o.type = type;
-   /* Set the object marker */
-   o->o.marker = 0;
    /* Take care of special initialization for specific types */
    if(type == BUZZTYPE_TABLE) {
       o->t.value = buzzdict_new(BUZZTYPE_TABLE_BUCKETS,
@@ -54,20 +62,13 @@ buzzobj_t buzzobj_new(uint16_t type) {
    else if(type == BUZZTYPE_CLOSURE) {
       o->c.value.actrec = buzzdarray_new(1, sizeof(buzzobj_t), NULL);
    }
-   /* All done */
-   return o;
 }
 
 /****************************************/
 /****************************************/
 
 void buzzobj_destroy(buzzobj_t* o) {
-   if((*o)->o.type == BUZZTYPE_TABLE) {
-      buzzdict_destroy(&((*o)->t.value));
-   }
-   else if((*o)->o.type == BUZZTYPE_CLOSURE) {
-      buzzdarray_destroy(&((*o)->c.value.actrec));
-   }
+   buzzobj_clear(*o);
    free(*o);
    *o = NULL;
 }
@@ -75,6 +76,21 @@ void buzzobj_destroy(buzzobj_t* o) {
 /****************************************/
 /****************************************/
 
+void buzzobj_clear(buzzobj_t o) {
+   if(o->o.type == BUZZTYPE_TABLE) {
+      buzzdict_destroy(&(o->t.value));
+   }
+   else if(o->o.type == BUZZTYPE_CLOSURE) {
+      buzzdarray_destroy(&(o->c.value.actrec));
+   }
+   else if(o->o.type == BUZZTYPE_BLOB) {
+      buzzblobbuf_unref(&(o->b.value.buf));
+   }
+}
+
+/****************************************/
+/****************************************/
+
 uint32_t buzzobj_hash(const buzzobj_t o) {
    switch(o->o.type) {
       case BUZZTYPE_NIL: {
@@ -98,6 +114,10 @@ uint32_t buzzobj_hash(const buzzobj_t o) {
          uint32_t p = (uintptr_t)(o->u.value);
          return buzzdict_uint32keyhash(&p);
       }
+      case BUZZTYPE_BLOB: {
+         uint32_t p = (uintptr_t)(o->b.value.data);
+         return buzzdict_uint32keyhash(&p);
+      }
       case BUZZTYPE_CLOSURE:
       default:
          fprintf(stderr, "[BUG] %s:%d: Hash for Buzz object type %d\n", __FILE__, __LINE__, o->o.type);
@@ -124,6 +144,7 @@ int buzzobj_eq(const buzzobj_t a,
                 (a->c.value.ref      == b->c.value.ref)      &&
                 (a->c.value.actrec   == b->c.value.actrec));
       case BUZZTYPE_USERDATA: return ((uintptr_t)(a->u.value) == (uintptr_t)(b->u.value));
+      case BUZZTYPE_BLOB:     return ((uintptr_t)(a->b.value.data) == (uintptr_t)(b->b.value.data));
       default:
          fprintf(stderr, "[BUG] %s:%d: Equality test between wrong Buzz objects types %d and %d\n", __FILE__, __LINE__, a->o.type, b->o.type);
          abort();
@@ -204,6 +225,12 @@ int buzzobj_cmp(const buzzobj_t a,
       if((uintptr_t)(a->u.value) > (uintptr_t)(b->u.value)) return 1;
       return 0;
    }
+   /* Blobs */
+   if(a->o.type == BUZZTYPE_BLOB && b->o.type == BUZZTYPE_BLOB) {
+      if((uintptr_t)(a->b.value.data) < (uintptr_t)(b->b.value.data)) return -1;
+      if((uintptr_t)(a->b.value.data) > (uintptr_t)(b->b.value.data)) return 1;
+      return 0;
+   }
    // TODO better error management
    fprintf(stderr, "[TODO] %s:%d: Error for comparison between Buzz objects of types %d and %d\n", __FILE__, __LINE__, a->o.type, b->o.type);
    abort();
@@ -241,11 +268,18 @@ int buzzobj_clone(buzzvm_t vm) {
 /****************************************/
 
 int buzzobj_size(buzzvm_t vm) {
-   /* Get table parameter and make sure it's a table */
+   /* Get parameter */
    buzzvm_lnum_assert(vm, 1);
    buzzvm_lload(vm, 1);
-   buzzvm_type_assert(vm, 1, BUZZTYPE_TABLE);
    buzzobj_t t = buzzvm_stack_at(vm, 1);
+   /* Blobs return their size in bytes */
+   if(t->o.type == BUZZTYPE_BLOB) {
+      buzzvm_pop(vm);
+      buzzvm_pushi(vm, t->b.value.size);
+      return buzzvm_ret1(vm);
+   }
+   /* Otherwise, make sure it's a table */
+   buzzvm_type_assert(vm, 1, BUZZTYPE_TABLE);
    buzzvm_pop(vm);
    buzzvm_pushi(vm, buzzdict_size(t->t.value));
    return buzzvm_ret1(vm);
@@ -407,11 +441,11 @@ int buzzobj_reduce(buzzvm_t vm) {
 /****************************************/
 
 void buzzobj_serialize_tableelem(const void* key, void* data, void* params) {
-   buzzobj_serialize((buzzdarray_t)params, *(buzzobj_t*)key);
-   buzzobj_serialize((buzzdarray_t)params, *(buzzobj_t*)data);
+   buzzobj_serialize((buzzmsg_payload_t)params, *(buzzobj_t*)key);
+   buzzobj_serialize((buzzmsg_payload_t)params, *(buzzobj_t*)data);
 }
 
-void buzzobj_serialize(buzzdarray_t buf,
+void buzzobj_serialize(buzzmsg_payload_t buf,
                        const buzzobj_t data) {
    buzzmsg_serialize_u8(buf, data->o.type);
    switch(data->o.type) {
@@ -430,6 +464,10 @@ void buzzobj_serialize(buzzdarray_t buf,
          buzzmsg_serialize_string(buf, data->s.value.str);
          break;
       }
+      case BUZZTYPE_BLOB: {
+         buzzmsg_serialize_bytes(buf, data->b.value.data, data->b.value.size);
+         break;
+      }
       case BUZZTYPE_TABLE: {
          buzzmsg_serialize_u8(buf, buzzdict_size(data->t.value));
          buzzdict_foreach(data->t.value, buzzobj_serialize_tableelem, buf);
@@ -463,7 +501,7 @@ void buzzobj_serialize(buzzdarray_t buf,
 /****************************************/
 
 int64_t buzzobj_deserialize(buzzobj_t* data,
-                            buzzdarray_t buf,
+                            buzzmsg_payload_t buf,
                             uint32_t pos,
                             struct buzzvm_s* vm) {
    int64_t p = pos;
@@ -490,6 +528,16 @@ int64_t buzzobj_deserialize(buzzobj_t* data,
          free(str);
          return p;
       }
+      case BUZZTYPE_BLOB: {
+         uint32_t size;
+         if(p + sizeof(uint32_t) > buzzmsg_payload_size(buf)) return -1;
+         p = buzzmsg_deserialize_u32(&size, buf, p);
+         if(p + size > buzzmsg_payload_size(buf)) return -1;
+         (*data)->b.value.buf  = buzzblobbuf_frombuffer(buf->data + p, size);
+         (*data)->b.value.data = (*data)->b.value.buf->data;
+         (*data)->b.value.size = size;
+         return p + size;
+      }
       case BUZZTYPE_TABLE: {
          uint8_t size;
          uint16_t i;
@@ -3,7 +3,9 @@
 
 #include <buzz/buzzdict.h>
 #include <buzz/buzzmsg.h>
+#include <buzz/buzzblobbuf.h>
 #include <stdint.h>
+#include <string.h>
 
 /*
  * Object types in Buzz
@@ -15,6 +17,7 @@
 #define BUZZTYPE_TABLE    4
 #define BUZZTYPE_CLOSURE  5
 #define BUZZTYPE_USERDATA 6
+#define BUZZTYPE_BLOB     7
 
 #ifdef __cplusplus
 extern "C" {
@@ -91,6 +94,19 @@ extern "C" {
       void*    value;
    } buzzuserdata_t;
 
+   /*
+    * Blob (binary-safe view over a shared byte buffer)
+    */
+   typedef struct {
+      uint16_t type;
+      uint16_t marker;
+      struct {
+         uint32_t size;     // The number of bytes
+         uint8_t* data;     // The first byte, inside buf
+         buzzblobbuf_t buf; // The shared buffer holding the bytes
+      } value;
+   } buzzblob_t;
+
    /*
     * A handle for a object
     */
@@ -106,9 +122,81 @@ extern "C" {
       buzztable_t    t;    // as table
       buzzclosure_t  c;    // as closure
       buzzuserdata_t u;    // as user data
+      buzzblob_t     b;    // as blob
    };
    typedef union buzzobj_u* buzzobj_t;
 
+   /*
+    * Unboxed values.
+    * On the VM stack and in local symbols, nil, integers and floats are
+    * stored in the buzzobj_t itself instead of in a heap object. Heap
+    * objects are aligned, so an unboxed value is marked by bit 0; bits
+    * 1-2 hold its type and the upper 32 bits its value. This needs
+    * 64-bit pointers; elsewhere every value is a heap object.
+    */
+#if UINTPTR_MAX > 0xFFFFFFFFu
+#define BUZZTYPE_UNBOXED 1
+#else
+#define BUZZTYPE_UNBOXED 0
+#endif
+
+   /*
+    * Returns non-zero if the passed value is unboxed.
+    * @param o The value.
+    */
+#define buzzobj_isunboxed(o) ((uintptr_t)(o) & BUZZTYPE_UNBOXED)
+
+   /*
+    * Returns the type of the passed value, unboxed or not.
+    * @param o The value.
+    */
+#define buzzobj_gettype(x) (buzzobj_isunboxed(x) ? (uint16_t)(((uintptr_t)(x) >> 1) & 3) : (x)->o.type)
+
+#if BUZZTYPE_UNBOXED
+
+   /*
+    * Makes an unboxed value.
+    * @param type BUZZTYPE_NIL, BUZZTYPE_INT or BUZZTYPE_FLOAT.
+    * @param bits The bits of the value.
+    * @return The unboxed value.
+    */
+   static inline buzzobj_t buzzobj_unboxed(uint16_t type,
+                                          uint32_t bits) {
+      return (buzzobj_t)(((uintptr_t)bits << 32) | ((uintptr_t)type << 1) | 1);
+   }
+
+   static inline buzzobj_t buzzobj_unboxed_int(int32_t v) {
+      return buzzobj_unboxed(BUZZTYPE_INT, (uint32_t)v);
+   }
+
+   static inline buzzobj_t buzzobj_unboxed_float(float v) {
+      uint32_t bits;
+      memcpy(&bits, &v, sizeof(bits));
+      return buzzobj_unboxed(BUZZTYPE_FLOAT, bits);
+   }
+
+#endif
+
+   /*
+    * Returns a heap object with the content of the passed value.
+    * Boxed values are returned as they are. Unboxed values are copied
+    * into the passed temporary, which is returned; the result is then
+    * good for reading only, and must not be stored.
+    * @param o The value.
+    * @param tmp The temporary.
+    * @return The object.
+    */
+   static inline buzzobj_t buzzobj_unbox(buzzobj_t o,
+                                         union buzzobj_u* tmp) {
+      if(!buzzobj_isunboxed(o)) return o;
+      uint32_t bits = (uint32_t)((uint64_t)(uintptr_t)o >> 32);
+      tmp->o.type = buzzobj_gettype(o);
+      tmp->o.marker = 0;
+      if(tmp->o.type == BUZZTYPE_INT) tmp->i.value = (int32_t)bits;
+      else if(tmp->o.type == BUZZTYPE_FLOAT) memcpy(&tmp->f.value, &bits, sizeof(bits));
+      return tmp;
+   }
+
    /*
     * Forward declaration of the Buzz VM.
     */
@@ -121,12 +209,26 @@ extern "C" {
     */
    extern buzzobj_t buzzobj_new(uint16_t type);
 
+   /*
+    * Initializes a Buzz object in the given memory.
+    * @param o The memory of the object.
+    * @param type The type of the Buzz object.
+    */
+   extern void buzzobj_init(buzzobj_t o,
+                            uint16_t type);
+
    /*
     * Destroys a Buzz object.
     * @param o The object to destroy.
     */
    extern void buzzobj_destroy(buzzobj_t* o);
 
+   /*
+    * Releases the data owned by a Buzz object, but not its memory.
+    * @param o The object.
+    */
+   extern void buzzobj_clear(buzzobj_t o);
+
    /*
     * Returns the hash of the passed Buzz object.
     * @param o The Buzz object to hash.
@@ -201,18 +303,16 @@ extern "C" {
 
    /*
     * Serializes a Buzz object.
-    * The data is appended to the given buffer. The buffer is treated as a
-    * dynamic array of uint8_t.
+    * The data is appended to the given buffer.
     * @param buf The output buffer where the serialized data is appended.
     * @param data The data to serialize.
     */
-   extern void buzzobj_serialize(buzzdarray_t buf,
+   extern void buzzobj_serialize(buzzmsg_payload_t buf,
                                  const buzzobj_t data);
 
    /*
     * Deserializes a Buzz object.
     * The data is read from the given buffer starting at the given position.
-    * The buffer is treated as a dynamic array of uint8_t.
     * @param data The deserialized data of the element.
     * @param buf The input buffer where the serialized data is stored.
     * @param pos The position at which the data starts.
@@ -220,7 +320,7 @@ extern "C" {
     * @return The new position in the buffer, of -1 in case of error.
     */
    extern int64_t buzzobj_deserialize(buzzobj_t* data,
-                                      buzzdarray_t buf,
+                                      buzzmsg_payload_t buf,
                                       uint32_t pos,
                                       struct buzzvm_s* vm);
 
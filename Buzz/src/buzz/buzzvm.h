@@ -9,6 +9,7 @@
 #include <buzz/buzzbstig.h>
 #include <buzz/buzzswarm.h>
 #include <buzz/buzzneighbors.h>
+#include <buzz/buzztimer.h>
 
 #include <stdlib.h>
 #include <math.h>
@@ -148,12 +149,23 @@ extern "C" {
      uint16_t key;
      uint16_t cid;
      uint16_t bidsize;
-     uint16_t time_to_wait;
      uint16_t time_to_destroy;
+     uint32_t deadline;          // Tick at which the wait is over
+     struct buzztimer_s timer;   // Fires at the deadline, or earlier if something is due
      buzzdarray_t checkednids;
    };
    typedef struct buzzchunk_reloc_elem_s* buzzchunk_reloc_elem_t;
 
+   /*
+    * Kinds of timers of the chunk monitor.
+    */
+   typedef enum {
+      BUZZCHUNK_TIMER_BIDDER = 0, // Element of the bidder list
+      BUZZCHUNK_TIMER_GETTER,     // Element of the getter list
+      BUZZCHUNK_TIMER_REQUEST,    // Element of the blob request list
+      BUZZCHUNK_TIMER_ANTIFLOOD   // Anti-flooding entry of the out message queue
+   } buzzchunk_timer_e;
+
    /*
     * A chunk monitor for chunk management 
     */
@@ -163,6 +175,7 @@ extern "C" {
      buzzdarray_t blobrequest; 
      buzzdarray_t getters;
      buzzdarray_t bidder; 
+     buzztimerwheel_t timers;  // Timeouts of the lists and the anti-flooding entries
      uint8_t status;
    };
    typedef struct buzzchunk_monitor_s* buzzchunk_monitor_t;
@@ -202,6 +215,35 @@ extern "C" {
       BUZZBLOB_STATUS_CHANGE_DONE,            // status changed
       BUZZBLOB_WAITING_FOR_BLOB_AVILABILITY   // all chunks allocated not avilable waiting.
    } buzz_blobrequest_e;
+   /*
+    * A pre-decoded instruction.
+    */
+   struct buzzvm_instr_s {
+      /*
+       * Opcode; BUZZVM_INSTR_COUNT leaves the instruction to buzzvm_step(),
+       * higher values mark a PUSHS fused with the GLOAD or TGET after it
+       */
+      uint8_t op;
+      /* Position of the following instruction */
+      uint32_t next;
+      /* Argument */
+      union {
+         int32_t i;
+         uint32_t u;
+         float f;
+      } arg;
+      /* Inline cache: dictionary slot where the key was last found */
+      uint32_t hint;
+   };
+
+   /*
+    * Inline cache counters of an instruction.
+    */
+   struct buzzvm_icstats_s {
+      uint64_t hits;   // Lookups answered by the cached slot
+      uint64_t misses; // Lookups that went through the dictionary
+   };
+
    /*
     * VM data
     */
@@ -210,6 +252,8 @@ extern "C" {
       const uint8_t* bcode;
       /* Size of the loaded bytecode */
       uint32_t bcode_size;
+      /* Pre-decoded bytecode, one record per bytecode position */
+      struct buzzvm_instr_s* code;
       /* Program counter */
       int32_t pc;
       /* Old program counter (for error reporting) */
@@ -248,6 +292,8 @@ extern "C" {
       buzzdict_t bstigs;
       /* Blob slot maps */
       buzzdict_t blobs;
+      /* Order in which stored blobs are evicted */
+      buzzblobprio_t blobprio;
       /* List of blob chunk stigmergy to refresh */
       buzzdarray_t chunk_stig;
       /* Neighbors active for chunk management */
@@ -273,6 +319,8 @@ extern "C" {
       /* Amount of out msg sent last step */
       uint64_t outmsgsstep;
       uint64_t p2poutmsgsstep;
+      /* Inline cache counters, by opcode (GLOAD, GSTORE, TGET, TPUT) */
+      struct buzzvm_icstats_s icstats[BUZZVM_INSTR_COUNT];
       int receiver;
    };
    typedef struct buzzvm_s* buzzvm_t;
@@ -358,8 +406,19 @@ extern "C" {
 
    extern void buzzvm_neighbors_update(buzzvm_t vm);
 
+   /*
+    * Marks a robot as an active neighbor.
+    * The neighbor entry is created if needed.
+    * @param vm The VM data.
+    * @param rid The id of the neighbor.
+    */
+   extern void buzzvm_neighbors_touch(buzzvm_t vm,
+                                      uint16_t rid);
+
    /*
     * Executes the next step in the bytecode, if possible.
+    * This decodes the instruction from the plain bytecode; the debugger
+    * relies on it to stop at breakpoints.
     * @param vm The VM data.
     * @return The updated VM state.
     */
@@ -371,6 +430,19 @@ extern "C" {
     * @return The updated VM state.
     */
    extern buzzvm_state buzzvm_execute_script(buzzvm_t vm);
+
+   /*
+    * Executes the pre-decoded bytecode until the VM is no longer ready or
+    * the stack count drops to the given depth.
+    * Unlike buzzvm_step(), this does not return between instructions, and
+    * the garbage collector only runs at jumps, calls and returns.
+    * Breakpoints are not checked: the debugger uses buzzvm_step().
+    * @param vm The VM data.
+    * @param depth The stack count to stop at, 0 to run until done.
+    * @return The updated VM state.
+    */
+   extern buzzvm_state buzzvm_run(buzzvm_t vm,
+                                  uint32_t depth);
    
    /*
     * Calls a Buzz closure.
@@ -448,6 +520,16 @@ extern "C" {
     */
    extern buzzvm_state buzzvm_dup(buzzvm_t vm);
 
+   /*
+    * Puts the stack element at the passed index in the heap.
+    * An unboxed element is replaced by a heap object with the same value.
+    * Use buzzvm_stack_at() rather than calling this directly.
+    * @param vm The VM data.
+    * @param idx The stack index, where 0 is the stack top and >0 goes down the stack.
+    * @return The heap object.
+    */
+   extern buzzobj_t buzzvm_stack_box(buzzvm_t vm, int64_t idx);
+
    /*
     * Pushes a variable on the stack.
     * @param vm The VM data.
@@ -464,6 +546,27 @@ extern "C" {
     */
    extern buzzvm_state buzzvm_pushu(buzzvm_t vm, void* v);
 
+   /*
+    * Pushes a blob on the stack.
+    * The bytes are copied into a buffer owned by the new object.
+    * @param vm The VM data.
+    * @param data The bytes.
+    * @param size The number of bytes.
+    * @return The VM state.
+    */
+   extern buzzvm_state buzzvm_pushb(buzzvm_t vm, const void* data, uint32_t size);
+
+   /*
+    * Pushes a blob that views part of an existing buffer on the stack.
+    * No bytes are copied; the blob takes a reference to the buffer.
+    * @param vm The VM data.
+    * @param b The buffer.
+    * @param offset The offset of the first byte in the buffer.
+    * @param size The number of bytes.
+    * @return The VM state.
+    */
+   extern buzzvm_state buzzvm_pushbuf(buzzvm_t vm, buzzblobbuf_t b, uint32_t offset, uint32_t size);
+
    /*
     * Pushes nil on the stack.
     * @param vm The VM data.
@@ -594,13 +697,13 @@ extern "C" {
     */
    extern buzzvm_state buzzvm_ret1(buzzvm_t vm);
 
-   extern buzzdarray_t buzzvm_vm_serialize(buzzvm_t vm);
+   extern buzzmsg_payload_t buzzvm_vm_serialize(buzzvm_t vm);
 
-   extern void buzzvm_vm_deserialize_set(buzzvm_t vm, buzzdarray_t a);
+   extern void buzzvm_vm_deserialize_set(buzzvm_t vm, buzzmsg_payload_t a);
 
-   extern buzzdarray_t buzzvm_gsyms_serialize(buzzvm_t vm);
+   extern buzzmsg_payload_t buzzvm_gsyms_serialize(buzzvm_t vm);
 
-   extern int64_t buzzvm_gsyms_deserialize_set(buzzvm_t vm, buzzdarray_t a, int64_t pos);
+   extern int64_t buzzvm_gsyms_deserialize_set(buzzvm_t vm, buzzmsg_payload_t a, int64_t pos);
 
 #ifdef __cplusplus
 }
@@ -633,12 +736,12 @@ extern "C" {
  * @param tpe The type to check
  */
 #define buzzvm_type_assert(vm, idx, tpe)                                \
-   if(buzzvm_stack_at((vm), idx)->o.type != tpe) {                      \
+   if(buzzobj_gettype(buzzvm_stack_get((vm), idx)) != tpe) {               \
       buzzvm_seterror((vm),                                             \
                       BUZZVM_ERROR_TYPE,                                \
                       "expected %s, got %s",                            \
                       buzztype_desc[tpe],                               \
-                      buzztype_desc[buzzvm_stack_at((vm), idx)->o.type] \
+                      buzztype_desc[buzzobj_gettype(buzzvm_stack_get((vm), idx))] \
          );                                                             \
       return (vm)->state;                                               \
    }
@@ -650,13 +753,34 @@ extern "C" {
  */
 #define buzzvm_stack_top(vm) buzzdarray_size((vm)->stack)
 
+/*
+ * Returns the stack element at the passed index, as stored.
+ * The element may be an unboxed value.
+ * Does not perform any check on the validity of the index.
+ * @param vm The VM data.
+ * @param idx The stack index, where 0 is the stack top and >0 goes down the stack.
+ */
+#define buzzvm_stack_get(vm, idx) buzzdarray_get((vm)->stack, (buzzvm_stack_top(vm) - (idx)), buzzobj_t)
+
 /*
  * Returns the stack element at the passed index.
+ * An unboxed element is replaced by a heap object with the same value.
+ * Does not perform any check on the validity of the index.
+ * @param vm The VM data.
+ * @param idx The stack index, where 0 is the stack top and >0 goes down the stack.
+ */
+#define buzzvm_stack_at(vm, idx) (buzzobj_isunboxed(buzzvm_stack_get(vm, idx)) ? buzzvm_stack_box(vm, idx) : buzzvm_stack_get(vm, idx))
+
+/*
+ * Returns the stack element at the passed index, for reading only.
+ * Unlike buzzvm_stack_at(), an unboxed element is not put in the heap:
+ * its value is copied into *tmp, and tmp is returned.
  * Does not perform any check on the validity of the index.
  * @param vm The VM data.
  * @param idx The stack index, where 0 is the stack top and >0 goes down the stack.
+ * @param tmp A pointer to a union buzzobj_u.
  */
-#define buzzvm_stack_at(vm, idx) buzzdarray_get((vm)->stack, (buzzvm_stack_top(vm) - (idx)), buzzobj_t)
+#define buzzvm_stack_peek(vm, idx, tmp) buzzobj_unbox(buzzvm_stack_get(vm, idx), (tmp))
 
 /*
  * Terminates the current Buzz script.
@@ -724,7 +848,7 @@ extern "C" {
  */
 #define buzzvm_lstore(vm, idx) {                                  \
       buzzvm_stack_assert((vm), 1);                               \
-      buzzobj_t o = buzzvm_stack_at(vm, 1);                       \
+      buzzobj_t o = buzzvm_stack_get(vm, 1);                      \
       buzzvm_pop(vm);                                             \
       buzzdarray_set((vm)->lsyms->syms, idx, &o);                 \
    }
@@ -740,8 +864,9 @@ extern "C" {
  */
 #define buzzvm_binary_op_arith(vm, oper)                                \
    buzzvm_stack_assert((vm), 2);                                        \
-   buzzobj_t op1 = buzzvm_stack_at(vm, 1);                              \
-   buzzobj_t op2 = buzzvm_stack_at(vm, 2);                              \
+   union buzzobj_u op1_v, op2_v;                                        \
+   buzzobj_t op1 = buzzvm_stack_peek(vm, 1, &op1_v);                    \
+   buzzobj_t op2 = buzzvm_stack_peek(vm, 2, &op2_v);                    \
    if((op1->o.type != BUZZTYPE_INT &&                                   \
        op1->o.type != BUZZTYPE_FLOAT) ||                                \
       (op2->o.type != BUZZTYPE_INT &&                                   \
@@ -754,26 +879,18 @@ extern "C" {
    buzzdarray_pop(vm->stack);                                           \
    if(op1->o.type == BUZZTYPE_INT &&                                    \
       op2->o.type == BUZZTYPE_INT) {                                    \
-      buzzobj_t res = buzzheap_newobj((vm), BUZZTYPE_INT);        \
-      res->i.value = op2->i.value oper op1->i.value;                    \
-      buzzvm_push(vm, res);                                             \
+      buzzvm_pushi(vm, op2->i.value oper op1->i.value);                 \
    }                                                                    \
    else if(op1->o.type == BUZZTYPE_INT &&                               \
            op2->o.type == BUZZTYPE_FLOAT) {                             \
-      buzzobj_t res = buzzheap_newobj((vm), BUZZTYPE_FLOAT);      \
-      res->f.value = op2->f.value oper op1->i.value;                    \
-      buzzvm_push(vm, res);                                             \
+      buzzvm_pushf(vm, op2->f.value oper op1->i.value);                 \
    }                                                                    \
    else if(op1->o.type == BUZZTYPE_FLOAT &&                             \
            op2->o.type == BUZZTYPE_INT) {                               \
-      buzzobj_t res = buzzheap_newobj((vm), BUZZTYPE_FLOAT);      \
-      res->f.value = op2->i.value oper op1->f.value;                    \
-      buzzvm_push(vm, res);                                             \
+      buzzvm_pushf(vm, op2->i.value oper op1->f.value);                 \
    }                                                                    \
    else {                                                               \
-      buzzobj_t res = buzzheap_newobj((vm), BUZZTYPE_FLOAT);      \
-      res->f.value = op2->f.value oper op1->f.value;                    \
-      buzzvm_push(vm, res);                                             \
+      buzzvm_pushf(vm, op2->f.value oper op1->f.value);                 \
    }
 
 /*
@@ -787,19 +904,17 @@ extern "C" {
  */
 #define buzzvm_binary_op_logic(vm, oper)                                \
    buzzvm_stack_assert((vm), 2);                                        \
-   buzzobj_t op1 = buzzvm_stack_at(vm, 1);                              \
-   buzzobj_t op2 = buzzvm_stack_at(vm, 2);                              \
+   union buzzobj_u op1_v, op2_v;                                        \
+   buzzobj_t op1 = buzzvm_stack_peek(vm, 1, &op1_v);                    \
+   buzzobj_t op2 = buzzvm_stack_peek(vm, 2, &op2_v);                    \
    buzzdarray_pop(vm->stack);                                           \
    buzzdarray_pop(vm->stack);                                           \
-   buzzobj_t res = buzzheap_newobj((vm), BUZZTYPE_INT);           \
-   res->i.value =                                                       \
+   buzzvm_pushi(vm,                                                     \
       !(op2->o.type == BUZZTYPE_NIL ||                                  \
         (op2->i.type == BUZZTYPE_INT && op2->i.value == 0))             \
       oper                                                              \
       !(op1->o.type == BUZZTYPE_NIL ||                                  \
-        (op1->i.type == BUZZTYPE_INT && op1->i.value == 0));            \
-   res->o.type = BUZZTYPE_INT;                                          \
-   buzzvm_push(vm, res);
+        (op1->i.type == BUZZTYPE_INT && op1->i.value == 0)));
 
 /*
  * Pops two numeric operands from the stack and pushes the result of a comparison operation on them.
@@ -812,13 +927,12 @@ extern "C" {
  */
 #define buzzvm_binary_op_cmp(vm, oper)                                  \
    buzzvm_stack_assert((vm), 2);                                        \
-   buzzobj_t op1 = buzzvm_stack_at(vm, 1);                              \
-   buzzobj_t op2 = buzzvm_stack_at(vm, 2);                              \
+   union buzzobj_u op1_v, op2_v;                                        \
+   buzzobj_t op1 = buzzvm_stack_peek(vm, 1, &op1_v);                    \
+   buzzobj_t op2 = buzzvm_stack_peek(vm, 2, &op2_v);                    \
    buzzdarray_pop(vm->stack);                                           \
    buzzdarray_pop(vm->stack);                                           \
-   buzzobj_t res = buzzheap_newobj((vm), BUZZTYPE_INT);           \
-   res->i.value = (buzzobj_cmp(op2, op1) oper 0);                       \
-   buzzvm_push(vm, res);
+   buzzvm_pushi(vm, (buzzobj_cmp(op2, op1) oper 0));
 
 /*
  * Pushes stack(#2) + stack(#1) and pops the operands.
@@ -865,37 +979,34 @@ extern "C" {
  */
 #define buzzvm_mod(vm)                                                  \
    buzzvm_stack_assert((vm), 2);                                        \
-   buzzobj_t op1 = buzzvm_stack_at(vm, 1);                              \
-   buzzobj_t op2 = buzzvm_stack_at(vm, 2);                              \
+   union buzzobj_u op1_v, op2_v;                                        \
+   buzzobj_t op1 = buzzvm_stack_peek(vm, 1, &op1_v);                    \
+   buzzobj_t op2 = buzzvm_stack_peek(vm, 2, &op2_v);                    \
    buzzdarray_pop(vm->stack);                                           \
    buzzdarray_pop(vm->stack);                                           \
    if(op1->o.type == BUZZTYPE_INT &&                                    \
       op2->o.type == BUZZTYPE_INT) {                                    \
-      buzzobj_t res = buzzheap_newobj((vm), BUZZTYPE_INT);        \
-      res->i.value = op2->i.value % op1->i.value;                       \
-      if(res->i.value < 0) res->i.value += op1->i.value;                \
-      buzzvm_push(vm, res);                                             \
+      int32_t res = op2->i.value % op1->i.value;                        \
+      if(res < 0) res += op1->i.value;                                  \
+      buzzvm_pushi(vm, res);                                            \
    }                                                                    \
    else if(op1->o.type == BUZZTYPE_FLOAT &&                             \
            op2->o.type == BUZZTYPE_FLOAT) {                             \
-      buzzobj_t res = buzzheap_newobj((vm), BUZZTYPE_FLOAT);      \
-      res->f.value = fmodf(op2->f.value, op1->f.value);                 \
-      if(res->f.value < 0.) res->f.value += op1->f.value;               \
-      buzzvm_push(vm, res);                                             \
+      float res = fmodf(op2->f.value, op1->f.value);                    \
+      if(res < 0.) res += op1->f.value;                                 \
+      buzzvm_pushf(vm, res);                                            \
    }                                                                    \
    else if(op1->o.type == BUZZTYPE_INT &&                               \
            op2->o.type == BUZZTYPE_FLOAT) {                             \
-      buzzobj_t res = buzzheap_newobj((vm), BUZZTYPE_FLOAT);      \
-      res->f.value = fmodf(op2->f.value, op1->i.value);                 \
-      if(res->f.value < 0.) res->f.value += op1->f.value;               \
-      buzzvm_push(vm, res);                                             \
+      float res = fmodf(op2->f.value, op1->i.value);                    \
+      if(res < 0.) res += op1->f.value;                                 \
+      buzzvm_pushf(vm, res);                                            \
    }                                                                    \
    else if(op1->o.type == BUZZTYPE_FLOAT &&                             \
            op2->o.type == BUZZTYPE_INT) {                               \
-      buzzobj_t res = buzzheap_newobj((vm), BUZZTYPE_FLOAT);      \
-      res->f.value = fmodf(op2->i.value, op1->f.value);                 \
-      if(res->f.value < 0.) res->f.value += op1->i.value;               \
-      buzzvm_push(vm, res);                                             \
+      float res = fmodf(op2->i.value, op1->f.value);                    \
+      if(res < 0.) res += op1->i.value;                                 \
+      buzzvm_pushf(vm, res);                                            \
    }                                                                    \
    else {                                                               \
       (vm)->state = BUZZVM_STATE_ERROR;                                 \
@@ -912,33 +1023,26 @@ extern "C" {
  */
 #define buzzvm_pow(vm)                                                  \
    buzzvm_stack_assert((vm), 2);                                        \
-   buzzobj_t op1 = buzzvm_stack_at(vm, 1);                              \
-   buzzobj_t op2 = buzzvm_stack_at(vm, 2);                              \
+   union buzzobj_u op1_v, op2_v;                                        \
+   buzzobj_t op1 = buzzvm_stack_peek(vm, 1, &op1_v);                    \
+   buzzobj_t op2 = buzzvm_stack_peek(vm, 2, &op2_v);                    \
    buzzdarray_pop(vm->stack);                                           \
    buzzdarray_pop(vm->stack);                                           \
    if(op1->o.type == BUZZTYPE_INT &&                                    \
       op2->o.type == BUZZTYPE_INT) {                                    \
-      buzzobj_t res = buzzheap_newobj((vm), BUZZTYPE_FLOAT);      \
-      res->f.value = powf(op2->i.value, op1->i.value);                  \
-      buzzvm_push(vm, res);                                             \
+      buzzvm_pushf(vm, powf(op2->i.value, op1->i.value));               \
    }                                                                    \
    else if(op1->o.type == BUZZTYPE_FLOAT &&                             \
            op2->o.type == BUZZTYPE_FLOAT) {                             \
-      buzzobj_t res = buzzheap_newobj((vm), BUZZTYPE_FLOAT);      \
-      res->f.value = powf(op2->f.value, op1->f.value);                  \
-      buzzvm_push(vm, res);                                             \
+      buzzvm_pushf(vm, powf(op2->f.value, op1->f.value));               \
    }                                                                    \
    else if(op1->o.type == BUZZTYPE_INT &&                               \
            op2->o.type == BUZZTYPE_FLOAT) {                             \
-      buzzobj_t res = buzzheap_newobj((vm), BUZZTYPE_FLOAT);      \
-      res->f.value = powf(op2->f.value, op1->i.value);                  \
-      buzzvm_push(vm, res);                                             \
+      buzzvm_pushf(vm, powf(op2->f.value, op1->i.value));               \
    }                                                                    \
    else if(op1->o.type == BUZZTYPE_FLOAT &&                             \
            op2->o.type == BUZZTYPE_INT) {                               \
-      buzzobj_t res = buzzheap_newobj((vm), BUZZTYPE_FLOAT);      \
-      res->f.value = powf(op2->i.value, op1->f.value);                  \
-      buzzvm_push(vm, res);                                             \
+      buzzvm_pushf(vm, powf(op2->i.value, op1->f.value));               \
    }                                                                    \
    else {                                                               \
       (vm)->state = BUZZVM_STATE_ERROR;                                 \
@@ -955,17 +1059,14 @@ extern "C" {
  */
 #define buzzvm_unm(vm)                                                  \
    buzzvm_stack_assert(vm, 1);                                          \
-   buzzobj_t op = buzzvm_stack_at(vm, 1);                               \
+   union buzzobj_u op_v;                                                \
+   buzzobj_t op = buzzvm_stack_peek(vm, 1, &op_v);                      \
    buzzdarray_pop(vm->stack);                                           \
    if(op->o.type == BUZZTYPE_INT) {                                     \
-      buzzobj_t res = buzzheap_newobj((vm), BUZZTYPE_INT);        \
-      res->i.value = -op->i.value;                                      \
-      buzzvm_push(vm, res);                                             \
+      buzzvm_pushi(vm, -op->i.value);                                   \
    }                                                                    \
    else if(op->o.type == BUZZTYPE_FLOAT) {                              \
-      buzzobj_t res = buzzheap_newobj((vm), BUZZTYPE_FLOAT);      \
-      res->f.value = -op->f.value;                                      \
-      buzzvm_push(vm, res);                                             \
+      buzzvm_pushf(vm, -op->f.value);                                   \
    }                                                                    \
    else {                                                               \
       (vm)->state = BUZZVM_STATE_ERROR;                                 \
@@ -1000,13 +1101,12 @@ extern "C" {
  */
 #define buzzvm_not(vm)                                                  \
    buzzvm_stack_assert((vm), 1);                                        \
-   buzzobj_t op = buzzvm_stack_at(vm, 1);                               \
+   union buzzobj_u op_v;                                                \
+   buzzobj_t op = buzzvm_stack_peek(vm, 1, &op_v);                      \
    buzzdarray_pop(vm->stack);                                           \
-   buzzobj_t res = buzzheap_newobj((vm), BUZZTYPE_INT);           \
-   res->i.value =                                                       \
+   buzzvm_pushi(vm,                                                     \
       (op->o.type == BUZZTYPE_NIL ||                                    \
-       (op->i.type == BUZZTYPE_INT && op->i.value == 0));               \
-   buzzvm_push(vm, res);
+       (op->i.type == BUZZTYPE_INT && op->i.value == 0)));
    
 /*
  * Pushes stack(#2) == stack(#1) and pops the operands.
@@ -81,9 +81,7 @@ buzzvstig_elem_t buzzvstig_elem_clone(buzzvm_t vm, const buzzvstig_elem_t e) {
 /****************************************/
 
 void buzzvstig_elem_destroy(const void* key, void* data, void* params) {
-   free((void*)key);
    free(*(buzzvstig_elem_t*)data);
-   free(data);
 }
 
 /****************************************/
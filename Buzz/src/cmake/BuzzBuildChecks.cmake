@@ -3,6 +3,11 @@
 #
 find_package(PkgConfig REQUIRED)
 
+#
+# Find the threading library
+#
+find_package(Threads REQUIRED)
+
 #
 # Look for the optional ARGoS package
 #
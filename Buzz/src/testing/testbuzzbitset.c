@@ -0,0 +1,98 @@
+#include <buzz/buzzbitset.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Test of the bit set holding the chunks of a blob. Elements are added
+ * and removed at random and checked against a plain array, along with
+ * the missing elements and the byte form sent in status messages.
+ */
+
+#define ELEMS  1000
+#define ROUNDS 100000
+
+/****************************************/
+/****************************************/
+
+static uint32_t rnd(uint32_t* x) {
+   *x = *x * 1103515245 + 12345;
+   return *x >> 8;
+}
+
+/****************************************/
+/****************************************/
+
+static int check() {
+   buzzbitset_t s = buzzbitset_new();
+   buzzbitset_t miss = buzzbitset_new();
+   uint8_t ref[ELEMS], bytes[ELEMS / 8 + 1];
+   uint32_t x = 12345, count = 0, i, k;
+   memset(ref, 0, sizeof(ref));
+   for(k = 0; k < ROUNDS; ++k) {
+      /* Grow slowly, so that both the inline and heap words are used */
+      i = rnd(&x) % (k < ROUNDS / 2 ? 100 : ELEMS);
+      if(rnd(&x) % 3) {
+         if(buzzbitset_add(s, i) != !ref[i]) return 0;
+         count += !ref[i];
+         ref[i] = 1;
+      }
+      else {
+         if(buzzbitset_remove(s, i) != ref[i]) return 0;
+         count -= ref[i];
+         ref[i] = 0;
+      }
+      if(buzzbitset_count(s) != count) {
+         fprintf(stdout, "count %u instead of %u\n", buzzbitset_count(s), count);
+         return 0;
+      }
+      if(k % 1000) continue;
+      /* Walk the elements in order */
+      int64_t e = buzzbitset_next(s, 0), last = -1;
+      for(i = 0; i < ELEMS; ++i) {
+         if(buzzbitset_has(s, i) != ref[i]) return 0;
+         if(!ref[i]) continue;
+         if(e != i) {
+            fprintf(stdout, "next gave %ld instead of %u\n", (long)e, i);
+            return 0;
+         }
+         e = buzzbitset_next(s, i + 1);
+         last = i;
+      }
+      if(e != -1 || buzzbitset_last(s) != last) return 0;
+      /* Missing elements below a bound */
+      uint32_t n = rnd(&x) % ELEMS;
+      buzzbitset_missing(s, n, miss);
+      for(i = 0; i < ELEMS; ++i) {
+         if(buzzbitset_has(miss, i) != (i < n && !ref[i])) {
+            fprintf(stdout, "%u wrongly missing below %u\n", i, n);
+            return 0;
+         }
+      }
+      /* Byte form, whole and from a later byte */
+      buzzbitset_tobytes(s, 0, buzzbitset_nbytes(s), bytes);
+      buzzbitset_clear(miss);
+      buzzbitset_frombytes(miss, 0, bytes, buzzbitset_nbytes(s));
+      if(buzzbitset_count(miss) != count) return 0;
+      for(i = 0; i < ELEMS; ++i)
+         if(buzzbitset_has(miss, i) != ref[i]) return 0;
+      buzzbitset_tobytes(s, 3, 10, bytes);
+      for(i = 0; i < 80; ++i)
+         if(((bytes[i / 8] >> (i % 8)) & 1) != ref[24 + i]) return 0;
+   }
+   buzzbitset_destroy(&miss);
+   buzzbitset_destroy(&s);
+   return 1;
+}
+
+/****************************************/
+/****************************************/
+
+int main() {
+   if(!check()) {
+      fprintf(stdout, "bit set check failed\n");
+      return 1;
+   }
+   fprintf(stdout, "bit set matches the reference\n");
+   return 0;
+}
@@ -0,0 +1,69 @@
+#include <buzz/buzzblobprio.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * Test of the blob eviction order. Random insertions, removals and
+ * priority changes are checked against a brute-force sorted list.
+ */
+
+#define BLOBS 512
+
+/****************************************/
+/****************************************/
+
+static uint32_t rnd(uint32_t* x) {
+   *x = *x * 1103515245 + 12345;
+   return *x >> 8;
+}
+
+/* Brute-force order: stat first, then priority, key and id */
+static int before(buzzblobprio_node_t a, buzzblobprio_node_t b) {
+   if(a->stat != b->stat) return a->stat > b->stat;
+   if(a->priority != b->priority) return a->priority < b->priority;
+   if(a->key != b->key) return a->key < b->key;
+   return a->id < b->id;
+}
+
+static int check(buzzblobprio_t l, buzzblobprio_node_t* nodes) {
+   uint32_t i, n = 0;
+   buzzblobprio_node_t p = NULL, x;
+   for(x = buzzblobprio_first(l); x; x = buzzblobprio_next(x)) {
+      if(p && !before(p, x)) return 0;
+      p = x;
+      ++n;
+   }
+   if(n != buzzblobprio_size(l)) return 0;
+   for(i = 0; i < BLOBS; ++i) if(nodes[i]) --n;
+   return n == 0;
+}
+
+/****************************************/
+/****************************************/
+
+int main() {
+   buzzblobprio_t l = buzzblobprio_new();
+   buzzblobprio_node_t nodes[BLOBS] = { NULL };
+   uint32_t x = 12345, i;
+   for(i = 0; i < 200000; ++i) {
+      uint32_t b = rnd(&x) % BLOBS;
+      uint32_t op = rnd(&x) % 4;
+      if(!nodes[b])
+         nodes[b] = buzzblobprio_insert(l, b % 7, b, rnd(&x) % 8, rnd(&x) % 5 == 0);
+      else if(op == 0)
+         buzzblobprio_remove(&nodes[b]);
+      else
+         buzzblobprio_update(nodes[b], rnd(&x) % 8, rnd(&x) % 5 == 0);
+      if(i % 97 == 0 && !check(l, nodes)) {
+         fprintf(stdout, "order mismatch at operation %u\n", i);
+         return 1;
+      }
+   }
+   if(!check(l, nodes)) {
+      fprintf(stdout, "order mismatch\n");
+      return 1;
+   }
+   fprintf(stdout, "order matches\n");
+   buzzblobprio_destroy(&l);
+   return 0;
+}
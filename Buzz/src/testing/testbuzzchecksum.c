@@ -0,0 +1,128 @@
+#include <buzz/buzzbstig.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Microbenchmark of the bstig chunk checksums.
+ * Checks CRC32C and xxHash against published values, and the SSE4.2
+ * CRC32C against the portable one. Then hashes a buffer in chunk-sized
+ * pieces with every algorithm, checks that streaming and one-shot
+ * checksums agree, and prints the throughput.
+ */
+
+#define BUFFER_SIZE (1 << 20)
+#define ROUNDS      20
+
+static const char* ALGO_NAMES[] = { "md5", "crc32c", "xxh64" };
+
+/* Published 64-bit xxHash values, seed 0 */
+static const struct {
+   const char* in;
+   uint64_t h;
+} XXH64_VECTORS[] = {
+   { "", 0xEF46DB3751D8E999ULL },
+   { "a", 0xD24EC4F1A98C6E5BULL },
+   { "abc", 0x44BC2CF5AD770999ULL },
+   { "Nobody inspects the spammish repetition", 0xFBCEA83C8A378BF1ULL }
+};
+
+static double now() {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int known_answers() {
+   int err = 0;
+   uint32_t c = buzzbstig_checksum(BUZZBSTIG_CHECKSUM_CRC32C, "123456789", 9);
+   if(c != 0xE3069283) {
+      fprintf(stdout, "crc32c(\"123456789\") is %08x instead of e3069283\n", c);
+      err = 1;
+   }
+   c = buzzbstig_crc32c_portable("123456789", 9);
+   if(c != 0xE3069283) {
+      fprintf(stdout, "portable crc32c(\"123456789\") is %08x instead of e3069283\n", c);
+      err = 1;
+   }
+   for(uint32_t i = 0; i < sizeof(XXH64_VECTORS) / sizeof(XXH64_VECTORS[0]); ++i) {
+      /* The checksum folds the 64-bit hash into 32 bits */
+      uint64_t h = XXH64_VECTORS[i].h;
+      uint32_t want = (uint32_t)(h ^ (h >> 32));
+      c = buzzbstig_checksum(BUZZBSTIG_CHECKSUM_XXH64,
+                             XXH64_VECTORS[i].in,
+                             strlen(XXH64_VECTORS[i].in));
+      if(c != want) {
+         fprintf(stdout, "xxh64(\"%s\") is %08x instead of %08x\n",
+                 XXH64_VECTORS[i].in, c, want);
+         err = 1;
+      }
+   }
+   return err;
+}
+
+/* The CRC32C in use, SSE4.2 or not, must match the portable one */
+static int crc32c_paths(const uint8_t* buf, uint32_t size) {
+   uint32_t x = 777, i;
+   for(i = 0; i < 2000; ++i) {
+      x = x * 1103515245 + 12345;
+      uint32_t off = (x >> 8) % 16;
+      x = x * 1103515245 + 12345;
+      uint32_t len = (x >> 8) % ((i % 10) ? 100 : 5000);
+      if(off + len > size) continue;
+      uint32_t a = buzzbstig_checksum(BUZZBSTIG_CHECKSUM_CRC32C, buf + off, len);
+      uint32_t b = buzzbstig_crc32c_portable(buf + off, len);
+      if(a != b) {
+         fprintf(stdout, "crc32c paths disagree on %u bytes at %u: %08x != %08x\n",
+                 len, off, a, b);
+         return 1;
+      }
+   }
+   return 0;
+}
+
+int main(int argc, char** argv) {
+   /* Chunk size to hash */
+   uint32_t chunk = (argc > 1) ? atoi(argv[1]) : BLOB_CHUNK_SIZE;
+   if(chunk == 0) chunk = BLOB_CHUNK_SIZE;
+   /* Fill a buffer with pseudo-random bytes */
+   uint8_t* buf = (uint8_t*)malloc(BUFFER_SIZE);
+   uint32_t x = 12345;
+   for(uint32_t i = 0; i < BUFFER_SIZE; ++i) {
+      x = x * 1103515245 + 12345;
+      buf[i] = (uint8_t)(x >> 16);
+   }
+   fprintf(stdout, "preferred algorithm: %s\n", ALGO_NAMES[buzzbstig_checksum_default()]);
+   fprintf(stdout, "chunk size: %u bytes\n\n", chunk);
+   int err = known_answers() | crc32c_paths(buf, BUFFER_SIZE);
+   if(!err) fprintf(stdout, "known answers and crc32c paths match\n\n");
+   uint8_t a;
+   for(a = 0; a < BUZZBSTIG_CHECKSUM_COUNT; ++a) {
+      /* Streaming and one-shot checksums must match */
+      struct buzzbstig_checksum_s ctx;
+      buzzbstig_checksum_init(&ctx, a);
+      uint32_t i;
+      for(i = 0; i < BUFFER_SIZE; i += 7)
+         buzzbstig_checksum_update(&ctx, buf + i, (BUFFER_SIZE - i < 7) ? (BUFFER_SIZE - i) : 7);
+      uint32_t streamed = buzzbstig_checksum_final(&ctx);
+      uint32_t oneshot = buzzbstig_checksum(a, buf, BUFFER_SIZE);
+      if(streamed != oneshot) {
+         fprintf(stdout, "%-8s streaming mismatch: %08x != %08x\n", ALGO_NAMES[a], streamed, oneshot);
+         err = 1;
+      }
+      /* Time per-chunk checksums over the whole buffer */
+      uint32_t sink = 0;
+      double t0 = now();
+      int r;
+      for(r = 0; r < ROUNDS; ++r)
+         for(i = 0; i + chunk <= BUFFER_SIZE; i += chunk)
+            sink += buzzbstig_checksum(a, buf + i, chunk);
+      double dt = now() - t0;
+      double mb = (double)ROUNDS * (BUFFER_SIZE - BUFFER_SIZE % chunk) / (1024.0 * 1024.0);
+      fprintf(stdout, "%-8s %10.1f MB/s  (checksum %08x, sink %08x)\n",
+              ALGO_NAMES[a], mb / dt, oneshot, sink);
+   }
+   free(buf);
+   return err;
+}
@@ -73,6 +73,20 @@ int main() {
       dai_print(dai);
    }
 
+   int16_t buf[20];
+   for(i = 0; i < 20; ++i) buf[i] = i * 10;
+   fprintf(stdout, "pushing 20 elements at once\n");
+   buzzdarray_push_n(dai, buf, 20);
+   dai_print(dai);
+
+   fprintf(stdout, "appending a 3-element buffer\n");
+   buzzdarray_append_buffer(dai, buf, 3 * sizeof(int16_t));
+   dai_print(dai);
+
+   fprintf(stdout, "clearing\n");
+   buzzdarray_clear(dai, 1);
+   dai_print(dai);
+
    buzzdarray_destroy(&dai);
    return 0;
 }
@@ -0,0 +1,239 @@
+#include <buzz/buzzdict.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+ * Benchmark of buzzdict against the bucket-of-darray dictionary it
+ * replaced. The reference implementation below is the old one, kept
+ * here only for comparison. Both dictionaries receive the same random
+ * operations and their contents are checked against each other.
+ */
+
+#define NUM_KEYS 20000
+#define ROUNDS   5
+
+/****************************************/
+/****************************************/
+
+struct refdict_entry_s {
+   void* key;
+   void* data;
+};
+
+struct refdict_s {
+   buzzdarray_t* buckets;
+   uint32_t size;
+   uint32_t num_buckets;
+   buzzdict_hashfunp hashf;
+   buzzdict_key_cmpp keycmpf;
+   uint32_t key_size;
+   uint32_t data_size;
+};
+typedef struct refdict_s* refdict_t;
+
+refdict_t refdict_new(uint32_t buckets,
+                      uint32_t key_size,
+                      uint32_t data_size,
+                      buzzdict_hashfunp hashf,
+                      buzzdict_key_cmpp keycmpf) {
+   refdict_t dt = (refdict_t)calloc(1, sizeof(struct refdict_s));
+   dt->num_buckets = buckets;
+   dt->hashf = hashf;
+   dt->keycmpf = keycmpf;
+   dt->key_size = key_size;
+   dt->data_size = data_size;
+   dt->buckets = (buzzdarray_t*)calloc(buckets, sizeof(buzzdarray_t));
+   return dt;
+}
+
+void refdict_destroy(refdict_t* dt) {
+   uint32_t i, j;
+   for(i = 0; i < (*dt)->num_buckets; ++i) {
+      if((*dt)->buckets[i]) {
+         for(j = 0; j < buzzdarray_size((*dt)->buckets[i]); ++j) {
+            const struct refdict_entry_s* e = &buzzdarray_get((*dt)->buckets[i], j, struct refdict_entry_s);
+            free(e->key);
+            free(e->data);
+         }
+         buzzdarray_destroy(&((*dt)->buckets[i]));
+      }
+   }
+   free((*dt)->buckets);
+   free(*dt);
+   *dt = NULL;
+}
+
+void* refdict_get(refdict_t dt, const void* key) {
+   uint32_t h = dt->hashf(key) % dt->num_buckets, i;
+   if(!dt->buckets[h]) return NULL;
+   for(i = 0; i < buzzdarray_size(dt->buckets[h]); ++i) {
+      const struct refdict_entry_s* e = &buzzdarray_get(dt->buckets[h], i, struct refdict_entry_s);
+      if(dt->keycmpf(key, e->key) == 0) return e->data;
+   }
+   return NULL;
+}
+
+void refdict_set(refdict_t dt, const void* key, const void* data) {
+   void* d = refdict_get(dt, key);
+   if(d) {
+      memcpy(d, data, dt->data_size);
+      return;
+   }
+   uint32_t h = dt->hashf(key) % dt->num_buckets;
+   if(!dt->buckets[h])
+      dt->buckets[h] = buzzdarray_new(1, sizeof(struct refdict_entry_s), NULL);
+   struct refdict_entry_s e;
+   e.key = malloc(dt->key_size);
+   memcpy(e.key, key, dt->key_size);
+   e.data = malloc(dt->data_size);
+   memcpy(e.data, data, dt->data_size);
+   buzzdarray_push(dt->buckets[h], &e);
+   ++(dt->size);
+}
+
+int refdict_remove(refdict_t dt, const void* key) {
+   uint32_t h = dt->hashf(key) % dt->num_buckets, i;
+   if(!dt->buckets[h]) return 0;
+   for(i = 0; i < buzzdarray_size(dt->buckets[h]); ++i) {
+      const struct refdict_entry_s* e = &buzzdarray_get(dt->buckets[h], i, struct refdict_entry_s);
+      if(dt->keycmpf(key, e->key) == 0) {
+         free(e->key);
+         free(e->data);
+         buzzdarray_remove(dt->buckets[h], i);
+         if(buzzdarray_isempty(dt->buckets[h]))
+            buzzdarray_destroy(&(dt->buckets[h]));
+         --(dt->size);
+         return 1;
+      }
+   }
+   return 0;
+}
+
+/****************************************/
+/****************************************/
+
+double now() {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+uint32_t rnd(uint32_t* x) {
+   *x = *x * 1103515245 + 12345;
+   return *x >> 8;
+}
+
+void check_elem(const void* key, void* data, void* params) {
+   refdict_t ref = (refdict_t)params;
+   const int32_t* d = (const int32_t*)refdict_get(ref, key);
+   if(!d || *d != *(int32_t*)data) {
+      fprintf(stdout, "mismatch for key %d\n", *(const int32_t*)key);
+      exit(1);
+   }
+}
+
+/****************************************/
+/****************************************/
+
+int main(int argc, char** argv) {
+   /* Bucket count the VM typically passes */
+   uint32_t buckets = (argc > 1) ? atoi(argv[1]) : 20;
+   if(buckets == 0) buckets = 20;
+   int32_t* keys = (int32_t*)malloc(NUM_KEYS * sizeof(int32_t));
+   uint32_t x = 12345, i;
+   int r;
+   for(i = 0; i < NUM_KEYS; ++i) keys[i] = rnd(&x);
+   /*
+    * Random operations on both dictionaries, checked against each other.
+    * The pointer to the data of an element must not change until the
+    * element is removed.
+    */
+   const void* ptrs[2000] = { NULL };
+   buzzdict_t dt = buzzdict_new(buckets, sizeof(int32_t), sizeof(int32_t),
+                                buzzdict_int32keyhash, buzzdict_int32keycmp, NULL);
+   refdict_t ref = refdict_new(buckets, sizeof(int32_t), sizeof(int32_t),
+                               buzzdict_int32keyhash, buzzdict_int32keycmp);
+   for(i = 0; i < NUM_KEYS; ++i) {
+      uint32_t j = rnd(&x) % 2000;
+      int32_t k = keys[j], d = i;
+      if(rnd(&x) % 3 == 0) {
+         if(buzzdict_remove(dt, &k) != refdict_remove(ref, &k)) {
+            fprintf(stdout, "remove mismatch for key %d\n", k);
+            return 1;
+         }
+         ptrs[j] = NULL;
+      }
+      else {
+         const void* p = buzzdict_set(dt, &k, &d);
+         if(ptrs[j] && ptrs[j] != p) {
+            fprintf(stdout, "data of key %d moved\n", k);
+            return 1;
+         }
+         ptrs[j] = p;
+         refdict_set(ref, &k, &d);
+      }
+   }
+   if(buzzdict_size(dt) != ref->size) {
+      fprintf(stdout, "size mismatch: %u != %u\n", buzzdict_size(dt), ref->size);
+      return 1;
+   }
+   buzzdict_foreach(dt, check_elem, ref);
+   for(i = 0; i < 2000; ++i) {
+      if(ptrs[i] && buzzdict_rawget(dt, &keys[i]) != ptrs[i]) {
+         fprintf(stdout, "data of key %d moved\n", keys[i]);
+         return 1;
+      }
+   }
+   buzzdict_destroy(&dt);
+   refdict_destroy(&ref);
+   fprintf(stdout, "contents match\n\n");
+   /*
+    * Timing
+    */
+   fprintf(stdout, "%u keys, %u initial buckets, times in ns/op\n", NUM_KEYS, buckets);
+   fprintf(stdout, "%-10s %10s %10s %10s %10s\n", "", "insert", "hit", "miss", "remove");
+   int impl;
+   for(impl = 0; impl < 2; ++impl) {
+      double ti = 0, th = 0, tm = 0, tr = 0, t0;
+      int64_t sink = 0;
+      for(r = 0; r < ROUNDS; ++r) {
+         int32_t k;
+         if(impl == 0) {
+            buzzdict_t d = buzzdict_new(buckets, sizeof(int32_t), sizeof(int32_t),
+                                        buzzdict_int32keyhash, buzzdict_int32keycmp, NULL);
+            t0 = now();
+            for(i = 0; i < NUM_KEYS; ++i) buzzdict_set(d, &keys[i], &i);
+            ti += now() - t0; t0 = now();
+            for(i = 0; i < NUM_KEYS; ++i) sink += *buzzdict_get(d, &keys[i], int32_t);
+            th += now() - t0; t0 = now();
+            for(i = 0; i < NUM_KEYS; ++i) { k = keys[i] + 1; sink += buzzdict_exists(d, &k); }
+            tm += now() - t0; t0 = now();
+            for(i = 0; i < NUM_KEYS; ++i) sink += buzzdict_remove(d, &keys[i]);
+            tr += now() - t0;
+            buzzdict_destroy(&d);
+         }
+         else {
+            refdict_t d = refdict_new(buckets, sizeof(int32_t), sizeof(int32_t),
+                                      buzzdict_int32keyhash, buzzdict_int32keycmp);
+            t0 = now();
+            for(i = 0; i < NUM_KEYS; ++i) refdict_set(d, &keys[i], &i);
+            ti += now() - t0; t0 = now();
+            for(i = 0; i < NUM_KEYS; ++i) sink += *(int32_t*)refdict_get(d, &keys[i]);
+            th += now() - t0; t0 = now();
+            for(i = 0; i < NUM_KEYS; ++i) { k = keys[i] + 1; sink += (refdict_get(d, &k) != NULL); }
+            tm += now() - t0; t0 = now();
+            for(i = 0; i < NUM_KEYS; ++i) sink += refdict_remove(d, &keys[i]);
+            tr += now() - t0;
+            refdict_destroy(&d);
+         }
+      }
+      double n = 1e9 / ((double)ROUNDS * NUM_KEYS);
+      fprintf(stdout, "%-10s %10.1f %10.1f %10.1f %10.1f  (sink %lld)\n",
+              impl == 0 ? "buzzdict" : "buckets",
+              ti * n, th * n, tm * n, tr * n, (long long)sink);
+   }
+   free(keys);
+   return 0;
+}
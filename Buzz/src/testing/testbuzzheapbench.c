@@ -0,0 +1,159 @@
+#include <buzz/buzzvm.h>
+#include <buzz/buzzneighbors.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+/*
+ * Benchmark of the object heap. A swarm of robots on a circle runs a
+ * script (e.g. testhexagon.bo or testgradient.bo), every robot seeing
+ * every other one and receiving all the broadcasts of the previous
+ * step. The heap allocation counters are summed over the swarm: every
+ * object created used to be a separate calloc(), while now only the
+ * slabs come from malloc().
+ */
+
+#define ROBOTS 16
+#define STEPS  1000
+
+/****************************************/
+/****************************************/
+
+double now() {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int nop(buzzvm_t vm) {
+   return buzzvm_ret0(vm);
+}
+
+void register_nop(buzzvm_t vm, const char* name) {
+   buzzvm_pushs(vm, buzzvm_string_register(vm, name, 1));
+   buzzvm_pushcc(vm, buzzvm_function_register(vm, nop));
+   buzzvm_gstore(vm);
+}
+
+/****************************************/
+/****************************************/
+
+int main(int argc, char** argv) {
+   if(argc < 2) {
+      fprintf(stderr, "Usage:\n\t%s <file.bo> [steps]\n\n", argv[0]);
+      return 1;
+   }
+   uint32_t steps = argc > 2 ? atoi(argv[2]) : STEPS;
+   /* Read bytecode */
+   FILE* fd = fopen(argv[1], "rb");
+   if(!fd) {
+      perror(argv[1]);
+      return 1;
+   }
+   fseek(fd, 0, SEEK_END);
+   size_t bcode_size = ftell(fd);
+   rewind(fd);
+   uint8_t* bcode = (uint8_t*)malloc(bcode_size);
+   if(fread(bcode, 1, bcode_size, fd) < bcode_size) {
+      perror(argv[1]);
+      return 1;
+   }
+   fclose(fd);
+   /* Create the swarm */
+   buzzvm_t vm[ROBOTS];
+   buzzmsg_payload_t* msgs = NULL;
+   uint16_t* senders = NULL;
+   uint32_t nmsgs = 0, cap = 0, i, j, r, s;
+   for(r = 0; r < ROBOTS; ++r) {
+      vm[r] = buzzvm_new(r);
+      buzzvm_set_bcode(vm[r], bcode, bcode_size);
+      register_nop(vm[r], "log");
+      register_nop(vm[r], "goto");
+      while(buzzvm_step(vm[r]) == BUZZVM_STATE_READY);
+      if(vm[r]->state != BUZZVM_STATE_DONE ||
+         buzzvm_function_call(vm[r], "init", 0) != BUZZVM_STATE_READY) {
+         fprintf(stderr, "robot %u: %s\n", r, vm[r]->errormsg);
+         return 1;
+      }
+   }
+   /* Run the swarm */
+   double t0 = now();
+   for(s = 0; s < steps; ++s) {
+      uint32_t prev = nmsgs;
+      for(r = 0; r < ROBOTS; ++r) {
+         /* Neighbors */
+         buzzneighbors_reset(vm[r]);
+         for(j = 0; j < ROBOTS; ++j) {
+            if(j == r) continue;
+            float a = 2.0f * M_PI * j / ROBOTS - 2.0f * M_PI * r / ROBOTS;
+            buzzneighbors_add(vm[r], j, 300.0f * fabsf(sinf(a / 2.0f)) + 1.0f, a, 0.0f);
+         }
+         /* Messages of the previous step */
+         for(i = 0; i < prev; ++i)
+            if(senders[i] != r)
+               buzzinmsg_queue_append(vm[r], senders[i],
+                                      buzzmsg_payload_frombuffer(msgs[i]->data, msgs[i]->size));
+         buzzvm_process_inmsgs(vm[r]);
+         if(buzzvm_function_call(vm[r], "step", 0) != BUZZVM_STATE_READY) {
+            fprintf(stderr, "robot %u: %s\n", r, vm[r]->errormsg);
+            return 1;
+         }
+         buzzvm_process_outmsgs(vm[r]);
+         /* Broadcasts for the next step */
+         while(!buzzoutmsg_queue_isempty(vm[r])) {
+            if(nmsgs == cap) {
+               cap = cap ? 2 * cap : 64;
+               msgs = (buzzmsg_payload_t*)realloc(msgs, cap * sizeof(buzzmsg_payload_t));
+               senders = (uint16_t*)realloc(senders, cap * sizeof(uint16_t));
+            }
+            msgs[nmsgs] = buzzoutmsg_queue_first(vm[r]);
+            senders[nmsgs] = r;
+            ++nmsgs;
+            buzzoutmsg_queue_next(vm[r]);
+         }
+      }
+      /* Done with the messages of the previous step */
+      for(i = 0; i < prev; ++i) buzzmsg_payload_destroy(&msgs[i]);
+      for(i = prev; i < nmsgs; ++i) {
+         msgs[i - prev] = msgs[i];
+         senders[i - prev] = senders[i];
+      }
+      nmsgs -= prev;
+   }
+   double t = now() - t0;
+   /* Report */
+   struct buzzheap_allocstats_s a = { 0, 0, 0 };
+   struct buzzheap_gcstats_s g = { 0, 0, 0, 0, 0 };
+   struct buzzvm_icstats_s c = { 0, 0 };
+   for(r = 0; r < ROBOTS; ++r) {
+      for(i = 0; i < BUZZVM_INSTR_COUNT; ++i) {
+         c.hits   += vm[r]->icstats[i].hits;
+         c.misses += vm[r]->icstats[i].misses;
+      }
+      a.objs   += vm[r]->heap->allocstats.objs;
+      a.reused += vm[r]->heap->allocstats.reused;
+      a.slabs  += vm[r]->heap->allocstats.slabs;
+      g.cycles += vm[r]->heap->stats.cycles;
+      g.freed  += vm[r]->heap->stats.freed;
+   }
+   fprintf(stdout, "%s: %u robots, %u steps, %.1f us/step\n",
+           argv[1], ROBOTS, steps, t * 1e6 / steps);
+   fprintf(stdout, "objects created: %lu (%.1f per robot step)\n",
+           (unsigned long)a.objs, (double)a.objs / ROBOTS / steps);
+   fprintf(stdout, "slots reused:    %lu (%.1f%%)\n",
+           (unsigned long)a.reused, a.objs ? 100.0 * a.reused / a.objs : 0.0);
+   fprintf(stdout, "slabs allocated: %u\n", a.slabs);
+   fprintf(stdout, "gc cycles:       %lu, objects freed: %lu\n",
+           (unsigned long)g.cycles, (unsigned long)g.freed);
+   fprintf(stdout, "cache lookups:   %lu (%.1f%% hits)\n",
+           (unsigned long)(c.hits + c.misses),
+           c.hits + c.misses ? 100.0 * c.hits / (c.hits + c.misses) : 0.0);
+   /* Cleanup */
+   for(i = 0; i < nmsgs; ++i) buzzmsg_payload_destroy(&msgs[i]);
+   free(msgs);
+   free(senders);
+   for(r = 0; r < ROBOTS; ++r) buzzvm_destroy(&vm[r]);
+   free(bcode);
+   return 0;
+}
@@ -0,0 +1,141 @@
+#include <buzz/buzzqueue.h>
+#include <buzz/buzzvm.h>
+#include <buzz/buzzoutmsg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*
+ * Stress benchmark of the outgoing message queues. Every step pushes
+ * one message and pops the oldest one, with a growing backlog already
+ * queued. With a ring buffer the per-step cost must stay flat; the
+ * dynamic array the queues used before is timed for comparison.
+ */
+
+#define STEPS 20000
+
+/****************************************/
+/****************************************/
+
+double now() {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+uint32_t rnd(uint32_t* x) {
+   *x = *x * 1103515245 + 12345;
+   return *x >> 8;
+}
+
+/****************************************/
+/****************************************/
+
+int check(buzzqueue_t q, buzzdarray_t da) {
+   uint32_t i;
+   if(buzzqueue_size(q) != buzzdarray_size(da)) return 0;
+   for(i = 0; i < buzzqueue_size(q); ++i)
+      if(buzzqueue_get(q, i, int32_t) != buzzdarray_get(da, i, int32_t)) return 0;
+   return 1;
+}
+
+double step_darray(uint32_t backlog) {
+   buzzdarray_t da = buzzdarray_new(1, sizeof(int32_t), NULL);
+   int32_t i;
+   for(i = 0; i < backlog; ++i) buzzdarray_push(da, &i);
+   double t0 = now();
+   for(i = 0; i < STEPS; ++i) {
+      buzzdarray_push(da, &i);
+      buzzdarray_remove(da, 0);
+   }
+   double t = now() - t0;
+   buzzdarray_destroy(&da);
+   return t * 1e9 / STEPS;
+}
+
+double step_queue(uint32_t backlog) {
+   buzzqueue_t q = buzzqueue_new(1, sizeof(int32_t), NULL);
+   int32_t i;
+   for(i = 0; i < backlog; ++i) buzzqueue_push(q, &i);
+   double t0 = now();
+   for(i = 0; i < STEPS; ++i) {
+      buzzqueue_push(q, &i);
+      buzzqueue_pop(q);
+   }
+   double t = now() - t0;
+   buzzqueue_destroy(&q);
+   return t * 1e9 / STEPS;
+}
+
+double step_outmsg(uint32_t backlog) {
+   buzzvm_t vm = buzzvm_new(1);
+   buzzobj_t topic = buzzheap_newobj(vm, BUZZTYPE_INT);
+   buzzobj_t value = buzzheap_newobj(vm, BUZZTYPE_INT);
+   uint32_t i;
+   for(i = 0; i < backlog; ++i) buzzoutmsg_queue_append_broadcast(vm, topic, value);
+   double t0 = now();
+   for(i = 0; i < STEPS; ++i) {
+      buzzoutmsg_queue_append_broadcast(vm, topic, value);
+      buzzmsg_payload_t m = buzzoutmsg_queue_first(vm);
+      buzzmsg_payload_destroy(&m);
+      buzzoutmsg_queue_next(vm);
+   }
+   double t = now() - t0;
+   buzzvm_destroy(&vm);
+   return t * 1e9 / STEPS;
+}
+
+/****************************************/
+/****************************************/
+
+int main() {
+   /*
+    * Random operations on a queue and a dynamic array, checked against
+    * each other
+    */
+   buzzqueue_t q = buzzqueue_new(1, sizeof(int32_t), NULL);
+   buzzdarray_t da = buzzdarray_new(1, sizeof(int32_t), NULL);
+   uint32_t x = 12345, i;
+   for(i = 0; i < 100000; ++i) {
+      int32_t v = i;
+      uint32_t op = rnd(&x) % 8;
+      if(op < 3) {
+         buzzqueue_push(q, &v);
+         buzzdarray_push(da, &v);
+      }
+      else if(op < 4) {
+         buzzqueue_push_front(q, &v);
+         buzzdarray_insert(da, 0, &v);
+      }
+      else if(op < 6) {
+         buzzqueue_pop(q);
+         buzzdarray_remove(da, 0);
+      }
+      else if(!buzzdarray_isempty(da)) {
+         uint32_t pos = rnd(&x) % buzzdarray_size(da);
+         buzzqueue_remove(q, pos);
+         buzzdarray_remove(da, pos);
+      }
+      if(!check(q, da)) {
+         fprintf(stdout, "content mismatch at operation %u\n", i);
+         return 1;
+      }
+   }
+   buzzqueue_destroy(&q);
+   buzzdarray_destroy(&da);
+   fprintf(stdout, "contents match\n\n");
+   /*
+    * Timing
+    */
+   static const uint32_t BACKLOGS[] = { 10, 100, 1000, 10000, 100000 };
+   fprintf(stdout, "%u push+pop steps, times in ns/step\n", STEPS);
+   fprintf(stdout, "%10s %10s %10s %10s\n", "backlog", "darray", "queue", "outmsg");
+   for(i = 0; i < sizeof(BACKLOGS) / sizeof(BACKLOGS[0]); ++i) {
+      fprintf(stdout, "%10u %10.1f %10.1f %10.1f\n",
+              BACKLOGS[i],
+              step_darray(BACKLOGS[i]),
+              step_queue(BACKLOGS[i]),
+              step_outmsg(BACKLOGS[i]));
+   }
+   return 0;
+}
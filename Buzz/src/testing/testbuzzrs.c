@@ -0,0 +1,81 @@
+#include <buzz/buzzrs.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Test of the Reed-Solomon code of the blob chunks. Random data is
+ * encoded, up to m random pieces are dropped, and the data must come
+ * back from the rest.
+ */
+
+#define ROUNDS 2000
+#define SIZE   100
+
+/****************************************/
+/****************************************/
+
+static uint32_t rnd(uint32_t* x) {
+   *x = *x * 1103515245 + 12345;
+   return *x >> 8;
+}
+
+/****************************************/
+/****************************************/
+
+static int check() {
+   static uint8_t buf[BUZZRS_MAXPIECES][SIZE];
+   static uint8_t out[BUZZRS_MAXPIECES][SIZE];
+   const uint8_t* data[BUZZRS_MAXPIECES];
+   const uint8_t* pieces[BUZZRS_MAXPIECES];
+   uint8_t* parity[BUZZRS_MAXPIECES];
+   uint8_t* rebuilt[BUZZRS_MAXPIECES];
+   uint32_t x = 12345, r, i;
+   for(r = 0; r < ROUNDS; ++r) {
+      /* Mostly small codes, sometimes one filling the field */
+      uint16_t k = 1 + rnd(&x) % ((r % 10) ? 16 : 200);
+      uint16_t m = rnd(&x) % ((r % 10) ? 8 : (BUZZRS_MAXPIECES - k + 1));
+      for(i = 0; i < k + m; ++i) {
+         if(i < k) {
+            for(uint32_t j = 0; j < SIZE; ++j) buf[i][j] = rnd(&x);
+            data[i] = buf[i];
+         }
+         else parity[i - k] = buf[i];
+         pieces[i] = buf[i];
+         rebuilt[i] = out[i];
+      }
+      buzzrs_encode(k, m, data, parity, SIZE);
+      /* Drop up to m pieces */
+      uint16_t lost = m ? rnd(&x) % (m + 1) : 0;
+      for(i = 0; i < lost; ++i) pieces[rnd(&x) % (k + m)] = NULL;
+      if(!buzzrs_decode(k, m, pieces, rebuilt, SIZE)) {
+         fprintf(stdout, "round %u: k=%u m=%u not decoded\n", r, k, m);
+         return 0;
+      }
+      for(i = 0; i < k; ++i) {
+         if(!pieces[i] && memcmp(out[i], buf[i], SIZE)) {
+            fprintf(stdout, "round %u: k=%u m=%u piece %u rebuilt wrong\n", r, k, m, i);
+            return 0;
+         }
+      }
+      /* One piece too few must be refused */
+      uint16_t left = 0;
+      for(i = 0; i < k + m; ++i) if(pieces[i]) ++left;
+      for(i = 0; i < k + m && left >= k; ++i)
+         if(pieces[i]) { pieces[i] = NULL; --left; }
+      if(buzzrs_decode(k, m, pieces, rebuilt, SIZE)) {
+         fprintf(stdout, "round %u: k=%u m=%u decoded from %u pieces\n", r, k, m, left);
+         return 0;
+      }
+   }
+   return 1;
+}
+
+/****************************************/
+/****************************************/
+
+int main() {
+   if(!check()) return 1;
+   fprintf(stdout, "all data rebuilt from any k pieces\n");
+   return 0;
+}
@@ -0,0 +1,186 @@
+#include <buzz/buzzswarmrt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+/*
+ * Benchmark of the swarm runtime. A swarm of robots on a circle runs a
+ * script (e.g. testhexagon.bo or testgradient.bo), every robot seeing
+ * its closest neighbors on the circle and receiving their broadcasts of
+ * the previous step. The swarm is run with an increasing number of
+ * threads; the messages sent must be the same every time.
+ */
+
+#define ROBOTS    128
+#define NEIGHBORS 8
+#define STEPS     200
+
+/*
+ * Data of a robot, written by the hooks.
+ */
+struct robot_s {
+   /* Broadcasts of the last step */
+   buzzmsg_payload_t* msgs;
+   uint32_t nmsgs;
+   uint32_t cap;
+   /* Hash of all the broadcasts */
+   uint64_t hash;
+};
+
+struct robot_s robots[ROBOTS];
+
+/****************************************/
+/****************************************/
+
+double now() {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int nop(buzzvm_t vm) {
+   return buzzvm_ret0(vm);
+}
+
+void register_nop(buzzvm_t vm, const char* name) {
+   buzzvm_pushs(vm, buzzvm_string_register(vm, name, 1));
+   buzzvm_pushcc(vm, buzzvm_function_register(vm, nop));
+   buzzvm_gstore(vm);
+}
+
+/****************************************/
+/****************************************/
+
+/* Sets the neighbors and queues their broadcasts */
+void prestep(buzzvm_t vm, void* param) {
+   int32_t r = vm->robot, d;
+   buzzneighbors_reset(vm);
+   for(d = -NEIGHBORS / 2; d <= NEIGHBORS / 2; ++d) {
+      if(d == 0) continue;
+      uint32_t j = (r + d + ROBOTS) % ROBOTS, i;
+      float a = 2.0f * M_PI * d / ROBOTS;
+      buzzneighbors_add(vm, j, 300.0f * fabsf(sinf(a / 2.0f)) + 1.0f, a, 0.0f);
+      for(i = 0; i < robots[j].nmsgs; ++i)
+         buzzinmsg_queue_append(vm, j,
+                                buzzmsg_payload_frombuffer(robots[j].msgs[i]->data,
+                                                           robots[j].msgs[i]->size));
+   }
+}
+
+/* Replaces the broadcasts of the previous step with the new ones */
+void poststep(buzzvm_t vm, void* param) {
+   struct robot_s* r = robots + vm->robot;
+   uint32_t i;
+   for(i = 0; i < r->nmsgs; ++i) buzzmsg_payload_destroy(&r->msgs[i]);
+   r->nmsgs = 0;
+   while(!buzzoutmsg_queue_isempty(vm)) {
+      if(r->nmsgs == r->cap) {
+         r->cap = r->cap ? 2 * r->cap : 8;
+         r->msgs = (buzzmsg_payload_t*)realloc(r->msgs, r->cap * sizeof(buzzmsg_payload_t));
+      }
+      buzzmsg_payload_t m = buzzoutmsg_queue_first(vm);
+      for(i = 0; i < m->size; ++i)
+         r->hash = (r->hash ^ buzzmsg_payload_get(m, i)) * 1099511628211ull;
+      r->msgs[r->nmsgs++] = m;
+      buzzoutmsg_queue_next(vm);
+   }
+}
+
+/****************************************/
+/****************************************/
+
+/* Runs the swarm, returns the time per step or -1 in case of error */
+double run(const uint8_t* bcode, uint32_t bcode_size,
+           uint32_t threads, uint32_t steps, uint64_t* hash) {
+   buzzswarm_runtime_t rt = buzzswarm_runtime_new(threads);
+   buzzswarm_runtime_set_hooks(rt, prestep, poststep, NULL);
+   buzzvm_t vm[ROBOTS];
+   uint32_t r, s, i;
+   for(r = 0; r < ROBOTS; ++r) {
+      robots[r].nmsgs = 0;
+      robots[r].hash = 14695981039346656037ull;
+      vm[r] = buzzvm_new(r);
+      buzzvm_set_bcode(vm[r], bcode, bcode_size);
+      register_nop(vm[r], "log");
+      register_nop(vm[r], "goto");
+      while(buzzvm_step(vm[r]) == BUZZVM_STATE_READY);
+      if(vm[r]->state != BUZZVM_STATE_DONE ||
+         buzzvm_function_call(vm[r], "init", 0) != BUZZVM_STATE_READY) {
+         fprintf(stderr, "robot %u: %s\n", r, vm[r]->errormsg);
+         return -1;
+      }
+      buzzswarm_runtime_add(rt, vm[r]);
+   }
+   double t0 = now(), t;
+   for(s = 0; s < steps; ++s) {
+      if(buzzswarm_runtime_step(rt) > 0) {
+         for(r = 0; r < ROBOTS; ++r)
+            if(vm[r]->state == BUZZVM_STATE_ERROR)
+               fprintf(stderr, "robot %u: %s\n", r, vm[r]->errormsg);
+         return -1;
+      }
+   }
+   t = now() - t0;
+   /* Cleanup */
+   uint64_t steals = 0;
+   for(i = 0; i < buzzswarm_runtime_threads(rt); ++i)
+      steals += buzzswarm_runtime_stats(rt, i)->steals;
+   *hash = 0;
+   for(r = 0; r < ROBOTS; ++r) {
+      *hash = (*hash ^ robots[r].hash) * 1099511628211ull;
+      for(i = 0; i < robots[r].nmsgs; ++i) buzzmsg_payload_destroy(&robots[r].msgs[i]);
+      buzzvm_destroy(&vm[r]);
+   }
+   fprintf(stdout, "%8u %12.1f %12lu %18lx\n",
+           buzzswarm_runtime_threads(rt), t * 1e6 / steps,
+           (unsigned long)steals, (unsigned long)*hash);
+   buzzswarm_runtime_destroy(&rt);
+   return t / steps;
+}
+
+/****************************************/
+/****************************************/
+
+int main(int argc, char** argv) {
+   if(argc < 2) {
+      fprintf(stderr, "Usage:\n\t%s <file.bo> [steps] [max threads]\n\n", argv[0]);
+      return 1;
+   }
+   uint32_t steps = argc > 2 ? atoi(argv[2]) : STEPS;
+   uint32_t maxthreads = argc > 3 ? atoi(argv[3]) : 8;
+   /* Read bytecode */
+   FILE* fd = fopen(argv[1], "rb");
+   if(!fd) {
+      perror(argv[1]);
+      return 1;
+   }
+   fseek(fd, 0, SEEK_END);
+   size_t bcode_size = ftell(fd);
+   rewind(fd);
+   uint8_t* bcode = (uint8_t*)malloc(bcode_size);
+   if(fread(bcode, 1, bcode_size, fd) < bcode_size) {
+      perror(argv[1]);
+      return 1;
+   }
+   fclose(fd);
+   /* Run the swarm with more and more threads */
+   fprintf(stdout, "%s: %u robots, %u steps\n", argv[1], ROBOTS, steps);
+   fprintf(stdout, "%8s %12s %12s %18s\n", "threads", "us/step", "steals", "hash");
+   uint64_t hash1, hash;
+   double t1 = run(bcode, bcode_size, 1, steps, &hash1);
+   if(t1 < 0) return 1;
+   for(uint32_t n = 2; n <= maxthreads; n *= 2) {
+      double t = run(bcode, bcode_size, n, steps, &hash);
+      if(t < 0) return 1;
+      if(hash != hash1) {
+         fprintf(stdout, "messages differ with %u threads\n", n);
+         return 1;
+      }
+      fprintf(stdout, "%8s %11.2fx\n", "speedup", t1 / t);
+   }
+   /* Cleanup */
+   for(uint32_t r = 0; r < ROBOTS; ++r) free(robots[r].msgs);
+   free(bcode);
+   return 0;
+}
@@ -0,0 +1,85 @@
+#include <buzz/buzztimer.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+ * Test of the timer wheel. Timers are scheduled, moved and canceled at
+ * random, and must fire exactly at the tick they were set to.
+ */
+
+#define TIMERS 4096
+#define TICKS  100000
+
+/****************************************/
+/****************************************/
+
+static uint32_t rnd(uint32_t* x) {
+   *x = *x * 1103515245 + 12345;
+   return *x >> 8;
+}
+
+/* Random delay, mostly short, sometimes spanning the upper levels */
+static uint32_t delay(uint32_t* x) {
+   switch(rnd(x) % 4) {
+      case 0:  return rnd(x) % 64;
+      case 1:  return rnd(x) % 1000;
+      case 2:  return rnd(x) % 70000;
+      default: return rnd(x) % 300;
+   }
+}
+
+/****************************************/
+/****************************************/
+
+static int check() {
+   buzztimerwheel_t w = buzztimerwheel_new();
+   struct buzztimer_s* t = (struct buzztimer_s*)calloc(TIMERS, sizeof(struct buzztimer_s));
+   uint32_t* due = (uint32_t*)calloc(TIMERS, sizeof(uint32_t));
+   uint32_t x = 12345, i, k;
+   for(k = 0; k < TICKS; ++k) {
+      /* Schedule, move or cancel a few timers */
+      for(i = 0; i < 8; ++i) {
+         uint32_t n = rnd(&x) % TIMERS;
+         if(rnd(&x) % 5 == 0) {
+            buzztimer_cancel(t + n);
+         }
+         else {
+            uint32_t d = delay(&x);
+            buzztimer_schedule(w, t + n, d);
+            /* Timers with no delay fire at the next tick */
+            due[n] = buzztimerwheel_now(w) + (d ? d : 1);
+         }
+      }
+      buzztimerwheel_tick(w);
+      buzztimer_t e;
+      while((e = buzztimerwheel_pop(w))) {
+         uint32_t n = e - t;
+         if(due[n] != buzztimerwheel_now(w) || buzztimer_pending(e)) {
+            fprintf(stdout, "timer %u fired at %u instead of %u\n",
+                    n, buzztimerwheel_now(w), due[n]);
+            return 0;
+         }
+      }
+   }
+   /* Pending timers must still be due */
+   for(i = 0; i < TIMERS; ++i) {
+      if(buzztimer_pending(t + i) && due[i] <= buzztimerwheel_now(w)) {
+         fprintf(stdout, "timer %u missed its tick %u\n", i, due[i]);
+         return 0;
+      }
+      buzztimer_cancel(t + i);
+   }
+   buzztimerwheel_destroy(&w);
+   free(t);
+   free(due);
+   return 1;
+}
+
+/****************************************/
+/****************************************/
+
+int main() {
+   if(!check()) return 1;
+   fprintf(stdout, "timers fire on time\n");
+   return 0;
+}